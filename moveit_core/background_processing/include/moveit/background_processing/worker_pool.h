@@ -0,0 +1,97 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_BACKGROUND_PROCESSING_WORKER_POOL_
+#define MOVEIT_BACKGROUND_PROCESSING_WORKER_POOL_
+
+#include <deque>
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace moveit
+{
+namespace tools
+{
+
+/** \brief A fixed set of threads that evaluate the tasks of parallel loops. Unlike BackgroundProcessing, run() blocks
+    until all tasks it was given are complete, and the calling thread evaluates tasks as well. The threads are started
+    once, so a pool can be kept around and used for many short loops. A pool can be used from multiple threads at the same
+    time; tasks are then evaluated in the order their loops were started. */
+class WorkerPool : private boost::noncopyable
+{
+public:
+
+  /** \brief The signature for tasks: the index of the task in its loop */
+  typedef boost::function<void(std::size_t)> TaskCallback;
+
+  /** \brief Constructor. Starts \e threads threads, in addition to the threads that call run(). */
+  WorkerPool(unsigned int threads);
+
+  /** \brief Stops the threads of the pool. Must not be called while run() is executing. */
+  ~WorkerPool();
+
+  /** \brief The number of threads owned by the pool */
+  std::size_t getThreadCount() const
+  {
+    return threads_group_.size();
+  }
+
+  /** \brief Call \e task for indices 0 .. count-1, distributed across the threads of the pool and the calling thread.
+      Returns once all calls are complete. Exceptions thrown by \e task are logged and ignored. */
+  void run(std::size_t count, const TaskCallback &task);
+
+private:
+
+  struct Loop;
+  typedef boost::shared_ptr<Loop> LoopPtr;
+
+  void workerThread();
+
+  /* Take the next task index of \e loop and evaluate it. \e ulock must be locked on entry; it is unlocked while the task executes */
+  void runTask(const LoopPtr &loop, boost::unique_lock<boost::mutex> &ulock);
+
+  boost::thread_group threads_group_;
+  bool run_threads_;
+
+  boost::mutex lock_;
+  boost::condition_variable new_loop_condition_;
+  std::deque<LoopPtr> loops_;
+};
+
+}
+}
+
+#endif
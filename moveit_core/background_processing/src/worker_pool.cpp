@@ -0,0 +1,131 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+
+#include <moveit/background_processing/worker_pool.h>
+#include <console_bridge/console.h>
+#include <algorithm>
+
+struct moveit::tools::WorkerPool::Loop
+{
+  Loop(std::size_t count, const TaskCallback &task) : task_(task), count_(count), next_(0), done_(0)
+  {
+  }
+
+  TaskCallback task_;
+  std::size_t count_;
+  std::size_t next_;
+  std::size_t done_;
+  boost::condition_variable done_condition_;
+};
+
+moveit::tools::WorkerPool::WorkerPool(unsigned int threads) : run_threads_(true)
+{
+  for (unsigned int i = 0 ; i < threads ; ++i)
+    threads_group_.create_thread(boost::bind(&WorkerPool::workerThread, this));
+}
+
+moveit::tools::WorkerPool::~WorkerPool()
+{
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    run_threads_ = false;
+    new_loop_condition_.notify_all();
+  }
+  threads_group_.join_all();
+}
+
+void moveit::tools::WorkerPool::workerThread()
+{
+  boost::unique_lock<boost::mutex> ulock(lock_);
+  while (run_threads_)
+  {
+    if (loops_.empty())
+      new_loop_condition_.wait(ulock);
+    else
+      runTask(loops_.front(), ulock);
+  }
+}
+
+void moveit::tools::WorkerPool::runTask(const LoopPtr &loop, boost::unique_lock<boost::mutex> &ulock)
+{
+  // once all tasks of a loop are taken, the loop leaves the queue; it stays alive until the threads that still
+  // evaluate its tasks are done
+  LoopPtr keep(loop);
+  std::size_t index = keep->next_++;
+  if (keep->next_ == keep->count_)
+  {
+    std::deque<LoopPtr>::iterator it = std::find(loops_.begin(), loops_.end(), keep);
+    if (it != loops_.end())
+      loops_.erase(it);
+  }
+
+  ulock.unlock();
+  try
+  {
+    keep->task_(index);
+  }
+  catch(std::exception &ex)
+  {
+    logError("Exception caught while evaluating task %u of a parallel loop: %s", (unsigned int)index, ex.what());
+  }
+  catch(...)
+  {
+    logError("Exception caught while evaluating task %u of a parallel loop", (unsigned int)index);
+  }
+  ulock.lock();
+
+  if (++keep->done_ == keep->count_)
+    keep->done_condition_.notify_all();
+}
+
+void moveit::tools::WorkerPool::run(std::size_t count, const TaskCallback &task)
+{
+  if (count == 0)
+    return;
+  LoopPtr loop(new Loop(count, task));
+
+  boost::unique_lock<boost::mutex> ulock(lock_);
+  if (count > 1 && threads_group_.size() > 0)
+  {
+    loops_.push_back(loop);
+    new_loop_condition_.notify_all();
+  }
+
+  // the calling thread works on its own loop until all its tasks are taken, then waits for the other threads to finish theirs
+  while (loop->next_ < loop->count_)
+    runTask(loop, ulock);
+  while (loop->done_ < loop->count_)
+    loop->done_condition_.wait(ulock);
+}
@@ -38,9 +38,11 @@
 #define MOVEIT_COLLISION_DETECTION_COLLISION_MATRIX_
 
 #include <moveit/collision_detection/collision_common.h>
+#include <moveit/robot_model/robot_model.h>
 #include <moveit/macros/class_forward.h>
 #include <moveit_msgs/AllowedCollisionMatrix.h>
 #include <boost/function.hpp>
+#include <boost/unordered_map.hpp>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -73,6 +75,7 @@ namespace collision_detection
   typedef boost::function<bool(collision_detection::Contact&)> DecideContactFn;
 
   MOVEIT_CLASS_FORWARD(AllowedCollisionMatrix);
+  MOVEIT_CLASS_FORWARD(CompiledAllowedCollisionMatrix);
 
   /** @class AllowedCollisionMatrix
    *  @brief Definition of a structure for the allowed collision matrix. All elements in the collision world are referred to by their names.
@@ -236,14 +239,105 @@ namespace collision_detection
     /** @brief Print the allowed collision matrix */
     void print(std::ostream& out) const;
 
+    /** @brief Get a compiled view of this matrix for the links of \e model. The view is built on first use and then kept
+     *  up to date by the modifications of the matrix: changes that involve a few elements only re-evaluate the entries of
+     *  those elements. A view for a different model is built from scratch. */
+    CompiledAllowedCollisionMatrixConstPtr getCompiled(const robot_model::RobotModelConstPtr &model) const;
+
   private:
 
+    friend class CompiledAllowedCollisionMatrix;
+
+    /// Drop the compiled view; the next call to getCompiled() builds a new one
+    void invalidateCompiled();
+
+    /// Re-evaluate the entries of the compiled view (if any) that involve \e name
+    void updateCompiled(const std::string &name);
+
+    /// Re-evaluate the entry of the compiled view (if any) for the pair (\e name1, \e name2)
+    void updateCompiled(const std::string &name1, const std::string &name2);
+
+    /// Get the compiled view for modification, or NULL if there is none. A view that is still referenced elsewhere is copied first.
+    CompiledAllowedCollisionMatrix* getCompiledForUpdate();
+
     std::map<std::string, std::map<std::string, AllowedCollision::Type> > entries_;
     std::map<std::string, std::map<std::string, DecideContactFn> >        allowed_contacts_;
 
     std::map<std::string, AllowedCollision::Type>                         default_entries_;
     std::map<std::string, DecideContactFn>                                default_allowed_contacts_;
 
+    /// Cached result of getCompiled(); accessed atomically, as getCompiled() may be called from multiple threads
+    mutable CompiledAllowedCollisionMatrixPtr                             compiled_;
+  };
+
+  /** @class CompiledAllowedCollisionMatrix
+   *  @brief A view of an AllowedCollisionMatrix for a particular robot model, meant for the per-pair filtering done by
+   *  collision checkers. Every element is assigned an index: the links of the robot come first, the remaining names known
+   *  to the matrix follow. Entries are resolved once (default entries included) and stored in a dense table, so a query
+   *  is an array access instead of a lookup in nested maps. */
+  class CompiledAllowedCollisionMatrix
+  {
+  public:
+
+    CompiledAllowedCollisionMatrix(const AllowedCollisionMatrix &acm, const robot_model::RobotModelConstPtr &model);
+
+    /** @brief Get the index of the element \e name. Names the matrix does not know about all share one index. */
+    int getIndex(const std::string &name) const
+    {
+      boost::unordered_map<std::string, int>::const_iterator it = index_.find(name);
+      return it == index_.end() ? UNKNOWN_INDEX : it->second;
+    }
+
+    /** @brief Get the index of the link \e link of the robot model this view was compiled for. Links come first, in the
+     *  order of their link index, so this does not need to look up the name of the link. */
+    int getIndex(const robot_model::LinkModel *link) const
+    {
+      return link->getLinkIndex() < link_count_ ? link->getLinkIndex() + 1 : getIndex(link->getName());
+    }
+
+    /** @brief Same as AllowedCollisionMatrix::getAllowedCollision(), for elements identified by index */
+    bool getAllowedCollision(int index1, int index2, AllowedCollision::Type& allowed_collision) const
+    {
+      unsigned char t = entries_[index1 * stride_ + index2];
+      if (t == NOT_FOUND)
+        return false;
+      allowed_collision = static_cast<AllowedCollision::Type>(t);
+      return true;
+    }
+
+    /** @brief The model this view was compiled for */
+    const robot_model::RobotModelConstPtr& getRobotModel() const
+    {
+      return model_;
+    }
+
+  private:
+
+    friend class AllowedCollisionMatrix;
+
+    static const unsigned char NOT_FOUND = 0xff;
+
+    /// All names the matrix does not know about share this index
+    static const int UNKNOWN_INDEX = 0;
+
+    /// Add \e name to the view without evaluating any entries, and return its index
+    int addName(const std::string &name);
+
+    /// Get the index of \e name, adding the name to the view if needed
+    int getOrAddIndex(const std::string &name);
+
+    /// Re-evaluate the entries involving the element at \e index
+    void updateIndex(const AllowedCollisionMatrix &acm, int index);
+
+    /// Re-evaluate the entry for the pair of elements at \e index1 and \e index2
+    void updatePair(const AllowedCollisionMatrix &acm, int index1, int index2);
+
+    robot_model::RobotModelConstPtr        model_;
+    std::vector<std::string>               names_;
+    boost::unordered_map<std::string, int> index_;
+    int                                    link_count_;
+    std::size_t                            stride_;
+    std::vector<unsigned char>             entries_;
   };
 }
 
@@ -217,6 +217,19 @@ namespace collision_detection
     /** \brief The shortest distance to another world instance (\e world), ignoring the distances between world elements that are allowed to collide (as specified by \e acm) */
     virtual double distanceWorld(const CollisionWorld &world,
                                  const AllowedCollisionMatrix &acm) const = 0;
+
+    /** \brief Indicate that a sequence of changes to the world is about to be made. Implementations may postpone updating
+     *  their internal structures until the matching call to endUpdate(), so that the changes are applied together. Collision
+     *  checks should not be performed in between. Calls can be nested. */
+    virtual void beginUpdate()
+    {
+    }
+
+    /** \brief Apply the changes made to the world since the matching call to beginUpdate() */
+    virtual void endUpdate()
+    {
+    }
+
     /** set the world to use.
      * This can be expensive unless the new and old world are empty.
      * Passing NULL will result in a new empty world being created. */
@@ -36,6 +36,7 @@
 
 #include <moveit/collision_detection/collision_matrix.h>
 #include <boost/bind.hpp>
+#include <algorithm>
 #include <iomanip>
 
 collision_detection::AllowedCollisionMatrix::AllowedCollisionMatrix()
@@ -135,12 +136,14 @@ void collision_detection::AllowedCollisionMatrix::setEntry(const std::string &na
     if (jt != it->second.end())
       it->second.erase(jt);
   }
+  updateCompiled(name1, name2);
 }
 
 void collision_detection::AllowedCollisionMatrix::setEntry(const std::string& name1, const std::string& name2, const DecideContactFn &fn)
 {
   entries_[name1][name2] = entries_[name2][name1] = AllowedCollision::CONDITIONAL;
   allowed_contacts_[name1][name2] = allowed_contacts_[name2][name1] = fn;
+  updateCompiled(name1, name2);
 }
 
 void collision_detection::AllowedCollisionMatrix::removeEntry(const std::string& name)
@@ -151,6 +154,7 @@ void collision_detection::AllowedCollisionMatrix::removeEntry(const std::string&
     it->second.erase(name);
   for (std::map<std::string, std::map<std::string, DecideContactFn> >::iterator it = allowed_contacts_.begin() ; it != allowed_contacts_.end() ; ++it)
     it->second.erase(name);
+  updateCompiled(name);
 }
 
 void collision_detection::AllowedCollisionMatrix::removeEntry(const std::string& name1, const std::string &name2)
@@ -184,6 +188,7 @@ void collision_detection::AllowedCollisionMatrix::removeEntry(const std::string&
     if (jt != it->second.end())
       it->second.erase(jt);
   }
+  updateCompiled(name1, name2);
 }
 
 void collision_detection::AllowedCollisionMatrix::setEntry(const std::string& name, const std::vector<std::string>& other_names, bool allowed)
@@ -212,6 +217,7 @@ void collision_detection::AllowedCollisionMatrix::setEntry(const std::string& na
 
 void collision_detection::AllowedCollisionMatrix::setEntry(bool allowed)
 {
+  invalidateCompiled();
   const AllowedCollision::Type v = allowed ? AllowedCollision::ALWAYS : AllowedCollision::NEVER;
   for (std::map<std::string, std::map<std::string, AllowedCollision::Type> >::iterator it1 = entries_.begin() ; it1 != entries_.end() ; ++it1)
     for (std::map<std::string, AllowedCollision::Type>::iterator it2 = it1->second.begin() ; it2 != it1->second.end() ; ++it2)
@@ -223,12 +229,14 @@ void collision_detection::AllowedCollisionMatrix::setDefaultEntry(const std::str
   const AllowedCollision::Type v = allowed ? AllowedCollision::ALWAYS : AllowedCollision::NEVER;
   default_entries_[name] = v;
   default_allowed_contacts_.erase(name);
+  updateCompiled(name);
 }
 
 void collision_detection::AllowedCollisionMatrix::setDefaultEntry(const std::string &name, const DecideContactFn &fn)
 {
   default_entries_[name] = AllowedCollision::CONDITIONAL;
   default_allowed_contacts_[name] = fn;
+  updateCompiled(name);
 }
 
 bool collision_detection::AllowedCollisionMatrix::getDefaultEntry(const std::string &name, AllowedCollision::Type &allowed_collision) const
@@ -315,12 +323,140 @@ bool collision_detection::AllowedCollisionMatrix::getAllowedCollision(const std:
 
 void collision_detection::AllowedCollisionMatrix::clear()
 {
+  invalidateCompiled();
   entries_.clear();
   allowed_contacts_.clear();
   default_entries_.clear();
   default_allowed_contacts_.clear();
 }
 
+void collision_detection::AllowedCollisionMatrix::invalidateCompiled()
+{
+  boost::atomic_store(&compiled_, CompiledAllowedCollisionMatrixPtr());
+}
+
+collision_detection::CompiledAllowedCollisionMatrix* collision_detection::AllowedCollisionMatrix::getCompiledForUpdate()
+{
+  // the matrix is not modified concurrently with other calls, so compiled_ can be accessed directly here
+  if (compiled_ && !compiled_.unique())
+    // someone still uses the current view (e.g., a caller of getCompiled()); leave it as it is
+    boost::atomic_store(&compiled_, CompiledAllowedCollisionMatrixPtr(new CompiledAllowedCollisionMatrix(*compiled_)));
+  return compiled_.get();
+}
+
+void collision_detection::AllowedCollisionMatrix::updateCompiled(const std::string &name)
+{
+  if (CompiledAllowedCollisionMatrix *compiled = getCompiledForUpdate())
+    compiled->updateIndex(*this, compiled->getOrAddIndex(name));
+}
+
+void collision_detection::AllowedCollisionMatrix::updateCompiled(const std::string &name1, const std::string &name2)
+{
+  if (CompiledAllowedCollisionMatrix *compiled = getCompiledForUpdate())
+  {
+    // a name that is new to the view needs all of its entries evaluated, as its default entry may apply to them
+    int index1 = compiled->getIndex(name1);
+    int index2 = compiled->getIndex(name2);
+    if (index1 == CompiledAllowedCollisionMatrix::UNKNOWN_INDEX)
+      compiled->updateIndex(*this, index1 = compiled->addName(name1));
+    if (index2 == CompiledAllowedCollisionMatrix::UNKNOWN_INDEX)
+      compiled->updateIndex(*this, index2 = compiled->addName(name2));
+    compiled->updatePair(*this, index1, index2);
+  }
+}
+
+collision_detection::CompiledAllowedCollisionMatrixConstPtr
+collision_detection::AllowedCollisionMatrix::getCompiled(const robot_model::RobotModelConstPtr &model) const
+{
+  CompiledAllowedCollisionMatrixPtr compiled = boost::atomic_load(&compiled_);
+  if (!compiled || compiled->getRobotModel() != model)
+  {
+    // if multiple threads get here at the same time, each builds its own view and one of them is kept
+    compiled.reset(new CompiledAllowedCollisionMatrix(*this, model));
+    boost::atomic_store(&compiled_, compiled);
+  }
+  return compiled;
+}
+
+const unsigned char collision_detection::CompiledAllowedCollisionMatrix::NOT_FOUND;
+const int collision_detection::CompiledAllowedCollisionMatrix::UNKNOWN_INDEX;
+
+collision_detection::CompiledAllowedCollisionMatrix::CompiledAllowedCollisionMatrix(const AllowedCollisionMatrix &acm,
+                                                                                     const robot_model::RobotModelConstPtr &model)
+  : model_(model)
+  , link_count_(0)
+  , stride_(1)
+  , entries_(1, NOT_FOUND)
+{
+  // all names the matrix does not know about behave the same: only the default entry of the other element can apply
+  names_.push_back(std::string());
+
+  // links come first, in the order of their link index
+  const std::vector<std::string> &links = model->getLinkModelNames();
+  for (std::size_t i = 0 ; i < links.size() ; ++i)
+    addName(links[i]);
+  link_count_ = links.size();
+
+  // followed by all other names that have entries or default entries in the matrix
+  std::vector<std::string> acm_names;
+  acm.getAllEntryNames(acm_names);
+  for (std::map<std::string, AllowedCollision::Type>::const_iterator it = acm.default_entries_.begin() ; it != acm.default_entries_.end() ; ++it)
+    acm_names.push_back(it->first);
+  for (std::size_t i = 0 ; i < acm_names.size() ; ++i)
+    getOrAddIndex(acm_names[i]);
+
+  AllowedCollision::Type type;
+  for (std::size_t i = 1 ; i < names_.size() ; ++i)
+  {
+    for (std::size_t j = i ; j < names_.size() ; ++j)
+      if (acm.getAllowedCollision(names_[i], names_[j], type))
+        entries_[i * stride_ + j] = entries_[j * stride_ + i] = type;
+    if (acm.getDefaultEntry(names_[i], type))
+      entries_[i * stride_ + UNKNOWN_INDEX] = entries_[UNKNOWN_INDEX * stride_ + i] = type;
+  }
+}
+
+int collision_detection::CompiledAllowedCollisionMatrix::addName(const std::string &name)
+{
+  int index = names_.size();
+  names_.push_back(name);
+  index_[name] = index;
+
+  // the table grows geometrically, so adding names one at a time does not copy it every time
+  if (names_.size() > stride_)
+  {
+    std::size_t stride = std::max<std::size_t>(names_.size(), 2 * stride_);
+    std::vector<unsigned char> entries(stride * stride, NOT_FOUND);
+    for (std::size_t i = 0 ; i < stride_ ; ++i)
+      std::copy(entries_.begin() + i * stride_, entries_.begin() + (i + 1) * stride_, entries.begin() + i * stride);
+    entries_.swap(entries);
+    stride_ = stride;
+  }
+  return index;
+}
+
+int collision_detection::CompiledAllowedCollisionMatrix::getOrAddIndex(const std::string &name)
+{
+  boost::unordered_map<std::string, int>::const_iterator it = index_.find(name);
+  return it == index_.end() ? addName(name) : it->second;
+}
+
+void collision_detection::CompiledAllowedCollisionMatrix::updateIndex(const AllowedCollisionMatrix &acm, int index)
+{
+  for (std::size_t j = 1 ; j < names_.size() ; ++j)
+    updatePair(acm, index, j);
+  AllowedCollision::Type type;
+  entries_[index * stride_ + UNKNOWN_INDEX] = entries_[UNKNOWN_INDEX * stride_ + index] =
+    acm.getDefaultEntry(names_[index], type) ? type : NOT_FOUND;
+}
+
+void collision_detection::CompiledAllowedCollisionMatrix::updatePair(const AllowedCollisionMatrix &acm, int index1, int index2)
+{
+  AllowedCollision::Type type;
+  entries_[index1 * stride_ + index2] = entries_[index2 * stride_ + index1] =
+    acm.getAllowedCollision(names_[index1], names_[index2], type) ? type : NOT_FOUND;
+}
+
 void collision_detection::AllowedCollisionMatrix::getAllEntryNames(std::vector<std::string>& names) const
 {
   names.clear();
@@ -43,6 +43,7 @@
 #include <fcl/broadphase/broadphase.h>
 #include <fcl/collision.h>
 #include <fcl/distance.h>
+#include <fcl/continuous_collision.h>
 #include <memory>
 #include <set>
 
@@ -110,6 +111,7 @@ struct CollisionGeometryData
 
   BodyType type;
   int shape_index;
+
   union
   {
     const robot_model::LinkModel    *link;
@@ -134,9 +136,17 @@ struct CollisionData
   {
   }
 
-  /// Compute \e active_components_only_ based on \e req_
+  /// Compute \e active_components_only_ based on \e req_, and get the compiled view of \e acm_ for \e kmodel
   void enableGroup(const robot_model::RobotModelConstPtr &kmodel);
 
+  /// Look up the allowed collision type for a pair of bodies in \e acm_, through \e compiled_acm_ if available
+  bool getAllowedCollision(const CollisionGeometryData &cd1, const CollisionGeometryData &cd2, AllowedCollision::Type &type) const
+  {
+    if (compiled_acm_)
+      return compiled_acm_->getAllowedCollision(getCompiledIndex(cd1), getCompiledIndex(cd2), type);
+    return acm_->getAllowedCollision(cd1.getID(), cd2.getID(), type);
+  }
+
   /// The collision request passed by the user
   const CollisionRequest       *req_;
 
@@ -151,10 +161,34 @@ struct CollisionData
   /// The user specified collision matrix (may be NULL)
   const AllowedCollisionMatrix *acm_;
 
+  /// Index based view of \e acm_, for the robot model passed to enableGroup() (may be NULL)
+  CompiledAllowedCollisionMatrixConstPtr compiled_acm_;
+
   /// Flag indicating whether collision checking is complete
   bool                          done_;
+
+private:
+
+  int getCompiledIndex(const CollisionGeometryData &cd) const
+  {
+    // links are found by their link index; only attached bodies and world objects are looked up by name
+    return cd.type == BodyTypes::ROBOT_LINK ? compiled_acm_->getIndex(cd.ptr.link) : compiled_acm_->getIndex(cd.getID());
+  }
 };
 
+/** \brief Data passed to continuousCollisionCallback(). The objects in the broadphase are placed at their start
+    poses; \e end_transforms_ holds the pose every moving object reaches at the end of the motion. Objects
+    without an entry are considered static. */
+struct ContinuousCollisionData : public CollisionData
+{
+  ContinuousCollisionData(const CollisionRequest *req, CollisionResult *res,
+                          const AllowedCollisionMatrix *acm) : CollisionData(req, res, acm)
+  {
+  }
+
+  /// The pose at the end of the motion for every moving collision object
+  std::map<const fcl::CollisionObject*, fcl::Transform3f> end_transforms_;
+};
 
 MOVEIT_CLASS_FORWARD(FCLGeometry);
 
@@ -217,6 +251,15 @@ struct FCLManager
 
 bool collisionCallback(fcl::CollisionObject *o1, fcl::CollisionObject *o2, void *data);
 
+/** \brief Broadphase callback for continuous collision checking; \e data must point to a ContinuousCollisionData.
+    Each body is assumed to move with constant linear and angular velocity between its start and end poses. */
+bool continuousCollisionCallback(fcl::CollisionObject *o1, fcl::CollisionObject *o2, void *data);
+
+/** \brief Turn the objects of \e start (at their start poses) into objects suitable for continuous collision checking:
+    their AABBs are enlarged to enclose the motion to the corresponding objects of \e end, and the end transforms are
+    recorded in \e cdata. Returns false if \e start and \e end do not contain corresponding objects. */
+bool sweepFCLObject(FCLObject &start, const FCLObject &end, ContinuousCollisionData &cdata);
+
 bool distanceCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void *data, double& min_dist);
 
 FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr &shape,
@@ -234,8 +277,37 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr &shape,
                                             const robot_state::AttachedBody *ab, int shape_index);
 FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr &shape, double scale, double padding,
                                             const World::Object *obj);
+
+/** \brief Remove the entries for shapes that no longer exist from the cache used by createCollisionGeometry() */
 void cleanCollisionGeometryCache();
 
+/** \brief Remove the cache entries for the shapes of \e obj, even though the shapes still exist. This is used when the
+    object leaves a world, so that the cache does not keep its geometry (and the data it refers to) alive */
+void removeCollisionGeometryFromCache(const World::Object *obj);
+
+/** \brief Usage counters for the cache of FCL geometry used by createCollisionGeometry() */
+struct CollisionGeometryCacheStatistics
+{
+  CollisionGeometryCacheStatistics() : hits_(0), misses_(0), contended_(0), entries_(0)
+  {
+  }
+
+  /// The number of requests answered with existing geometry
+  std::size_t hits_;
+
+  /// The number of requests for which new geometry was constructed
+  std::size_t misses_;
+
+  /// The number of accesses that had to wait for another thread using the same part of the cache
+  std::size_t contended_;
+
+  /// The number of entries currently in the cache
+  std::size_t entries_;
+};
+
+/** \brief Get the usage counters accumulated since the start of the process, for monitoring purposes */
+CollisionGeometryCacheStatistics getCollisionGeometryCacheStatistics();
+
 inline void transform2fcl(const Eigen::Affine3d &b, fcl::Transform3f &f)
 {
   Eigen::Quaterniond q(b.rotation());
@@ -38,6 +38,7 @@
 #define MOVEIT_COLLISION_DETECTION_FCL_COLLISION_ROBOT_
 
 #include <moveit/collision_detection_fcl/collision_common.h>
+#include <boost/thread/mutex.hpp>
 
 namespace collision_detection
 {
@@ -75,24 +76,111 @@ namespace collision_detection
     virtual double distanceOther(const robot_state::RobotState &state, const CollisionRobot &other_robot,
                                  const robot_state::RobotState &other_state, const AllowedCollisionMatrix &acm) const;
 
+    /** \brief Enable or disable the use of broadphase structures that persist across calls (a pool owned by this instance, holding one structure per concurrent query).
+        When enabled (the default), the structure is built once and only the objects whose transforms changed are refit;
+        when disabled, the structure is rebuilt for every call. */
+    void setPersistentBroadPhase(bool flag)
+    {
+      persistent_broadphase_ = flag;
+    }
+
+    bool getPersistentBroadPhase() const
+    {
+      return persistent_broadphase_;
+    }
+
   protected:
 
+    /** \brief Broadphase structure for the links of the robot, kept across queries */
+    struct SelfCollisionBroadPhase
+    {
+      SelfCollisionBroadPhase() : version_(0)
+      {
+      }
+
+      /// The manager containing one collision object for every link geometry
+      FCLManager                manager_;
+
+      /// For each collision object in \e manager_, the index of the corresponding entry in geoms_
+      std::vector<std::size_t>  geom_index_;
+
+      /// For each collision object in \e manager_, the transform it was last refit to
+      EigenSTL::vector_Affine3d poses_;
+
+      /// The value of geoms_version_ this structure was built for
+      unsigned int              version_;
+    };
+
+    /** \brief The broadphase manager used by one query: either a structure checked out of the pool, or \e scratch_ */
+    struct SelfCollisionQuery
+    {
+      /// Holds the attached bodies of the queried state, or the whole robot if no persistent structure is used
+      FCLManager                                  scratch_;
+
+      /// The structure checked out of the pool for this query, if any
+      boost::shared_ptr<SelfCollisionBroadPhase>  broadphase_;
+    };
+
     virtual void updatedPaddingOrScaling(const std::vector<std::string> &links);
     void constructFCLObject(const robot_state::RobotState &state, FCLObject &fcl_obj) const;
     void allocSelfCollisionBroadPhase(const robot_state::RobotState &state, FCLManager &manager) const;
-    void getAttachedBodyObjects(const robot_state::AttachedBody *ab, std::vector<FCLGeometryConstPtr> &geoms) const;
+
+    /** \brief Get a broadphase manager that contains the robot at \e state. If persistent broadphase structures are
+        enabled, a structure is checked out of the pool kept by this instance (or built, if the pool is empty),
+        refit to \e state and returned; the bodies attached to \e state are constructed in the scratch manager of \e query
+        and registered to it. Otherwise, the scratch manager is filled from scratch and returned.
+        Every call must be matched by a call to releaseSelfCollisionBroadPhase() */
+    FCLManager* getSelfCollisionBroadPhase(const robot_state::RobotState &state, SelfCollisionQuery &query) const;
+
+    /** \brief Unregister the attached bodies and return the structure used by \e query to the pool */
+    void releaseSelfCollisionBroadPhase(SelfCollisionQuery &query) const;
+    void constructAttachedBodyObjects(const robot_state::RobotState &state, FCLObject &fcl_obj) const;
+
+    /** \brief The FCL objects for the shapes of an attached body, placed at the origin. They are computed once and stored
+        with the body (see robot_state::AttachedBody::setCollisionCache()) and shared by its copies */
+    struct AttachedBodyObjects
+    {
+      /// The copy of the attached body the geometry data points to
+      boost::shared_ptr<const robot_state::AttachedBody> body_;
+
+      std::vector<FCLGeometryConstPtr>   geoms_;
+      std::vector<FCLCollisionObjectPtr> objects_;
+
+      /// For each entry in objects_, the index of the corresponding shape of the attached body
+      std::vector<std::size_t>           shape_index_;
+    };
+
+    boost::shared_ptr<const AttachedBodyObjects> getAttachedBodyObjects(const robot_state::AttachedBody *ab) const;
 
     void checkSelfCollisionHelper(const CollisionRequest &req, CollisionResult &res, const robot_state::RobotState &state,
                                   const AllowedCollisionMatrix *acm) const;
     void checkOtherCollisionHelper(const CollisionRequest &req, CollisionResult &res, const robot_state::RobotState &state,
                                    const CollisionRobot &other_robot, const robot_state::RobotState &other_state,
                                    const AllowedCollisionMatrix *acm) const;
+    void checkSelfCollisionHelper(const CollisionRequest &req, CollisionResult &res, const robot_state::RobotState &state1,
+                                  const robot_state::RobotState &state2, const AllowedCollisionMatrix *acm) const;
+    void checkOtherCollisionHelper(const CollisionRequest &req, CollisionResult &res, const robot_state::RobotState &state1,
+                                   const robot_state::RobotState &state2, const CollisionRobot &other_robot,
+                                   const robot_state::RobotState &other_state1, const robot_state::RobotState &other_state2,
+                                   const AllowedCollisionMatrix *acm) const;
+
+    /** \brief Construct the objects of the robot at \e state1, swept to their poses at \e state2, for continuous collision checking */
+    bool constructSweptFCLObject(const robot_state::RobotState &state1, const robot_state::RobotState &state2,
+                                 FCLObject &fcl_obj, ContinuousCollisionData &cd) const;
     double distanceSelfHelper(const robot_state::RobotState &state, const AllowedCollisionMatrix *acm) const;
     double distanceOtherHelper(const robot_state::RobotState &state, const CollisionRobot &other_robot,
                                const robot_state::RobotState &other_state, const AllowedCollisionMatrix *acm) const;
 
     std::vector<FCLGeometryConstPtr> geoms_;
     std::vector<FCLCollisionObjectConstPtr> fcl_objs_;
+
+    /// Changes every time geoms_ or fcl_objs_ change, so persistent broadphase structures know to rebuild
+    unsigned int                            geoms_version_;
+    bool                                    persistent_broadphase_;
+
+    /// Persistent broadphase structures not currently used by a query; there are at most as many as concurrent queries
+    mutable std::vector<boost::shared_ptr<SelfCollisionBroadPhase> > broadphase_pool_;
+    mutable boost::mutex                    broadphase_pool_lock_;
   };
 
 }
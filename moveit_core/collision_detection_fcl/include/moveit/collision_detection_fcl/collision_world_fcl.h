@@ -68,16 +68,28 @@ namespace collision_detection
 
     virtual void setWorld(const WorldPtr& world);
 
+    /** \brief Changes to world objects are accumulated until the matching call to endUpdate(). Every changed object is then
+        processed once, and objects that were only moved are refitted in a single broadphase update */
+    virtual void beginUpdate();
+    virtual void endUpdate();
+
   protected:
 
     void checkWorldCollisionHelper(const CollisionRequest &req, CollisionResult &res, const CollisionWorld &other_world, const AllowedCollisionMatrix *acm) const;
     void checkRobotCollisionHelper(const CollisionRequest &req, CollisionResult &res, const CollisionRobot &robot, const robot_state::RobotState &state, const AllowedCollisionMatrix *acm) const;
+    void checkRobotCollisionHelper(const CollisionRequest &req, CollisionResult &res, const CollisionRobot &robot, const robot_state::RobotState &state1,
+                                   const robot_state::RobotState &state2, const AllowedCollisionMatrix *acm) const;
     double distanceRobotHelper(const CollisionRobot &robot, const robot_state::RobotState &state, const AllowedCollisionMatrix *acm) const;
     double distanceWorldHelper(const CollisionWorld &world, const AllowedCollisionMatrix *acm) const;
 
     void constructFCLObject(const World::Object *obj, FCLObject &fcl_obj) const;
     void updateFCLObject(const std::string &id);
 
+    /** \brief If only the poses of the shapes of \e obj changed, move its existing FCL objects instead of reconstructing them.
+        The moved objects are appended to \e moved; the broadphase structure is not updated. Returns false if the object needs
+        to be reconstructed instead. */
+    bool moveFCLObject(const World::Object *obj, std::vector<fcl::CollisionObject*> &moved);
+
 
     boost::scoped_ptr<fcl::BroadPhaseCollisionManager> manager_;
     std::map<std::string, FCLObject >                  fcl_objs_;
@@ -86,6 +98,12 @@ namespace collision_detection
     void initialize();
     void notifyObjectChange(const ObjectConstPtr& obj, World::Action action);
     World::ObserverHandle observer_handle_;
+
+    /// Nesting depth of beginUpdate() calls
+    unsigned int                         update_depth_;
+
+    /// The changes accumulated for each object while updates are postponed
+    std::map<std::string, int>           pending_changes_;
   };
 
 }
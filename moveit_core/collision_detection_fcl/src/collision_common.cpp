@@ -45,14 +45,13 @@
 namespace collision_detection
 {
 
-bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void *data)
+namespace
+{
+/* Decide whether the pair (cd1, cd2) needs to be checked at all, based on the active components, the allowed
+   collision matrix and the attached body touch links. If the pair is only conditionally allowed, \e dcf is set
+   to the function that decides on individual contacts. */
+bool needsCollisionCheck(const CollisionData *cdata, const CollisionGeometryData *cd1, const CollisionGeometryData *cd2, DecideContactFn &dcf)
 {
-  CollisionData *cdata = reinterpret_cast<CollisionData*>(data);
-  if (cdata->done_)
-    return true;
-  const CollisionGeometryData *cd1 = static_cast<const CollisionGeometryData*>(o1->collisionGeometry()->getUserData());
-  const CollisionGeometryData *cd2 = static_cast<const CollisionGeometryData*>(o2->collisionGeometry()->getUserData());
-
   // do not collision check geoms part of the same object / link / attached body
   if (cd1->sameObject(*cd2))
     return false;
@@ -70,24 +69,22 @@ bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void
   }
 
   // use the collision matrix (if any) to avoid certain collision checks
-  DecideContactFn dcf;
-  bool always_allow_collision = false;
   if (cdata->acm_)
   {
     AllowedCollision::Type type;
-    bool found = cdata->acm_->getAllowedCollision(cd1->getID(), cd2->getID(), type);
+    bool found = cdata->getAllowedCollision(*cd1, *cd2, type);
     if (found)
     {
       // if we have an entry in the collision matrix, we read it
       if (type == AllowedCollision::ALWAYS)
       {
-        always_allow_collision = true;
         if (cdata->req_->verbose)
           logDebug("Collision between '%s' (type '%s') and '%s' (type '%s') is always allowed. No contacts are computed.",
                    cd1->getID().c_str(),
                    cd1->getTypeString().c_str(),
                    cd2->getID().c_str(),
                    cd2->getTypeString().c_str());
+        return false;
       }
       else
         if (type == AllowedCollision::CONDITIONAL)
@@ -105,10 +102,10 @@ bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void
     const std::set<std::string> &tl = cd2->ptr.ab->getTouchLinks();
     if (tl.find(cd1->getID()) != tl.end())
     {
-      always_allow_collision = true;
       if (cdata->req_->verbose)
         logDebug("Robot link '%s' is allowed to touch attached object '%s'. No contacts are computed.",
                  cd1->getID().c_str(), cd2->getID().c_str());
+      return false;
     }
   }
   else
@@ -117,21 +114,32 @@ bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void
       const std::set<std::string> &tl = cd1->ptr.ab->getTouchLinks();
       if (tl.find(cd2->getID()) != tl.end())
       {
-        always_allow_collision = true;
         if (cdata->req_->verbose)
           logDebug("Robot link '%s' is allowed to touch attached object '%s'. No contacts are computed.",
                    cd2->getID().c_str(), cd1->getID().c_str());
+        return false;
       }
     }
+
   // bodies attached to the same link should not collide
   if (cd1->type == BodyTypes::ROBOT_ATTACHED && cd2->type == BodyTypes::ROBOT_ATTACHED)
-  {
     if (cd1->ptr.ab->getAttachedLink() == cd2->ptr.ab->getAttachedLink())
-      always_allow_collision = true;
-  }
+      return false;
 
-  // if collisions are always allowed, we are done
-  if (always_allow_collision)
+  return true;
+}
+}
+
+bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void *data)
+{
+  CollisionData *cdata = reinterpret_cast<CollisionData*>(data);
+  if (cdata->done_)
+    return true;
+  const CollisionGeometryData *cd1 = static_cast<const CollisionGeometryData*>(o1->collisionGeometry()->getUserData());
+  const CollisionGeometryData *cd2 = static_cast<const CollisionGeometryData*>(o2->collisionGeometry()->getUserData());
+
+  DecideContactFn dcf;
+  if (!needsCollisionCheck(cdata, cd1, cd2, dcf))
     return false;
 
   if (cdata->req_->verbose)
@@ -328,34 +336,270 @@ bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void
   return cdata->done_;
 }
 
+namespace
+{
+/* fcl::CollisionObject only computes its AABB from its current pose; for continuous checks
+   we need the AABB to enclose the whole motion instead */
+struct SweptCollisionObject : public fcl::CollisionObject
+{
+  SweptCollisionObject(const fcl::CollisionObject &other, const fcl::AABB &swept_aabb) : fcl::CollisionObject(other)
+  {
+    aabb = swept_aabb;
+  }
+};
+
+void storeCostSources(CollisionData *cdata, const fcl::CollisionResult &col_result)
+{
+  std::vector<fcl::CostSource> cost_sources;
+  col_result.getCostSources(cost_sources);
+
+  CostSource cs;
+  for (std::size_t i = 0; i < cost_sources.size(); ++i)
+  {
+    fcl2costsource(cost_sources[i], cs);
+    cdata->res_->cost_sources.insert(cs);
+    while (cdata->res_->cost_sources.size() > cdata->req_->max_cost_sources)
+      cdata->res_->cost_sources.erase(--cdata->res_->cost_sources.end());
+  }
+}
+}
+
+bool sweepFCLObject(FCLObject &start, const FCLObject &end, ContinuousCollisionData &cdata)
+{
+  if (start.collision_objects_.size() != end.collision_objects_.size())
+    return false;
+  for (std::size_t i = 0 ; i < start.collision_objects_.size() ; ++i)
+  {
+    const fcl::CollisionObject &o1 = *start.collision_objects_[i];
+    const fcl::CollisionObject &o2 = *end.collision_objects_[i];
+    if (o1.collisionGeometry() != o2.collisionGeometry())
+    {
+      // attached bodies are distinct instances in the two states; they only need to consist of the same shapes
+      const CollisionGeometryData *cd1 = static_cast<const CollisionGeometryData*>(o1.collisionGeometry()->getUserData());
+      const CollisionGeometryData *cd2 = static_cast<const CollisionGeometryData*>(o2.collisionGeometry()->getUserData());
+      if (!cd1 || !cd2 || cd1->type != BodyTypes::ROBOT_ATTACHED || cd2->type != BodyTypes::ROBOT_ATTACHED ||
+          cd1->shape_index != cd2->shape_index || cd1->ptr.ab->getName() != cd2->ptr.ab->getName() ||
+          cd1->ptr.ab->getShapes()[cd1->shape_index] != cd2->ptr.ab->getShapes()[cd2->shape_index])
+        return false;
+    }
+
+    // The body moves with constant linear velocity of its origin and constant angular velocity around
+    // its origin, so it never leaves the box spanned by the two origins, grown by the largest distance
+    // of a point of the body from its origin
+    const fcl::CollisionGeometry &g = *o1.collisionGeometry();
+    fcl::FCL_REAL r = g.aabb_center.length() + g.aabb_radius;
+    fcl::AABB swept(o1.getTranslation(), o2.getTranslation());
+    swept.expand(fcl::Vec3f(r, r, r));
+
+    FCLCollisionObjectPtr swept_obj(new SweptCollisionObject(o1, swept));
+    cdata.end_transforms_[swept_obj.get()] = o2.getTransform();
+    start.collision_objects_[i] = swept_obj;
+  }
+  return true;
+}
+
+bool continuousCollisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void *data)
+{
+  ContinuousCollisionData *cdata = reinterpret_cast<ContinuousCollisionData*>(data);
+  if (cdata->done_)
+    return true;
+  const CollisionGeometryData *cd1 = static_cast<const CollisionGeometryData*>(o1->collisionGeometry()->getUserData());
+  const CollisionGeometryData *cd2 = static_cast<const CollisionGeometryData*>(o2->collisionGeometry()->getUserData());
+
+  DecideContactFn dcf;
+  if (!needsCollisionCheck(cdata, cd1, cd2, dcf))
+    return false;
+
+  if (cdata->req_->verbose)
+    logDebug("Actually checking continuous collisions between %s and %s", cd1->getID().c_str(), cd2->getID().c_str());
+
+  std::map<const fcl::CollisionObject*, fcl::Transform3f>::const_iterator it1 = cdata->end_transforms_.find(o1);
+  std::map<const fcl::CollisionObject*, fcl::Transform3f>::const_iterator it2 = cdata->end_transforms_.find(o2);
+  const fcl::Transform3f &tf1_end = it1 != cdata->end_transforms_.end() ? it1->second : o1->getTransform();
+  const fcl::Transform3f &tf2_end = it2 != cdata->end_transforms_.end() ? it2->second : o2->getTransform();
+
+  // conservative advancement is the efficient solver, but FCL only implements it for meshes and primitive shapes;
+  // octrees and planes fall back to checking a fixed number of intermediate poses
+  fcl::ContinuousCollisionRequest ccd_req;
+  ccd_req.ccd_motion_type = fcl::CCDM_LINEAR;
+  fcl::OBJECT_TYPE t1 = o1->getObjectType();
+  fcl::OBJECT_TYPE t2 = o2->getObjectType();
+  if ((t1 == fcl::OT_BVH || t1 == fcl::OT_GEOM) && (t2 == fcl::OT_BVH || t2 == fcl::OT_GEOM) &&
+      o1->getNodeType() != fcl::GEOM_PLANE && o2->getNodeType() != fcl::GEOM_PLANE)
+    ccd_req.ccd_solver_type = fcl::CCDC_CONSERVATIVE_ADVANCEMENT;
+  else
+  {
+    ccd_req.ccd_solver_type = fcl::CCDC_NAIVE;
+    ccd_req.num_max_iterations = 20;
+  }
+
+  fcl::ContinuousCollisionResult ccd_res;
+  fcl::continuousCollide(o1, tf1_end, o2, tf2_end, ccd_req, ccd_res);
+  if (!ccd_res.is_collide)
+    return false;
+
+  // see if we need to compute a contact
+  std::size_t want_contact_count = 0;
+  if (cdata->req_->contacts && cdata->res_->contact_count < cdata->req_->max_contacts)
+  {
+    const std::pair<std::string, std::string> cp = cd1->getID() < cd2->getID() ?
+      std::make_pair(cd1->getID(), cd2->getID()) : std::make_pair(cd2->getID(), cd1->getID());
+    CollisionResult::ContactMap::const_iterator ct = cdata->res_->contacts.find(cp);
+    std::size_t have = ct != cdata->res_->contacts.end() ? ct->second.size() : 0;
+    if (have < cdata->req_->max_contacts_per_pair)
+      want_contact_count = std::min(cdata->req_->max_contacts_per_pair - have, cdata->req_->max_contacts - cdata->res_->contact_count);
+  }
+
+  if (dcf || want_contact_count > 0 || cdata->req_->cost)
+  {
+    // contacts are computed with a discrete check at the poses of first contact
+    fcl::CollisionResult col_result;
+    std::size_t num_max_contacts = dcf ? std::numeric_limits<size_t>::max() : std::max<std::size_t>(want_contact_count, 1);
+    int num_contacts = fcl::collide(o1->collisionGeometry().get(), ccd_res.contact_tf1, o2->collisionGeometry().get(), ccd_res.contact_tf2,
+                                    fcl::CollisionRequest(num_max_contacts, true, cdata->req_->max_cost_sources, cdata->req_->cost), col_result);
+    if (cdata->req_->cost)
+      storeCostSources(cdata, col_result);
+
+    const std::pair<std::string, std::string> &pc = cd1->getID() < cd2->getID() ?
+      std::make_pair(cd1->getID(), cd2->getID()) : std::make_pair(cd2->getID(), cd1->getID());
+    bool accepted = dcf && num_contacts > 0;
+    for (int i = 0 ; i < num_contacts ; ++i)
+    {
+      Contact c;
+      fcl2contact(col_result.getContact(i), c);
+      if (dcf && dcf(c))
+        continue;
+      accepted = false;
+      if (want_contact_count == 0)
+        break;
+      --want_contact_count;
+      cdata->res_->contacts[pc].push_back(c);
+      cdata->res_->contact_count++;
+    }
+    // conditional contacts can only be evaluated at the time of first contact; if they are all
+    // allowed there, the pair is not considered to be in collision
+    if (accepted)
+    {
+      if (cdata->req_->verbose)
+        logDebug("Contacts between '%s' and '%s' at time %lf are allowed", cd1->getID().c_str(), cd2->getID().c_str(), ccd_res.time_of_contact);
+      return false;
+    }
+  }
+
+  cdata->res_->collision = true;
+  if (cdata->req_->verbose)
+    logInform("Found a continuous collision between '%s' (type '%s') and '%s' (type '%s') at time %lf",
+              cd1->getID().c_str(), cd1->getTypeString().c_str(), cd2->getID().c_str(), cd2->getTypeString().c_str(),
+              ccd_res.time_of_contact);
+
+  if (!cdata->req_->contacts || cdata->res_->contact_count >= cdata->req_->max_contacts)
+    if (!cdata->req_->cost)
+      cdata->done_ = true;
+
+  if (!cdata->done_ && cdata->req_->is_done)
+    cdata->done_ = cdata->req_->is_done(*cdata->res_);
+
+  return cdata->done_;
+}
+
+/* The cache is split in shards, selected by the address of the shape, so threads that create collision geometry
+   for different shapes rarely wait for each other */
 struct FCLShapeCache
 {
-  FCLShapeCache() : clean_count_(0) {}
+  typedef std::map<boost::weak_ptr<const shapes::Shape>, FCLGeometryConstPtr> Map;
 
-  void bumpUseCount(bool force = false)
+  struct Shard
   {
-    clean_count_++;
+    Shard() : clean_count_(0), hits_(0), misses_(0), contended_(0)
+    {
+    }
+
+    void bumpUseCount()
+    {
+      clean_count_++;
+
+      // clean-up for cache (we don't want to keep infinitely large number of weak ptrs stored)
+      if (clean_count_ > MAX_CLEAN_COUNT)
+        removeExpired();
+    }
 
-    // clean-up for cache (we don't want to keep infinitely large number of weak ptrs stored)
-    if (clean_count_ > MAX_CLEAN_COUNT || force)
+    /* Remove the entries for shapes that no longer exist; the lock must be held */
+    void removeExpired()
     {
       clean_count_ = 0;
-      unsigned int from = map_.size();
-      for (std::map<boost::weak_ptr<const shapes::Shape>, FCLGeometryConstPtr>::iterator it = map_.begin() ; it != map_.end() ; )
+      for (Map::iterator it = map_.begin() ; it != map_.end() ; )
       {
-        std::map<boost::weak_ptr<const shapes::Shape>, FCLGeometryConstPtr>::iterator nit = it; ++nit;
+        Map::iterator nit = it; ++nit;
         if (it->first.expired())
           map_.erase(it);
         it = nit;
       }
-      //      logDebug("Cleaning up cache for FCL objects that correspond to static shapes. Cache size reduced from %u to %u", from, (unsigned int)map_.size());
+    }
+
+    Map          map_;
+    unsigned int clean_count_;
+
+    std::size_t  hits_;
+    std::size_t  misses_;
+    std::size_t  contended_;
+    boost::mutex lock_;
+  };
+
+  /* Holds the lock of a shard, counting the access as contended if the lock was held by another thread */
+  class ShardLock
+  {
+  public:
+    ShardLock(Shard &shard) : lock_(shard.lock_, boost::try_to_lock)
+    {
+      if (!lock_.owns_lock())
+      {
+        lock_.lock();
+        shard.contended_++;
+      }
+    }
+
+  private:
+    boost::mutex::scoped_lock lock_;
+  };
+
+  Shard& getShard(const shapes::ShapeConstPtr &shape)
+  {
+    // shapes are heap allocated, so the lowest bits of their addresses carry little information
+    std::size_t h = reinterpret_cast<std::size_t>(shape.get());
+    return shards_[((h >> 4) ^ (h >> 12)) % SHARD_COUNT];
+  }
+
+  void addStatistics(CollisionGeometryCacheStatistics &stats)
+  {
+    for (std::size_t i = 0 ; i < SHARD_COUNT ; ++i)
+    {
+      boost::mutex::scoped_lock slock(shards_[i].lock_);
+      stats.hits_ += shards_[i].hits_;
+      stats.misses_ += shards_[i].misses_;
+      stats.contended_ += shards_[i].contended_;
+      stats.entries_ += shards_[i].map_.size();
+    }
+  }
+
+  void remove(const shapes::ShapeConstPtr &shape)
+  {
+    Shard &shard = getShard(shape);
+    boost::mutex::scoped_lock slock(shard.lock_);
+    shard.map_.erase(boost::weak_ptr<const shapes::Shape>(shape));
+  }
+
+  void clean()
+  {
+    for (std::size_t i = 0 ; i < SHARD_COUNT ; ++i)
+    {
+      boost::mutex::scoped_lock slock(shards_[i].lock_);
+      shards_[i].removeExpired();
     }
   }
 
-  static const unsigned int MAX_CLEAN_COUNT = 100; // every this many uses of the cache, a cleaning operation is executed (this is only removal of expired entries)
-  std::map<boost::weak_ptr<const shapes::Shape>, FCLGeometryConstPtr> map_;
-  unsigned int clean_count_;
-  boost::mutex lock_;
+  static const std::size_t SHARD_COUNT = 16;
+  static const unsigned int MAX_CLEAN_COUNT = 100; // every this many uses of a shard, a cleaning operation is executed (this is only removal of expired entries)
+  Shard shards_[SHARD_COUNT];
 };
 
 
@@ -391,7 +635,7 @@ bool distanceCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void*
   {
     AllowedCollision::Type type;
 
-    bool found = cdata->acm_->getAllowedCollision(cd1->getID(), cd2->getID(), type);
+    bool found = cdata->getAllowedCollision(*cd1, *cd2, type);
     if (found)
     {
       // if we have an entry in the collision matrix, we read it
@@ -484,17 +728,18 @@ struct IfSameType<T, T>
 template<typename BV, typename T>
 FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr &shape, const T *data, int shape_index)
 {
-  FCLShapeCache &cache = GetShapeCache<BV, T>();
+  FCLShapeCache::Shard &shard = GetShapeCache<BV, T>().getShard(shape);
 
   boost::weak_ptr<const shapes::Shape> wptr(shape);
   {
-    boost::mutex::scoped_lock slock(cache.lock_);
-    std::map<boost::weak_ptr<const shapes::Shape>, FCLGeometryConstPtr>::const_iterator cache_it = cache.map_.find(wptr);
-    if (cache_it != cache.map_.end())
+    FCLShapeCache::ShardLock slock(shard);
+    FCLShapeCache::Map::const_iterator cache_it = shard.map_.find(wptr);
+    if (cache_it != shard.map_.end())
     {
       if (cache_it->second->collision_geometry_data_->ptr.raw == (void*)data)
       {
         //        logDebug("Collision data structures for object %s retrieved from cache.", cache_it->second->collision_geometry_data_->getID().c_str());
+        shard.hits_++;
         return cache_it->second;
       }
       else
@@ -502,81 +747,52 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr &shape,
         {
           const_cast<FCLGeometry*>(cache_it->second.get())->updateCollisionGeometryData(data, shape_index, false);
           //          logDebug("Collision data structures for object %s retrieved from cache after updating the source object.", cache_it->second->collision_geometry_data_->getID().c_str());
+          shard.hits_++;
           return cache_it->second;
         }
     }
   }
 
-  // attached objects could have previously been World::Object; we try to move them
-  // from their old cache to the new one, if possible. the code is not pretty, but should help
-  // when we attach/detach objects that are in the world
+  // attached objects could have previously been World::Object and world objects could have previously been attached
+  // objects; we try to move them from their old cache to the new one, if possible. this helps when we attach/detach
+  // objects that are in the world
+  FCLShapeCache::Shard *other_shard = NULL;
   if (IfSameType<T, robot_state::AttachedBody>::value == 1)
-  {
-    // get the cache that corresponds to objects; maybe this attached object used to be a world object
-    FCLShapeCache &othercache = GetShapeCache<BV, World::Object>();
+    other_shard = &GetShapeCache<BV, World::Object>().getShard(shape);
+  else
+    if (IfSameType<T, World::Object>::value == 1)
+      other_shard = &GetShapeCache<BV, robot_state::AttachedBody>().getShard(shape);
 
-    // attached bodies could be just moved from the environment.
-    othercache.lock_.lock(); // lock manually to avoid having 2 simultaneous locks active (avoids possible deadlock)
-    std::map<boost::weak_ptr<const shapes::Shape>, FCLGeometryConstPtr>::iterator cache_it = othercache.map_.find(wptr);
-    if (cache_it != othercache.map_.end())
+  if (other_shard)
+  {
+    FCLGeometryConstPtr obj_cache;
     {
-      if (cache_it->second.unique())
+      // only one shard is locked at a time (avoids possible deadlock)
+      FCLShapeCache::ShardLock slock(*other_shard);
+      FCLShapeCache::Map::iterator cache_it = other_shard->map_.find(wptr);
+      if (cache_it != other_shard->map_.end() && cache_it->second.unique())
       {
         // remove from old cache
-        FCLGeometryConstPtr obj_cache = cache_it->second;
-        othercache.map_.erase(cache_it);
-        othercache.lock_.unlock();
-
-        // update the CollisionGeometryData; nobody has a pointer to this, so we can safely modify it
-        const_cast<FCLGeometry*>(obj_cache.get())->updateCollisionGeometryData(data, shape_index, true);
-
-        //        logDebug("Collision data structures for attached body %s retrieved from the cache for world objects.", obj_cache->collision_geometry_data_->getID().c_str());
-
-        // add to the new cache
-        boost::mutex::scoped_lock slock(cache.lock_);
-        cache.map_[wptr] = obj_cache;
-        cache.bumpUseCount();
-        return obj_cache;
+        obj_cache = cache_it->second;
+        other_shard->map_.erase(cache_it);
       }
     }
-    othercache.lock_.unlock();
-  }
-  else
-    // world objects could have previously been attached objects; we try to move them
-    // from their old cache to the new one, if possible. the code is not pretty, but should help
-    // when we attach/detach objects that are in the world
-    if (IfSameType<T, World::Object>::value == 1)
+
+    if (obj_cache)
     {
-      // get the cache that corresponds to objects; maybe this attached object used to be a world object
-      FCLShapeCache &othercache = GetShapeCache<BV, robot_state::AttachedBody>();
+      // update the CollisionGeometryData; nobody has a pointer to this, so we can safely modify it
+      const_cast<FCLGeometry*>(obj_cache.get())->updateCollisionGeometryData(data, shape_index, true);
 
-      // attached bodies could be just moved from the environment.
-      othercache.lock_.lock(); // lock manually to avoid having 2 simultaneous locks active (avoids possible deadlock)
-      std::map<boost::weak_ptr<const shapes::Shape>, FCLGeometryConstPtr>::iterator cache_it = othercache.map_.find(wptr);
-      if (cache_it != othercache.map_.end())
-      {
-        if (cache_it->second.unique())
-        {
-          // remove from old cache
-          FCLGeometryConstPtr obj_cache = cache_it->second;
-          othercache.map_.erase(cache_it);
-          othercache.lock_.unlock();
-
-          // update the CollisionGeometryData; nobody has a pointer to this, so we can safely modify it
-          const_cast<FCLGeometry*>(obj_cache.get())->updateCollisionGeometryData(data, shape_index, true);
-
-          //          logDebug("Collision data structures for world object %s retrieved from the cache for attached bodies.",
-          //                   obj_cache->collision_geometry_data_->getID().c_str());
-
-          // add to the new cache
-          boost::mutex::scoped_lock slock(cache.lock_);
-          cache.map_[wptr] = obj_cache;
-          cache.bumpUseCount();
-          return obj_cache;
-        }
-      }
-      othercache.lock_.unlock();
+      //      logDebug("Collision data structures for %s retrieved from the cache of the other body type.", obj_cache->collision_geometry_data_->getID().c_str());
+
+      // add to the new cache
+      FCLShapeCache::ShardLock slock(shard);
+      shard.map_[wptr] = obj_cache;
+      shard.hits_++;
+      shard.bumpUseCount();
+      return obj_cache;
     }
+  }
 
   fcl::CollisionGeometry* cg_g = NULL;
   if (shape->type == shapes::PLANE) // shapes that directly produce CollisionGeometry
@@ -659,9 +875,10 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr &shape,
   {
     cg_g->computeLocalAABB();
     FCLGeometryConstPtr res(new FCLGeometry(cg_g, data, shape_index));
-    boost::mutex::scoped_lock slock(cache.lock_);
-    cache.map_[wptr] = res;
-    cache.bumpUseCount();
+    FCLShapeCache::ShardLock slock(shard);
+    shard.map_[wptr] = res;
+    shard.misses_++;
+    shard.bumpUseCount();
     return res;
   }
   return FCLGeometryConstPtr();
@@ -722,16 +939,23 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr &shape,
 
 void cleanCollisionGeometryCache()
 {
-  FCLShapeCache &cache1 = GetShapeCache<fcl::OBBRSS, World::Object>();
-  {
-    boost::mutex::scoped_lock slock(cache1.lock_);
-    cache1.bumpUseCount(true);
-  }
-  FCLShapeCache &cache2 = GetShapeCache<fcl::OBBRSS, robot_state::AttachedBody>();
-  {
-    boost::mutex::scoped_lock slock(cache2.lock_);
-    cache2.bumpUseCount(true);
-  }
+  GetShapeCache<fcl::OBBRSS, World::Object>().clean();
+  GetShapeCache<fcl::OBBRSS, robot_state::AttachedBody>().clean();
+}
+
+void removeCollisionGeometryFromCache(const World::Object *obj)
+{
+  for (std::size_t i = 0 ; i < obj->shapes_.size() ; ++i)
+    GetShapeCache<fcl::OBBRSS, World::Object>().remove(obj->shapes_[i]);
+}
+
+CollisionGeometryCacheStatistics getCollisionGeometryCacheStatistics()
+{
+  CollisionGeometryCacheStatistics stats;
+  GetShapeCache<fcl::OBBRSS, robot_model::LinkModel>().addStatistics(stats);
+  GetShapeCache<fcl::OBBRSS, robot_state::AttachedBody>().addStatistics(stats);
+  GetShapeCache<fcl::OBBRSS, World::Object>().addStatistics(stats);
+  return stats;
 }
 
 }
@@ -742,6 +966,8 @@ void collision_detection::CollisionData::enableGroup(const robot_model::RobotMod
     active_components_only_ = &kmodel->getJointModelGroup(req_->group_name)->getUpdatedLinkModelsSet();
   else
     active_components_only_ = NULL;
+  if (acm_)
+    compiled_acm_ = acm_->getCompiled(kmodel);
 }
 
 void collision_detection::FCLObject::registerTo(fcl::BroadPhaseCollisionManager *manager)
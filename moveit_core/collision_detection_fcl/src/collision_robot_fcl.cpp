@@ -35,9 +35,26 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/collision_detection_fcl/collision_robot_fcl.h>
+#include <boost/thread/mutex.hpp>
+
+namespace
+{
+/* Identifies the collision data this class stores with attached bodies */
+const robot_state::AttachedBody::CollisionCacheKey FCL_ATTACHED_BODY_CACHE("collision_detection::CollisionRobotFCL");
+
+/* Geometry versions are unique across all instances, so a structure can never be mistaken for one built
+   from other geometry */
+unsigned int nextGeometryVersion()
+{
+  static boost::mutex lock;
+  static unsigned int version = 0;
+  boost::mutex::scoped_lock slock(lock);
+  return ++version;
+}
+}
 
 collision_detection::CollisionRobotFCL::CollisionRobotFCL(const robot_model::RobotModelConstPtr &model, double padding, double scale)
-  : CollisionRobot(model, padding, scale)
+  : CollisionRobot(model, padding, scale), geoms_version_(nextGeometryVersion()), persistent_broadphase_(true)
 {
   const std::vector<const robot_model::LinkModel*>& links = robot_model_->getLinkModelsWithCollisionGeometry();
   std::size_t index;
@@ -68,17 +85,34 @@ collision_detection::CollisionRobotFCL::CollisionRobotFCL(const CollisionRobotFC
 {
   geoms_ = other.geoms_;
   fcl_objs_ = other.fcl_objs_;
+  geoms_version_ = other.geoms_version_;
+  persistent_broadphase_ = other.persistent_broadphase_;
 }
 
-void collision_detection::CollisionRobotFCL::getAttachedBodyObjects(const robot_state::AttachedBody *ab, std::vector<FCLGeometryConstPtr> &geoms) const
+boost::shared_ptr<const collision_detection::CollisionRobotFCL::AttachedBodyObjects>
+collision_detection::CollisionRobotFCL::getAttachedBodyObjects(const robot_state::AttachedBody *ab) const
 {
-  const std::vector<shapes::ShapeConstPtr> &shapes = ab->getShapes();
+  boost::shared_ptr<const AttachedBodyObjects> objs =
+    boost::static_pointer_cast<const AttachedBodyObjects>(ab->getCollisionCache(FCL_ATTACHED_BODY_CACHE));
+  if (objs)
+    return objs;
+
+  // the cached objects are shared by all copies of ab, so the geometry refers to a private copy of the body
+  boost::shared_ptr<AttachedBodyObjects> new_objs(new AttachedBodyObjects());
+  new_objs->body_.reset(new robot_state::AttachedBody(*ab));
+  const std::vector<shapes::ShapeConstPtr> &shapes = new_objs->body_->getShapes();
   for (std::size_t i = 0 ; i < shapes.size() ; ++i)
   {
-    FCLGeometryConstPtr co = createCollisionGeometry(shapes[i], ab, i);
-    if (co)
-      geoms.push_back(co);
+    FCLGeometryConstPtr g = createCollisionGeometry(shapes[i], new_objs->body_.get(), i);
+    if (g && g->collision_geometry_)
+    {
+      new_objs->geoms_.push_back(g);
+      new_objs->objects_.push_back(FCLCollisionObjectPtr(new fcl::CollisionObject(g->collision_geometry_)));
+      new_objs->shape_index_.push_back(i);
+    }
   }
+  ab->setCollisionCache(FCL_ATTACHED_BODY_CACHE, new_objs);
+  return new_objs;
 }
 
 void collision_detection::CollisionRobotFCL::constructFCLObject(const robot_state::RobotState &state, FCLObject &fcl_obj) const
@@ -95,24 +129,30 @@ void collision_detection::CollisionRobotFCL::constructFCLObject(const robot_stat
       collObj->computeAABB();
       fcl_obj.collision_objects_.push_back(FCLCollisionObjectPtr(collObj));
     }
-  
-  // TODO: Implement a method for caching fcl::CollisionObject's for robot_state::AttachedBody's
+
+  constructAttachedBodyObjects(state, fcl_obj);
+}
+
+void collision_detection::CollisionRobotFCL::constructAttachedBodyObjects(const robot_state::RobotState &state, FCLObject &fcl_obj) const
+{
+  fcl::Transform3f fcl_tf;
+
   std::vector<const robot_state::AttachedBody*> ab;
   state.getAttachedBodies(ab);
   for (std::size_t j = 0 ; j < ab.size() ; ++j)
   {
-    std::vector<FCLGeometryConstPtr> objs;
-    getAttachedBodyObjects(ab[j], objs);
+    boost::shared_ptr<const AttachedBodyObjects> objs = getAttachedBodyObjects(ab[j]);
     const EigenSTL::vector_Affine3d &ab_t = ab[j]->getGlobalCollisionBodyTransforms();
-    for (std::size_t k = 0 ; k < objs.size() ; ++k)
-      if (objs[k]->collision_geometry_)
-      {
-        transform2fcl(ab_t[k], fcl_tf);
-        fcl_obj.collision_objects_.push_back(FCLCollisionObjectPtr(new fcl::CollisionObject(objs[k]->collision_geometry_, fcl_tf)));
-        // we copy the shared ptr to the CollisionGeometryData, as this is not stored by the class itself,
-        // and would be destroyed when objs goes out of scope.
-        fcl_obj.collision_geometry_.push_back(objs[k]);
-      }
+    for (std::size_t k = 0 ; k < objs->objects_.size() ; ++k)
+    {
+      transform2fcl(ab_t[objs->shape_index_[k]], fcl_tf);
+      fcl::CollisionObject *collObj = new fcl::CollisionObject(*objs->objects_[k]);
+      collObj->setTransform(fcl_tf);
+      collObj->computeAABB();
+      fcl_obj.collision_objects_.push_back(FCLCollisionObjectPtr(collObj));
+      // we copy the shared ptr to the CollisionGeometryData, so it stays valid even if the body drops its cache
+      fcl_obj.collision_geometry_.push_back(objs->geoms_[k]);
+    }
   }
 }
 
@@ -126,6 +166,89 @@ void collision_detection::CollisionRobotFCL::allocSelfCollisionBroadPhase(const
   // manager.manager_->update();
 }
 
+collision_detection::FCLManager* collision_detection::CollisionRobotFCL::getSelfCollisionBroadPhase(const robot_state::RobotState &state, SelfCollisionQuery &query) const
+{
+  if (!persistent_broadphase_)
+  {
+    allocSelfCollisionBroadPhase(state, query.scratch_);
+    return &query.scratch_;
+  }
+
+  {
+    boost::mutex::scoped_lock slock(broadphase_pool_lock_);
+    if (!broadphase_pool_.empty())
+    {
+      query.broadphase_ = broadphase_pool_.back();
+      broadphase_pool_.pop_back();
+    }
+  }
+
+  SelfCollisionBroadPhase *bp = query.broadphase_.get();
+  if (!bp || bp->version_ != geoms_version_)
+  {
+    // (re)build the structure; this only happens once per concurrent query, unless padding or scaling change
+    bp = new SelfCollisionBroadPhase();
+    query.broadphase_.reset(bp);
+    bp->version_ = geoms_version_;
+    bp->manager_.manager_.reset(new fcl::DynamicAABBTreeCollisionManager());
+    bp->manager_.object_.collision_objects_.reserve(geoms_.size());
+    fcl::Transform3f fcl_tf;
+    for (std::size_t i = 0 ; i < geoms_.size() ; ++i)
+      if (geoms_[i] && geoms_[i]->collision_geometry_)
+      {
+        const Eigen::Affine3d &pose = state.getCollisionBodyTransform(geoms_[i]->collision_geometry_data_->ptr.link, geoms_[i]->collision_geometry_data_->shape_index);
+        transform2fcl(pose, fcl_tf);
+        fcl::CollisionObject *collObj = new fcl::CollisionObject(*fcl_objs_[i]);
+        collObj->setTransform(fcl_tf);
+        collObj->computeAABB();
+        bp->manager_.object_.collision_objects_.push_back(FCLCollisionObjectPtr(collObj));
+        bp->geom_index_.push_back(i);
+        bp->poses_.push_back(pose);
+      }
+    bp->manager_.object_.registerTo(bp->manager_.manager_.get());
+  }
+  else
+  {
+    // only refit the objects that moved since this structure was last used
+    std::vector<fcl::CollisionObject*> updated;
+    fcl::Transform3f fcl_tf;
+    for (std::size_t i = 0 ; i < bp->geom_index_.size() ; ++i)
+    {
+      const FCLGeometryConstPtr &g = geoms_[bp->geom_index_[i]];
+      const Eigen::Affine3d &pose = state.getCollisionBodyTransform(g->collision_geometry_data_->ptr.link, g->collision_geometry_data_->shape_index);
+      if (pose.matrix() == bp->poses_[i].matrix())
+        continue;
+      bp->poses_[i] = pose;
+      transform2fcl(pose, fcl_tf);
+      fcl::CollisionObject *collObj = bp->manager_.object_.collision_objects_[i].get();
+      collObj->setTransform(fcl_tf);
+      collObj->computeAABB();
+      updated.push_back(collObj);
+    }
+    if (!updated.empty())
+      bp->manager_.manager_->update(updated);
+  }
+
+  // attached bodies change from one state to the next, so they are registered for the duration of one query only
+  constructAttachedBodyObjects(state, query.scratch_.object_);
+  query.scratch_.object_.registerTo(bp->manager_.manager_.get());
+  return &bp->manager_;
+}
+
+void collision_detection::CollisionRobotFCL::releaseSelfCollisionBroadPhase(SelfCollisionQuery &query) const
+{
+  if (!query.broadphase_)
+    return;
+  query.scratch_.object_.unregisterFrom(query.broadphase_->manager_.manager_.get());
+  query.scratch_.object_.clear();
+  if (query.broadphase_->version_ == geoms_version_)
+  {
+    boost::mutex::scoped_lock slock(broadphase_pool_lock_);
+    broadphase_pool_.push_back(query.broadphase_);
+  }
+  query.broadphase_.reset();
+}
+
 void collision_detection::CollisionRobotFCL::checkSelfCollision(const CollisionRequest &req, CollisionResult &res, const robot_state::RobotState &state) const
 {
   checkSelfCollisionHelper(req, res, state, NULL);
@@ -139,22 +262,51 @@ void collision_detection::CollisionRobotFCL::checkSelfCollision(const CollisionR
 
 void collision_detection::CollisionRobotFCL::checkSelfCollision(const CollisionRequest &req, CollisionResult &res, const robot_state::RobotState &state1, const robot_state::RobotState &state2) const
 {
-  logError("FCL continuous collision checking not yet implemented");
+  checkSelfCollisionHelper(req, res, state1, state2, NULL);
 }
 
 void collision_detection::CollisionRobotFCL::checkSelfCollision(const CollisionRequest &req, CollisionResult &res, const robot_state::RobotState &state1, const robot_state::RobotState &state2, const AllowedCollisionMatrix &acm) const
 {
-  logError("FCL continuous collision checking not yet implemented");
+  checkSelfCollisionHelper(req, res, state1, state2, &acm);
+}
+
+bool collision_detection::CollisionRobotFCL::constructSweptFCLObject(const robot_state::RobotState &state1, const robot_state::RobotState &state2,
+                                                                     FCLObject &fcl_obj, ContinuousCollisionData &cd) const
+{
+  FCLObject fcl_obj2;
+  constructFCLObject(state1, fcl_obj);
+  constructFCLObject(state2, fcl_obj2);
+  if (!sweepFCLObject(fcl_obj, fcl_obj2, cd))
+  {
+    logError("Continuous collision checking requires the same bodies to be attached to the robot at the start and end of the motion");
+    return false;
+  }
+  return true;
+}
+
+void collision_detection::CollisionRobotFCL::checkSelfCollisionHelper(const CollisionRequest &req, CollisionResult &res, const robot_state::RobotState &state1,
+                                                                      const robot_state::RobotState &state2, const AllowedCollisionMatrix *acm) const
+{
+  ContinuousCollisionData cd(&req, &res, acm);
+  FCLObject fcl_obj;
+  if (!constructSweptFCLObject(state1, state2, fcl_obj, cd))
+    return;
+  cd.enableGroup(getRobotModel());
+
+  fcl::DynamicAABBTreeCollisionManager manager;
+  fcl_obj.registerTo(&manager);
+  manager.collide(&cd, &continuousCollisionCallback);
 }
 
 void collision_detection::CollisionRobotFCL::checkSelfCollisionHelper(const CollisionRequest &req, CollisionResult &res, const robot_state::RobotState &state,
                                                                       const AllowedCollisionMatrix *acm) const
 {
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
+  SelfCollisionQuery query;
+  FCLManager *manager = getSelfCollisionBroadPhase(state, query);
   CollisionData cd(&req, &res, acm);
   cd.enableGroup(getRobotModel());
-  manager.manager_->collide(&cd, &collisionCallback);
+  manager->manager_->collide(&cd, &collisionCallback);
+  releaseSelfCollisionBroadPhase(query);
   if (req.distance)
     res.distance = distanceSelfHelper(state, acm);
 }
@@ -175,22 +327,44 @@ void collision_detection::CollisionRobotFCL::checkOtherCollision(const Collision
 void collision_detection::CollisionRobotFCL::checkOtherCollision(const CollisionRequest &req, CollisionResult &res, const robot_state::RobotState &state1, const robot_state::RobotState &state2,
                                                                  const CollisionRobot &other_robot, const robot_state::RobotState &other_state1, const robot_state::RobotState &other_state2) const
 {
-  logError("FCL continuous collision checking not yet implemented");
+  checkOtherCollisionHelper(req, res, state1, state2, other_robot, other_state1, other_state2, NULL);
 }
 
 void collision_detection::CollisionRobotFCL::checkOtherCollision(const CollisionRequest &req, CollisionResult &res, const robot_state::RobotState &state1, const robot_state::RobotState &state2,
                                                                  const CollisionRobot &other_robot, const robot_state::RobotState &other_state1, const robot_state::RobotState &other_state2,
                                                                  const AllowedCollisionMatrix &acm) const
 {
-  logError("FCL continuous collision checking not yet implemented");
+  checkOtherCollisionHelper(req, res, state1, state2, other_robot, other_state1, other_state2, &acm);
+}
+
+void collision_detection::CollisionRobotFCL::checkOtherCollisionHelper(const CollisionRequest &req, CollisionResult &res, const robot_state::RobotState &state1,
+                                                                       const robot_state::RobotState &state2, const CollisionRobot &other_robot,
+                                                                       const robot_state::RobotState &other_state1, const robot_state::RobotState &other_state2,
+                                                                       const AllowedCollisionMatrix *acm) const
+{
+  ContinuousCollisionData cd(&req, &res, acm);
+  FCLObject fcl_obj;
+  if (!constructSweptFCLObject(state1, state2, fcl_obj, cd))
+    return;
+
+  const CollisionRobotFCL &fcl_rob = dynamic_cast<const CollisionRobotFCL&>(other_robot);
+  FCLObject other_fcl_obj;
+  if (!fcl_rob.constructSweptFCLObject(other_state1, other_state2, other_fcl_obj, cd))
+    return;
+  cd.enableGroup(getRobotModel());
+
+  fcl::DynamicAABBTreeCollisionManager manager;
+  fcl_obj.registerTo(&manager);
+  for (std::size_t i = 0 ; !cd.done_ && i < other_fcl_obj.collision_objects_.size() ; ++i)
+    manager.collide(other_fcl_obj.collision_objects_[i].get(), &cd, &continuousCollisionCallback);
 }
 
 void collision_detection::CollisionRobotFCL::checkOtherCollisionHelper(const CollisionRequest &req, CollisionResult &res, const robot_state::RobotState &state,
                                                                        const CollisionRobot &other_robot, const robot_state::RobotState &other_state,
                                                                        const AllowedCollisionMatrix *acm) const
 {
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
+  SelfCollisionQuery query;
+  FCLManager *manager = getSelfCollisionBroadPhase(state, query);
 
   const CollisionRobotFCL &fcl_rob = dynamic_cast<const CollisionRobotFCL&>(other_robot);
   FCLObject other_fcl_obj;
@@ -199,7 +373,8 @@ void collision_detection::CollisionRobotFCL::checkOtherCollisionHelper(const Col
   CollisionData cd(&req, &res, acm);
   cd.enableGroup(getRobotModel());
   for (std::size_t i = 0 ; !cd.done_ && i < other_fcl_obj.collision_objects_.size() ; ++i)
-    manager.manager_->collide(other_fcl_obj.collision_objects_[i].get(), &cd, &collisionCallback);
+    manager->manager_->collide(other_fcl_obj.collision_objects_[i].get(), &cd, &collisionCallback);
+  releaseSelfCollisionBroadPhase(query);
   if (req.distance)
     res.distance = distanceOtherHelper(state, other_robot, other_state, acm);
 }
@@ -226,6 +401,11 @@ void collision_detection::CollisionRobotFCL::updatedPaddingOrScaling(const std::
     else
       logError("Updating padding or scaling for unknown link: '%s'", links[i].c_str());
   }
+  geoms_version_ = nextGeometryVersion();
+
+  // structures built for the old geometry can not be reused
+  boost::mutex::scoped_lock slock(broadphase_pool_lock_);
+  broadphase_pool_.clear();
 }
 
 double collision_detection::CollisionRobotFCL::distanceSelf(const robot_state::RobotState &state) const
@@ -242,15 +422,16 @@ double collision_detection::CollisionRobotFCL::distanceSelf(const robot_state::R
 double collision_detection::CollisionRobotFCL::distanceSelfHelper(const robot_state::RobotState &state,
                                                                   const AllowedCollisionMatrix *acm) const
 {
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
+  SelfCollisionQuery query;
+  FCLManager *manager = getSelfCollisionBroadPhase(state, query);
 
   CollisionRequest req;
   CollisionResult res;
   CollisionData cd(&req, &res, acm);
   cd.enableGroup(getRobotModel());
 
-  manager.manager_->distance(&cd, &distanceCallback);
+  manager->manager_->distance(&cd, &distanceCallback);
+  releaseSelfCollisionBroadPhase(query);
 
   return res.distance;
 }
@@ -275,8 +456,8 @@ double collision_detection::CollisionRobotFCL::distanceOtherHelper(const robot_s
                                                                    const robot_state::RobotState &other_state,
                                                                    const AllowedCollisionMatrix *acm) const
 {
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
+  SelfCollisionQuery query;
+  FCLManager *manager = getSelfCollisionBroadPhase(state, query);
 
   const CollisionRobotFCL& fcl_rob = dynamic_cast<const CollisionRobotFCL&>(other_robot);
   FCLObject other_fcl_obj;
@@ -287,7 +468,8 @@ double collision_detection::CollisionRobotFCL::distanceOtherHelper(const robot_s
   CollisionData cd(&req, &res, acm);
   cd.enableGroup(getRobotModel());
   for(std::size_t i = 0; !cd.done_ && i < other_fcl_obj.collision_objects_.size(); ++i)
-    manager.manager_->distance(other_fcl_obj.collision_objects_[i].get(), &cd, &distanceCallback);
+    manager->manager_->distance(other_fcl_obj.collision_objects_[i].get(), &cd, &distanceCallback);
+  releaseSelfCollisionBroadPhase(query);
 
   return res.distance;
 }
@@ -42,7 +42,7 @@
 #include <boost/bind.hpp>
 
 collision_detection::CollisionWorldFCL::CollisionWorldFCL() :
-  CollisionWorld()
+  CollisionWorld(), update_depth_(0)
 {
   fcl::DynamicAABBTreeCollisionManager* m = new fcl::DynamicAABBTreeCollisionManager();
   // m->tree_init_level = 2;
@@ -53,7 +53,7 @@ collision_detection::CollisionWorldFCL::CollisionWorldFCL() :
 }
 
 collision_detection::CollisionWorldFCL::CollisionWorldFCL(const WorldPtr& world) :
-  CollisionWorld(world)
+  CollisionWorld(world), update_depth_(0)
 {
   fcl::DynamicAABBTreeCollisionManager* m = new fcl::DynamicAABBTreeCollisionManager();
   // m->tree_init_level = 2;
@@ -65,7 +65,7 @@ collision_detection::CollisionWorldFCL::CollisionWorldFCL(const WorldPtr& world)
 }
 
 collision_detection::CollisionWorldFCL::CollisionWorldFCL(const CollisionWorldFCL &other, const WorldPtr& world) :
-  CollisionWorld(other, world)
+  CollisionWorld(other, world), update_depth_(0)
 {
   fcl::DynamicAABBTreeCollisionManager* m = new fcl::DynamicAABBTreeCollisionManager();
   // m->tree_init_level = 2;
@@ -97,12 +97,27 @@ void collision_detection::CollisionWorldFCL::checkRobotCollision(const Collision
 
 void collision_detection::CollisionWorldFCL::checkRobotCollision(const CollisionRequest &req, CollisionResult &res, const CollisionRobot &robot, const robot_state::RobotState &state1, const robot_state::RobotState &state2) const
 {
-  logError("FCL continuous collision checking not yet implemented");
+  checkRobotCollisionHelper(req, res, robot, state1, state2, NULL);
 }
 
 void collision_detection::CollisionWorldFCL::checkRobotCollision(const CollisionRequest &req, CollisionResult &res, const CollisionRobot &robot, const robot_state::RobotState &state1, const robot_state::RobotState &state2, const AllowedCollisionMatrix &acm) const
 {
-  logError("FCL continuous collision checking not yet implemented");
+  checkRobotCollisionHelper(req, res, robot, state1, state2, &acm);
+}
+
+void collision_detection::CollisionWorldFCL::checkRobotCollisionHelper(const CollisionRequest &req, CollisionResult &res, const CollisionRobot &robot, const robot_state::RobotState &state1,
+                                                                       const robot_state::RobotState &state2, const AllowedCollisionMatrix *acm) const
+{
+  const CollisionRobotFCL &robot_fcl = dynamic_cast<const CollisionRobotFCL&>(robot);
+  ContinuousCollisionData cd(&req, &res, acm);
+  FCLObject fcl_obj;
+  if (!robot_fcl.constructSweptFCLObject(state1, state2, fcl_obj, cd))
+    return;
+  cd.enableGroup(robot.getRobotModel());
+
+  // world objects have no entry in cd.end_transforms_, so they are considered static
+  for (std::size_t i = 0 ; !cd.done_ && i < fcl_obj.collision_objects_.size() ; ++i)
+    manager_->collide(fcl_obj.collision_objects_[i].get(), &cd, &continuousCollisionCallback);
 }
 
 void collision_detection::CollisionWorldFCL::checkRobotCollisionHelper(const CollisionRequest &req, CollisionResult &res, const CollisionRobot &robot, const robot_state::RobotState &state, const AllowedCollisionMatrix *acm) const
@@ -200,6 +215,7 @@ void collision_detection::CollisionWorldFCL::setWorld(const WorldPtr& world)
   // clear out objects from old world
   manager_->clear();
   fcl_objs_.clear();
+  pending_changes_.clear();
   cleanCollisionGeometryCache();
 
   CollisionWorld::setWorld(world);
@@ -211,8 +227,76 @@ void collision_detection::CollisionWorldFCL::setWorld(const WorldPtr& world)
   getWorld()->notifyObserverAllObjects(observer_handle_, World::CREATE);
 }
 
+bool collision_detection::CollisionWorldFCL::moveFCLObject(const World::Object *obj, std::vector<fcl::CollisionObject*> &moved)
+{
+  std::map<std::string, FCLObject>::iterator jt = fcl_objs_.find(obj->id_);
+  if (jt == fcl_objs_.end())
+    return false;
+  FCLObject &fcl_obj = jt->second;
+
+  // the existing geometry can only be reused if it was constructed for every shape of this instance of the object
+  if (fcl_obj.collision_objects_.size() != obj->shapes_.size())
+    return false;
+  for (std::size_t i = 0 ; i < fcl_obj.collision_geometry_.size() ; ++i)
+    if (fcl_obj.collision_geometry_[i]->collision_geometry_data_->ptr.obj != obj)
+      return false;
+
+  for (std::size_t i = 0 ; i < fcl_obj.collision_objects_.size() ; ++i)
+  {
+    FCLCollisionObjectPtr &co = fcl_obj.collision_objects_[i];
+    if (co.unique())
+    {
+      co->setTransform(transform2fcl(obj->shape_poses_[i]));
+      co->computeAABB();
+      moved.push_back(co.get());
+    }
+    else
+    {
+      // the object is shared with a copy of this world, so a new one is needed; the geometry is still shared
+      manager_->unregisterObject(co.get());
+      co.reset(new fcl::CollisionObject(fcl_obj.collision_geometry_[i]->collision_geometry_, transform2fcl(obj->shape_poses_[i])));
+      manager_->registerObject(co.get());
+    }
+  }
+  return true;
+}
+
+void collision_detection::CollisionWorldFCL::beginUpdate()
+{
+  ++update_depth_;
+}
+
+void collision_detection::CollisionWorldFCL::endUpdate()
+{
+  if (update_depth_ == 0 || --update_depth_ > 0)
+    return;
+
+  std::vector<fcl::CollisionObject*> moved;
+  bool clean_cache = false;
+  for (std::map<std::string, int>::const_iterator it = pending_changes_.begin() ; it != pending_changes_.end() ; ++it)
+  {
+    collision_detection::World::const_iterator jt = getWorld()->find(it->first);
+    if (it->second != World::MOVE_SHAPE || jt == getWorld()->end() || !moveFCLObject(jt->second.get(), moved))
+      updateFCLObject(it->first);
+    if (it->second & (World::DESTROY|World::REMOVE_SHAPE))
+      clean_cache = true;
+  }
+  pending_changes_.clear();
+
+  if (!moved.empty())
+    manager_->update(moved);
+  if (clean_cache)
+    cleanCollisionGeometryCache();
+}
+
 void collision_detection::CollisionWorldFCL::notifyObjectChange(const ObjectConstPtr& obj, World::Action action)
 {
+  if (update_depth_ > 0)
+  {
+    pending_changes_[obj->id_] |= action;
+    return;
+  }
+
   if (action == World::DESTROY)
   {
     std::map<std::string, FCLObject>::iterator it = fcl_objs_.find(obj->id_);
@@ -222,10 +306,20 @@ void collision_detection::CollisionWorldFCL::notifyObjectChange(const ObjectCons
       it->second.clear();
       fcl_objs_.erase(it);
     }
+    // the world notifies before it lets go of the object, so its shapes have not expired yet
+    removeCollisionGeometryFromCache(obj.get());
     cleanCollisionGeometryCache();
   }
   else
   {
+    std::vector<fcl::CollisionObject*> moved;
+    if (action == World::MOVE_SHAPE && moveFCLObject(obj.get(), moved))
+    {
+      if (!moved.empty())
+        manager_->update(moved);
+      return;
+    }
+
     updateFCLObject(obj->id_);
     if (action & (World::DESTROY|World::REMOVE_SHAPE))
       cleanCollisionGeometryCache();
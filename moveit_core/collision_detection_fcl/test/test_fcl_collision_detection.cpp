@@ -580,6 +580,307 @@ TEST_F(FclCollisionDetectionTester, TestChangingShapeSize)
   }
 }
 
+TEST_F(FclCollisionDetectionTester, CompiledAllowedCollisionMatrix)
+{
+  acm_->setEntry("base_link", "base_bellow_link", false);
+  acm_->setEntry("box", "r_gripper_palm_link", true);
+  acm_->setDefaultEntry("l_gripper_palm_link", false);
+
+  collision_detection::CompiledAllowedCollisionMatrixConstPtr compiled = acm_->getCompiled(kmodel_);
+  EXPECT_EQ(compiled, acm_->getCompiled(kmodel_));
+
+  std::vector<std::string> names = kmodel_->getLinkModelNames();
+  names.push_back("box");
+  names.push_back("not_in_matrix");
+  for (std::size_t i = 0 ; i < names.size() ; ++i)
+    for (std::size_t j = 0 ; j < names.size() ; ++j)
+    {
+      collision_detection::AllowedCollision::Type t1, t2;
+      bool found1 = acm_->getAllowedCollision(names[i], names[j], t1);
+      bool found2 = compiled->getAllowedCollision(compiled->getIndex(names[i]), compiled->getIndex(names[j]), t2);
+      ASSERT_EQ(found1, found2);
+      if (found1)
+        EXPECT_EQ(t1, t2);
+    }
+
+  // modifications update the compiled view, but leave views that are still referenced untouched
+  collision_detection::CompiledAllowedCollisionMatrixConstPtr old_compiled = compiled;
+  acm_->setEntry("base_link", "base_bellow_link", true);
+  compiled = acm_->getCompiled(kmodel_);
+  EXPECT_NE(compiled, old_compiled);
+  collision_detection::AllowedCollision::Type t;
+  ASSERT_TRUE(compiled->getAllowedCollision(compiled->getIndex("base_link"), compiled->getIndex("base_bellow_link"), t));
+  EXPECT_EQ(t, collision_detection::AllowedCollision::ALWAYS);
+  ASSERT_TRUE(old_compiled->getAllowedCollision(old_compiled->getIndex("base_link"), old_compiled->getIndex("base_bellow_link"), t));
+  EXPECT_EQ(t, collision_detection::AllowedCollision::NEVER);
+
+  // links can also be found by their link model
+  const std::vector<std::string> &links = kmodel_->getLinkModelNames();
+  for (std::size_t i = 0 ; i < links.size() ; ++i)
+    EXPECT_EQ(compiled->getIndex(links[i]), compiled->getIndex(kmodel_->getLinkModel(links[i])));
+}
+
+static bool allowShallowContact(collision_detection::Contact &c)
+{
+  return c.depth < 0.1;
+}
+
+TEST_F(FclCollisionDetectionTester, IncrementalCompiledAllowedCollisionMatrix)
+{
+  acm_->setEntry("box", "r_gripper_palm_link", true);
+  acm_->getCompiled(kmodel_);
+
+  // each of these modifications only re-evaluates the entries of the names involved, including names new to the view
+  acm_->setEntry("base_link", "base_bellow_link", false);
+  acm_->setEntry("box", "cylinder", true);
+  acm_->setEntry("cylinder", "l_gripper_palm_link", collision_detection::DecideContactFn(&allowShallowContact));
+  acm_->setDefaultEntry("l_gripper_palm_link", false);
+  acm_->setDefaultEntry("sphere", true);
+  acm_->removeEntry("box", "r_gripper_palm_link");
+  acm_->removeEntry("base_link");
+  collision_detection::CompiledAllowedCollisionMatrixConstPtr incremental = acm_->getCompiled(kmodel_);
+
+  // a copy of the matrix has no compiled view, so it builds one from scratch
+  collision_detection::AllowedCollisionMatrix copy(*acm_);
+  collision_detection::CompiledAllowedCollisionMatrixConstPtr full = copy.getCompiled(kmodel_);
+  ASSERT_NE(incremental, full);
+
+  std::vector<std::string> names = kmodel_->getLinkModelNames();
+  names.push_back("box");
+  names.push_back("cylinder");
+  names.push_back("sphere");
+  names.push_back("not_in_matrix");
+  for (std::size_t i = 0 ; i < names.size() ; ++i)
+    for (std::size_t j = 0 ; j < names.size() ; ++j)
+    {
+      collision_detection::AllowedCollision::Type t1, t2, t3;
+      bool found1 = acm_->getAllowedCollision(names[i], names[j], t1);
+      bool found2 = incremental->getAllowedCollision(incremental->getIndex(names[i]), incremental->getIndex(names[j]), t2);
+      bool found3 = full->getAllowedCollision(full->getIndex(names[i]), full->getIndex(names[j]), t3);
+      ASSERT_EQ(found1, found2) << names[i] << " " << names[j];
+      ASSERT_EQ(found1, found3) << names[i] << " " << names[j];
+      if (found1)
+      {
+        EXPECT_EQ(t1, t2);
+        EXPECT_EQ(t1, t3);
+      }
+    }
+}
+
+TEST_F(FclCollisionDetectionTester, ContinuousCollisionWorld)
+{
+  robot_state::RobotState kstate1(kmodel_);
+  kstate1.setToDefaultValues();
+  robot_state::RobotState kstate2(kstate1);
+
+  // move the gripper across a small box; neither end of the motion touches it
+  kstate1.updateStateWithLinkAt("r_gripper_palm_link", Eigen::Affine3d(Eigen::Translation3d(-1.0, 0.0, 5.0)));
+  kstate1.update();
+  kstate2.updateStateWithLinkAt("r_gripper_palm_link", Eigen::Affine3d(Eigen::Translation3d(1.0, 0.0, 5.0)));
+  kstate2.update();
+
+  shapes::ShapeConstPtr box(new shapes::Box(0.1, 0.1, 0.1));
+  cworld_->getWorld()->addToObject("box", box, Eigen::Affine3d(Eigen::Translation3d(0.0, 0.0, 5.0)));
+
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res1;
+  cworld_->checkRobotCollision(req, res1, *crobot_, kstate1, *acm_);
+  ASSERT_FALSE(res1.collision);
+  collision_detection::CollisionResult res2;
+  cworld_->checkRobotCollision(req, res2, *crobot_, kstate2, *acm_);
+  ASSERT_FALSE(res2.collision);
+
+  collision_detection::CollisionResult res3;
+  cworld_->checkRobotCollision(req, res3, *crobot_, kstate1, kstate2, *acm_);
+  ASSERT_TRUE(res3.collision);
+
+  // the same motion next to the box is collision free
+  cworld_->getWorld()->moveShapeInObject("box", box, Eigen::Affine3d(Eigen::Translation3d(0.0, 1.0, 5.0)));
+  collision_detection::CollisionResult res4;
+  cworld_->checkRobotCollision(req, res4, *crobot_, kstate1, kstate2, *acm_);
+  ASSERT_FALSE(res4.collision);
+}
+
+TEST_F(FclCollisionDetectionTester, ContinuousSelfCollision)
+{
+  robot_state::RobotState kstate1(kmodel_);
+  kstate1.setToDefaultValues();
+  robot_state::RobotState kstate2(kstate1);
+
+  // the two grippers swap places, passing through each other
+  kstate1.updateStateWithLinkAt("r_gripper_palm_link", Eigen::Affine3d(Eigen::Translation3d(3.0, -1.0, 0.0)));
+  kstate1.updateStateWithLinkAt("l_gripper_palm_link", Eigen::Affine3d(Eigen::Translation3d(3.0, 1.0, 0.0)));
+  kstate1.update();
+  kstate2.updateStateWithLinkAt("r_gripper_palm_link", Eigen::Affine3d(Eigen::Translation3d(3.0, 1.0, 0.0)));
+  kstate2.updateStateWithLinkAt("l_gripper_palm_link", Eigen::Affine3d(Eigen::Translation3d(3.0, -1.0, 0.0)));
+  kstate2.update();
+
+  acm_->setEntry("r_gripper_palm_link", "l_gripper_palm_link", false);
+
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res1;
+  crobot_->checkSelfCollision(req, res1, kstate1, *acm_);
+  ASSERT_FALSE(res1.collision);
+
+  collision_detection::CollisionResult res2;
+  crobot_->checkSelfCollision(req, res2, kstate1, kstate2, *acm_);
+  ASSERT_TRUE(res2.collision);
+
+  acm_->setEntry("r_gripper_palm_link", "l_gripper_palm_link", true);
+  collision_detection::CollisionResult res3;
+  crobot_->checkSelfCollision(req, res3, kstate1, kstate2, *acm_);
+  ASSERT_FALSE(res3.collision);
+}
+
+TEST_F(FclCollisionDetectionTester, MoveWorldObjects)
+{
+  robot_state::RobotState kstate(kmodel_);
+  kstate.setToDefaultValues();
+  kstate.update();
+
+  Eigen::Affine3d touching = kstate.getGlobalLinkTransform("r_gripper_palm_link");
+  Eigen::Affine3d away = Eigen::Translation3d(0.0, 0.0, 5.0) * touching;
+
+  shapes::ShapeConstPtr box(new shapes::Box(0.05, 0.05, 0.05));
+  cworld_->getWorld()->addToObject("box", box, away);
+
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res1;
+  cworld_->checkRobotCollision(req, res1, *crobot_, kstate, *acm_);
+  ASSERT_FALSE(res1.collision);
+
+  // moving the box only refits the existing FCL objects
+  cworld_->getWorld()->moveShapeInObject("box", box, touching);
+  collision_detection::CollisionResult res2;
+  cworld_->checkRobotCollision(req, res2, *crobot_, kstate, *acm_);
+  ASSERT_TRUE(res2.collision);
+
+  // moving the box in a copy of the world does not affect the original
+  collision_detection::WorldPtr world_copy(new collision_detection::World(*cworld_->getWorld()));
+  collision_detection::CollisionWorldPtr cworld_copy(new DefaultCWorldType(dynamic_cast<const DefaultCWorldType&>(*cworld_), world_copy));
+  world_copy->moveShapeInObject("box", box, away);
+  collision_detection::CollisionResult res3;
+  cworld_copy->checkRobotCollision(req, res3, *crobot_, kstate, *acm_);
+  ASSERT_FALSE(res3.collision);
+  collision_detection::CollisionResult res4;
+  cworld_->checkRobotCollision(req, res4, *crobot_, kstate, *acm_);
+  ASSERT_TRUE(res4.collision);
+
+  // many changes made while updates are postponed are applied together
+  cworld_->beginUpdate();
+  for (int i = 0 ; i < 10 ; ++i)
+    cworld_->getWorld()->moveShapeInObject("box", box, Eigen::Translation3d(0.0, 0.0, 0.1 * i) * away);
+  shapes::ShapeConstPtr other(new shapes::Box(0.05, 0.05, 0.05));
+  cworld_->getWorld()->addToObject("other", other, away);
+  cworld_->endUpdate();
+  collision_detection::CollisionResult res5;
+  cworld_->checkRobotCollision(req, res5, *crobot_, kstate, *acm_);
+  ASSERT_FALSE(res5.collision);
+
+  cworld_->beginUpdate();
+  cworld_->getWorld()->moveShapeInObject("other", other, touching);
+  cworld_->getWorld()->removeObject("box");
+  cworld_->endUpdate();
+  collision_detection::CollisionResult res6;
+  req.contacts = true;
+  req.max_contacts = 10;
+  cworld_->checkRobotCollision(req, res6, *crobot_, kstate, *acm_);
+  ASSERT_TRUE(res6.collision);
+  for (collision_detection::CollisionResult::ContactMap::const_iterator it = res6.contacts.begin() ; it != res6.contacts.end() ; ++it)
+    EXPECT_TRUE(it->first.first == "other" || it->first.second == "other");
+}
+
+TEST_F(FclCollisionDetectionTester, AttachedBodyCopies)
+{
+  robot_state::RobotState kstate1(kmodel_);
+  kstate1.setToDefaultValues();
+  kstate1.updateStateWithLinkAt("r_gripper_palm_link", Eigen::Affine3d(Eigen::Translation3d(-1.0, 0.0, 5.0)));
+
+  std::vector<shapes::ShapeConstPtr> shapes(1, shapes::ShapeConstPtr(new shapes::Box(0.1, 0.1, 0.1)));
+  EigenSTL::vector_Affine3d poses(1, Eigen::Affine3d(Eigen::Translation3d(0.3, 0.0, 0.0)));
+  std::vector<std::string> touch_links(1, "r_gripper_palm_link");
+  kstate1.attachBody("held", shapes, poses, touch_links, "r_gripper_palm_link");
+  kstate1.update();
+
+  shapes::ShapeConstPtr box(new shapes::Box(0.1, 0.1, 0.1));
+  cworld_->getWorld()->addToObject("box", box, Eigen::Affine3d(Eigen::Translation3d(-0.7, 0.0, 5.0)));
+
+  collision_detection::CollisionRequest req;
+  req.contacts = true;
+  req.max_contacts = 10;
+
+  // repeated checks of the same state, and checks of copies of it, find the attached body
+  for (int i = 0 ; i < 3 ; ++i)
+  {
+    robot_state::RobotState copy(kstate1);
+    copy.update();
+    const robot_state::RobotState &kstate = i == 0 ? kstate1 : copy;
+    collision_detection::CollisionResult res;
+    cworld_->checkRobotCollision(req, res, *crobot_, kstate, *acm_);
+    ASSERT_TRUE(res.collision);
+    EXPECT_TRUE(res.contacts.find(std::make_pair(std::string("box"), std::string("held"))) != res.contacts.end());
+  }
+
+  // the objects cached by a state remain usable by its copies once the state is gone
+  {
+    robot_state::RobotState *original = new robot_state::RobotState(kstate1);
+    original->attachBody("held2", shapes, poses, touch_links, "r_gripper_palm_link");
+    original->update();
+    collision_detection::CollisionResult res;
+    cworld_->checkRobotCollision(req, res, *crobot_, *original, *acm_);
+    ASSERT_TRUE(res.collision);
+    robot_state::RobotState copy(*original);
+    delete original;
+    copy.update();
+    collision_detection::CollisionResult res2;
+    cworld_->checkRobotCollision(req, res2, *crobot_, copy, *acm_);
+    ASSERT_TRUE(res2.collision);
+    EXPECT_TRUE(res2.contacts.find(std::make_pair(std::string("box"), std::string("held2"))) != res2.contacts.end());
+  }
+
+  // the attached body is swept along with the gripper between two distinct states
+  cworld_->getWorld()->moveShapeInObject("box", box, Eigen::Affine3d(Eigen::Translation3d(0.3, 0.0, 5.5)));
+  robot_state::RobotState kstate2(kstate1);
+  kstate2.updateStateWithLinkAt("r_gripper_palm_link", Eigen::Affine3d(Eigen::Translation3d(1.0, 0.0, 5.0)));
+  kstate2.update();
+
+  req.contacts = false;
+  collision_detection::CollisionResult res1;
+  cworld_->checkRobotCollision(req, res1, *crobot_, kstate1, kstate2, *acm_);
+  EXPECT_FALSE(res1.collision);
+
+  cworld_->getWorld()->moveShapeInObject("box", box, Eigen::Affine3d(Eigen::Translation3d(0.3, 0.0, 5.0)));
+  collision_detection::CollisionResult res2;
+  cworld_->checkRobotCollision(req, res2, *crobot_, kstate1, kstate2, *acm_);
+  EXPECT_TRUE(res2.collision);
+}
+
+TEST_F(FclCollisionDetectionTester, CollisionGeometryCache)
+{
+  collision_detection::World::Object obj("cached");
+  shapes::ShapeConstPtr box(new shapes::Box(0.1, 0.2, 0.3));
+
+  collision_detection::CollisionGeometryCacheStatistics before = collision_detection::getCollisionGeometryCacheStatistics();
+  collision_detection::FCLGeometryConstPtr g1 = collision_detection::createCollisionGeometry(box, &obj);
+  collision_detection::FCLGeometryConstPtr g2 = collision_detection::createCollisionGeometry(box, &obj);
+  collision_detection::CollisionGeometryCacheStatistics after = collision_detection::getCollisionGeometryCacheStatistics();
+
+  ASSERT_TRUE(g1);
+  EXPECT_EQ(g1, g2);
+  EXPECT_EQ(before.misses_ + 1, after.misses_);
+  EXPECT_EQ(before.hits_ + 1, after.hits_);
+  EXPECT_EQ(before.entries_ + 1, after.entries_);
+
+  // expired entries are removed once the shape is gone and the cache is cleaned
+  g1.reset();
+  g2.reset();
+  box.reset();
+  collision_detection::cleanCollisionGeometryCache();
+  collision_detection::CollisionGeometryCacheStatistics cleaned = collision_detection::getCollisionGeometryCacheStatistics();
+  EXPECT_LT(cleaned.entries_, after.entries_);
+  EXPECT_LE(cleaned.entries_, before.entries_);
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -310,7 +310,8 @@ public:
    */
   IKConstraintSampler(const planning_scene::PlanningSceneConstPtr &scene,
                       const std::string &group_name) :
-    ConstraintSampler(scene, group_name)
+    ConstraintSampler(scene, group_name),
+    use_batch_ik_(false)
   {
   }
 
@@ -387,6 +388,26 @@ public:
     ik_timeout_ = timeout;
   }
 
+  /**
+   * \brief Returns true if sample() solves IK for all its attempts with one batched query
+   */
+  bool getUseBatchIK() const
+  {
+    return use_batch_ik_;
+  }
+
+  /**
+   * \brief Enable or disable batched IK queries in sample(). When enabled and the IK solver supports concurrent
+   * queries, the poses for all attempts are sampled first and solved on multiple threads, stopping at the first valid
+   * solution (see kinematics::KinematicsBase::searchPositionIKBatch()). Disabled by default.
+   *
+   * @param flag True to use batched queries
+   */
+  void setUseBatchIK(bool flag)
+  {
+    use_batch_ik_ = flag;
+  }
+
   /**
    * \brief Gets the position constraint associated with this sampler.
    *
@@ -517,12 +538,29 @@ protected:
   bool callIK(const geometry_msgs::Pose &ik_query, const kinematics::KinematicsBase::IKCallbackFn &adapted_ik_validity_callback,
               double timeout, robot_state::RobotState &state, bool use_as_seed);
   bool sampleHelper(robot_state::RobotState &state, const robot_state::RobotState &reference_state, unsigned int max_attempts, bool project);
+
+  /**
+   * \brief Samples \e max_attempts poses and solves IK for them with a single batched query
+   * (see kinematics::KinematicsBase::searchPositionIKBatch()). The query stops at the first solution that passes the
+   * group state validity callback and the constraints, which is then written to \e state.
+   *
+   * @return True if a valid solution was found, false otherwise
+   */
+  bool sampleBatch(robot_state::RobotState &state, const robot_state::RobotState &reference_state, unsigned int max_attempts);
+
+  /**
+   * \brief The solution callback for batched IK queries: accepts \e ik_sol if it passes the group state validity
+   * callback and the constraints. \e state is used as scratch space.
+   */
+  void batchSolutionCallback(robot_state::RobotState *state, const geometry_msgs::Pose &ik_pose, const std::vector<double> &ik_sol,
+                             moveit_msgs::MoveItErrorCodes &error_code) const;
   bool validate(robot_state::RobotState &state) const;
 
   random_numbers::RandomNumberGenerator random_number_generator_; /**< \brief Random generator used by the sampler */
   IKSamplingPose                        sampling_pose_; /**< \brief Holder for the pose used for sampling */
   kinematics::KinematicsBaseConstPtr    kb_; /**< \brief Holds the kinematics solver */
   double                                ik_timeout_; /**< \brief Holds the timeout associated with IK */
+  bool                                  use_batch_ik_; /**< \brief True if sample() uses batched IK queries */
   std::string                           ik_frame_; /**< \brief Holds the base from of the IK solver */
   bool                                  transform_ik_; /**< \brief True if the frame associated with the kinematic model is different than the base frame of the IK solver */
 };
@@ -504,6 +504,10 @@ bool constraint_samplers::IKConstraintSampler::sampleHelper(robot_state::RobotSt
     return false;
   }
 
+  // when enabled and the solver can run queries concurrently, solve for all the attempts at once
+  if (use_batch_ik_ && !project && max_attempts > 1 && kb_->supportsConcurrentQueries())
+    return sampleBatch(state, reference_state, max_attempts);
+
   kinematics::KinematicsBase::IKCallbackFn adapted_ik_validity_callback;
   if (group_state_validity_callback_)
     adapted_ik_validity_callback = boost::bind(&samplingIkCallbackFnAdapter, &state, jmg_, group_state_validity_callback_, _1, _2, _3);
@@ -535,6 +539,92 @@ bool constraint_samplers::IKConstraintSampler::sampleHelper(robot_state::RobotSt
   return false;
 }
 
+bool constraint_samplers::IKConstraintSampler::sampleBatch(robot_state::RobotState &state, const robot_state::RobotState &reference_state, unsigned int max_attempts)
+{
+  std::vector<geometry_msgs::Pose> ik_queries;
+  ik_queries.reserve(max_attempts);
+  for (unsigned int a = 0 ; a < max_attempts ; ++a)
+  {
+    // sample a point in the constraint region
+    Eigen::Vector3d point;
+    Eigen::Quaterniond quat;
+    if (!samplePose(point, quat, reference_state, max_attempts))
+      break;
+
+    geometry_msgs::Pose ik_query;
+    ik_query.position.x = point.x();
+    ik_query.position.y = point.y();
+    ik_query.position.z = point.z();
+    ik_query.orientation.x = quat.x();
+    ik_query.orientation.y = quat.y();
+    ik_query.orientation.z = quat.z();
+    ik_query.orientation.w = quat.w();
+    ik_queries.push_back(ik_query);
+  }
+
+  if (ik_queries.empty())
+  {
+    if (verbose_)
+      logInform("IK constraint sampler was unable to produce a pose to run IK for");
+    return false;
+  }
+
+  // each pose gets its own random seed, as it would when the attempts run one after the other
+  const std::vector<unsigned int>& ik_joint_bijection = jmg_->getKinematicsSolverJointBijection();
+  std::vector<std::vector<double> > seeds(ik_queries.size(), std::vector<double>(ik_joint_bijection.size(), 0.0));
+  std::vector<double> vals;
+  for (std::size_t k = 0 ; k < seeds.size() ; ++k)
+  {
+    jmg_->getVariableRandomPositions(random_number_generator_, vals);
+    assert(vals.size() == ik_joint_bijection.size());
+    for (std::size_t i = 0 ; i < ik_joint_bijection.size() ; ++i)
+      seeds[k][i] = vals[ik_joint_bijection[i]];
+  }
+
+  // each attempt keeps the timeout it would have had when run on its own, so the batch takes no longer than the
+  // attempts would have taken one after the other; the batch stops at the first solution the callback accepts
+  kinematics::KinematicsBatchOptions batch_options;
+  batch_options.query_timeout = ik_timeout_;
+  batch_options.max_solutions = 1;
+  batch_options.seed_per_pose = true;
+  batch_options.solution_callback = boost::bind(&IKConstraintSampler::batchSolutionCallback, this, &state, _1, _2, _3);
+  std::vector<kinematics::KinematicsBatchSolution> ik_solutions;
+  kinematics::KinematicsResult result;
+  if (!kb_->searchPositionIKBatch(ik_queries, seeds, ik_timeout_ * ik_queries.size(), ik_solutions, result, batch_options))
+  {
+    if (verbose_)
+      logInform("IK failed");
+    return false;
+  }
+
+  // the callback used state as scratch space for other solutions as well
+  const std::vector<double> &ik_sol = ik_solutions.front().solution;
+  assert(ik_sol.size() == ik_joint_bijection.size());
+  std::vector<double> solution(ik_joint_bijection.size());
+  for (std::size_t i = 0 ; i < ik_joint_bijection.size() ; ++i)
+    solution[ik_joint_bijection[i]] = ik_sol[i];
+  state.setJointGroupPositions(jmg_, solution);
+  state.update();
+  return true;
+}
+
+void constraint_samplers::IKConstraintSampler::batchSolutionCallback(robot_state::RobotState *state, const geometry_msgs::Pose &ik_pose,
+                                                                     const std::vector<double> &ik_sol, moveit_msgs::MoveItErrorCodes &error_code) const
+{
+  if (group_state_validity_callback_)
+  {
+    samplingIkCallbackFnAdapter(state, jmg_, group_state_validity_callback_, ik_pose, ik_sol, error_code);
+    if (error_code.val != moveit_msgs::MoveItErrorCodes::SUCCESS)
+      return;
+  }
+  const std::vector<unsigned int> &bij = jmg_->getKinematicsSolverJointBijection();
+  std::vector<double> solution(bij.size());
+  for (std::size_t i = 0 ; i < bij.size() ; ++i)
+    solution[bij[i]] = ik_sol[i];
+  state->setJointGroupPositions(jmg_, solution);
+  error_code.val = validate(*state) ? moveit_msgs::MoveItErrorCodes::SUCCESS : moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+}
+
 bool constraint_samplers::IKConstraintSampler::project(robot_state::RobotState &state,
                                                        unsigned int max_attempts)
 {
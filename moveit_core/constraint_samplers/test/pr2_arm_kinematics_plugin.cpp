@@ -40,6 +40,7 @@
 #include <eigen_conversions/eigen_kdl.h>
 #include <algorithm>
 #include <numeric>
+#include <boost/bind.hpp>
 
 #include "pr2_arm_kinematics_plugin.h"
 
@@ -162,7 +163,8 @@ int PR2ArmIKSolver::CartToJnt(const KDL::JntArray& q_init,
 int PR2ArmIKSolver::CartToJntSearch(const KDL::JntArray& q_in,
                                     const KDL::Frame& p_in,
                                     KDL::JntArray &q_out,
-                                    const double &timeout)
+                                    const double &timeout,
+                                    const boost::function<bool(const KDL::JntArray&)> &accept)
 {
   const bool verbose = false;
   KDL::JntArray q_init = q_in;
@@ -178,7 +180,7 @@ int PR2ArmIKSolver::CartToJntSearch(const KDL::JntArray& q_in,
     ROS_DEBUG_NAMED("pr2_arm_kinematics_plugin","%f %f %f %d %d \n\n",initial_guess,pr2_arm_ik_.solver_info_.limits[free_angle_].max_position,pr2_arm_ik_.solver_info_.limits[free_angle_].min_position,num_positive_increments,num_negative_increments);
   while(loop_time < timeout)
   {
-    if(CartToJnt(q_init,p_in,q_out) > 0)
+    if(CartToJnt(q_init,p_in,q_out) > 0 && (!accept || accept(q_out)))
       return 1;
     if(!getCount(count,num_positive_increments,-num_negative_increments))
       return -1;
@@ -200,6 +202,17 @@ int PR2ArmIKSolver::CartToJntSearch(const KDL::JntArray& q_in,
   return NO_IK_SOLUTION;
 }
 
+bool acceptSolution(const geometry_msgs::Pose &ik_pose, const kinematics::KinematicsBase::IKCallbackFn &solution_callback,
+                    const KDL::JntArray &jnt_pos)
+{
+  std::vector<double> solution(jnt_pos.rows());
+  for(std::size_t i=0; i < solution.size(); i++)
+    solution[i] = jnt_pos(i);
+  moveit_msgs::MoveItErrorCodes error_code;
+  solution_callback(ik_pose, solution, error_code);
+  return error_code.val == error_code.SUCCESS;
+}
+
 bool getKDLChain(const urdf::ModelInterface& model, const std::string &root_name, const std::string &tip_name, KDL::Chain &kdl_chain)
 {
   // create robot chain from root to tip
@@ -334,6 +347,28 @@ bool PR2ArmKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose &ik_pose
                                               std::vector<double> &solution,
                                               moveit_msgs::MoveItErrorCodes &error_code,
                                               const kinematics::KinematicsQueryOptions &options) const
+{
+  return searchPositionIK(ik_pose, ik_seed_state, timeout, solution, IKCallbackFn(), error_code, options);
+}
+
+bool PR2ArmKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose &ik_pose,
+                                              const std::vector<double> &ik_seed_state,
+                                              double timeout,
+                                              const std::vector<double> &consistency_limit,
+                                              std::vector<double> &solution,
+                                              moveit_msgs::MoveItErrorCodes &error_code,
+                                              const kinematics::KinematicsQueryOptions &options) const
+{
+  return false;
+}
+
+bool PR2ArmKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose &ik_pose,
+                                              const std::vector<double> &ik_seed_state,
+                                              double timeout,
+                                              std::vector<double> &solution,
+                                              const IKCallbackFn &solution_callback,
+                                              moveit_msgs::MoveItErrorCodes &error_code,
+                                              const kinematics::KinematicsQueryOptions &options) const
 {
   if(!active_)
   {
@@ -346,6 +381,10 @@ bool PR2ArmKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose &ik_pose
   tf::poseMsgToEigen(ik_pose, tp);
   tf::transformEigenToKDL(tp, pose_desired);
 
+  boost::function<bool(const KDL::JntArray&)> accept;
+  if(solution_callback)
+    accept = boost::bind(&acceptSolution, boost::cref(ik_pose), boost::cref(solution_callback), _1);
+
   //Do the IK
   KDL::JntArray jnt_pos_in;
   KDL::JntArray jnt_pos_out;
@@ -358,7 +397,8 @@ bool PR2ArmKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose &ik_pose
   int ik_valid = pr2_arm_ik_solver_->CartToJntSearch(jnt_pos_in,
                                                      pose_desired,
                                                      jnt_pos_out,
-                                                     timeout);
+                                                     timeout,
+                                                     accept);
   if(ik_valid == pr2_arm_kinematics::NO_IK_SOLUTION)
   {
     error_code.val = error_code.NO_IK_SOLUTION;
@@ -383,27 +423,6 @@ bool PR2ArmKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose &ik_pose
   }
 }
 
-bool PR2ArmKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose &ik_pose,
-                                              const std::vector<double> &ik_seed_state,
-                                              double timeout,
-                                              const std::vector<double> &consistency_limit,
-                                              std::vector<double> &solution,
-                                              moveit_msgs::MoveItErrorCodes &error_code,
-                                              const kinematics::KinematicsQueryOptions &options) const
-{
-  return false;
-}
-
-bool PR2ArmKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose &ik_pose,
-                                              const std::vector<double> &ik_seed_state,
-                                              double timeout,
-                                              std::vector<double> &solution,
-                                              const IKCallbackFn &solution_callback,
-                                              moveit_msgs::MoveItErrorCodes &error_code,
-                                              const kinematics::KinematicsQueryOptions &options) const
-{
-  return false;
-}
 
 bool PR2ArmKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose &ik_pose,
                                               const std::vector<double> &ik_seed_state,
@@ -54,6 +54,7 @@
 #include <kdl/chainfksolverpos_recursive.hpp>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
 
 #include <urdf_world/types.h>
 
@@ -105,10 +106,14 @@ public:
                 const KDL::Frame& p_in,
                 KDL::JntArray& q_out);
 
+  /**
+   * @brief Search the free angle for a solution; if \e accept is set, only solutions it returns true for are reported
+   */
   int CartToJntSearch(const KDL::JntArray& q_in,
                       const KDL::Frame& p_in,
                       KDL::JntArray &q_out,
-                      const double &timeout);
+                      const double &timeout,
+                      const boost::function<bool(const KDL::JntArray&)> &accept = boost::function<bool(const KDL::JntArray&)>());
 
   void getSolverInfo(moveit_msgs::KinematicSolverInfo &response)
   {
@@ -229,6 +234,14 @@ public:
                                 moveit_msgs::MoveItErrorCodes &error_code,
                                 const kinematics::KinematicsQueryOptions &options = kinematics::KinematicsQueryOptions()) const;
 
+  /**
+   * @brief The solver keeps no state between calls, so queries can run concurrently
+   */
+  virtual bool supportsConcurrentQueries() const
+  {
+    return true;
+  }
+
   /**
    * @brief Given a set of joint angles and a set of links, compute their pose
    * @param request  - the request contains the joint angles, set of links for which poses are to be computed and a timeout
@@ -43,6 +43,7 @@
 #include <moveit_msgs/DisplayTrajectory.h>
 #include <moveit/robot_state/conversions.h>
 #include <moveit_resources/config.h>
+#include <eigen_conversions/eigen_msg.h>
 
 #include <geometric_shapes/shape_operations.h>
 #include <visualization_msgs/MarkerArray.h>
@@ -349,6 +350,250 @@ TEST_F(LoadPlanningModelsPr2, IKConstraintsSamplerSimple)
 }
 
 
+namespace
+{
+bool isUpperArmRollPositive(robot_state::RobotState *state, const robot_model::JointModelGroup *group, const double *values)
+{
+  state->setJointGroupPositions(group, values);
+  return state->getVariablePosition("l_upper_arm_roll_joint") >= 0.0;
+}
+}
+
+TEST_F(LoadPlanningModelsPr2, BatchedIK)
+{
+  const robot_model::JointModelGroup *jmg = kmodel->getJointModelGroup("left_arm");
+  kinematics::KinematicsBaseConstPtr solver = jmg->getSolverInstance();
+  ASSERT_TRUE(solver);
+
+  robot_state::RobotState ks(kmodel);
+  ks.setToDefaultValues();
+
+  // poses of the tip, in the base frame of the solver, for a few random arm configurations
+  const std::size_t NP = 5;
+  std::vector<geometry_msgs::Pose> poses(NP);
+  for (std::size_t i = 0 ; i < NP ; ++i)
+  {
+    ks.setToRandomPositions(jmg);
+    ks.update();
+    Eigen::Affine3d pose = ks.getGlobalLinkTransform("torso_lift_link").inverse() * ks.getGlobalLinkTransform("l_wrist_roll_link");
+    tf::poseEigenToMsg(pose, poses[i]);
+  }
+
+  std::vector<std::vector<double> > seeds(2, std::vector<double>(solver->getJointNames().size(), 0.0));
+  std::vector<kinematics::KinematicsBatchSolution> solutions;
+  kinematics::KinematicsResult result;
+  kinematics::KinematicsBatchOptions batch_options;
+  batch_options.max_solutions_per_pose = 0;
+  EXPECT_TRUE(solver->searchPositionIKBatch(poses, seeds, 5.0, solutions, result, batch_options));
+  EXPECT_EQ(kinematics::KinematicErrors::OK, result.kinematic_error);
+  EXPECT_LE(solutions.size(), NP * seeds.size());
+
+  const std::vector<unsigned int> &bij = jmg->getKinematicsSolverJointBijection();
+  for (std::size_t i = 0 ; i < solutions.size() ; ++i)
+  {
+    ASSERT_LT(solutions[i].pose_index, NP);
+    ASSERT_LT(solutions[i].seed_index, seeds.size());
+    if (i > 0)
+      EXPECT_TRUE(solutions[i - 1].pose_index < solutions[i].pose_index ||
+                  (solutions[i - 1].pose_index == solutions[i].pose_index && solutions[i - 1].seed_index < solutions[i].seed_index));
+
+    std::vector<double> values(bij.size());
+    for (std::size_t j = 0 ; j < bij.size() ; ++j)
+      values[bij[j]] = solutions[i].solution[j];
+    ks.setJointGroupPositions(jmg, values);
+    ks.update();
+    Eigen::Affine3d pose = ks.getGlobalLinkTransform("torso_lift_link").inverse() * ks.getGlobalLinkTransform("l_wrist_roll_link");
+    EXPECT_NEAR(poses[solutions[i].pose_index].position.x, pose.translation().x(), 1e-3);
+    EXPECT_NEAR(poses[solutions[i].pose_index].position.y, pose.translation().y(), 1e-3);
+    EXPECT_NEAR(poses[solutions[i].pose_index].position.z, pose.translation().z(), 1e-3);
+  }
+
+  // by default only the first solution for each pose is kept
+  batch_options = kinematics::KinematicsBatchOptions();
+  solver->searchPositionIKBatch(poses, seeds, 5.0, solutions, result, batch_options);
+  EXPECT_LE(solutions.size(), NP);
+  for (std::size_t i = 1 ; i < solutions.size() ; ++i)
+    EXPECT_LT(solutions[i - 1].pose_index, solutions[i].pose_index);
+
+  batch_options.max_solutions = 2;
+  solver->searchPositionIKBatch(poses, seeds, 5.0, solutions, result, batch_options);
+  EXPECT_LE(solutions.size(), 2u);
+
+  // with one seed per pose, each pose is only searched from its own seed
+  batch_options = kinematics::KinematicsBatchOptions();
+  batch_options.seed_per_pose = true;
+  EXPECT_FALSE(solver->searchPositionIKBatch(poses, seeds, 5.0, solutions, result, batch_options));
+  seeds.resize(NP, seeds[0]);
+  for (std::size_t i = 0 ; i < NP ; ++i)
+    seeds[i][0] = 0.1 * i;
+  solver->searchPositionIKBatch(poses, seeds, 5.0, solutions, result, batch_options);
+  EXPECT_LE(solutions.size(), NP);
+  for (std::size_t i = 0 ; i < solutions.size() ; ++i)
+    EXPECT_EQ(solutions[i].pose_index, solutions[i].seed_index);
+}
+
+TEST_F(LoadPlanningModelsPr2, SetFromIKWithBatchedRestarts)
+{
+  const robot_model::JointModelGroup *jmg = kmodel->getJointModelGroup("left_arm");
+  ASSERT_TRUE(jmg->getSolverInstance());
+  ASSERT_TRUE(jmg->getSolverInstance()->supportsConcurrentQueries());
+
+  robot_state::RobotState ks(kmodel);
+  ks.setToDefaultValues();
+  robot_state::RobotState goal(ks);
+  int solved = 0;
+  for (int t = 0 ; t < 20 ; ++t)
+  {
+    goal.setToRandomPositions(jmg);
+    goal.update();
+    Eigen::Affine3d pose = goal.getGlobalLinkTransform("l_wrist_roll_link");
+
+    // the restarts after the first attempt run as a batch, and the validity callback is still honored
+    ks.setToRandomPositions(jmg);
+    if (ks.setFromIK(jmg, pose, 10, 0.1, &isUpperArmRollPositive))
+    {
+      ++solved;
+      ks.update();
+      EXPECT_GE(ks.getVariablePosition("l_upper_arm_roll_joint"), 0.0);
+      EXPECT_TRUE(ks.getGlobalLinkTransform("l_wrist_roll_link").translation().isApprox(pose.translation(), 1e-3));
+    }
+  }
+  EXPECT_GT(solved, 0);
+}
+
+TEST_F(LoadPlanningModelsPr2, BatchedIKMatchesSerialIK)
+{
+  const robot_model::JointModelGroup *jmg = kmodel->getJointModelGroup("left_arm");
+  kinematics::KinematicsBaseConstPtr solver = jmg->getSolverInstance();
+  ASSERT_TRUE(solver);
+  ASSERT_TRUE(solver->supportsConcurrentQueries());
+
+  robot_state::RobotState ks(kmodel);
+  ks.setToDefaultValues();
+
+  const std::size_t NP = 6;
+  std::vector<geometry_msgs::Pose> poses(NP);
+  for (std::size_t i = 0 ; i < NP ; ++i)
+  {
+    ks.setToRandomPositions(jmg);
+    ks.update();
+    Eigen::Affine3d pose = ks.getGlobalLinkTransform("torso_lift_link").inverse() * ks.getGlobalLinkTransform("l_wrist_roll_link");
+    tf::poseEigenToMsg(pose, poses[i]);
+  }
+
+  const std::vector<unsigned int> &bij = jmg->getKinematicsSolverJointBijection();
+  std::vector<std::vector<double> > seeds(3, std::vector<double>(bij.size()));
+  for (std::size_t k = 0 ; k < seeds.size() ; ++k)
+  {
+    ks.setToRandomPositions(jmg);
+    std::vector<double> values;
+    ks.copyJointGroupPositions(jmg, values);
+    for (std::size_t j = 0 ; j < bij.size() ; ++j)
+      seeds[k][j] = values[bij[j]];
+  }
+
+  // every (pose, seed) pair on multiple threads
+  kinematics::KinematicsBatchOptions batch_options;
+  batch_options.max_solutions_per_pose = 0;
+  batch_options.thread_count = 4;
+  std::vector<kinematics::KinematicsBatchSolution> solutions;
+  kinematics::KinematicsResult result;
+  solver->searchPositionIKBatch(poses, seeds, 60.0, solutions, result, batch_options);
+
+  // the solver is deterministic for a given seed, so the batch finds exactly what serial queries find
+  std::size_t next = 0;
+  for (std::size_t i = 0 ; i < NP ; ++i)
+    for (std::size_t k = 0 ; k < seeds.size() ; ++k)
+    {
+      std::vector<double> solution;
+      moveit_msgs::MoveItErrorCodes error_code;
+      bool found = solver->searchPositionIK(poses[i], seeds[k], 5.0, solution, error_code);
+      bool in_batch = next < solutions.size() && solutions[next].pose_index == i && solutions[next].seed_index == k;
+      EXPECT_EQ(found, in_batch) << "pose " << i << ", seed " << k;
+      if (found && in_batch)
+      {
+        ASSERT_EQ(solution.size(), solutions[next].solution.size());
+        for (std::size_t j = 0 ; j < solution.size() ; ++j)
+          EXPECT_NEAR(solution[j], solutions[next].solution[j], 1e-9);
+      }
+      if (in_batch)
+        ++next;
+    }
+  EXPECT_EQ(solutions.size(), next);
+}
+
+TEST_F(LoadPlanningModelsPr2, BatchedIKConstraintSampler)
+{
+  robot_state::RobotState ks(kmodel);
+  ks.setToDefaultValues();
+  ks.update();
+  robot_state::RobotState ks_const(kmodel);
+  ks_const.setToDefaultValues();
+  ks_const.update();
+
+  robot_state::Transforms &tf = ps->getTransformsNonConst();
+
+  kinematic_constraints::PositionConstraint pc(kmodel);
+  moveit_msgs::PositionConstraint pcm;
+  pcm.link_name = "l_wrist_roll_link";
+  pcm.header.frame_id = kmodel->getModelFrame();
+  pcm.constraint_region.primitives.resize(1);
+  pcm.constraint_region.primitives[0].type = shape_msgs::SolidPrimitive::SPHERE;
+  pcm.constraint_region.primitives[0].dimensions.resize(1);
+  pcm.constraint_region.primitives[0].dimensions[0] = 0.001;
+  pcm.constraint_region.primitive_poses.resize(1);
+  pcm.constraint_region.primitive_poses[0].position.x = 0.55;
+  pcm.constraint_region.primitive_poses[0].position.y = 0.2;
+  pcm.constraint_region.primitive_poses[0].position.z = 1.25;
+  pcm.constraint_region.primitive_poses[0].orientation.w = 1.0;
+  pcm.weight = 1.0;
+  EXPECT_TRUE(pc.configure(pcm, tf));
+
+  kinematic_constraints::OrientationConstraint oc(kmodel);
+  moveit_msgs::OrientationConstraint ocm;
+  ocm.link_name = "l_wrist_roll_link";
+  ocm.header.frame_id = kmodel->getModelFrame();
+  ocm.orientation.w = 1.0;
+  ocm.absolute_x_axis_tolerance = 0.2;
+  ocm.absolute_y_axis_tolerance = 0.1;
+  ocm.absolute_z_axis_tolerance = 0.4;
+  ocm.weight = 1.0;
+  EXPECT_TRUE(oc.configure(ocm, tf));
+
+  constraint_samplers::IKConstraintSampler serial(ps, "left_arm");
+  EXPECT_TRUE(serial.configure(constraint_samplers::IKSamplingPose(pc, oc)));
+  EXPECT_FALSE(serial.getUseBatchIK());
+  serial.setGroupStateValidityCallback(&isUpperArmRollPositive);
+
+  constraint_samplers::IKConstraintSampler batch(ps, "left_arm");
+  EXPECT_TRUE(batch.configure(constraint_samplers::IKSamplingPose(pc, oc)));
+  batch.setUseBatchIK(true);
+  batch.setGroupStateValidityCallback(&isUpperArmRollPositive);
+
+  // the batched sampler honors the validity callback and succeeds as often as the serial one
+  const int trials = 50;
+  int serial_successes = 0, batch_successes = 0;
+  for (int t = 0 ; t < trials ; ++t)
+  {
+    if (serial.sample(ks, ks_const, 10))
+    {
+      ++serial_successes;
+      EXPECT_GE(ks.getVariablePosition("l_upper_arm_roll_joint"), 0.0);
+      EXPECT_TRUE(pc.decide(ks).satisfied);
+      EXPECT_TRUE(oc.decide(ks).satisfied);
+    }
+    if (batch.sample(ks, ks_const, 10))
+    {
+      ++batch_successes;
+      EXPECT_GE(ks.getVariablePosition("l_upper_arm_roll_joint"), 0.0);
+      EXPECT_TRUE(pc.decide(ks).satisfied);
+      EXPECT_TRUE(oc.decide(ks).satisfied);
+    }
+  }
+  EXPECT_GT(serial_successes, trials / 2);
+  EXPECT_GE(batch_successes + trials / 10, serial_successes);
+}
+
 TEST_F(LoadPlanningModelsPr2, OrientationConstraintsSampler)
 {
   robot_state::RobotState ks(kmodel);
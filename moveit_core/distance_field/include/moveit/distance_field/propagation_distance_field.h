@@ -43,7 +43,17 @@
 #include <list>
 #include <Eigen/Core>
 #include <set>
+#include <string>
 #include <octomap/octomap.h>
+#include <boost/shared_ptr.hpp>
+
+namespace boost
+{
+namespace interprocess
+{
+class mapped_region;
+}
+}
 
 namespace distance_field
 {
@@ -160,6 +170,13 @@ public:
    * \ref PropagationDistanceField description for more information on
    * the implications of this.
    *
+   * @param [in] sparse_storage Whether to store the cells in blocks
+   * that are only allocated near obstacles.  This saves memory for
+   * large, mostly empty volumes.  Distances are identical to those of
+   * a densely stored field, but unoccupied cells that are never
+   * reached by negative propagation keep an uninitialized
+   * closest_negative_point_.
+   *
    */
   PropagationDistanceField(double size_x,
                            double size_y,
@@ -167,7 +184,8 @@ public:
                            double resolution,
                            double origin_x, double origin_y, double origin_z,
                            double max_distance,
-                           bool propagate_negative_distances=false);
+                           bool propagate_negative_distances=false,
+                           bool sparse_storage=false);
 
   /**
    * \brief Constructor based on an OcTree and bounding box
@@ -190,12 +208,20 @@ public:
    * and all obstacle cells will be assigned zero distance.  See the
    * \ref PropagationDistanceField description for more information on
    * the implications of this.
+   *
+   * @param [in] sparse_storage Whether to store the cells in blocks
+   * that are only allocated near obstacles.  This saves memory for
+   * large, mostly empty volumes.  Distances are identical to those of
+   * a densely stored field, but unoccupied cells that are never
+   * reached by negative propagation keep an uninitialized
+   * closest_negative_point_.
    */
   PropagationDistanceField(const octomap::OcTree& octree,
                            const octomap::point3d& bbx_min,
                            const octomap::point3d& bbx_max,
                            double max_distance,
-                           bool propagate_negative_distances=false);
+                           bool propagate_negative_distances=false,
+                           bool sparse_storage=false);
 
   /**
    * \brief Constructor that takes an istream and reads the contents
@@ -216,11 +242,32 @@ public:
    * \ref PropagationDistanceField description for more information on
    * the implications of this.
    *
+   * @param [in] sparse_storage Whether to store the cells in blocks
+   * that are only allocated near obstacles.  This saves memory for
+   * large, mostly empty volumes.  Distances are identical to those of
+   * a densely stored field, but unoccupied cells that are never
+   * reached by negative propagation keep an uninitialized
+   * closest_negative_point_.
+   *
    * @return
    */
   PropagationDistanceField(std::istream& stream,
                            double max_distance,
-                           bool propagate_negative_distances=false);
+                           bool propagate_negative_distances=false,
+                           bool sparse_storage=false);
+
+  /**
+   * \brief Constructor that maps a distance field file written by
+   * \ref writeToMappedFile.  Calls the function \ref readFromMappedFile.
+   * If the file cannot be mapped, the field is left empty.
+   *
+   * @param [in] filename The file to map
+   *
+   * @param [in] verify_checksum Whether to verify the checksum of
+   * the cell data, which requires reading the whole file
+   */
+  PropagationDistanceField(const std::string& filename,
+                           bool verify_checksum=true);
   /**
    * \brief Empty destructor
    *
@@ -373,6 +420,54 @@ public:
    */
   virtual bool readFromStream(std::istream& stream);
 
+  /**
+   * \brief Writes the distance field, including all propagated
+   * distances, to a binary file that can be used in place by \ref
+   * readFromMappedFile.
+   *
+   * The file starts with a versioned header that gives the
+   * resolution, size, origin, maximum distance and whether negative
+   * distances are propagated, followed by a checksum of the cell
+   * data.  The cells are stored densely after the header, aligned to
+   * a page boundary, in the byte order and layout of the machine that
+   * wrote them.
+   *
+   * @param [in] filename The file to write
+   *
+   * @return True if the file was written; otherwise False.
+   */
+  bool writeToMappedFile(const std::string& filename) const;
+
+  /**
+   * \brief Maps a file written by \ref writeToMappedFile and uses its
+   * cells directly, without parsing or propagating them.
+   *
+   * The file is mapped copy-on-write, so processes mapping the same
+   * file share its pages, and the pages are only copied if the field
+   * is modified.  The file itself is never modified.  The maximum
+   * distance and whether negative distances are propagated are taken
+   * from the file; the field always uses dense storage.
+   *
+   * @param [in] filename The file to map
+   *
+   * @param [in] verify_checksum Whether to verify the checksum of
+   * the cell data, which requires reading the whole file
+   *
+   * @return True if the file was mapped; otherwise False, in which
+   * case the field is unchanged.
+   */
+  bool readFromMappedFile(const std::string& filename, bool verify_checksum=true);
+
+  /**
+   * \brief Whether the cells of the field are mapped from a file.
+   *
+   * @return True if the field was loaded by \ref readFromMappedFile
+   */
+  bool isMapped() const
+  {
+    return mapped_region_.get() != NULL;
+  }
+
   //passthrough docs to DistanceField
   virtual double getUninitializedDistance() const
   {
@@ -392,7 +487,7 @@ public:
    */
   const PropDistanceFieldVoxel& getCell(int x, int y, int z) const
   {
-    return voxel_grid_->getCell(x, y, z);
+    return getConstVoxelGrid().getCell(x, y, z);
   }
 
   /**
@@ -415,19 +510,20 @@ public:
    */
   const PropDistanceFieldVoxel* getNearestCell(int x, int y, int z, double& dist, Eigen::Vector3i& pos) const
   {
-    const PropDistanceFieldVoxel* cell = &voxel_grid_->getCell(x, y, z);
+    const VoxelGrid<PropDistanceFieldVoxel>& grid = getConstVoxelGrid();
+    const PropDistanceFieldVoxel* cell = &grid.getCell(x, y, z);
     if (cell->distance_square_ > 0)
     {
       dist = sqrt_table_[cell->distance_square_];
       pos = cell->closest_point_;
-      const PropDistanceFieldVoxel* ncell = &voxel_grid_->getCell(pos.x(), pos.y(), pos.z());
+      const PropDistanceFieldVoxel* ncell = &grid.getCell(pos.x(), pos.y(), pos.z());
       return ncell == cell ? NULL : ncell;
     }
     if (cell->negative_distance_square_ > 0)
     {
       dist = -sqrt_table_[cell->negative_distance_square_];
       pos = cell->closest_negative_point_;
-      const PropDistanceFieldVoxel* ncell = &voxel_grid_->getCell(pos.x(), pos.y(), pos.z());
+      const PropDistanceFieldVoxel* ncell = &grid.getCell(pos.x(), pos.y(), pos.z());
       return ncell == cell ? NULL : ncell;
     }
     dist = 0.0;
@@ -450,17 +546,79 @@ public:
     return max_distance_sq_;
   }
 
+  /**
+   * \brief Sets the number of threads used to propagate distances.
+   *
+   * With more than one thread, the voxels of each sufficiently large
+   * bucket of the propagation queue are expanded concurrently and
+   * the resulting updates are then applied in the same order as the
+   * serial propagation would apply them.  The distances, closest
+   * points and update directions are therefore identical to those
+   * computed with a single thread.  The bucket is split into this
+   * many ranges, which are evaluated by a worker pool shared by all
+   * fields and sized to the hardware concurrency.
+   *
+   * @param [in] thread_count The number of threads; 0 is treated as 1
+   */
+  void setPropagationThreadCount(unsigned int thread_count);
+
+  /**
+   * \brief Gets the number of threads used to propagate distances.
+   *
+   * @return The number of propagation threads, 1 by default
+   */
+  unsigned int getPropagationThreadCount() const
+  {
+    return propagation_thread_count_;
+  }
+
+  /**
+   * \brief Whether cells are stored in blocks allocated on demand.
+   *
+   * @return True if the field was constructed with sparse storage
+   */
+  bool hasSparseStorage() const
+  {
+    return sparse_storage_;
+  }
+
+  /**
+   * \brief Gets the number of cells for which memory is allocated.
+   *
+   * @return The number of allocated cells
+   */
+  std::size_t getNumAllocatedCells() const
+  {
+    return voxel_grid_->getNumAllocatedCells();
+  }
+
 private:
 
   typedef std::set<Eigen::Vector3i, compareEigen_Vector3i> VoxelSet; /**< \brief Typedef for set of integer indices */
 
+  /**
+   * \brief Updates computed by one thread for a contiguous range of a
+   * bucket, to be applied in order once all threads are done.
+   */
+  struct PropagationChunk
+  {
+    std::vector<Eigen::Vector3i> closest_points_; /**< \brief Closest point of each voxel in the range when expanded */
+    std::vector<int> update_directions_;          /**< \brief Update direction of each voxel in the range when expanded */
+    std::vector<std::size_t> update_begin_;       /**< \brief Index of the first update proposed by each voxel in the range */
+    std::vector<Eigen::Vector3i> update_locations_; /**< \brief Neighbor cells proposed for update */
+    std::vector<int> update_distances_;           /**< \brief Proposed squared distances */
+    std::vector<int> update_neighbor_directions_; /**< \brief Update directions for the proposed cells */
+  };
+
   /**
    * \brief Initializes the field, resetting the voxel grid and
    * building a sqrt lookup table for efficiency based on
    * max_distance_.
    *
+   * @param mapped_data If not NULL, dense cell data that is used
+   * as is instead of allocating and resetting the voxel grid
    */
-  void initialize();
+  void initialize(PropDistanceFieldVoxel* mapped_data=NULL);
 
   /**
    * \brief Adds a valid set of integer points to the voxel grid
@@ -492,6 +650,66 @@ private:
    */
   void propagateNegative();
 
+  /**
+   * \brief Propagates from a single voxel of a bucket, pushing any
+   * updated neighbors into the appropriate bucket queue.
+   *
+   * @param loc The voxel to propagate from
+   * @param bucket The index of the bucket being processed
+   * @param negative Whether to propagate negative distances
+   */
+  void propagateVoxel(Eigen::Vector3i loc, unsigned int bucket, bool negative);
+
+  /**
+   * \brief Processes one bucket of the positive or negative bucket
+   * queue using \ref propagation_thread_count_ threads, producing
+   * the same result as calling \ref propagateVoxel for each entry in
+   * order.
+   *
+   * @param bucket The index of the bucket to process
+   * @param negative Whether to process the negative bucket queue
+   */
+  void propagateBucketParallel(unsigned int bucket, bool negative);
+
+  /**
+   * \brief The voxel grid for read-only access.  The shared pointer
+   * does not carry constness, and with sparse storage the non-const
+   * cell accessors allocate blocks, so const methods must read
+   * through this.
+   */
+  const VoxelGrid<PropDistanceFieldVoxel>& getConstVoxelGrid() const
+  {
+    return static_cast<const VoxelGrid<PropDistanceFieldVoxel>&>(*voxel_grid_);
+  }
+
+  /**
+   * \brief Computes, without modifying the grid, the updates that a
+   * range of voxels of a bucket would make to their neighbors.
+   *
+   * @param bucket The index of the bucket being processed
+   * @param negative Whether the negative bucket queue is processed
+   * @param begin The first entry of the range
+   * @param end One past the last entry of the range
+   * @param chunk The updates for the range
+   */
+  void computeBucketUpdates(unsigned int bucket, bool negative,
+                            std::size_t begin, std::size_t end,
+                            PropagationChunk* chunk) const;
+
+  /**
+   * \brief Computes the updates for one range of a bucket that was
+   * split by \ref propagateBucketParallel; a task of the worker pool.
+   *
+   * @param bucket The index of the bucket being processed
+   * @param negative Whether the negative bucket queue is processed
+   * @param chunk_begin The first entry of each range, followed by the bucket size
+   * @param chunks The updates for each range
+   * @param index The range to compute
+   */
+  void computeBucketChunk(unsigned int bucket, bool negative,
+                          const std::vector<std::size_t>& chunk_begin,
+                          std::vector<PropagationChunk>& chunks, std::size_t index) const;
+
   /**
    * \brief Determines distance based on actual voxel data
    *
@@ -556,8 +774,12 @@ private:
 
   bool propagate_negative_;     /**< \brief Whether or not to propagate negative distances */
 
+  bool sparse_storage_;         /**< \brief Whether the voxel grid allocates its cells on demand */
+
   VoxelGrid<PropDistanceFieldVoxel>::Ptr voxel_grid_; /**< \brief Actual container for distance data */
 
+  boost::shared_ptr<boost::interprocess::mapped_region> mapped_region_; /**< \brief Mapping of the file holding the cells, if any */
+
   /// \brief Structure used to hold propagation frontier
   std::vector<std::vector<Eigen::Vector3i> > bucket_queue_; /**< \brief Data member that holds points from which to propagate, where each vector holds points that are a particular integer distance from the closest obstacle points*/
 
@@ -566,6 +788,8 @@ private:
   double max_distance_;         /**< \brief Holds maximum distance  */
   int max_distance_sq_;         /**< \brief Holds maximum distance squared in cells */
 
+  unsigned int propagation_thread_count_; /**< \brief Number of threads used to process large buckets */
+
   std::vector<double> sqrt_table_; /**< \brief Precomputed square root table for faster distance lookups */
 
   /**
@@ -39,6 +39,8 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
+#include <vector>
 #include <Eigen/Core>
 #include <moveit/macros/declare_ptr.h>
 
@@ -53,10 +55,14 @@ enum Dimension {
 };
 
 /**
- * \brief VoxelGrid holds a dense 3D, axis-aligned set of data at a
- * given resolution, where the data is supplied as a template
- * parameter.
+ * \brief VoxelGrid holds a 3D, axis-aligned set of data at a given
+ * resolution, where the data is supplied as a template parameter.
  *
+ * By default the data is stored densely.  Alternatively, the grid can
+ * be split into blocks of 8x8x8 cells that are only allocated once a
+ * cell in them is accessed for writing, with the cells of each block
+ * stored in Morton order.  This sparse storage is meant for large,
+ * mostly uniform volumes.
  */
 template <typename T>
 class VoxelGrid
@@ -88,9 +94,17 @@ public:
    *
    * @param [in] default_object An object that will be returned for any
    * future queries that are not valid
+   *
+   * @param [in] sparse Whether to allocate the grid in blocks on
+   * demand rather than all at once
+   *
+   * @param [in] external_data Dense storage for the cells that is
+   * owned by the caller and must outlive the grid; ignored for sparse
+   * grids.  If NULL, the grid allocates its own storage.
    */
   VoxelGrid(double size_x, double size_y, double size_z, double resolution,
-            double origin_x, double origin_y, double origin_z, T default_object);
+            double origin_x, double origin_y, double origin_z, T default_object,
+            bool sparse=false, T* external_data=NULL);
   virtual ~VoxelGrid();
 
   /**
@@ -117,9 +131,17 @@ public:
    * @param [in] origin_x Minimum point along the X axis of the volume
    * @param [in] origin_y Minimum point along the Y axis of the volume
    * @param [in] origin_z Minimum point along the Z axis of the volume
+   *
+   * @param [in] sparse Whether to allocate the grid in blocks on
+   * demand rather than all at once
+   *
+   * @param [in] external_data Dense storage for the cells that is
+   * owned by the caller and must outlive the grid; ignored for sparse
+   * grids.  If NULL, the grid allocates its own storage.
    */
   void resize(double size_x, double size_y, double size_z, double resolution,
-    double origin_x, double origin_y, double origin_z, T default_object);
+    double origin_x, double origin_y, double origin_z, T default_object,
+    bool sparse=false, T* external_data=NULL);
 
   /**
    * \brief Operator that gets the value of the given location (x, y,
@@ -152,7 +174,10 @@ public:
    * @param [in] z The Z index of the desired cell
    *
    * @return The data in the indicated cell.  If x,y,z is invalid then
-   * corruption and/or SEGFAULTS will occur.
+   * corruption and/or SEGFAULTS will occur.  With sparse storage, the
+   * non-const versions allocate the block holding the cell, while the
+   * const versions return the value given to \ref reset for cells of
+   * blocks that are not allocated.
    */
   T& getCell(int x, int y, int z);
   T& getCell(const Eigen::Vector3i& pos);
@@ -181,12 +206,36 @@ public:
   void setCell(const Eigen::Vector3i& pos, const T& obj);
 
   /**
-   * \brief Sets every cell in the voxel grid to the supplied data
+   * \brief Sets every cell in the voxel grid to the supplied data.
+   * With sparse storage, this releases all allocated blocks.
    *
    * @param [in] initial The template variable to which to set the data
    */
   void reset(const T& initial);
 
+  /**
+   * \brief Whether cells are allocated in blocks on demand
+   *
+   * @return True if the grid uses sparse storage; otherwise False.
+   */
+  bool isSparse() const;
+
+  /**
+   * \brief Gets the number of cells for which memory is allocated.
+   * This is the total number of cells for dense storage.
+   *
+   * @return The number of allocated cells
+   */
+  std::size_t getNumAllocatedCells() const;
+
+  /**
+   * \brief Gets the storage of a dense grid, where the cell (x,y,z)
+   * is found at index (x*num_y + y)*num_z + z.
+   *
+   * @return The cell storage, or NULL for sparse or empty grids
+   */
+  const T* getData() const;
+
   /**
    * \brief Gets the size in arbitrary units of the indicated dimension
    *
@@ -288,6 +337,7 @@ public:
 
 protected:
   T* data_;                     /**< \brief Storage for the full set of data elements */
+  bool owns_data_;              /**< \brief Whether data_ was allocated by the grid */
   T default_object_;            /**< \brief The default object to return in case of out-of-bounds query */
   T*** data_ptrs_;              /**< \brief 3D array of pointers to the data elements */
   double size_[3];              /**< \brief The size of each dimension in meters (in Dimension order) */
@@ -300,6 +350,15 @@ protected:
   int stride1_;                 /**< \brief The step to take when stepping between consecutive X members in the 1D array */
   int stride2_;                 /**< \brief The step to take when stepping between consecutive Y members given an X in the 1D array */
 
+  bool sparse_;                 /**< \brief Whether the data is stored in blocks allocated on demand */
+  std::vector<T*> blocks_;      /**< \brief Storage for the blocks of a sparse grid; NULL for blocks that are not allocated */
+  int num_blocks_[3];           /**< \brief The number of blocks in each dimension (in Dimension order) */
+  T initial_object_;            /**< \brief The value of all cells in blocks that are not allocated */
+
+  static const int BLOCK_BITS = 3; /**< \brief Blocks have 2^BLOCK_BITS cells along each dimension */
+  static const int BLOCK_MASK = (1 << BLOCK_BITS) - 1;
+  static const int BLOCK_CELLS = 1 << (3 * BLOCK_BITS);
+
   /**
    * \brief Gets the 1D index into the array, with no validity check.
    *
@@ -311,6 +370,27 @@ protected:
    */
   int ref(int x, int y, int z) const;
 
+  /**
+   * \brief Gets the index of the block holding a cell of a sparse
+   * grid, with no validity check.
+   */
+  int blockRef(int x, int y, int z) const;
+
+  /**
+   * \brief Gets the Morton order index of a cell within its block.
+   */
+  static int cellInBlockRef(int x, int y, int z);
+
+  /**
+   * \brief Gets a cell of a sparse grid, allocating its block if needed.
+   */
+  T& getSparseCell(int x, int y, int z);
+
+  /**
+   * \brief Releases all blocks of a sparse grid.
+   */
+  void clearBlocks();
+
   /**
    * \brief Gets the cell number from the location
    */
@@ -342,15 +422,19 @@ protected:
 
 template<typename T>
 VoxelGrid<T>::VoxelGrid(double size_x, double size_y, double size_z, double resolution,
-    double origin_x, double origin_y, double origin_z, T default_object)
+    double origin_x, double origin_y, double origin_z, T default_object, bool sparse, T* external_data)
   : data_(NULL)
+  , owns_data_(false)
+  , sparse_(false)
 {
-  resize(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z, default_object);
+  resize(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z, default_object, sparse, external_data);
 }
 
 template<typename T>
 VoxelGrid<T>::VoxelGrid()
   : data_(NULL)
+  , owns_data_(false)
+  , sparse_(false)
 {
   for (int i=DIM_X; i<=DIM_Z; ++i)
   {
@@ -358,6 +442,7 @@ VoxelGrid<T>::VoxelGrid()
     origin_[i] = 0;
     origin_minus_[i] = 0;
     num_cells_[i] = 0;
+    num_blocks_[i] = 0;
   }
   resolution_ = 1.0;
   oo_resolution_ = 1.0 / resolution_;
@@ -368,10 +453,14 @@ VoxelGrid<T>::VoxelGrid()
 
 template<typename T>
 void VoxelGrid<T>::resize(double size_x, double size_y, double size_z, double resolution,
-    double origin_x, double origin_y, double origin_z, T default_object)
+    double origin_x, double origin_y, double origin_z, T default_object, bool sparse, T* external_data)
 {
-  delete[] data_;
+  if (owns_data_)
+    delete[] data_;
   data_ = NULL;
+  owns_data_ = false;
+  clearBlocks();
+  blocks_.clear();
 
   size_[DIM_X] = size_x;
   size_[DIM_Y] = size_y;
@@ -392,19 +481,61 @@ void VoxelGrid<T>::resize(double size_x, double size_y, double size_z, double re
   }
 
   default_object_ = default_object;
+  initial_object_ = default_object;
 
   stride1_ = num_cells_[DIM_Y]*num_cells_[DIM_Z];
   stride2_ = num_cells_[DIM_Z];
 
   // initialize the data:
-  if (num_cells_total_ > 0)
+  sparse_ = sparse;
+  if (sparse_)
+  {
+    std::size_t num_blocks_total = 1;
+    for (int i=DIM_X; i<=DIM_Z; ++i)
+    {
+      num_blocks_[i] = (num_cells_[i] + BLOCK_MASK) >> BLOCK_BITS;
+      num_blocks_total *= num_blocks_[i];
+    }
+    if (num_cells_total_ > 0)
+      blocks_.resize(num_blocks_total, NULL);
+  }
+  else if (external_data)
+    data_ = external_data;
+  else if (num_cells_total_ > 0)
+  {
     data_ = new T[num_cells_total_];
+    owns_data_ = true;
+  }
 }
 
 template<typename T>
 VoxelGrid<T>::~VoxelGrid()
 {
-  delete[] data_;
+  if (owns_data_)
+    delete[] data_;
+  clearBlocks();
+}
+
+template<typename T>
+void VoxelGrid<T>::clearBlocks()
+{
+  for (std::size_t i=0; i<blocks_.size(); ++i)
+  {
+    delete[] blocks_[i];
+    blocks_[i] = NULL;
+  }
+}
+
+template<typename T>
+T& VoxelGrid<T>::getSparseCell(int x, int y, int z)
+{
+  T*& block = blocks_[blockRef(x,y,z)];
+  if (!block)
+  {
+    block = new T[BLOCK_CELLS];
+    std::fill(block, block + BLOCK_CELLS, initial_object_);
+  }
+  return block[cellInBlockRef(x,y,z)];
 }
 
 template<typename T>
@@ -434,6 +565,49 @@ inline int VoxelGrid<T>::ref(int x, int y, int z) const
   return x*stride1_ + y*stride2_ + z;
 }
 
+template<typename T>
+inline int VoxelGrid<T>::blockRef(int x, int y, int z) const
+{
+  return ((x >> BLOCK_BITS)*num_blocks_[DIM_Y] + (y >> BLOCK_BITS))*num_blocks_[DIM_Z] + (z >> BLOCK_BITS);
+}
+
+template<typename T>
+inline int VoxelGrid<T>::cellInBlockRef(int x, int y, int z)
+{
+  // interleave the three low bits of each coordinate so that cells
+  // that are close in space are close in memory
+  x &= BLOCK_MASK;
+  y &= BLOCK_MASK;
+  z &= BLOCK_MASK;
+  return ((x & 1) << 2) | ((y & 1) << 1) | (z & 1) |
+    ((x & 2) << 4) | ((y & 2) << 3) | ((z & 2) << 2) |
+    ((x & 4) << 6) | ((y & 4) << 5) | ((z & 4) << 4);
+}
+
+template<typename T>
+inline bool VoxelGrid<T>::isSparse() const
+{
+  return sparse_;
+}
+
+template<typename T>
+inline const T* VoxelGrid<T>::getData() const
+{
+  return data_;
+}
+
+template<typename T>
+inline std::size_t VoxelGrid<T>::getNumAllocatedCells() const
+{
+  if (!sparse_)
+    return data_ ? num_cells_total_ : 0;
+  std::size_t num_blocks = 0;
+  for (std::size_t i=0; i<blocks_.size(); ++i)
+    if (blocks_[i])
+      ++num_blocks;
+  return num_blocks * BLOCK_CELLS;
+}
+
 template<typename T>
 inline double VoxelGrid<T>::getSize(Dimension dim) const
 {
@@ -484,37 +658,44 @@ inline const T& VoxelGrid<T>::operator()(const Eigen::Vector3d& pos) const
 template<typename T>
 inline T& VoxelGrid<T>::getCell(int x, int y, int z)
 {
+  if (sparse_)
+    return getSparseCell(x, y, z);
   return data_[ref(x,y,z)];
 }
 
 template<typename T>
 inline const T& VoxelGrid<T>::getCell(int x, int y, int z) const
 {
+  if (sparse_)
+  {
+    const T* block = blocks_[blockRef(x,y,z)];
+    return block ? block[cellInBlockRef(x,y,z)] : initial_object_;
+  }
   return data_[ref(x,y,z)];
 }
 
 template<typename T>
 inline T& VoxelGrid<T>::getCell(const Eigen::Vector3i& pos)
 {
-  return data_[ref(pos.x(), pos.y(), pos.z())];
+  return getCell(pos.x(), pos.y(), pos.z());
 }
 
 template<typename T>
 inline const T& VoxelGrid<T>::getCell(const Eigen::Vector3i& pos) const
 {
-  return data_[ref(pos.x(), pos.y(), pos.z())];
+  return getCell(pos.x(), pos.y(), pos.z());
 }
 
 template<typename T>
 inline void VoxelGrid<T>::setCell(int x, int y, int z, const T& obj)
 {
-  data_[ref(x,y,z)] = obj;
+  getCell(x,y,z) = obj;
 }
 
 template<typename T>
 inline void VoxelGrid<T>::setCell(const Eigen::Vector3i& pos, const T& obj)
 {
-  data_[ref(pos.x(), pos.y(), pos.z())] = obj;
+  getCell(pos.x(), pos.y(), pos.z()) = obj;
 }
 
 template<typename T>
@@ -547,7 +728,13 @@ inline double VoxelGrid<T>::getLocationFromCell(Dimension dim, int cell) const
 template<typename T>
 inline void VoxelGrid<T>::reset(const T& initial)
 {
-  std::fill(data_, data_ + num_cells_total_, initial);
+  if (sparse_)
+  {
+    clearBlocks();
+    initial_object_ = initial;
+  }
+  else
+    std::fill(data_, data_ + num_cells_total_, initial);
 }
 
 template<typename T>
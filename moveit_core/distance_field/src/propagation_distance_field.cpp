@@ -35,23 +35,84 @@
 /* Author: Mrinal Kalakrishnan, Ken Anderson */
 
 #include <moveit/distance_field/propagation_distance_field.h>
+#include <moveit/background_processing/worker_pool.h>
 #include <visualization_msgs/Marker.h>
 #include <console_bridge/console.h>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/copy.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <fstream>
+#include <cstring>
 
 namespace distance_field
 {
 
+// buckets with fewer entries than this are expanded serially, as
+// splitting them across threads costs more than it saves
+static const std::size_t MIN_PARALLEL_BUCKET_SIZE = 4096;
+
+// shared by all fields, so the threads are started once rather than for every bucket
+static moveit::tools::WorkerPool& getPropagationWorkers()
+{
+  static moveit::tools::WorkerPool workers(std::max(1u, boost::thread::hardware_concurrency()) - 1);
+  return workers;
+}
+
+static const char MAPPED_FILE_MAGIC[8] = { 'M', 'V', 'I', 'T', 'P', 'D', 'F', '\0' };
+static const boost::uint32_t MAPPED_FILE_VERSION = 1;
+static const boost::uint32_t MAPPED_FILE_BYTE_ORDER = 0x01020304;
+// cell data starts on a page boundary so it can be used in place
+static const boost::uint64_t MAPPED_FILE_DATA_OFFSET = 4096;
+
+/// \brief Header of the files written by writeToMappedFile()
+struct MappedFileHeader
+{
+  char magic_[8];
+  boost::uint32_t version_;
+  boost::uint32_t byte_order_;
+  boost::uint32_t voxel_size_;
+  boost::uint32_t propagate_negative_;
+  boost::int32_t num_cells_[3];
+  boost::int32_t max_distance_sq_;
+  double resolution_;
+  double size_[3];
+  double origin_[3];
+  double max_distance_;
+  boost::uint64_t data_offset_;
+  boost::uint64_t data_size_;
+  boost::uint64_t checksum_;
+};
+
+// 64 bit FNV-1a over 32 bit words; the cell data is always a multiple of 4 bytes long
+static boost::uint64_t updateChecksum(boost::uint64_t hash, const char* data, std::size_t size)
+{
+  for (std::size_t i = 0 ; i + sizeof(boost::uint32_t) <= size ; i += sizeof(boost::uint32_t))
+  {
+    boost::uint32_t word;
+    memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+static const boost::uint64_t CHECKSUM_SEED = 14695981039346656037ULL;
+
 PropagationDistanceField::PropagationDistanceField(double size_x, double size_y, double size_z,
                                                    double resolution,
                                                    double origin_x, double origin_y, double origin_z,
                                                    double max_distance,
-                                                   bool propagate_negative):
+                                                   bool propagate_negative,
+                                                   bool sparse_storage):
   DistanceField(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z),
   propagate_negative_(propagate_negative),
-  max_distance_(max_distance)
+  sparse_storage_(sparse_storage),
+  max_distance_(max_distance),
+  propagation_thread_count_(1)
 {
   initialize();
 }
@@ -60,7 +121,8 @@ PropagationDistanceField::PropagationDistanceField(const octomap::OcTree& octree
                                                    const octomap::point3d& bbx_min,
                                                    const octomap::point3d& bbx_max,
                                                    double max_distance,
-                                                   bool propagate_negative_distances) :
+                                                   bool propagate_negative_distances,
+                                                   bool sparse_storage) :
   DistanceField(bbx_max.x()-bbx_min.x(),
                 bbx_max.y()-bbx_min.y(),
                 bbx_max.z()-bbx_min.z(),
@@ -69,7 +131,9 @@ PropagationDistanceField::PropagationDistanceField(const octomap::OcTree& octree
                 bbx_min.y(),
                 bbx_min.z()),
   propagate_negative_(propagate_negative_distances),
-  max_distance_(max_distance)
+  sparse_storage_(sparse_storage),
+  max_distance_(max_distance),
+  propagation_thread_count_(1)
 {
   initialize();
   addOcTreeToField(&octree);
@@ -77,21 +141,43 @@ PropagationDistanceField::PropagationDistanceField(const octomap::OcTree& octree
 
 PropagationDistanceField::PropagationDistanceField(std::istream& is,
                                                    double max_distance,
-                                                   bool propagate_negative_distances) :
+                                                   bool propagate_negative_distances,
+                                                   bool sparse_storage) :
   DistanceField(0,0,0,0,0,0,0),
   propagate_negative_(propagate_negative_distances),
-  max_distance_(max_distance)
+  sparse_storage_(sparse_storage),
+  max_distance_(max_distance),
+  propagation_thread_count_(1)
 {
   readFromStream(is);
 }
 
-void PropagationDistanceField::initialize()
+PropagationDistanceField::PropagationDistanceField(const std::string& filename,
+                                                   bool verify_checksum) :
+  DistanceField(0,0,0,0,0,0,0),
+  propagate_negative_(false),
+  sparse_storage_(false),
+  max_distance_(0.0),
+  propagation_thread_count_(1)
+{
+  // leave an empty field behind if the file cannot be used
+  if (!readFromMappedFile(filename, verify_checksum))
+  {
+    resolution_ = 1.0;
+    initialize();
+  }
+}
+
+void PropagationDistanceField::initialize(PropDistanceFieldVoxel* mapped_data)
 {
   max_distance_sq_ = ceil(max_distance_/resolution_)*ceil(max_distance_/resolution_);
   voxel_grid_.reset(new VoxelGrid<PropDistanceFieldVoxel>(size_x_, size_y_, size_z_,
                                                           resolution_,
                                                           origin_x_, origin_y_, origin_z_,
-                                                          PropDistanceFieldVoxel(max_distance_sq_,0)));
+                                                          PropDistanceFieldVoxel(max_distance_sq_,0),
+                                                          sparse_storage_, mapped_data));
+  if (!mapped_data)
+    mapped_region_.reset();
 
   initNeighborhoods();
 
@@ -103,7 +189,8 @@ void PropagationDistanceField::initialize()
   for (int i=0; i<=max_distance_sq_; ++i)
     sqrt_table_[i] = sqrt(double(i))*resolution_;
 
-  reset();
+  if (!mapped_data)
+    reset();
 }
 
 int PropagationDistanceField::eucDistSq(Eigen::Vector3i point1, Eigen::Vector3i point2)
@@ -179,7 +266,7 @@ void PropagationDistanceField::updatePointsInField(const EigenSTL::vector_Vector
 
   std::vector<Eigen::Vector3i> new_not_in_current;
   for(unsigned int i = 0; i < new_not_old.size(); i++) {
-    if(voxel_grid_->getCell(new_not_old[i].x(),new_not_old[i].y(),new_not_old[i].z()).distance_square_ != 0) {
+    if(getCell(new_not_old[i].x(),new_not_old[i].y(),new_not_old[i].z()).distance_square_ != 0) {
       new_not_in_current.push_back(new_not_old[i]);
     }
     //logInform("Adding obstacle voxel %d %d %d", (*it).x(), (*it).y(), (*it).z());
@@ -210,7 +297,7 @@ void PropagationDistanceField::addPointsToField(const EigenSTL::vector_Vector3d&
 
     if( valid )
     {
-      if(voxel_grid_->getCell(voxel_loc.x(),voxel_loc.y(),voxel_loc.z()).distance_square_ > 0) {
+      if(getCell(voxel_loc.x(),voxel_loc.y(),voxel_loc.z()).distance_square_ > 0) {
         voxel_points.push_back(voxel_loc);
       }
     }
@@ -246,9 +333,12 @@ void PropagationDistanceField::addNewObstacleVoxels(const std::vector<Eigen::Vec
 {
   int initial_update_direction = getDirectionNumber(0,0,0);
   bucket_queue_[0].reserve(voxel_points.size());
+  // the stacks start out with the given voxels and grow as neighbors are
+  // reset; reserving the size of the whole grid would allocate memory
+  // proportional to the volume on every update
   std::vector<Eigen::Vector3i> negative_stack;
   if(propagate_negative_) {
-    negative_stack.reserve(getXNumCells() * getYNumCells() * getZNumCells());
+    negative_stack.reserve(voxel_points.size());
     negative_bucket_queue_[0].reserve(voxel_points.size());
   }
 
@@ -323,15 +413,12 @@ void PropagationDistanceField::removeObstacleVoxels(const std::vector<Eigen::Vec
 //const VoxelSet& locations )
 {
   std::vector<Eigen::Vector3i> stack;
-  std::vector<Eigen::Vector3i> negative_stack;
   int initial_update_direction = getDirectionNumber(0,0,0);
 
-  stack.reserve(getXNumCells() * getYNumCells() * getZNumCells());
+  stack.reserve(voxel_points.size());
   bucket_queue_[0].reserve(voxel_points.size());
-  if(propagate_negative_) {
-    negative_stack.reserve(getXNumCells() * getYNumCells() * getZNumCells());
+  if(propagate_negative_)
     negative_bucket_queue_[0].reserve(voxel_points.size());
-  }
 
   // First reset the obstacle voxels,
   // VoxelSet::const_iterator it = locations.begin();
@@ -401,127 +488,240 @@ void PropagationDistanceField::removeObstacleVoxels(const std::vector<Eigen::Vec
   }
 }
 
+void PropagationDistanceField::setPropagationThreadCount(unsigned int thread_count)
+{
+  propagation_thread_count_ = thread_count > 0 ? thread_count : 1;
+}
+
 void PropagationDistanceField::propagatePositive()
 {
 
   // now process the queue:
   for (unsigned int i=0; i<bucket_queue_.size(); ++i)
   {
-    std::vector<Eigen::Vector3i>::iterator list_it = bucket_queue_[i].begin();
-    std::vector<Eigen::Vector3i>::iterator list_end = bucket_queue_[i].end();
-    for ( ; list_it != list_end ; ++list_it)
+    if (propagation_thread_count_ > 1 && bucket_queue_[i].size() >= MIN_PARALLEL_BUCKET_SIZE)
+      propagateBucketParallel(i, false);
+    else
     {
-      const Eigen::Vector3i& loc = *list_it;
-      PropDistanceFieldVoxel* vptr = &voxel_grid_->getCell(loc.x(), loc.y(), loc.z());
+      // voxels pushed onto this bucket while it is processed are not expanded
+      std::size_t bucket_size = bucket_queue_[i].size();
+      for (std::size_t j=0; j<bucket_size; ++j)
+        propagateVoxel(bucket_queue_[i][j], i, false);
+    }
+    bucket_queue_[i].clear();
+  }
+}
 
-      // select the neighborhood list based on the update direction:
-      std::vector<Eigen::Vector3i >* neighborhood;
-      int D = i;
-      if (D>1)
-        D=1;
+void PropagationDistanceField::propagateNegative()
+{
 
-      // This will never happen.  update_direction_ is always set before voxel is added to bucket queue.
-      if (vptr->update_direction_<0 || vptr->update_direction_>26)
-      {
-        logError("PROGRAMMING ERROR: Invalid update direction detected: %d", vptr->update_direction_);
-        continue;
-      }
+  // now process the queue:
+  for (unsigned int i=0; i<negative_bucket_queue_.size(); ++i)
+  {
+    if (propagation_thread_count_ > 1 && negative_bucket_queue_[i].size() >= MIN_PARALLEL_BUCKET_SIZE)
+      propagateBucketParallel(i, true);
+    else
+    {
+      // voxels pushed onto this bucket while it is processed are not expanded
+      std::size_t bucket_size = negative_bucket_queue_[i].size();
+      for (std::size_t j=0; j<bucket_size; ++j)
+        propagateVoxel(negative_bucket_queue_[i][j], i, true);
+    }
+    negative_bucket_queue_[i].clear();
+  }
+}
 
-      neighborhood = &neighborhoods_[D][vptr->update_direction_];
+void PropagationDistanceField::propagateVoxel(Eigen::Vector3i loc, unsigned int bucket, bool negative)
+{
+  std::vector<std::vector<Eigen::Vector3i> >& queue = negative ? negative_bucket_queue_ : bucket_queue_;
+  PropDistanceFieldVoxel* vptr = &voxel_grid_->getCell(loc.x(), loc.y(), loc.z());
+  int update_direction = negative ? vptr->negative_update_direction_ : vptr->update_direction_;
 
-      for (unsigned int n=0; n<neighborhood->size(); n++)
-      {
-        Eigen::Vector3i diff = (*neighborhood)[n];
-        Eigen::Vector3i nloc( loc.x() + diff.x(), loc.y() + diff.y(), loc.z() + diff.z() );
-        if (!isCellValid(nloc.x(), nloc.y(), nloc.z()) )
-          continue;
+  // This will never happen.  The update direction is always set before voxel is added to a bucket queue.
+  if (update_direction<0 || update_direction>26)
+  {
+    logError("PROGRAMMING ERROR: Invalid update direction detected: %d", update_direction);
+    return;
+  }
 
-        // the real update code:
-        // calculate the neighbor's new distance based on my closest filled voxel:
-        PropDistanceFieldVoxel* neighbor = &voxel_grid_->getCell(nloc.x(),nloc.y(),nloc.z());
-        int new_distance_sq = eucDistSq(vptr->closest_point_, nloc);
-        if (new_distance_sq > max_distance_sq_)
-          continue;
+  // select the neighborhood list based on the update direction:
+  int D = bucket;
+  if (D>1)
+    D=1;
+  const std::vector<Eigen::Vector3i>& neighborhood = neighborhoods_[D][update_direction];
+  const Eigen::Vector3i closest_point = negative ? vptr->closest_negative_point_ : vptr->closest_point_;
 
+  for (unsigned int n=0; n<neighborhood.size(); n++)
+  {
+    const Eigen::Vector3i& diff = neighborhood[n];
+    Eigen::Vector3i nloc( loc.x() + diff.x(), loc.y() + diff.y(), loc.z() + diff.z() );
+    if (!isCellValid(nloc.x(), nloc.y(), nloc.z()) )
+      continue;
+
+    // the real update code:
+    // calculate the neighbor's new distance based on my closest filled voxel:
+    PropDistanceFieldVoxel* neighbor = &voxel_grid_->getCell(nloc.x(),nloc.y(),nloc.z());
+    int new_distance_sq = eucDistSq(closest_point, nloc);
+    if (new_distance_sq > max_distance_sq_)
+      continue;
+
+    int& neighbor_distance_sq = negative ? neighbor->negative_distance_square_ : neighbor->distance_square_;
+    if (new_distance_sq < neighbor_distance_sq)
+    {
+      // update the neighboring voxel
+      neighbor_distance_sq = new_distance_sq;
+      if (negative)
+      {
+        neighbor->closest_negative_point_ = closest_point;
+        neighbor->negative_update_direction_ = getDirectionNumber(diff.x(), diff.y(), diff.z());
+      }
+      else
+      {
+        neighbor->closest_point_ = closest_point;
+        neighbor->update_direction_ = getDirectionNumber(diff.x(), diff.y(), diff.z());
+      }
 
-        if (new_distance_sq < neighbor->distance_square_)
-        {
-          // update the neighboring voxel
-          neighbor->distance_square_ = new_distance_sq;
-          neighbor->closest_point_ = vptr->closest_point_;
-          neighbor->update_direction_ = getDirectionNumber(diff.x(), diff.y(), diff.z());
+      // and put it in the queue:
+      queue[new_distance_sq].push_back(nloc);
+    }
+  }
+}
 
-          // and put it in the queue:
-          bucket_queue_[new_distance_sq].push_back(nloc);
-        }
+void PropagationDistanceField::computeBucketUpdates(unsigned int bucket, bool negative,
+                                                    std::size_t begin, std::size_t end,
+                                                    PropagationChunk* chunk) const
+{
+  const std::vector<Eigen::Vector3i>& entries = negative ? negative_bucket_queue_[bucket] : bucket_queue_[bucket];
+  int D = bucket;
+  if (D>1)
+    D=1;
+
+  chunk->closest_points_.clear();
+  chunk->update_directions_.clear();
+  chunk->update_begin_.clear();
+  chunk->update_locations_.clear();
+  chunk->update_distances_.clear();
+  chunk->update_neighbor_directions_.clear();
+  chunk->closest_points_.reserve(end - begin);
+  chunk->update_directions_.reserve(end - begin);
+  chunk->update_begin_.reserve(end - begin + 1);
+
+  // this runs concurrently on several threads, so it must not allocate blocks
+  const VoxelGrid<PropDistanceFieldVoxel>& grid = getConstVoxelGrid();
+  for (std::size_t j=begin; j<end; ++j)
+  {
+    const Eigen::Vector3i& loc = entries[j];
+    const PropDistanceFieldVoxel& voxel = grid.getCell(loc.x(), loc.y(), loc.z());
+    const Eigen::Vector3i& closest_point = negative ? voxel.closest_negative_point_ : voxel.closest_point_;
+    int update_direction = negative ? voxel.negative_update_direction_ : voxel.update_direction_;
+    chunk->closest_points_.push_back(closest_point);
+    chunk->update_directions_.push_back(update_direction);
+    chunk->update_begin_.push_back(chunk->update_locations_.size());
+    if (update_direction<0 || update_direction>26)
+      continue;
+
+    const std::vector<Eigen::Vector3i>& neighborhood = neighborhoods_[D][update_direction];
+    for (unsigned int n=0; n<neighborhood.size(); n++)
+    {
+      const Eigen::Vector3i& diff = neighborhood[n];
+      Eigen::Vector3i nloc( loc.x() + diff.x(), loc.y() + diff.y(), loc.z() + diff.z() );
+      if (!isCellValid(nloc.x(), nloc.y(), nloc.z()) )
+        continue;
+      int new_distance_sq = eucDistSq(closest_point, nloc);
+      if (new_distance_sq > max_distance_sq_)
+        continue;
+
+      // distances only decrease while a bucket is processed, so a
+      // neighbor that is already closer cannot be updated later on
+      const PropDistanceFieldVoxel& neighbor = grid.getCell(nloc.x(), nloc.y(), nloc.z());
+      if (new_distance_sq < (negative ? neighbor.negative_distance_square_ : neighbor.distance_square_))
+      {
+        chunk->update_locations_.push_back(nloc);
+        chunk->update_distances_.push_back(new_distance_sq);
+        chunk->update_neighbor_directions_.push_back(getDirectionNumber(diff.x(), diff.y(), diff.z()));
       }
     }
-    bucket_queue_[i].clear();
   }
+  chunk->update_begin_.push_back(chunk->update_locations_.size());
 }
 
-void PropagationDistanceField::propagateNegative()
+void PropagationDistanceField::computeBucketChunk(unsigned int bucket, bool negative,
+                                                  const std::vector<std::size_t>& chunk_begin,
+                                                  std::vector<PropagationChunk>& chunks, std::size_t index) const
 {
+  computeBucketUpdates(bucket, negative, chunk_begin[index], chunk_begin[index+1], &chunks[index]);
+}
 
-  // now process the queue:
-  for (unsigned int i=0; i<negative_bucket_queue_.size(); ++i)
+void PropagationDistanceField::propagateBucketParallel(unsigned int bucket, bool negative)
+{
+  std::vector<std::vector<Eigen::Vector3i> >& queue = negative ? negative_bucket_queue_ : bucket_queue_;
+  std::size_t bucket_size = queue[bucket].size();
+  std::size_t thread_count = std::min<std::size_t>(propagation_thread_count_, bucket_size);
+
+  std::vector<std::size_t> chunk_begin(thread_count+1);
+  for (std::size_t t=0; t<=thread_count; ++t)
+    chunk_begin[t] = bucket_size * t / thread_count;
+
+  // compute the updates proposed by each voxel against the current state of the grid
+  std::vector<PropagationChunk> chunks(thread_count);
+  getPropagationWorkers().run(thread_count, boost::bind(&PropagationDistanceField::computeBucketChunk, this,
+                                                      bucket, negative, boost::cref(chunk_begin), boost::ref(chunks), _1));
+
+  // apply the updates in the order the serial propagation makes them;
+  // a voxel that was itself updated earlier in this bucket proposes
+  // different updates, so it is expanded again from its current state
+  for (std::size_t t=0; t<thread_count; ++t)
   {
-    std::vector<Eigen::Vector3i>::iterator list_it = negative_bucket_queue_[i].begin();
-    std::vector<Eigen::Vector3i>::iterator list_end = negative_bucket_queue_[i].end();
-    for ( ; list_it != list_end ; ++list_it)
+    const PropagationChunk& chunk = chunks[t];
+    for (std::size_t j=0; j<chunk_begin[t+1]-chunk_begin[t]; ++j)
     {
-      const Eigen::Vector3i& loc = *list_it;
-      PropDistanceFieldVoxel* vptr = &voxel_grid_->getCell(loc.x(), loc.y(), loc.z());
-
-      // select the neighborhood list based on the update direction:
-      std::vector<Eigen::Vector3i >* neighborhood;
-      int D = i;
-      if (D>1)
-        D=1;
-
-      // This will never happen.  negative_update_direction_ is always set before voxel is added to negative_bucket_queue_.
-      if (vptr->negative_update_direction_<0 || vptr->negative_update_direction_>26)
+      Eigen::Vector3i loc = queue[bucket][chunk_begin[t]+j];
+      const PropDistanceFieldVoxel& voxel = voxel_grid_->getCell(loc.x(), loc.y(), loc.z());
+      const Eigen::Vector3i closest_point = negative ? voxel.closest_negative_point_ : voxel.closest_point_;
+      int update_direction = negative ? voxel.negative_update_direction_ : voxel.update_direction_;
+      if (update_direction != chunk.update_directions_[j] || closest_point != chunk.closest_points_[j] ||
+          update_direction<0 || update_direction>26)
       {
-        logError("PROGRAMMING ERROR: Invalid update direction detected: %d", vptr->update_direction_);
+        propagateVoxel(loc, bucket, negative);
         continue;
       }
 
-      neighborhood = &neighborhoods_[D][vptr->negative_update_direction_];
-
-      for (unsigned int n=0; n<neighborhood->size(); n++)
+      for (std::size_t u=chunk.update_begin_[j]; u<chunk.update_begin_[j+1]; ++u)
       {
-        Eigen::Vector3i diff = (*neighborhood)[n];
-        Eigen::Vector3i nloc( loc.x() + diff.x(), loc.y() + diff.y(), loc.z() + diff.z() );
-        if (!isCellValid(nloc.x(), nloc.y(), nloc.z()) )
-          continue;
-
-        // the real update code:
-        // calculate the neighbor's new distance based on my closest filled voxel:
-        PropDistanceFieldVoxel* neighbor = &voxel_grid_->getCell(nloc.x(),nloc.y(),nloc.z());
-        int new_distance_sq = eucDistSq(vptr->closest_negative_point_, nloc);
-        if (new_distance_sq > max_distance_sq_)
-          continue;
-        //std::cout << "Looking at " << nloc.x() << " " << nloc.y() << " " << nloc.z() << " " << new_distance_sq << " " << neighbor->negative_distance_square_ << std::endl;
-        if (new_distance_sq < neighbor->negative_distance_square_)
+        const Eigen::Vector3i& nloc = chunk.update_locations_[u];
+        PropDistanceFieldVoxel* neighbor = &voxel_grid_->getCell(nloc.x(), nloc.y(), nloc.z());
+        int new_distance_sq = chunk.update_distances_[u];
+        int& neighbor_distance_sq = negative ? neighbor->negative_distance_square_ : neighbor->distance_square_;
+        if (new_distance_sq < neighbor_distance_sq)
         {
-          //std::cout << "Updating " << nloc.x() << " " << nloc.y() << " " << nloc.z() << " " << new_distance_sq << std::endl;
-          // update the neighboring voxel
-          neighbor->negative_distance_square_ = new_distance_sq;
-          neighbor->closest_negative_point_ = vptr->closest_negative_point_;
-          neighbor->negative_update_direction_ = getDirectionNumber(diff.x(), diff.y(), diff.z());
-
-          // and put it in the queue:
-          negative_bucket_queue_[new_distance_sq].push_back(nloc);
+          neighbor_distance_sq = new_distance_sq;
+          if (negative)
+          {
+            neighbor->closest_negative_point_ = closest_point;
+            neighbor->negative_update_direction_ = chunk.update_neighbor_directions_[u];
+          }
+          else
+          {
+            neighbor->closest_point_ = closest_point;
+            neighbor->update_direction_ = chunk.update_neighbor_directions_[u];
+          }
+          queue[new_distance_sq].push_back(nloc);
         }
       }
     }
-    negative_bucket_queue_[i].clear();
   }
 }
 
 void PropagationDistanceField::reset()
 {
   voxel_grid_->reset(PropDistanceFieldVoxel(max_distance_sq_,0));
+
+  // touching every cell would allocate the whole sparse grid; the
+  // propagation treats an uninitialized closest_negative_point_ as
+  // the cell itself
+  if (sparse_storage_)
+    return;
+
   for(int x = 0; x < getXNumCells(); x++)
   {
     for(int y = 0; y < getYNumCells(); y++)
@@ -609,12 +809,12 @@ Eigen::Vector3i PropagationDistanceField::getLocationDifference(int directionNum
 
 double PropagationDistanceField::getDistance(double x, double y, double z) const
 {
-  return getDistance((*voxel_grid_.get())(x,y,z));
+  return getDistance(getConstVoxelGrid()(x,y,z));
 }
 
 double PropagationDistanceField::getDistance(int x, int y, int z) const
 {
-  return getDistance(voxel_grid_->getCell(x,y,z));
+  return getDistance(getConstVoxelGrid().getCell(x,y,z));
 }
 
 bool PropagationDistanceField::isCellValid(int x, int y, int z) const
@@ -755,4 +955,150 @@ bool PropagationDistanceField::readFromStream(std::istream& is)
   return true;
 }
 
+bool PropagationDistanceField::writeToMappedFile(const std::string& filename) const
+{
+  std::ofstream os(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!os.good())
+  {
+    logError("Unable to open distance field file '%s' for writing", filename.c_str());
+    return false;
+  }
+
+  MappedFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic_, MAPPED_FILE_MAGIC, sizeof(header.magic_));
+  header.version_ = MAPPED_FILE_VERSION;
+  header.byte_order_ = MAPPED_FILE_BYTE_ORDER;
+  header.voxel_size_ = sizeof(PropDistanceFieldVoxel);
+  header.propagate_negative_ = propagate_negative_ ? 1 : 0;
+  header.num_cells_[DIM_X] = getXNumCells();
+  header.num_cells_[DIM_Y] = getYNumCells();
+  header.num_cells_[DIM_Z] = getZNumCells();
+  header.max_distance_sq_ = max_distance_sq_;
+  header.resolution_ = resolution_;
+  header.size_[DIM_X] = size_x_;
+  header.size_[DIM_Y] = size_y_;
+  header.size_[DIM_Z] = size_z_;
+  header.origin_[DIM_X] = origin_x_;
+  header.origin_[DIM_Y] = origin_y_;
+  header.origin_[DIM_Z] = origin_z_;
+  header.max_distance_ = max_distance_;
+  header.data_offset_ = MAPPED_FILE_DATA_OFFSET;
+  header.data_size_ = (boost::uint64_t)getXNumCells() * getYNumCells() * getZNumCells() * sizeof(PropDistanceFieldVoxel);
+
+  // the header is written again once the checksum is known
+  std::vector<char> padding(MAPPED_FILE_DATA_OFFSET, 0);
+  os.write(&padding[0], padding.size());
+
+  // write the cells in the order of a dense voxel grid
+  boost::uint64_t checksum = CHECKSUM_SEED;
+  std::vector<PropDistanceFieldVoxel> row(getZNumCells());
+  for (int x = 0 ; x < getXNumCells() ; ++x)
+    for (int y = 0 ; y < getYNumCells() ; ++y)
+    {
+      for (int z = 0 ; z < getZNumCells() ; ++z)
+        row[z] = getCell(x, y, z);
+      if (row.empty())
+        continue;
+      const char* bytes = reinterpret_cast<const char*>(&row[0]);
+      checksum = updateChecksum(checksum, bytes, row.size() * sizeof(PropDistanceFieldVoxel));
+      os.write(bytes, row.size() * sizeof(PropDistanceFieldVoxel));
+    }
+  header.checksum_ = checksum;
+
+  os.seekp(0);
+  os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  os.flush();
+  if (!os.good())
+  {
+    logError("Failed writing distance field file '%s'", filename.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool PropagationDistanceField::readFromMappedFile(const std::string& filename, bool verify_checksum)
+{
+  boost::shared_ptr<boost::interprocess::mapped_region> region;
+  try
+  {
+    boost::interprocess::file_mapping file(filename.c_str(), boost::interprocess::read_only);
+    region.reset(new boost::interprocess::mapped_region(file, boost::interprocess::copy_on_write));
+  }
+  catch (boost::interprocess::interprocess_exception &ex)
+  {
+    logError("Unable to map distance field file '%s': %s", filename.c_str(), ex.what());
+    return false;
+  }
+
+  if (region->get_size() < sizeof(MappedFileHeader))
+  {
+    logError("Distance field file '%s' is too short", filename.c_str());
+    return false;
+  }
+  MappedFileHeader header;
+  memcpy(&header, region->get_address(), sizeof(header));
+  if (memcmp(header.magic_, MAPPED_FILE_MAGIC, sizeof(header.magic_)) != 0)
+  {
+    logError("File '%s' is not a distance field file", filename.c_str());
+    return false;
+  }
+  if (header.version_ != MAPPED_FILE_VERSION)
+  {
+    logError("Distance field file '%s' has unsupported version %u", filename.c_str(), header.version_);
+    return false;
+  }
+  if (header.byte_order_ != MAPPED_FILE_BYTE_ORDER || header.voxel_size_ != sizeof(PropDistanceFieldVoxel))
+  {
+    logError("Distance field file '%s' was written on a machine with a different data layout", filename.c_str());
+    return false;
+  }
+
+  // make sure the grid computed from the header matches the stored cells
+  double oo_resolution = 1.0 / header.resolution_;
+  boost::uint64_t num_cells = 1;
+  for (int i = DIM_X ; i <= DIM_Z ; ++i)
+  {
+    int n = header.size_[i] * oo_resolution;
+    if (n != header.num_cells_[i] || n < 0)
+    {
+      logError("Distance field file '%s' has an inconsistent header", filename.c_str());
+      return false;
+    }
+    num_cells *= n;
+  }
+  int max_distance_sq = ceil(header.max_distance_/header.resolution_)*ceil(header.max_distance_/header.resolution_);
+  if (max_distance_sq != header.max_distance_sq_ ||
+      header.data_offset_ < sizeof(MappedFileHeader) || header.data_offset_ % sizeof(double) != 0 ||
+      header.data_size_ != num_cells * sizeof(PropDistanceFieldVoxel) ||
+      header.data_offset_ + header.data_size_ > region->get_size())
+  {
+    logError("Distance field file '%s' has an inconsistent header", filename.c_str());
+    return false;
+  }
+
+  char* data = static_cast<char*>(region->get_address()) + header.data_offset_;
+  if (verify_checksum && updateChecksum(CHECKSUM_SEED, data, header.data_size_) != header.checksum_)
+  {
+    logError("Checksum mismatch in distance field file '%s'", filename.c_str());
+    return false;
+  }
+
+  resolution_ = header.resolution_;
+  inv_twice_resolution_ = 1.0/(2.0*resolution_);
+  size_x_ = header.size_[DIM_X];
+  size_y_ = header.size_[DIM_Y];
+  size_z_ = header.size_[DIM_Z];
+  origin_x_ = header.origin_[DIM_X];
+  origin_y_ = header.origin_[DIM_Y];
+  origin_z_ = header.origin_[DIM_Z];
+  max_distance_ = header.max_distance_;
+  propagate_negative_ = header.propagate_negative_ != 0;
+  sparse_storage_ = false;
+
+  initialize(num_cells > 0 ? reinterpret_cast<PropDistanceFieldVoxel*>(data) : NULL);
+  mapped_region_ = region;
+  return true;
+}
+
 }
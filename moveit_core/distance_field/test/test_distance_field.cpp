@@ -45,6 +45,7 @@
 #include <octomap/octomap.h>
 
 #include <memory>
+#include <fstream>
 
 
 using namespace distance_field;
@@ -740,6 +741,155 @@ TEST(TestSignedPropagationDistanceField, TestPerformance)
   wd = ros::WallTime::now()-dt;
   printf("Time for signed adding %u uniform points is %g average %g\n", (unsigned int)bad_vec.size(), wd.toSec(), wd.toSec()/(bad_vec.size()*1.0));
 
+  // the same updates with large buckets split across the propagation worker pool
+  PropagationDistanceField pdf(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION,
+                               PERF_ORIGIN_X, PERF_ORIGIN_Y, PERF_ORIGIN_Z, PERF_MAX_DIST, false);
+  PropagationDistanceField psdf(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION,
+                                PERF_ORIGIN_X, PERF_ORIGIN_Y, PERF_ORIGIN_Z, PERF_MAX_DIST, true);
+  pdf.setPropagationThreadCount(4);
+  psdf.setPropagationThreadCount(4);
+
+  dt = ros::WallTime::now();
+  pdf.addShapeToField(&big_table, p);
+  std::cout << "Adding to unsigned with 4 threads took " << (ros::WallTime::now()-dt).toSec() << std::endl;
+
+  dt = ros::WallTime::now();
+  psdf.addShapeToField(&big_table, p);
+  std::cout << "Adding to signed with 4 threads took " << (ros::WallTime::now()-dt).toSec() << std::endl;
+
+  dt = ros::WallTime::now();
+  pdf.moveShapeInField(&big_table, p, np);
+  std::cout << "Moving in unsigned with 4 threads took " << (ros::WallTime::now()-dt).toSec() << std::endl;
+
+  dt = ros::WallTime::now();
+  psdf.moveShapeInField(&big_table, p, np);
+  std::cout << "Moving in signed with 4 threads took " << (ros::WallTime::now()-dt).toSec() << std::endl;
+
+  pdf.reset();
+  psdf.reset();
+  dt = ros::WallTime::now();
+  pdf.addPointsToField(bad_vec);
+  wd = ros::WallTime::now()-dt;
+  printf("Time for unsigned adding %u uniform points with 4 threads is %g\n", (unsigned int)bad_vec.size(), wd.toSec());
+  dt = ros::WallTime::now();
+  psdf.addPointsToField(bad_vec);
+  wd = ros::WallTime::now()-dt;
+  printf("Time for signed adding %u uniform points with 4 threads is %g\n", (unsigned int)bad_vec.size(), wd.toSec());
+}
+
+TEST(TestSignedPropagationDistanceField, TestParallelPropagation)
+{
+  for (int propagate_negative = 0; propagate_negative < 2; ++propagate_negative)
+  {
+    PropagationDistanceField df(1.5, 1.5, 1.5, PERF_RESOLUTION, 0.0, 0.0, 0.0, PERF_MAX_DIST, propagate_negative);
+    PropagationDistanceField pdf(1.5, 1.5, 1.5, PERF_RESOLUTION, 0.0, 0.0, 0.0, PERF_MAX_DIST, propagate_negative);
+    pdf.setPropagationThreadCount(4);
+    EXPECT_EQ(4u, pdf.getPropagationThreadCount());
+
+    shapes::Box table(1.0, 1.0, 0.3);
+    shapes::Sphere sphere(0.2);
+    Eigen::Affine3d p = Eigen::Translation3d(0.75, 0.75, 0.5) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+    Eigen::Affine3d np = Eigen::Translation3d(0.8, 0.75, 0.5) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+    Eigen::Affine3d sp = Eigen::Translation3d(0.5, 0.6, 1.0) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+
+    df.addShapeToField(&table, p);
+    pdf.addShapeToField(&table, p);
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, pdf));
+
+    df.addShapeToField(&sphere, sp);
+    pdf.addShapeToField(&sphere, sp);
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, pdf));
+
+    df.moveShapeInField(&table, p, np);
+    pdf.moveShapeInField(&table, p, np);
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, pdf));
+
+    df.removeShapeFromField(&table, np);
+    pdf.removeShapeFromField(&table, np);
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, pdf));
+  }
+}
+
+TEST(TestSignedPropagationDistanceField, TestSparseStorage)
+{
+  for (int propagate_negative = 0; propagate_negative < 2; ++propagate_negative)
+  {
+    PropagationDistanceField df(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION,
+                                PERF_ORIGIN_X, PERF_ORIGIN_Y, PERF_ORIGIN_Z, PERF_MAX_DIST, propagate_negative);
+    PropagationDistanceField sdf(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION,
+                                 PERF_ORIGIN_X, PERF_ORIGIN_Y, PERF_ORIGIN_Z, PERF_MAX_DIST, propagate_negative, true);
+    EXPECT_TRUE(sdf.hasSparseStorage());
+    EXPECT_EQ(0u, sdf.getNumAllocatedCells());
+
+    shapes::Box table(0.5, 0.5, 0.1);
+    Eigen::Affine3d p = Eigen::Translation3d(1.0, 1.0, 1.0) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+    Eigen::Affine3d np = Eigen::Translation3d(1.1, 1.0, 1.0) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+
+    df.addShapeToField(&table, p);
+    sdf.addShapeToField(&table, p);
+    std::size_t allocated = sdf.getNumAllocatedCells();
+    EXPECT_LT(allocated, df.getNumAllocatedCells() / 10);
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, sdf));
+    // reading cells must not allocate blocks
+    EXPECT_EQ(allocated, sdf.getNumAllocatedCells());
+    double dist;
+    Eigen::Vector3i pos;
+    sdf.getNearestCell(0, 0, 0, dist, pos);
+    sdf.getDistance(0.0, 0.0, 0.0);
+    EXPECT_EQ(allocated, sdf.getNumAllocatedCells());
+
+    df.moveShapeInField(&table, p, np);
+    sdf.moveShapeInField(&table, p, np);
+    allocated = sdf.getNumAllocatedCells();
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, sdf));
+    EXPECT_EQ(allocated, sdf.getNumAllocatedCells());
+
+    df.removeShapeFromField(&table, np);
+    sdf.removeShapeFromField(&table, np);
+    allocated = sdf.getNumAllocatedCells();
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, sdf));
+    EXPECT_EQ(allocated, sdf.getNumAllocatedCells());
+
+    df.reset();
+    sdf.reset();
+    EXPECT_EQ(0u, sdf.getNumAllocatedCells());
+  }
+}
+
+TEST(TestSignedPropagationDistanceField, TestSparseParallelPropagation)
+{
+  for (int propagate_negative = 0; propagate_negative < 2; ++propagate_negative)
+  {
+    PropagationDistanceField df(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION,
+                                PERF_ORIGIN_X, PERF_ORIGIN_Y, PERF_ORIGIN_Z, PERF_MAX_DIST, propagate_negative);
+    PropagationDistanceField spdf(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION,
+                                  PERF_ORIGIN_X, PERF_ORIGIN_Y, PERF_ORIGIN_Z, PERF_MAX_DIST, propagate_negative, true);
+    spdf.setPropagationThreadCount(4);
+    EXPECT_EQ(4u, spdf.getPropagationThreadCount());
+
+    shapes::Box table(0.5, 0.5, 0.1);
+    shapes::Sphere sphere(0.2);
+    Eigen::Affine3d p = Eigen::Translation3d(1.0, 1.0, 1.0) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+    Eigen::Affine3d np = Eigen::Translation3d(1.1, 1.0, 1.0) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+    Eigen::Affine3d sp = Eigen::Translation3d(2.0, 1.5, 1.5) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+
+    df.addShapeToField(&table, p);
+    spdf.addShapeToField(&table, p);
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, spdf));
+    EXPECT_LT(spdf.getNumAllocatedCells(), df.getNumAllocatedCells() / 10);
+
+    df.addShapeToField(&sphere, sp);
+    spdf.addShapeToField(&sphere, sp);
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, spdf));
+
+    df.moveShapeInField(&table, p, np);
+    spdf.moveShapeInField(&table, p, np);
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, spdf));
+
+    df.removeShapeFromField(&table, np);
+    spdf.removeShapeFromField(&table, np);
+    EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, spdf));
+  }
 }
 
 TEST(TestSignedPropagationDistanceField, TestOcTree)
@@ -882,6 +1032,50 @@ TEST(TestSignedPropagationDistanceField, TestReadWrite)
   EXPECT_FALSE(areDistanceFieldsDistancesEqual(df, df3));
 }
 
+TEST(TestSignedPropagationDistanceField, TestMappedFile)
+{
+  PropagationDistanceField df(width, height, depth, resolution, origin_x, origin_y, origin_z, max_dist, true);
+  shapes::Sphere sphere(.3);
+  Eigen::Affine3d p = Eigen::Translation3d(0.5, 0.5, 0.5) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+  df.addShapeToField(&sphere, p);
+
+  ASSERT_TRUE(df.writeToMappedFile("test_mapped.df"));
+
+  PropagationDistanceField mdf("test_mapped.df");
+  EXPECT_TRUE(mdf.isMapped());
+  EXPECT_EQ(df.getMaximumDistanceSquared(), mdf.getMaximumDistanceSquared());
+  EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, mdf));
+  EXPECT_EQ(df.getDistance(0.1, 0.2, 0.3), mdf.getDistance(0.1, 0.2, 0.3));
+
+  // modifying a mapped field leaves the file untouched
+  EigenSTL::vector_Vector3d points;
+  points.push_back(point1);
+  mdf.addPointsToField(points);
+  EXPECT_FALSE(areDistanceFieldsDistancesEqual(df, mdf));
+  PropagationDistanceField mdf2("test_mapped.df");
+  EXPECT_TRUE(areDistanceFieldsDistancesEqual(df, mdf2));
+
+  // corrupted cell data is detected
+  {
+    std::fstream f("test_mapped.df", std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(-1, std::ios::end);
+    f.put(42);
+  }
+  PropagationDistanceField cdf(width, height, depth, resolution, origin_x, origin_y, origin_z, max_dist);
+  EXPECT_FALSE(cdf.readFromMappedFile("test_mapped.df"));
+  EXPECT_FALSE(cdf.isMapped());
+  EXPECT_TRUE(cdf.readFromMappedFile("test_mapped.df", false));
+  EXPECT_FALSE(cdf.readFromMappedFile("test_missing.df"));
+
+  // a field that is not mapped can still be read from a stream
+  std::ofstream sf("test_mapped_stream.df", std::ios::out);
+  df.writeToStream(sf);
+  sf.close();
+  std::ifstream si("test_mapped_stream.df", std::ios::in | std::ios::binary);
+  EXPECT_TRUE(cdf.readFromStream(si));
+  EXPECT_FALSE(cdf.isMapped());
+}
+
 int main(int argc, char **argv){
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
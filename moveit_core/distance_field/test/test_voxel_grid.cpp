@@ -96,6 +96,59 @@ TEST(TestVoxelGrid, TestReadWrite)
 
 }
 
+TEST(TestVoxelGrid, TestSparseReadWrite)
+{
+  int def=-100;
+  VoxelGrid<int> vg(0.2,0.2,0.2,0.01,0,0,0, def, true);
+  EXPECT_TRUE(vg.isSparse());
+
+  int numX = vg.getNumCells(DIM_X);
+  int numY = vg.getNumCells(DIM_Y);
+  int numZ = vg.getNumCells(DIM_Z);
+  EXPECT_EQ(numX,20);
+  EXPECT_EQ(numY,20);
+  EXPECT_EQ(numZ,20);
+
+  // reading through a const grid does not allocate anything
+  vg.reset(7);
+  const VoxelGrid<int>& cvg = vg;
+  for (int x=0; x<numX; x++)
+    for (int y=0; y<numY; y++)
+      for (int z=0; z<numZ; z++)
+        EXPECT_EQ(7, cvg.getCell(x,y,z));
+  EXPECT_EQ(0u, vg.getNumAllocatedCells());
+
+  // writing a cell allocates only its block
+  vg.getCell(1,2,3) = 1;
+  vg.setCell(19,19,19, 2);
+  EXPECT_EQ(2u*8*8*8, vg.getNumAllocatedCells());
+
+  int i=0;
+  for (int x=0; x<numX; x++)
+    for (int y=0; y<numY; y++)
+      for (int z=0; z<numZ; z++)
+      {
+        if (x == 1 && y == 2 && z == 3)
+          EXPECT_EQ(1, cvg.getCell(x,y,z));
+        else if (x == 19 && y == 19 && z == 19)
+          EXPECT_EQ(2, cvg.getCell(x,y,z));
+        else
+          EXPECT_EQ(7, cvg.getCell(x,y,z));
+        vg.getCell(x,y,z) = i++;
+      }
+
+  i=0;
+  for (int x=0; x<numX; x++)
+    for (int y=0; y<numY; y++)
+      for (int z=0; z<numZ; z++)
+        EXPECT_EQ(i++, cvg.getCell(x,y,z));
+
+  vg.reset(0);
+  EXPECT_EQ(0u, vg.getNumAllocatedCells());
+  EXPECT_EQ(0, cvg.getCell(5,5,5));
+  EXPECT_EQ(def, cvg(-1.0, 0.0, 0.0));
+}
+
 int main(int argc, char **argv){
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -439,7 +439,10 @@ kinematic_constraints::ConstraintEvaluationResult kinematic_constraints::Positio
   if (!link_model_ || constraint_region_.empty())
     return ConstraintEvaluationResult(true, 0.0);
 
-  Eigen::Vector3d pt = state.getGlobalLinkTransform(link_model_) * offset_;
+  // only the chain of links up to link_model_ is evaluated if the state is not up to date
+  Eigen::Affine3d link_transform;
+  state.computeGlobalLinkTransform(link_model_, link_transform);
+  Eigen::Vector3d pt = link_transform * offset_;
   if (mobile_frame_)
   {
     for (std::size_t i = 0 ; i < constraint_region_.size() ; ++i)
@@ -598,17 +601,21 @@ kinematic_constraints::ConstraintEvaluationResult kinematic_constraints::Orienta
   if (!link_model_)
     return ConstraintEvaluationResult(true, 0.0);
 
+  // only the chain of links up to link_model_ is evaluated if the state is not up to date
+  Eigen::Affine3d link_transform;
+  state.computeGlobalLinkTransform(link_model_, link_transform);
+
   Eigen::Vector3d xyz;
   if (mobile_frame_)
   {
     Eigen::Matrix3d tmp = state.getFrameTransform(desired_rotation_frame_id_).rotation() * desired_rotation_matrix_;
-    Eigen::Affine3d diff(tmp.inverse() * state.getGlobalLinkTransform(link_model_).rotation());
+    Eigen::Affine3d diff(tmp.inverse() * link_transform.rotation());
     xyz = diff.rotation().eulerAngles(0, 1, 2);
     // 0,1,2 corresponds to XYZ, the convention used in sampling constraints
   }
   else
   {
-    Eigen::Affine3d diff(desired_rotation_matrix_inv_ * state.getGlobalLinkTransform(link_model_).rotation());
+    Eigen::Affine3d diff(desired_rotation_matrix_inv_ * link_transform.rotation());
     xyz = diff.rotation().eulerAngles(0, 1, 2); // 0,1,2 corresponds to XYZ, the convention used in sampling constraints
   }
 
@@ -621,7 +628,7 @@ kinematic_constraints::ConstraintEvaluationResult kinematic_constraints::Orienta
 
   if (verbose)
   {
-    Eigen::Quaterniond q_act(state.getGlobalLinkTransform(link_model_).rotation());
+    Eigen::Quaterniond q_act(link_transform.rotation());
     Eigen::Quaterniond q_des(desired_rotation_matrix_);
     logInform("Orientation constraint %s for link '%s'. Quaternion desired: %f %f %f %f, quaternion actual: %f %f %f %f, error: x=%f, y=%f, z=%f, tolerance: x=%f, y=%f, z=%f",
              result ? "satisfied" : "violated", link_model_->getName().c_str(),
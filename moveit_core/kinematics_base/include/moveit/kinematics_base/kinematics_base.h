@@ -43,6 +43,7 @@
 #include <boost/function.hpp>
 #include <console_bridge/console.h>
 #include <string>
+#include <vector>
 
 namespace moveit
 {
@@ -133,6 +134,43 @@ struct KinematicsResult
 	                                             of solutions explored. */
 };
 
+/**
+ * @struct KinematicsBatchOptions
+ * @brief Limits for a batched ik query (see KinematicsBase::searchPositionIKBatch())
+ */
+struct KinematicsBatchOptions
+{
+  KinematicsBatchOptions() :
+    max_solutions_per_pose(1),
+    max_solutions(0),
+    query_timeout(0.0),
+    thread_count(0),
+    seed_per_pose(false)
+  {
+  }
+
+  unsigned int max_solutions_per_pose;          /**< Once this many solutions are known for a pose, its remaining seeds are skipped (0 for no limit) */
+  unsigned int max_solutions;                   /**< Once this many solutions are known in total, the batch stops (0 for no limit) */
+  double query_timeout;                         /**< Timeout for a single (pose, seed) query; 0 lets each query use the remaining batch time */
+  unsigned int thread_count;                    /**< Maximum number of threads used for the batch (0 for all the threads of the shared worker pool) */
+  bool seed_per_pose;                           /**< If true, pose i is only searched from seed i, instead of from every seed; there must be as many seeds as poses */
+
+  /** If set, this callback is passed to every query and a solution is only reported if the callback accepts it
+      (see KinematicsBase::searchPositionIK()). Calls to the callback are serialized, so it does not need to be thread safe */
+  boost::function<void(const geometry_msgs::Pose&, const std::vector<double>&, moveit_msgs::MoveItErrorCodes&)> solution_callback;
+};
+
+/**
+ * @struct KinematicsBatchSolution
+ * @brief One solution reported by a batched ik query
+ */
+struct KinematicsBatchSolution
+{
+  std::size_t pose_index;                       /**< Index of the pose this solution reaches */
+  std::size_t seed_index;                       /**< Index of the seed the solution was found from */
+  std::vector<double> solution;                 /**< The joint values, in the order of getJointNames() */
+};
+
 MOVEIT_CLASS_FORWARD(KinematicsBase);
 
 /**
@@ -335,6 +373,43 @@ public:
     return false;
   }
 
+  /**
+   * @brief Run many single-tip ik searches in one call: every pose in \e ik_poses is searched from every seed in
+   * \e ik_seed_states (or only from its own seed, see KinematicsBatchOptions#seed_per_pose), and all the solutions
+   * found before \e timeout expires are returned.
+   *
+   * The default implementation calls searchPositionIK() once per (pose, seed) pair, pose by pose. If the solver
+   * reports supportsConcurrentQueries(), the pairs are distributed over up to KinematicsBatchOptions#thread_count
+   * threads of a worker pool shared by all solvers; otherwise they are run in the calling thread. Solvers that can answer many queries at once more
+   * cheaply (e.g. analytic solvers that do not depend on the seed) should override this.
+   *
+   * @param ik_poses the desired poses of the tip link
+   * @param ik_seed_states the seeds to start from; each needs to have the size of getJointNames()
+   * @param timeout The amount of time (in seconds) available for the whole batch
+   * @param solutions the solutions found, sorted by pose index and then by seed index
+   * @param result reports KinematicErrors::OK if at least one solution was found, and the fraction of the
+   *        queries that were run which succeeded
+   * @param batch_options limits on the number of solutions and threads
+   * @param options container for other IK options, passed to every query
+   * @return True if at least one solution was found, false otherwise
+   */
+  virtual bool searchPositionIKBatch(const std::vector<geometry_msgs::Pose> &ik_poses,
+                                     const std::vector<std::vector<double> > &ik_seed_states,
+                                     double timeout,
+                                     std::vector<KinematicsBatchSolution> &solutions,
+                                     KinematicsResult &result,
+                                     const KinematicsBatchOptions &batch_options = KinematicsBatchOptions(),
+                                     const KinematicsQueryOptions &options = KinematicsQueryOptions()) const;
+
+  /**
+   * @brief Return true if the searchPositionIK() functions of this solver can be called from multiple threads at
+   * the same time. This is used by the default implementation of searchPositionIKBatch().
+   */
+  virtual bool supportsConcurrentQueries() const
+  {
+    return false;
+  }
+
   /**
    * @brief Given a set of joint angles and a set of links, compute their pose
    * @param link_names A set of links for which FK needs to be computed
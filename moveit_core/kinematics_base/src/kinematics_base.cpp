@@ -36,10 +36,128 @@
 
 #include <moveit/kinematics_base/kinematics_base.h>
 #include <moveit/robot_model/joint_model_group.h>
+#include <moveit/background_processing/worker_pool.h>
+#include <ros/time.h>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
 
 const double kinematics::KinematicsBase::DEFAULT_SEARCH_DISCRETIZATION = 0.1;
 const double kinematics::KinematicsBase::DEFAULT_TIMEOUT = 1.0;
 
+namespace
+{
+
+// State shared by the threads that work on one batched ik query
+struct BatchQuery
+{
+  const kinematics::KinematicsBase *solver_;
+  const std::vector<geometry_msgs::Pose> *poses_;
+  const std::vector<std::vector<double> > *seeds_;
+  const kinematics::KinematicsBatchOptions *batch_options_;
+  const kinematics::KinematicsQueryOptions *options_;
+  ros::WallTime deadline_;
+
+  boost::mutex lock_;
+  boost::mutex callback_lock_;
+  std::size_t next_;
+  std::size_t attempted_;
+  std::size_t succeeded_;
+  std::vector<unsigned int> solutions_per_pose_;
+  std::vector<kinematics::KinematicsBatchSolution> *solutions_;
+
+  bool full(std::size_t pose) const
+  {
+    return (batch_options_->max_solutions > 0 && solutions_->size() >= batch_options_->max_solutions) ||
+      (batch_options_->max_solutions_per_pose > 0 && solutions_per_pose_[pose] >= batch_options_->max_solutions_per_pose);
+  }
+
+  std::size_t pairCount() const
+  {
+    return batch_options_->seed_per_pose ? poses_->size() : poses_->size() * seeds_->size();
+  }
+
+  // pick the next (pose, seed) pair to run; pairs are handed out pose by pose, so that all seeds
+  // of a pose are tried before moving on
+  bool next(std::size_t &pose, std::size_t &seed, double &timeout)
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    const std::size_t total = pairCount();
+    while (next_ < total)
+    {
+      pose = batch_options_->seed_per_pose ? next_ : next_ / seeds_->size();
+      seed = batch_options_->seed_per_pose ? next_ : next_ % seeds_->size();
+      ++next_;
+      if (batch_options_->max_solutions > 0 && solutions_->size() >= batch_options_->max_solutions)
+        return false;
+      if (full(pose))
+        continue;
+      timeout = (deadline_ - ros::WallTime::now()).toSec();
+      if (timeout <= 0.0)
+        return false;
+      if (batch_options_->query_timeout > 0.0 && batch_options_->query_timeout < timeout)
+        timeout = batch_options_->query_timeout;
+      ++attempted_;
+      return true;
+    }
+    return false;
+  }
+
+  // the solution callback may not be thread safe, so only one thread calls it at a time
+  void callSolutionCallback(const geometry_msgs::Pose &pose, const std::vector<double> &solution, moveit_msgs::MoveItErrorCodes &error_code)
+  {
+    boost::mutex::scoped_lock slock(callback_lock_);
+    batch_options_->solution_callback(pose, solution, error_code);
+  }
+
+  void run()
+  {
+    kinematics::KinematicsBase::IKCallbackFn callback;
+    if (batch_options_->solution_callback)
+      callback = boost::bind(&BatchQuery::callSolutionCallback, this, _1, _2, _3);
+
+    std::size_t pose, seed;
+    double timeout;
+    std::vector<double> solution;
+    moveit_msgs::MoveItErrorCodes error_code;
+    while (next(pose, seed, timeout))
+      if (callback ?
+          solver_->searchPositionIK((*poses_)[pose], (*seeds_)[seed], timeout, solution, callback, error_code, *options_) :
+          solver_->searchPositionIK((*poses_)[pose], (*seeds_)[seed], timeout, solution, error_code, *options_))
+      {
+        boost::mutex::scoped_lock slock(lock_);
+        ++succeeded_;
+        // other threads may have filled the quota while this query was running
+        if (full(pose))
+          continue;
+        solutions_->resize(solutions_->size() + 1);
+        solutions_->back().pose_index = pose;
+        solutions_->back().seed_index = seed;
+        solutions_->back().solution.swap(solution);
+        solutions_per_pose_[pose]++;
+      }
+  }
+
+  void runTask(std::size_t)
+  {
+    run();
+  }
+};
+
+// the threads that evaluate batched queries, shared by all solvers
+moveit::tools::WorkerPool& getBatchWorkers()
+{
+  static moveit::tools::WorkerPool workers(std::max(1u, boost::thread::hardware_concurrency()) - 1);
+  return workers;
+}
+
+bool batchSolutionOrder(const kinematics::KinematicsBatchSolution &a, const kinematics::KinematicsBatchSolution &b)
+{
+  return a.pose_index < b.pose_index || (a.pose_index == b.pose_index && a.seed_index < b.seed_index);
+}
+
+}
+
 void kinematics::KinematicsBase::setValues(const std::string& robot_description,
                        const std::string& group_name,
                        const std::string& base_frame,
@@ -175,3 +293,72 @@ bool kinematics::KinematicsBase::getPositionIK(const std::vector<geometry_msgs::
 
   return true;
 }
+
+bool kinematics::KinematicsBase::searchPositionIKBatch(const std::vector<geometry_msgs::Pose> &ik_poses,
+                                                       const std::vector<std::vector<double> > &ik_seed_states,
+                                                       double timeout,
+                                                       std::vector<kinematics::KinematicsBatchSolution> &solutions,
+                                                       kinematics::KinematicsResult &result,
+                                                       const kinematics::KinematicsBatchOptions &batch_options,
+                                                       const kinematics::KinematicsQueryOptions &options) const
+{
+  solutions.clear();
+  result.solution_percentage = 0.0;
+
+  if (ik_poses.empty())
+  {
+    logError("moveit.kinematics_base: Input ik_poses array is empty");
+    result.kinematic_error = kinematics::KinematicErrors::EMPTY_TIP_POSES;
+    return false;
+  }
+
+  if (ik_seed_states.empty())
+  {
+    logError("moveit.kinematics_base: No seeds passed to batched IK query");
+    result.kinematic_error = kinematics::KinematicErrors::NO_SOLUTION;
+    return false;
+  }
+
+  if (batch_options.seed_per_pose && ik_seed_states.size() != ik_poses.size())
+  {
+    logError("moveit.kinematics_base: Batched IK query with one seed per pose has %u seeds for %u poses",
+             (unsigned int)ik_seed_states.size(), (unsigned int)ik_poses.size());
+    result.kinematic_error = kinematics::KinematicErrors::NO_SOLUTION;
+    return false;
+  }
+
+  BatchQuery query;
+  query.solver_ = this;
+  query.poses_ = &ik_poses;
+  query.seeds_ = &ik_seed_states;
+  query.batch_options_ = &batch_options;
+  query.options_ = &options;
+  query.deadline_ = ros::WallTime::now() + ros::WallDuration(timeout);
+  query.next_ = 0;
+  query.attempted_ = 0;
+  query.succeeded_ = 0;
+  query.solutions_per_pose_.resize(ik_poses.size(), 0);
+  query.solutions_ = &solutions;
+
+  std::size_t thread_count = 1;
+  if (supportsConcurrentQueries())
+  {
+    // the calling thread works on the batch as well
+    thread_count = batch_options.thread_count > 0 ? batch_options.thread_count : getBatchWorkers().getThreadCount() + 1;
+    thread_count = std::max<std::size_t>(1, std::min(thread_count, query.pairCount()));
+  }
+
+  if (thread_count > 1)
+  {
+    // each task takes (pose, seed) pairs until none are left
+    getBatchWorkers().run(thread_count, boost::bind(&BatchQuery::runTask, &query, _1));
+    std::sort(solutions.begin(), solutions.end(), &batchSolutionOrder);
+  }
+  else
+    query.run();
+
+  if (query.attempted_ > 0)
+    result.solution_percentage = (double)query.succeeded_ / (double)query.attempted_;
+  result.kinematic_error = solutions.empty() ? kinematics::KinematicErrors::NO_SOLUTION : kinematics::KinematicErrors::OK;
+  return !solutions.empty();
+}
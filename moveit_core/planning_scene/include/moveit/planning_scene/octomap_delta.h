@@ -0,0 +1,66 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt! contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#ifndef MOVEIT_PLANNING_SCENE_OCTOMAP_DELTA_
+#define MOVEIT_PLANNING_SCENE_OCTOMAP_DELTA_
+
+#include <octomap/octomap.h>
+#include <octomap_msgs/Octomap.h>
+#include <string>
+
+namespace planning_scene
+{
+
+/** \brief The id of octomap_msgs::Octomap messages that carry the changes made to a previously sent OcTree instead of a full map.
+
+    A delta lists the keys of the leaf nodes that changed, each with its current log-odds value (NaN for nodes
+    that no longer exist). The data starts with the revision the delta applies to; the revision the map has once the
+    delta is applied is stored in header.seq. Full maps that can serve as base for deltas store their revision in
+    header.seq as well; a revision of 0 means the map is not part of a revision sequence. */
+extern const std::string OCTOMAP_DELTA_ID;
+
+/** \brief Fill \e msg with the current values of the nodes at \e keys in \e octree, as the changes from revision \e base to revision \e revision */
+void octomapDeltaToMsg(const octomap::OcTree &octree, const octomap::KeySet &keys, unsigned int base, unsigned int revision,
+                       octomap_msgs::Octomap &msg);
+
+/** \brief Get the revision the delta in \e msg applies to. Returns false if \e msg is not a valid delta message */
+bool getOctomapDeltaBase(const octomap_msgs::Octomap &msg, unsigned int &base);
+
+/** \brief Apply the changes in the delta message \e msg to \e octree. Returns false (without changing \e octree) if \e msg
+    is not a valid delta or it was computed for a tree of a different resolution */
+bool applyOctomapDeltaMsg(const octomap_msgs::Octomap &msg, octomap::OcTree &octree);
+
+}
+
+#endif
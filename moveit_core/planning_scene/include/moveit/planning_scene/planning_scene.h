@@ -73,6 +73,11 @@ typedef boost::function<bool(const robot_state::RobotState&, bool)> StateFeasibi
     whether the check should be verbose or not. */
 typedef boost::function<bool(const robot_state::RobotState&, const robot_state::RobotState&, bool)> MotionFeasibilityFn;
 
+/** \brief This is the function signature for serializing the octomap of a planning scene into messages. The first argument is the octree to serialize,
+    the second one is whether the message being filled in is a diff; in that case the function may encode only the changes made since the octree was last sent
+    (see planning_scene::OCTOMAP_DELTA_ID) */
+typedef boost::function<void(const octomap::OcTree&, bool, octomap_msgs::Octomap&)> OctomapSerializerFn;
+
 /** \brief A map from object names (e.g., attached bodies, collision objects) to their colors */
 typedef std::map<std::string, std_msgs::ColorRGBA> ObjectColorMap;
 
@@ -690,7 +695,11 @@ public:
 
   bool processPlanningSceneWorldMsg(const moveit_msgs::PlanningSceneWorld &world);
 
+  /** \brief Replace the octomap of the scene with the one in \e map. If \e map is a delta (its id is planning_scene::OCTOMAP_DELTA_ID) and the
+      current octomap was received with the revision the delta applies to, the changes are applied to the current octomap instead. Deltas for other
+      revisions are ignored until the next full map is received. */
   void processOctomapMsg(const octomap_msgs::OctomapWithPose &map);
+  /** \brief Same as above, with the pose of the octomap given by the frame in the header of \e map */
   void processOctomapMsg(const octomap_msgs::Octomap &map);
   void processOctomapPtr(const std::shared_ptr<const octomap::OcTree> &octree, const Eigen::Affine3d &t);
 
@@ -746,6 +755,19 @@ public:
     state_feasibility_ = fn;
   }
 
+  /** \brief Specify the function used to serialize the octomap when filling in planning scene messages. By default (or if \e fn is empty) the full map is
+      serialized using octomap_msgs::fullMapToMsg() */
+  void setOctomapSerializer(const OctomapSerializerFn &fn)
+  {
+    octomap_serializer_ = fn;
+  }
+
+  /** \brief Get the function used to serialize the octomap when filling in planning scene messages */
+  const OctomapSerializerFn& getOctomapSerializer() const
+  {
+    return octomap_serializer_;
+  }
+
   /** \brief Get the predicate that decides whether states are considered valid or invalid for reasons beyond ones covered by collision checking and constraint evaluation. */
   const StateFeasibilityFn& getStateFeasibilityPredicate() const
   {
@@ -843,6 +865,46 @@ public:
   bool isPathValid(const robot_trajectory::RobotTrajectory &trajectory,
                    const std::string &group = "", bool verbose = false, std::vector<std::size_t> *invalid_index = NULL) const;
 
+  /** \brief Check a batch of \e count states for collisions. The states are obtained from \e reference by setting the variables
+      of the group \e req.group_name (all variables of the robot, if the group name is empty) to consecutive blocks of \e positions.
+      The index of the first state in collision (or \e count, if no state is in collision) is stored in \e first_colliding.
+      If \e colliding is NULL, checking stops at the first state in collision; otherwise all states are checked and the result
+      for each one is stored in \e colliding. If \e threads is larger than 1, the states are distributed across that many threads.
+      Returns false if the batch could not be checked (the group does not exist). */
+  bool checkCollisionBatch(const collision_detection::CollisionRequest& req, const robot_state::RobotState &reference,
+                           const double *positions, std::size_t count, std::size_t &first_colliding,
+                           std::vector<bool> *colliding = NULL, unsigned int threads = 1) const;
+
+  /** \brief Check a batch of \e count states for validity (collision avoidance and feasibility). The states are obtained from \e reference by
+      setting the variables of \e group (all variables of the robot, if \e group is empty) to consecutive blocks of \e positions.
+      The index of the first invalid state (or \e count, if all states are valid) is stored in \e first_invalid.
+      If \e valid is NULL, checking stops at the first invalid state; otherwise all states are checked and the result for each one is
+      stored in \e valid. If \e threads is larger than 1, the states are distributed across that many threads.
+      Returns false if the batch could not be checked (the group does not exist). */
+  bool isStateValidBatch(const robot_state::RobotState &reference, const double *positions, std::size_t count, std::size_t &first_invalid,
+                         const std::string &group = "", bool verbose = false,
+                         std::vector<bool> *valid = NULL, unsigned int threads = 1) const;
+
+  /** \brief Check the waypoints of \e trajectory for validity (collision avoidance and feasibility), as a batch.
+      The index of the first invalid waypoint (or the number of waypoints, if all are valid) is stored in \e first_invalid.
+      If \e valid is NULL, checking stops at the first invalid waypoint; otherwise all waypoints are checked and the result for each one is
+      stored in \e valid. If \e threads is larger than 1, the waypoints are distributed across that many threads.
+      Returns false if the batch could not be checked (the group does not exist). */
+  bool isStateValidBatch(const robot_trajectory::RobotTrajectory &trajectory, std::size_t &first_invalid,
+                         const std::string &group = "", bool verbose = false,
+                         std::vector<bool> *valid = NULL, unsigned int threads = 1) const;
+
+  /** \brief Check the waypoints of \e trajectory from index \e start onwards for validity (collision avoidance and feasibility), as a batch.
+      Collisions are checked for \e req, on the unpadded robot if \e unpadded is true, and with \e acm instead of the allowed collision
+      matrix of the scene if \e acm is not NULL. The index of the first invalid waypoint (or the number of waypoints, if all are valid)
+      is stored in \e first_invalid. If \e valid is NULL, checking stops at the first invalid waypoint; otherwise all waypoints from
+      \e start onwards are checked and the result for waypoint \e start + i is stored in element i of \e valid.
+      If \e threads is larger than 1, the waypoints are distributed across that many threads.
+      Returns false if the batch could not be checked (the group does not exist). */
+  bool isStateValidBatch(const robot_trajectory::RobotTrajectory &trajectory, std::size_t start,
+                         const collision_detection::CollisionRequest &req, const collision_detection::AllowedCollisionMatrix *acm,
+                         bool unpadded, std::size_t &first_invalid, std::vector<bool> *valid = NULL, unsigned int threads = 1) const;
+
   /** \brief Get the top \e max_costs cost sources for a specified trajectory. The resulting costs are stored in \e costs */
   void getCostSources(const robot_trajectory::RobotTrajectory &trajectory, std::size_t max_costs,
                       std::set<collision_detection::CostSource> &costs, double overlap_fraction = 0.9) const;
@@ -887,11 +949,32 @@ private:
   static robot_model::RobotModelPtr createRobotModel(const urdf::ModelInterfaceSharedPtr &urdf_model,
                                                      const boost::shared_ptr<const srdf::Model> &srdf_model);
 
+  /* Let the collision worlds apply a sequence of changes to world_ together; calls must be matched by endWorldUpdate() */
+  void beginWorldUpdate();
+  void endWorldUpdate();
+
   void getPlanningSceneMsgCollisionObject(moveit_msgs::PlanningScene &scene, const std::string &ns) const;
   void getPlanningSceneMsgCollisionObjects(moveit_msgs::PlanningScene &scene) const;
-  void getPlanningSceneMsgOctomap(moveit_msgs::PlanningScene &scene) const;
+  void getPlanningSceneMsgOctomap(moveit_msgs::PlanningScene &scene, bool diff = false) const;
+
+  /* Apply an octomap delta message on top of the octomap last received from a message; returns false if the delta does not apply to it */
+  bool applyOctomapDelta(const octomap_msgs::Octomap &map, const Eigen::Affine3d &t);
+
+  /* Keep the octree received from a message as the base for deltas, if its revision is known */
+  void setOctomapDeltaBase(const std::shared_ptr<octomap::OcTree> &octree, unsigned int revision);
   void getPlanningSceneMsgObjectColors(moveit_msgs::PlanningScene &scene_msg) const;
 
+  /* Signature of the check evaluated by checkBatch() for each index; the second argument is a scratch state
+     (a copy of the reference state) owned by the calling thread, or NULL if no reference state was given */
+  typedef boost::function<bool(std::size_t, robot_state::RobotState*)> BatchCheckFn;
+
+  /* Evaluate \e check for indices 0 .. count-1, distributed across \e threads threads of a worker pool shared by all
+     planning scenes. Lower indices are evaluated first. If \e passed is NULL, evaluation stops as soon as the lowest failing
+     index is known; otherwise the result for each index is stored in \e passed. Each thread copies \e reference (if not
+     NULL) into its scratch state. Returns the lowest index for which the check failed, or \e count. */
+  std::size_t checkBatch(std::size_t count, const BatchCheckFn &check, const robot_state::RobotState *reference,
+                         std::vector<bool> *passed, unsigned int threads) const;
+
   MOVEIT_CLASS_FORWARD(CollisionDetector);
 
   /* \brief A set of compatible collision detectors */
@@ -954,6 +1037,10 @@ private:
   StateFeasibilityFn                             state_feasibility_;
   MotionFeasibilityFn                            motion_feasibility_;
 
+  OctomapSerializerFn                            octomap_serializer_;
+  std::shared_ptr<octomap::OcTree>               octomap_delta_tree_;  // the octree last received from a message, if deltas can be applied to it
+  unsigned int                                   octomap_revision_;    // the revision of octomap_delta_tree_
+
   boost::scoped_ptr<ObjectColorMap>              object_colors_;
 
   // a map of object types
@@ -0,0 +1,130 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt! contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <moveit/planning_scene/octomap_delta.h>
+#include <boost/cstdint.hpp>
+#include <limits>
+#include <cstring>
+#include <cmath>
+
+namespace planning_scene
+{
+
+const std::string OCTOMAP_DELTA_ID = "OcTreeDelta";
+
+namespace
+{
+
+// a delta starts with the base revision, followed by one record per changed key
+const std::size_t DELTA_HEADER_SIZE = sizeof(boost::uint32_t);
+const std::size_t DELTA_RECORD_SIZE = 3 * sizeof(octomap::key_type) + sizeof(float);
+
+}
+
+void octomapDeltaToMsg(const octomap::OcTree &octree, const octomap::KeySet &keys, unsigned int base, unsigned int revision,
+                       octomap_msgs::Octomap &msg)
+{
+  msg.id = OCTOMAP_DELTA_ID;
+  msg.binary = false;
+  msg.resolution = octree.getResolution();
+  msg.header.seq = revision;
+  msg.data.resize(DELTA_HEADER_SIZE + keys.size() * DELTA_RECORD_SIZE);
+
+  int8_t *out = &msg.data[0];
+  boost::uint32_t b = base;
+  memcpy(out, &b, sizeof(b));
+  out += DELTA_HEADER_SIZE;
+
+  for (octomap::KeySet::const_iterator it = keys.begin() ; it != keys.end() ; ++it)
+  {
+    // nodes may have been pruned since they changed; search() then returns the parent that now holds their value
+    const octomap::OcTreeNode *node = octree.search(*it);
+    float value = node ? node->getLogOdds() : std::numeric_limits<float>::quiet_NaN();
+    for (int k = 0 ; k < 3 ; ++k)
+    {
+      memcpy(out, &(*it)[k], sizeof(octomap::key_type));
+      out += sizeof(octomap::key_type);
+    }
+    memcpy(out, &value, sizeof(value));
+    out += sizeof(value);
+  }
+}
+
+bool getOctomapDeltaBase(const octomap_msgs::Octomap &msg, unsigned int &base)
+{
+  if (msg.id != OCTOMAP_DELTA_ID || msg.data.size() < DELTA_HEADER_SIZE ||
+      (msg.data.size() - DELTA_HEADER_SIZE) % DELTA_RECORD_SIZE != 0)
+    return false;
+  boost::uint32_t b;
+  memcpy(&b, &msg.data[0], sizeof(b));
+  base = b;
+  return true;
+}
+
+bool applyOctomapDeltaMsg(const octomap_msgs::Octomap &msg, octomap::OcTree &octree)
+{
+  unsigned int base;
+  if (!getOctomapDeltaBase(msg, base))
+    return false;
+  if (fabs(msg.resolution - octree.getResolution()) > std::numeric_limits<double>::epsilon() * 100.0)
+    return false;
+
+  std::size_t count = (msg.data.size() - DELTA_HEADER_SIZE) / DELTA_RECORD_SIZE;
+  if (count == 0)
+    return true;
+
+  const int8_t *in = &msg.data[DELTA_HEADER_SIZE];
+  for (std::size_t i = 0 ; i < count ; ++i)
+  {
+    octomap::OcTreeKey key;
+    for (int k = 0 ; k < 3 ; ++k)
+    {
+      memcpy(&key[k], in, sizeof(octomap::key_type));
+      in += sizeof(octomap::key_type);
+    }
+    float value;
+    memcpy(&value, in, sizeof(value));
+    in += sizeof(value);
+
+    // inner nodes are updated once, after all the changes are applied
+    if (std::isnan(value))
+      octree.deleteNode(key);
+    else
+      octree.setNodeValue(key, value, true);
+  }
+  octree.updateInnerOccupancy();
+  return true;
+}
+
+}
@@ -36,6 +36,7 @@
 
 #include <boost/algorithm/string.hpp>
 #include <moveit/planning_scene/planning_scene.h>
+#include <moveit/planning_scene/octomap_delta.h>
 #include <moveit/collision_detection_fcl/collision_detector_allocator_fcl.h>
 #include <geometric_shapes/shape_operations.h>
 #include <moveit/collision_detection/collision_tools.h>
@@ -44,6 +45,9 @@
 #include <moveit/exceptions/exceptions.h>
 #include <octomap_msgs/conversions.h>
 #include <eigen_conversions/eigen_msg.h>
+#include <moveit/background_processing/worker_pool.h>
+#include <boost/atomic.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <memory>
 #include <set>
 
@@ -125,7 +129,8 @@ planning_scene::PlanningScene::PlanningScene(const robot_model::RobotModelConstP
                                              collision_detection::WorldPtr world) :
   kmodel_(robot_model),
   world_(world),
-  world_const_(world)
+  world_const_(world),
+  octomap_revision_(0)
 {
   initialize();
 }
@@ -134,7 +139,8 @@ planning_scene::PlanningScene::PlanningScene(const urdf::ModelInterfaceSharedPtr
                                              const boost::shared_ptr<const srdf::Model> &srdf_model,
                                              collision_detection::WorldPtr world) :
   world_(world),
-  world_const_(world)
+  world_const_(world),
+  octomap_revision_(0)
 {
   if (!urdf_model)
     throw moveit::ConstructException("The URDF model cannot be NULL");
@@ -189,7 +195,8 @@ robot_model::RobotModelPtr planning_scene::PlanningScene::createRobotModel(const
 }
 
 planning_scene::PlanningScene::PlanningScene(const PlanningSceneConstPtr &parent) :
-  parent_(parent)
+  parent_(parent),
+  octomap_revision_(0)
 {
   if (!parent_)
     throw moveit::ConstructException("NULL parent pointer for planning scene");
@@ -768,7 +775,7 @@ void planning_scene::PlanningScene::getPlanningSceneDiffMsg(moveit_msgs::Plannin
         getPlanningSceneMsgCollisionObject(scene_msg, it->first);
     }
     if (do_omap)
-      getPlanningSceneMsgOctomap(scene_msg);
+      getPlanningSceneMsgOctomap(scene_msg, true);
   }
 }
 
@@ -856,7 +863,7 @@ void planning_scene::PlanningScene::getPlanningSceneMsgCollisionObjects(moveit_m
       getPlanningSceneMsgCollisionObject(scene_msg, ns[i]);
 }
 
-void planning_scene::PlanningScene::getPlanningSceneMsgOctomap(moveit_msgs::PlanningScene &scene_msg) const
+void planning_scene::PlanningScene::getPlanningSceneMsgOctomap(moveit_msgs::PlanningScene &scene_msg, bool diff) const
 {
   scene_msg.world.octomap.header.frame_id = getPlanningFrame();
   scene_msg.world.octomap.octomap = octomap_msgs::Octomap();
@@ -867,7 +874,10 @@ void planning_scene::PlanningScene::getPlanningSceneMsgOctomap(moveit_msgs::Plan
     if (map->shapes_.size() == 1)
     {
       const shapes::OcTree *o = static_cast<const shapes::OcTree*>(map->shapes_[0].get());
-      octomap_msgs::fullMapToMsg(*o->octree, scene_msg.world.octomap.octomap);
+      if (octomap_serializer_)
+        octomap_serializer_(*o->octree, diff, scene_msg.world.octomap.octomap);
+      else
+        octomap_msgs::fullMapToMsg(*o->octree, scene_msg.world.octomap.octomap);
       tf::poseEigenToMsg(map->shape_poses_[0], scene_msg.world.octomap.origin);
     }
     else
@@ -1218,8 +1228,10 @@ bool planning_scene::PlanningScene::setPlanningSceneDiffMsg(const moveit_msgs::P
   }
 
   // process collision object updates
+  beginWorldUpdate();
   for (std::size_t i = 0 ; i < scene_msg.world.collision_objects.size() ; ++i)
     result &= processCollisionObjectMsg(scene_msg.world.collision_objects[i]);
+  endWorldUpdate();
 
   // if an octomap was specified, replace the one we have with that one
   if (!scene_msg.world.octomap.octomap.data.empty())
@@ -1263,12 +1275,26 @@ bool planning_scene::PlanningScene::setPlanningSceneMsg(const moveit_msgs::Plann
 bool planning_scene::PlanningScene::processPlanningSceneWorldMsg(const moveit_msgs::PlanningSceneWorld &world)
 {
   bool result = true;
+  beginWorldUpdate();
   for (std::size_t i = 0 ; i < world.collision_objects.size() ; ++i)
     result &= processCollisionObjectMsg(world.collision_objects[i]);
   processOctomapMsg(world.octomap);
+  endWorldUpdate();
   return result;
 }
 
+void planning_scene::PlanningScene::beginWorldUpdate()
+{
+  for (CollisionDetectorIterator it = collision_.begin() ; it != collision_.end() ; ++it)
+    it->second->cworld_->beginUpdate();
+}
+
+void planning_scene::PlanningScene::endWorldUpdate()
+{
+  for (CollisionDetectorIterator it = collision_.begin() ; it != collision_.end() ; ++it)
+    it->second->cworld_->endUpdate();
+}
+
 bool planning_scene::PlanningScene::usePlanningSceneMsg(const moveit_msgs::PlanningScene &scene_msg)
 {
   if (scene_msg.is_diff)
@@ -1279,8 +1305,15 @@ bool planning_scene::PlanningScene::usePlanningSceneMsg(const moveit_msgs::Plann
 
 void planning_scene::PlanningScene::processOctomapMsg(const octomap_msgs::Octomap &map)
 {
+  if (map.id == OCTOMAP_DELTA_ID)
+  {
+    applyOctomapDelta(map, map.header.frame_id.empty() ? Eigen::Affine3d::Identity() : getTransforms().getTransform(map.header.frame_id));
+    return;
+  }
+
   // each octomap replaces any previous one
   world_->removeObject(OCTOMAP_NS);
+  octomap_delta_tree_.reset();
 
   if (map.data.empty())
     return;
@@ -1301,6 +1334,7 @@ void planning_scene::PlanningScene::processOctomapMsg(const octomap_msgs::Octoma
   {
     world_->addToObject(OCTOMAP_NS, shapes::ShapeConstPtr(new shapes::OcTree(om)), Eigen::Affine3d::Identity());
   }
+  setOctomapDeltaBase(om, map.header.seq);
 }
 
 void planning_scene::PlanningScene::removeAllCollisionObjects()
@@ -1313,8 +1347,17 @@ void planning_scene::PlanningScene::removeAllCollisionObjects()
 
 void planning_scene::PlanningScene::processOctomapMsg(const octomap_msgs::OctomapWithPose &map)
 {
+  if (map.octomap.id == OCTOMAP_DELTA_ID)
+  {
+    Eigen::Affine3d p;
+    tf::poseMsgToEigen(map.origin, p);
+    applyOctomapDelta(map.octomap, getTransforms().getTransform(map.header.frame_id) * p);
+    return;
+  }
+
   // each octomap replaces any previous one
   world_->removeObject(OCTOMAP_NS);
+  octomap_delta_tree_.reset();
 
   if (map.octomap.data.empty())
     return;
@@ -1331,6 +1374,54 @@ void planning_scene::PlanningScene::processOctomapMsg(const octomap_msgs::Octoma
   tf::poseMsgToEigen(map.origin, p);
   p = t * p;
   world_->addToObject(OCTOMAP_NS, shapes::ShapeConstPtr(new shapes::OcTree(om)), p);
+  setOctomapDeltaBase(om, map.octomap.header.seq);
+}
+
+void planning_scene::PlanningScene::setOctomapDeltaBase(const std::shared_ptr<octomap::OcTree> &octree, unsigned int revision)
+{
+  // maps that are not part of a revision sequence cannot be updated by deltas
+  if (revision > 0)
+    octomap_delta_tree_ = octree;
+  else
+    octomap_delta_tree_.reset();
+  octomap_revision_ = revision;
+}
+
+bool planning_scene::PlanningScene::applyOctomapDelta(const octomap_msgs::Octomap &map, const Eigen::Affine3d &t)
+{
+  unsigned int base;
+  if (!getOctomapDeltaBase(map, base))
+  {
+    logError("Received malformed octomap delta");
+    return false;
+  }
+
+  // the delta must apply to the octree we last received, and that octree must still be the one in the world
+  collision_detection::CollisionWorld::ObjectConstPtr obj = world_->getObject(OCTOMAP_NS);
+  if (!octomap_delta_tree_ || base != octomap_revision_ || !obj || obj->shapes_.size() != 1 ||
+      obj->shapes_[0]->type != shapes::OCTREE ||
+      static_cast<const shapes::OcTree*>(obj->shapes_[0].get())->octree.get() != octomap_delta_tree_.get())
+  {
+    logDebug("Ignoring octomap delta from revision %u to %u; waiting for a full map", base, (unsigned int)map.header.seq);
+    return false;
+  }
+  if (fabs(map.resolution - octomap_delta_tree_->getResolution()) > std::numeric_limits<double>::epsilon() * 100.0)
+  {
+    logError("Octomap delta does not match the resolution of the current octomap (%lf vs %lf)", map.resolution, octomap_delta_tree_->getResolution());
+    return false;
+  }
+  obj.reset();
+
+  // once the shape is out of the world, the octree is only shared if other scenes (or collision geometry) still refer to it;
+  // in that case we update a copy so they keep seeing the octree they had
+  world_->removeObject(OCTOMAP_NS);
+  if (!octomap_delta_tree_.unique())
+    octomap_delta_tree_.reset(new octomap::OcTree(*octomap_delta_tree_));
+
+  applyOctomapDeltaMsg(map, *octomap_delta_tree_);
+  octomap_revision_ = map.header.seq;
+  world_->addToObject(OCTOMAP_NS, shapes::ShapeConstPtr(new shapes::OcTree(octomap_delta_tree_)), t);
+  return true;
 }
 
 void planning_scene::PlanningScene::processOctomapPtr(const std::shared_ptr<const octomap::OcTree> &octree, const Eigen::Affine3d &t)
@@ -1365,6 +1456,7 @@ void planning_scene::PlanningScene::processOctomapPtr(const std::shared_ptr<cons
   }
   // if the octree pointer changed, update the structure
   world_->removeObject(OCTOMAP_NS);
+  octomap_delta_tree_.reset();
   world_->addToObject(OCTOMAP_NS, shapes::ShapeConstPtr(new shapes::OcTree(octree)), t);
 }
 
@@ -2119,6 +2211,208 @@ bool planning_scene::PlanningScene::isPathValid(const robot_trajectory::RobotTra
   return isPathValid(trajectory, emp_constraints, emp_constraints_vector, group, verbose, invalid_index);
 }
 
+namespace planning_scene
+{
+namespace
+{
+
+/* The lowest index that failed a batch check so far, shared by the threads evaluating the batch */
+class BatchProgress
+{
+public:
+  BatchProgress(std::size_t count) : first_failure_(count)
+  {
+  }
+
+  void reportFailure(std::size_t index)
+  {
+    // the results are only read after the workers finished, so the ordering of other memory accesses does not matter here
+    std::size_t current = first_failure_.load(boost::memory_order_relaxed);
+    while (index < current && !first_failure_.compare_exchange_weak(current, index, boost::memory_order_relaxed))
+      ;
+  }
+
+  std::size_t getFirstFailure() const
+  {
+    return first_failure_.load(boost::memory_order_relaxed);
+  }
+
+private:
+  boost::atomic<std::size_t> first_failure_;
+};
+
+void runBatchChecks(const boost::function<bool(std::size_t, robot_state::RobotState*)> &check, const robot_state::RobotState *reference,
+                    std::size_t step, std::size_t count, std::vector<unsigned char> *passed, BatchProgress *progress, std::size_t first)
+{
+  // checks of states given as positions need a scratch state; checks of trajectory waypoints do not
+  boost::scoped_ptr<robot_state::RobotState> scratch(reference ? new robot_state::RobotState(*reference) : NULL);
+  for (std::size_t i = first ; i < count ; i += step)
+  {
+    // if only the first failure is needed, there is no point in checking past a failure already found
+    if (!passed && i > progress->getFirstFailure())
+      break;
+    bool ok = check(i, scratch.get());
+    if (passed)
+      (*passed)[i] = ok;
+    if (!ok)
+      progress->reportFailure(i);
+  }
+}
+
+/* The threads used for batch checks; they are started on first use and shared by all planning scenes */
+moveit::tools::WorkerPool& getBatchWorkers()
+{
+  // the thread calling checkBatch() takes part in the evaluation as well
+  static moveit::tools::WorkerPool workers(std::max(1u, boost::thread::hardware_concurrency()) - 1);
+  return workers;
+}
+
+bool getBatchGroup(const robot_model::RobotModelConstPtr &model, const std::string &group, const robot_model::JointModelGroup *&jmg)
+{
+  jmg = NULL;
+  if (group.empty())
+    return true;
+  jmg = model->getJointModelGroup(group);
+  if (!jmg)
+  {
+    logError("Cannot check a batch of states for unknown group '%s'", group.c_str());
+    return false;
+  }
+  return true;
+}
+
+void setBatchState(robot_state::RobotState &state, const robot_model::JointModelGroup *jmg, const double *positions)
+{
+  if (jmg)
+    state.setJointGroupPositions(jmg, positions);
+  else
+    state.setVariablePositions(positions);
+  state.updateCollisionBodyTransforms();
+}
+
+bool isBatchStateCollisionFree(const PlanningScene *scene, const collision_detection::CollisionRequest *req,
+                               const robot_model::JointModelGroup *jmg, const double *positions, std::size_t stride,
+                               std::size_t index, robot_state::RobotState *scratch)
+{
+  setBatchState(*scratch, jmg, positions + index * stride);
+  collision_detection::CollisionResult res;
+  scene->checkCollision(*req, res, const_cast<const robot_state::RobotState&>(*scratch));
+  return !res.collision;
+}
+
+bool isBatchStateValid(const PlanningScene *scene, const collision_detection::CollisionRequest *req,
+                       const robot_model::JointModelGroup *jmg, const double *positions, std::size_t stride,
+                       std::size_t index, robot_state::RobotState *scratch)
+{
+  setBatchState(*scratch, jmg, positions + index * stride);
+  collision_detection::CollisionResult res;
+  scene->checkCollision(*req, res, const_cast<const robot_state::RobotState&>(*scratch));
+  return !res.collision && scene->isStateFeasible(*scratch, req->verbose);
+}
+
+bool isBatchWayPointValid(const PlanningScene *scene, const collision_detection::CollisionRequest *req,
+                          const collision_detection::AllowedCollisionMatrix *acm, bool unpadded,
+                          const robot_trajectory::RobotTrajectory *trajectory, std::size_t start, std::size_t index, robot_state::RobotState *)
+{
+  const robot_state::RobotState &st = trajectory->getWayPoint(start + index);
+  const collision_detection::AllowedCollisionMatrix &matrix = acm ? *acm : scene->getAllowedCollisionMatrix();
+  collision_detection::CollisionResult res;
+  if (unpadded)
+    scene->checkCollisionUnpadded(*req, res, st, matrix);
+  else
+    scene->checkCollision(*req, res, st, matrix);
+  return !res.collision && scene->isStateFeasible(st, req->verbose);
+}
+
+}
+}
+
+std::size_t planning_scene::PlanningScene::checkBatch(std::size_t count, const BatchCheckFn &check, const robot_state::RobotState *reference,
+                                                      std::vector<bool> *passed, unsigned int threads) const
+{
+  BatchProgress progress(count);
+  std::vector<unsigned char> result;
+  if (passed)
+    result.resize(count, 1);
+  std::vector<unsigned char> *result_ptr = passed ? &result : NULL;
+
+  // interleave the indices, so all threads move from the start of the batch towards the end together
+  std::size_t nthreads = std::max<std::size_t>(1, std::min<std::size_t>(threads, count));
+  if (nthreads == 1)
+    runBatchChecks(check, reference, 1, count, result_ptr, &progress, 0);
+  else
+    getBatchWorkers().run(nthreads, boost::bind(&runBatchChecks, boost::cref(check), reference, nthreads, count, result_ptr, &progress, _1));
+
+  if (passed)
+    passed->assign(result.begin(), result.end());
+  return progress.getFirstFailure();
+}
+
+bool planning_scene::PlanningScene::checkCollisionBatch(const collision_detection::CollisionRequest& req, const robot_state::RobotState &reference,
+                                                        const double *positions, std::size_t count, std::size_t &first_colliding,
+                                                        std::vector<bool> *colliding, unsigned int threads) const
+{
+  const robot_model::JointModelGroup *jmg;
+  if (!getBatchGroup(getRobotModel(), req.group_name, jmg))
+    return false;
+  std::size_t stride = jmg ? jmg->getVariableCount() : getRobotModel()->getVariableCount();
+
+  first_colliding = checkBatch(count, boost::bind(&isBatchStateCollisionFree, this, &req, jmg, positions, stride, _1, _2),
+                               &reference, colliding, threads);
+  if (colliding)
+    colliding->flip();
+  return true;
+}
+
+bool planning_scene::PlanningScene::isStateValidBatch(const robot_state::RobotState &reference, const double *positions, std::size_t count,
+                                                      std::size_t &first_invalid, const std::string &group, bool verbose,
+                                                      std::vector<bool> *valid, unsigned int threads) const
+{
+  const robot_model::JointModelGroup *jmg;
+  if (!getBatchGroup(getRobotModel(), group, jmg))
+    return false;
+  std::size_t stride = jmg ? jmg->getVariableCount() : getRobotModel()->getVariableCount();
+
+  // the request is built once for the whole batch
+  collision_detection::CollisionRequest req;
+  req.verbose = verbose;
+  req.group_name = group;
+  first_invalid = checkBatch(count, boost::bind(&isBatchStateValid, this, &req, jmg, positions, stride, _1, _2),
+                             &reference, valid, threads);
+  return true;
+}
+
+bool planning_scene::PlanningScene::isStateValidBatch(const robot_trajectory::RobotTrajectory &trajectory, std::size_t &first_invalid,
+                                                      const std::string &group, bool verbose,
+                                                      std::vector<bool> *valid, unsigned int threads) const
+{
+  collision_detection::CollisionRequest req;
+  req.verbose = verbose;
+  req.group_name = group;
+  return isStateValidBatch(trajectory, 0, req, NULL, false, first_invalid, valid, threads);
+}
+
+bool planning_scene::PlanningScene::isStateValidBatch(const robot_trajectory::RobotTrajectory &trajectory, std::size_t start,
+                                                      const collision_detection::CollisionRequest &req,
+                                                      const collision_detection::AllowedCollisionMatrix *acm, bool unpadded,
+                                                      std::size_t &first_invalid, std::vector<bool> *valid, unsigned int threads) const
+{
+  const robot_model::JointModelGroup *jmg;
+  if (!getBatchGroup(getRobotModel(), req.group_name, jmg))
+    return false;
+  std::size_t wpc = trajectory.getWayPointCount();
+  if (start >= wpc)
+  {
+    if (valid)
+      valid->clear();
+    first_invalid = wpc;
+    return true;
+  }
+  first_invalid = start + checkBatch(wpc - start, boost::bind(&isBatchWayPointValid, this, &req, acm, unpadded, &trajectory, start, _1, _2),
+                                     NULL, valid, threads);
+  return true;
+}
+
 void planning_scene::PlanningScene::getCostSources(const robot_trajectory::RobotTrajectory &trajectory, std::size_t max_costs,
                                                    std::set<collision_detection::CostSource> &costs, double overlap_fraction) const
 {
@@ -36,8 +36,14 @@
 
 #include <gtest/gtest.h>
 #include <moveit/planning_scene/planning_scene.h>
+#include <moveit/planning_scene/octomap_delta.h>
+#include <octomap_msgs/conversions.h>
 #include <urdf_parser/urdf_parser.h>
 #include <fstream>
+#include <algorithm>
+#include <set>
+#include <boost/thread/mutex.hpp>
+#include <boost/bind.hpp>
 #include <boost/filesystem/path.hpp>
 #include <moveit_resources/config.h>
 
@@ -135,6 +141,219 @@ TEST(PlanningScene, MakeAttachedDiff)
   ps->checkCollision(req, res);
 }
 
+namespace
+{
+/* Feasibility predicate that records which states of a batch were checked; the states are told apart by the value of \e variable */
+class BatchRecorder
+{
+public:
+  BatchRecorder(int variable, double base, double step) : variable_(variable), base_(base), step_(step)
+  {
+  }
+
+  bool isFeasible(const robot_state::RobotState &state, bool)
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    checked_.insert((std::size_t)((state.getVariablePosition(variable_) - base_) / step_ + 0.5));
+    return true;
+  }
+
+  int variable_;
+  double base_;
+  double step_;
+  boost::mutex lock_;
+  std::set<std::size_t> checked_;
+};
+}
+
+TEST(PlanningScene, StateValidBatch)
+{
+  boost::shared_ptr<srdf::Model> srdf_model(new srdf::Model());
+  urdf::ModelInterfaceSharedPtr urdf_model;
+  loadRobotModel(urdf_model);
+
+  planning_scene::PlanningScenePtr ps(new planning_scene::PlanningScene(urdf_model, srdf_model));
+  const robot_model::RobotModelConstPtr &model = ps->getRobotModel();
+
+  // without an SRDF nothing disables the collisions of adjacent links; only world collisions are of interest here
+  ps->getAllowedCollisionMatrixNonConst().setEntry(model->getLinkModelNames(), model->getLinkModelNames(), true);
+
+  // state k swings the right arm outwards; a small box sits where the gripper ends up, so only that state is in collision
+  const std::size_t count = 50;
+  const std::size_t k = 17;
+  robot_state::RobotState state(model);
+  state.setToDefaultValues();
+  state.setVariablePosition("r_shoulder_pan_joint", -0.5);
+  state.update();
+  Eigen::Affine3d box_pose = state.getGlobalLinkTransform("r_gripper_palm_link");
+  ps->getWorldNonConst()->addToObject("box", shapes::ShapeConstPtr(new shapes::Box(0.05, 0.05, 0.05)), box_pose);
+  std::vector<double> colliding_positions(state.getVariablePositions(), state.getVariablePositions() + model->getVariableCount());
+
+  // the states are told apart by tiny offsets of the torso
+  state.setToDefaultValues();
+  state.update();
+  int torso = model->getVariableIndex("torso_lift_joint");
+  const double base = state.getVariablePosition(torso);
+  const double step = 1e-4;
+  std::size_t nvars = model->getVariableCount();
+  std::vector<double> positions(count * nvars);
+  for (std::size_t i = 0 ; i < count ; ++i)
+  {
+    const double *src = i == k ? &colliding_positions[0] : state.getVariablePositions();
+    std::copy(src, src + nvars, positions.begin() + i * nvars);
+    positions[i * nvars + torso] = base + step * i;
+  }
+  EXPECT_TRUE(ps->isStateValid(state));
+
+  for (unsigned int threads = 1 ; threads <= 4 ; threads += 3)
+  {
+    std::size_t first = count;
+    std::vector<bool> valid;
+    EXPECT_TRUE(ps->isStateValidBatch(state, &positions[0], count, first, "", false, &valid, threads));
+    EXPECT_EQ(k, first);
+    ASSERT_EQ(count, valid.size());
+    for (std::size_t i = 0 ; i < count ; ++i)
+      EXPECT_EQ(i != k, valid[i]);
+
+    first = count;
+    EXPECT_TRUE(ps->isStateValidBatch(state, &positions[0], count, first, "", false, NULL, threads));
+    EXPECT_EQ(k, first);
+
+    first = count;
+    std::vector<bool> colliding;
+    collision_detection::CollisionRequest req;
+    EXPECT_TRUE(ps->checkCollisionBatch(req, state, &positions[0], count, first, &colliding, threads));
+    EXPECT_EQ(k, first);
+    ASSERT_EQ(count, colliding.size());
+    for (std::size_t i = 0 ; i < count ; ++i)
+      EXPECT_EQ(i == k, colliding[i]);
+  }
+
+  // when only the first invalid state is asked for, the states after it are not needed
+  BatchRecorder recorder(torso, base, step);
+  ps->setStateFeasibilityPredicate(boost::bind(&BatchRecorder::isFeasible, &recorder, _1, _2));
+  std::size_t first = count;
+  EXPECT_TRUE(ps->isStateValidBatch(state, &positions[0], count, first, "", false, NULL, 1));
+  EXPECT_EQ(k, first);
+  ASSERT_FALSE(recorder.checked_.empty());
+  EXPECT_EQ(k - 1, *recorder.checked_.rbegin()); // state k is in collision, so its feasibility is not evaluated
+  EXPECT_EQ(k, recorder.checked_.size());
+
+  // with all results requested, every state is checked
+  recorder.checked_.clear();
+  std::vector<bool> valid;
+  EXPECT_TRUE(ps->isStateValidBatch(state, &positions[0], count, first, "", false, &valid, 1));
+  EXPECT_EQ(count - 1, recorder.checked_.size());
+
+  // batches for groups that do not exist are not checked
+  EXPECT_FALSE(ps->isStateValidBatch(state, &positions[0], count, first, "no_such_group"));
+  collision_detection::CollisionRequest req;
+  req.group_name = "no_such_group";
+  EXPECT_FALSE(ps->checkCollisionBatch(req, state, &positions[0], count, first));
+}
+
+namespace
+{
+std::shared_ptr<const octomap::OcTree> getSceneOctree(const planning_scene::PlanningScene &ps)
+{
+  collision_detection::World::ObjectConstPtr obj = ps.getWorld()->getObject(planning_scene::PlanningScene::OCTOMAP_NS);
+  if (!obj || obj->shapes_.size() != 1)
+    return std::shared_ptr<const octomap::OcTree>();
+  return static_cast<const shapes::OcTree*>(obj->shapes_[0].get())->octree;
+}
+
+void makeOctomapDelta(octomap::OcTree &tree, unsigned int base, octomap_msgs::Octomap &msg)
+{
+  octomap::KeySet keys;
+  for (octomap::KeyBoolMap::const_iterator it = tree.changedKeysBegin() ; it != tree.changedKeysEnd() ; ++it)
+    keys.insert(it->first);
+  tree.resetChangeDetection();
+  planning_scene::octomapDeltaToMsg(tree, keys, base, base + 1, msg);
+}
+}
+
+TEST(PlanningScene, OctomapDelta)
+{
+  urdf::ModelInterfaceSharedPtr urdf_model;
+  loadRobotModel(urdf_model);
+  boost::shared_ptr<srdf::Model> srdf_model(new srdf::Model());
+  planning_scene::PlanningScenePtr ps(new planning_scene::PlanningScene(urdf_model, srdf_model));
+
+  octomap::OcTree tree(0.05);
+  tree.enableChangeDetection(true);
+  const octomap::point3d p1(1.0, 0.0, 0.5), p2(1.0, 0.2, 0.5), p3(1.0, 0.4, 0.5);
+  tree.updateNode(p1, true);
+  tree.resetChangeDetection();
+
+  octomap_msgs::Octomap full;
+  ASSERT_TRUE(octomap_msgs::fullMapToMsg(tree, full));
+  full.header.seq = 1;
+  ps->processOctomapMsg(full);
+  std::shared_ptr<const octomap::OcTree> received = getSceneOctree(*ps);
+  ASSERT_TRUE(received);
+  EXPECT_TRUE(received->search(p1) && received->isNodeOccupied(received->search(p1)));
+  EXPECT_FALSE(received->search(p2));
+
+  // a delta from the received revision is applied to the received octree
+  tree.updateNode(p2, true);
+  for (int i = 0 ; i < 3 ; ++i)
+    tree.updateNode(p1, false);
+  octomap_msgs::Octomap delta;
+  makeOctomapDelta(tree, 1, delta);
+  EXPECT_LT(delta.data.size(), full.data.size());
+  ps->processOctomapMsg(delta);
+  std::shared_ptr<const octomap::OcTree> updated = getSceneOctree(*ps);
+  ASSERT_TRUE(updated);
+  ASSERT_TRUE(updated->search(p2));
+  EXPECT_TRUE(updated->isNodeOccupied(updated->search(p2)));
+  ASSERT_TRUE(updated->search(p1));
+  EXPECT_FALSE(updated->isNodeOccupied(updated->search(p1)));
+  EXPECT_FLOAT_EQ(tree.search(p1)->getLogOdds(), updated->search(p1)->getLogOdds());
+
+  // since we still hold the previous octree, it must not have been changed
+  EXPECT_FALSE(received->search(p2));
+  received.reset();
+
+  // once nothing else refers to it, later deltas update the octree in place
+  const octomap::OcTree *in_place = updated.get();
+  updated.reset();
+  for (int i = 0 ; i < 3 ; ++i)
+    tree.updateNode(p2, false);
+  makeOctomapDelta(tree, 2, delta);
+  ps->processOctomapMsg(delta);
+  EXPECT_EQ(in_place, getSceneOctree(*ps).get());
+  ASSERT_TRUE(getSceneOctree(*ps)->search(p2));
+  EXPECT_FALSE(getSceneOctree(*ps)->isNodeOccupied(getSceneOctree(*ps)->search(p2)));
+
+  // a delta that skips a revision is ignored
+  tree.updateNode(p3, true);
+  makeOctomapDelta(tree, 5, delta);
+  ps->processOctomapMsg(delta);
+  EXPECT_FALSE(getSceneOctree(*ps)->search(p3));
+
+  // a full map resynchronizes the scene, after which deltas apply again
+  ASSERT_TRUE(octomap_msgs::fullMapToMsg(tree, full));
+  full.header.seq = 6;
+  ps->processOctomapMsg(full);
+  EXPECT_TRUE(getSceneOctree(*ps)->search(p3));
+  for (int i = 0 ; i < 3 ; ++i)
+    tree.updateNode(p3, false);
+  makeOctomapDelta(tree, 6, delta);
+  ps->processOctomapMsg(delta);
+  ASSERT_TRUE(getSceneOctree(*ps)->search(p3));
+  EXPECT_FALSE(getSceneOctree(*ps)->isNodeOccupied(getSceneOctree(*ps)->search(p3)));
+
+  // full maps without a revision cannot be updated by deltas
+  ASSERT_TRUE(octomap_msgs::fullMapToMsg(tree, full));
+  full.header.seq = 0;
+  ps->processOctomapMsg(full);
+  for (int i = 0 ; i < 3 ; ++i)
+    tree.updateNode(p3, true);
+  makeOctomapDelta(tree, 0, delta);
+  ps->processOctomapMsg(delta);
+  EXPECT_FALSE(getSceneOctree(*ps)->isNodeOccupied(getSceneOctree(*ps)->search(p3)));
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
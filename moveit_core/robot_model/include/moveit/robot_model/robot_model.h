@@ -278,6 +278,12 @@ public:
     return link_model_vector_.size();
   }
 
+  /** \brief Get the links on the path from the root link to \e link (inclusive), starting with the root link */
+  const std::vector<const LinkModel*>& getLinkChain(const LinkModel *link) const
+  {
+    return link_chains_[link->getLinkIndex()];
+  }
+
   std::size_t getLinkGeometryCount() const
   {
     return link_geometry_count_;
@@ -513,6 +519,9 @@ protected:
    */
   std::vector<int>                              common_joint_roots_;
 
+  /** \brief For every link (by index), the links from the root link down to it */
+  std::vector<std::vector<const LinkModel*> >   link_chains_;
+
   // INDEXING
 
   /** \brief The names of the DOF that make up this state (this is just a sequence of joint variable names; not necessarily joint names!) */
@@ -581,6 +590,9 @@ protected:
   /** \brief For every pair of joints, pre-compute the common roots of the joints */
   void computeCommonRoots();
 
+  /** \brief For every link, pre-compute the chain of links from the root link */
+  void computeLinkChains();
+
   /** \brief (This function is mostly intended for internal use). Given a parent link, build up (recursively),
       the kinematic model by walking  down the tree*/
   JointModel* buildRecursive(LinkModel *parent, const urdf::Link *link, const srdf::Model &srdf_model);
@@ -224,6 +224,19 @@ void moveit::core::RobotModel::computeCommonRoots()
   }
 }
 
+void moveit::core::RobotModel::computeLinkChains()
+{
+  link_chains_.resize(link_model_vector_.size());
+  for (std::size_t i = 0 ; i < link_model_vector_.size() ; ++i)
+  {
+    std::vector<const LinkModel*> &chain = link_chains_[link_model_vector_[i]->getLinkIndex()];
+    chain.clear();
+    for (const LinkModel *link = link_model_vector_[i] ; link ; link = link->getParentLinkModel())
+      chain.push_back(link);
+    std::reverse(chain.begin(), chain.end());
+  }
+}
+
 void moveit::core::RobotModel::computeDescendants()
 {
   // compute the list of descendants for all joints
@@ -308,6 +321,7 @@ void moveit::core::RobotModel::buildJointInfo()
 
   computeDescendants();
   computeCommonRoots(); // must be called _after_ list of descendants was computed
+  computeLinkChains();
 }
 
 void moveit::core::RobotModel::buildGroupStates(const srdf::Model &srdf_model)
@@ -40,6 +40,8 @@
 #include <moveit/robot_model/link_model.h>
 #include <eigen_stl_containers/eigen_stl_containers.h>
 #include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
 #include <trajectory_msgs/JointTrajectory.h>
 #include <set>
 
@@ -58,6 +60,27 @@ class AttachedBody
 {
 public:
 
+  /** \brief Identifies the component that stores data with attached bodies (see setCollisionCache()). Keys are
+      told apart by their address, so each component defines one key that lives as long as the component's code. */
+  class CollisionCacheKey : private boost::noncopyable
+  {
+  public:
+
+    explicit CollisionCacheKey(const std::string &name) : name_(name)
+    {
+    }
+
+    /** \brief A name for the component, for debugging purposes */
+    const std::string& getName() const
+    {
+      return name_;
+    }
+
+  private:
+
+    std::string name_;
+  };
+
   /** \brief Construct an attached body for a specified \e link. The name of this body is \e id and it consists of \e shapes that
       attach to the link by the transforms \e attach_trans. The set of links that are allowed to be touched by this object is specified by \e touch_links. */
   AttachedBody(const LinkModel *link, const std::string &id,
@@ -66,6 +89,10 @@ public:
                const std::set<std::string> &touch_links,
                const trajectory_msgs::JointTrajectory &attach_posture);
 
+  /** \brief Copy an attached body. The copy shares the data stored with \e other by setCollisionCache(), as long as
+      neither of the two bodies changes its shapes */
+  AttachedBody(const AttachedBody &other);
+
   ~AttachedBody();
 
   /** \brief Get the name of the attached body */
@@ -124,6 +151,16 @@ public:
   /** \brief Set the scale for the shapes of this attached object */
   void setScale(double scale);
 
+  /** \brief Get the data that was associated to this body by setCollisionCache() using the same \e key, or NULL.
+      Collision checkers use this to store structures computed from the shapes of the body, so they are not recomputed
+      for every check. This function can be called concurrently with setCollisionCache(). */
+  boost::shared_ptr<const void> getCollisionCache(const CollisionCacheKey &key) const;
+
+  /** \brief Associate \e data with this body, for the component identified by \e key. Only one such entry is kept.
+      The data is shared with copies of the body made afterwards, so it must not refer to this particular instance;
+      it is discarded when the shapes of the body change. */
+  void setCollisionCache(const CollisionCacheKey &key, const boost::shared_ptr<const void> &data) const;
+
   /** \brief Recompute global_collision_body_transform given the transform of the parent link*/
   void computeTransform(const Eigen::Affine3d &parent_link_global_transform)
   {
@@ -154,6 +191,15 @@ private:
 
   /** \brief The global transforms for these attached bodies (computed by forward kinematics) */
   EigenSTL::vector_Affine3d          global_collision_body_transforms_;
+
+  struct CollisionCache
+  {
+    const CollisionCacheKey      *key_;
+    boost::shared_ptr<const void> data_;
+  };
+
+  /** \brief Data stored by a collision checker (see setCollisionCache()); only accessed atomically */
+  mutable boost::shared_ptr<const CollisionCache> collision_cache_;
 };
 
 }
@@ -0,0 +1,193 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt! contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#ifndef MOVEIT_CORE_ROBOT_STATE_BATCH_FORWARD_KINEMATICS_
+#define MOVEIT_CORE_ROBOT_STATE_BATCH_FORWARD_KINEMATICS_
+
+#include <moveit/robot_state/robot_state.h>
+
+namespace moveit
+{
+namespace core
+{
+
+MOVEIT_CLASS_FORWARD(BatchForwardKinematics);
+
+/** @brief Compute the global link transforms of a robot for many states at once.
+
+    The states share a reference RobotState and differ only in the values of the variables of a group (or of the
+    whole robot). Transforms are stored as structure-of-arrays: every element of every link transform is kept in
+    a contiguous array with one entry per state, so the work for consecutive states is done by the same
+    straight-line code and can be vectorized by the compiler. Revolute, prismatic and fixed joints are evaluated
+    in this form; planar and floating joints are evaluated per state.
+
+    Results take 96 bytes per computed link and per state, so very large batches should be processed in chunks.
+    The same instance can be used for any number of calls to compute(), but not from multiple threads at once. */
+class BatchForwardKinematics
+{
+public:
+
+  /** \brief Compute the transforms of all links of \e robot_model; the states are specified by the values of all the variables of the robot */
+  BatchForwardKinematics(const RobotModelConstPtr &robot_model);
+
+  /** \brief Compute the transforms of the links updated by \e group; the states are specified by the values of the variables of \e group */
+  BatchForwardKinematics(const RobotModelConstPtr &robot_model, const JointModelGroup *group);
+
+  ~BatchForwardKinematics();
+
+  const RobotModelConstPtr& getRobotModel() const
+  {
+    return robot_model_;
+  }
+
+  /** \brief Get the group the states are specified for (NULL if states are specified for the whole robot) */
+  const JointModelGroup* getJointModelGroup() const
+  {
+    return group_;
+  }
+
+  /** \brief The number of values that specify one state */
+  std::size_t getVariableCount() const
+  {
+    return variable_count_;
+  }
+
+  /** \brief Get the links for which transforms are computed */
+  const std::vector<const LinkModel*>& getLinkModels() const
+  {
+    return links_;
+  }
+
+  /** \brief Compute the link transforms for \e count states. The states are obtained by setting the variables of the group
+      (or robot) in \e reference to consecutive blocks of getVariableCount() values from \e positions. Mimic joints follow the
+      joints they mimic. The transforms of \e reference must be up to date. */
+  void compute(const RobotState &reference, const double *positions, std::size_t count);
+
+  /** \brief The number of states evaluated by the last call to compute() */
+  std::size_t getStateCount() const
+  {
+    return state_count_;
+  }
+
+  /** \brief Check if transforms for \e link are computed by this instance; other links have the transforms of the reference state */
+  bool hasLinkModel(const LinkModel *link) const
+  {
+    return link_slot_[link->getLinkIndex()] >= 0;
+  }
+
+  /** \brief Get the global transform of \e link for state \e state (as computed by the last call to compute()) */
+  Eigen::Affine3d getGlobalLinkTransform(const LinkModel *link, std::size_t state) const;
+
+  /** \brief Get the global transform of collision body \e shape_index of \e link for state \e state */
+  Eigen::Affine3d getCollisionBodyTransform(const LinkModel *link, std::size_t shape_index, std::size_t state) const;
+
+  /** \brief Get the \e count values of element (\e row, \e col) of the transform of \e link, for all the states, where \e row is
+      less than 3 and \e col is less than 4. This gives direct access to the structure-of-arrays layout. */
+  const double* getTransformElements(const LinkModel *link, unsigned int row, unsigned int col) const;
+
+private:
+
+  /* Where the value of a joint variable comes from */
+  struct VariableSource
+  {
+    /// Index in a block of positions passed to compute(), or -1 if the value is taken from the reference state
+    int    index_;
+
+    /// Index of the variable in the reference state
+    int    robot_index_;
+
+    double factor_;
+    double offset_;
+  };
+
+  struct LinkEntry
+  {
+    const LinkModel          *link_;
+
+    /// Slot of the parent link, or -1 if the parent transform is the same for all states
+    int                       parent_;
+
+    const JointModel         *joint_;
+    JointModel::JointType     type_;
+    Eigen::Vector3d           axis_;
+
+    /// The joint origin transform, as 12 values in the order used for storage
+    double                    origin_[12];
+
+    std::vector<VariableSource> variables_;
+  };
+
+  void initialize(const std::vector<const LinkModel*> &links);
+
+  double* elements(int slot)
+  {
+    return &transforms_[slot * 12 * capacity_];
+  }
+
+  const double* elements(int slot) const
+  {
+    return &transforms_[slot * 12 * capacity_];
+  }
+
+  double value(const VariableSource &src, const RobotState &reference, const double *positions, std::size_t state) const
+  {
+    double v = src.index_ >= 0 ? positions[state * variable_count_ + src.index_] : reference.getVariablePosition(src.robot_index_);
+    return src.factor_ * v + src.offset_;
+  }
+
+  RobotModelConstPtr            robot_model_;
+  const JointModelGroup        *group_;
+  std::size_t                   variable_count_;
+
+  std::vector<const LinkModel*> links_;
+  std::vector<LinkEntry>        entries_;
+
+  /// For every link of the robot model, its slot in entries_ (or -1)
+  std::vector<int>              link_slot_;
+
+  std::size_t                   state_count_;
+  std::size_t                   capacity_;
+
+  /// Transforms of all links, element by element: slot * 12 * capacity_ + element * capacity_ + state
+  std::vector<double>           transforms_;
+
+  /// Scratch space for joint transforms and for parent transforms that are the same for all states
+  std::vector<double>           local_;
+  std::vector<double>           parent_;
+};
+
+}
+}
+
+#endif
@@ -590,6 +590,10 @@ as the new values that correspond to the group */
 as the new values that correspond to the group */
   void setJointGroupPositions(const JointModelGroup *group, const Eigen::VectorXd& values);
 
+  /** \brief Given positions for the active joints of a group, in the order of JointModelGroup::getActiveJointModels(), set those
+as the new values that correspond to the group. The joints that mimic them are updated as well. */
+  void setJointGroupActivePositions(const JointModelGroup *group, const Eigen::VectorXd& values);
+
   /** \brief For a given group, copy the position values of the variables that make up the group into another location, in the order that the variables are found in the group. This is not necessarily a contiguous block of memory in the RobotState itself, so we copy instead of returning a pointer.*/
   void copyJointGroupPositions(const std::string &joint_group_name, std::vector<double> &gstate) const
   {
@@ -732,6 +736,9 @@ as the new values that correspond to the group */
       is available for each sub-group, then the joint values can be set by computing inverse kinematics.
       The poses are assumed to be in the reference frame of the kinematic model. The poses are assumed
       to be in the same order as the order of the sub-groups in this group. Returns true on success.
+      The first attempt starts from the current joint values and the others from random ones. For a single pose without
+      consistency limits and a solver that supportsConcurrentQueries(), the random restarts are searched in one batch
+      (see kinematics::KinematicsBase::searchPositionIKBatch()).
       @param poses The poses the last link in each chain needs to achieve
       @param tips The names of the frames for which IK is attempted.
       @param consistency_limits This specifies the desired distance between the solution and the seed state
@@ -1002,6 +1009,19 @@ as the new values that correspond to the group */
     return global_link_transforms_[link->getLinkIndex()];
   }
 
+  /** \brief Get the global transform of \e link, updating only the transforms of the links on the chain from the root of
+      the model to \e link. The transforms of all other links (and of attached bodies) are left out of date, which makes
+      this cheaper than getGlobalLinkTransform() when a single frame is needed after the state changed. */
+  const Eigen::Affine3d& computeGlobalLinkTransform(const std::string &link_name)
+  {
+    return computeGlobalLinkTransform(robot_model_->getLinkModel(link_name));
+  }
+
+  /** \brief Get the global transform of \e link, updating only the transforms of the links on the chain from the root of
+      the model to \e link. The transforms of all other links (and of attached bodies) are left out of date, which makes
+      this cheaper than getGlobalLinkTransform() when a single frame is needed after the state changed. */
+  const Eigen::Affine3d& computeGlobalLinkTransform(const LinkModel *link);
+
   const Eigen::Affine3d& getCollisionBodyTransforms(const std::string &link_name, std::size_t index)
   {
     return getCollisionBodyTransform(robot_model_->getLinkModel(link_name), index);
@@ -1041,6 +1061,10 @@ as the new values that correspond to the group */
     return global_link_transforms_[link->getLinkIndex()];
   }
 
+  /** \brief Compute the global transform of \e link into \e transform, even if the link transforms are out of date.
+      Only the joints on the chain from the root of the model to \e link are evaluated; the state itself is not modified. */
+  void computeGlobalLinkTransform(const LinkModel *link, Eigen::Affine3d &transform) const;
+
   const Eigen::Affine3d& getCollisionBodyTransform(const std::string &link_name, std::size_t index) const
   {
     return getCollisionBodyTransform(robot_model_->getLinkModel(link_name), index);
@@ -1415,8 +1439,28 @@ private:
     }
   }
 
+  /** \brief Sample a seed for the IK solver of \e jmg, in the order of the solver's joints. Redundant joints keep
+      their current values if \e options asks for that */
+  void getRandomIKSeed(const JointModelGroup *jmg, const kinematics::KinematicsQueryOptions &options, std::vector<double> &seed);
+
+  /** \brief Solve IK for \e ik_query (in the frame of the solver) from \e attempts random seeds with a single batched
+      query, and set the group to the first solution accepted by \e ik_callback_fn */
+  bool setFromIKBatch(const JointModelGroup *jmg, const geometry_msgs::Pose &ik_query, unsigned int attempts, double timeout,
+                      const kinematics::KinematicsBase::IKCallbackFn &ik_callback_fn, const kinematics::KinematicsQueryOptions &options);
+
   void updateLinkTransformsInternal(const JointModel *start);
 
+  /** \brief The position in \e chain (as returned by RobotModel::getLinkChain()) of the first link with an out of date
+      transform, or the size of \e chain if all transforms on the chain are up to date */
+  std::size_t getDirtyLinkChainStart(const std::vector<const LinkModel*> &chain) const
+  {
+    if (dirty_link_transforms_ != NULL)
+      for (std::size_t i = 0 ; i < chain.size() ; ++i)
+        if (chain[i]->getParentJointModel() == dirty_link_transforms_)
+          return i;
+    return chain.size();
+  }
+
   void getMissingKeys(const std::map<std::string, double> &variable_map, std::vector<std::string> &missing_variables) const;
   void getStateTreeJointString(std::ostream& ss, const JointModel* jm, const std::string& pfx0, bool last) const;
 
@@ -55,12 +55,45 @@ moveit::core::AttachedBody::AttachedBody(const LinkModel *parent_link_model,
     global_collision_body_transforms_[i].setIdentity();
 }
 
+moveit::core::AttachedBody::AttachedBody(const AttachedBody &other)
+  : parent_link_model_(other.parent_link_model_)
+  , id_(other.id_)
+  , shapes_(other.shapes_)
+  , attach_trans_(other.attach_trans_)
+  , touch_links_(other.touch_links_)
+  , detach_posture_(other.detach_posture_)
+  , global_collision_body_transforms_(other.global_collision_body_transforms_)
+  , collision_cache_(boost::atomic_load(&other.collision_cache_))
+{
+}
+
 moveit::core::AttachedBody::~AttachedBody()
 {
 }
 
+boost::shared_ptr<const void> moveit::core::AttachedBody::getCollisionCache(const CollisionCacheKey &key) const
+{
+  boost::shared_ptr<const CollisionCache> cache = boost::atomic_load(&collision_cache_);
+  if (cache && cache->key_ == &key)
+    return cache->data_;
+  return boost::shared_ptr<const void>();
+}
+
+void moveit::core::AttachedBody::setCollisionCache(const CollisionCacheKey &key, const boost::shared_ptr<const void> &data) const
+{
+  boost::shared_ptr<CollisionCache> cache;
+  if (data)
+  {
+    cache.reset(new CollisionCache());
+    cache->key_ = &key;
+    cache->data_ = data;
+  }
+  boost::atomic_store(&collision_cache_, boost::shared_ptr<const CollisionCache>(cache));
+}
+
 void moveit::core::AttachedBody::setScale(double scale)
 {
+  boost::atomic_store(&collision_cache_, boost::shared_ptr<const CollisionCache>());
   for (std::size_t i = 0 ; i < shapes_.size() ; ++i)
   {
     // if this shape is only owned here (and because this is a non-const function), we can safely const-cast:
@@ -78,6 +111,7 @@ void moveit::core::AttachedBody::setScale(double scale)
 
 void moveit::core::AttachedBody::setPadding(double padding)
 {
+  boost::atomic_store(&collision_cache_, boost::shared_ptr<const CollisionCache>());
   for (std::size_t i = 0 ; i < shapes_.size() ; ++i)
   {
     // if this shape is only owned here (and because this is a non-const function), we can safely const-cast:
@@ -0,0 +1,308 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt! contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <moveit/robot_state/batch_forward_kinematics.h>
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <moveit/robot_model/prismatic_joint_model.h>
+#include <algorithm>
+#include <cmath>
+
+/* Transforms are stored as 12 values per state: the rotation matrix column by column, followed by the translation.
+   A "varying" transform has each of its 12 values in an array of \e stride elements (one per state);
+   a constant transform is just 12 values. */
+namespace
+{
+
+bool linkIndexLess(const moveit::core::LinkModel *a, const moveit::core::LinkModel *b)
+{
+  return a->getLinkIndex() < b->getLinkIndex();
+}
+
+void storeTransform(const Eigen::Affine3d &t, double *out, std::size_t stride, std::size_t state)
+{
+  const Eigen::Affine3d::MatrixType &m = t.matrix();
+  for (unsigned int j = 0 ; j < 4 ; ++j)
+    for (unsigned int i = 0 ; i < 3 ; ++i)
+      out[(j * 3 + i) * stride + state] = m(i, j);
+}
+
+/* out = a * b for \e count states; a and b are varying (AV, BV) or constant, out is varying.
+   The loops over states are kept innermost so the compiler can vectorize them. */
+template<bool AV, bool BV>
+void multiplyTransforms(const double *a, const double *b, double *out, std::size_t stride, std::size_t count)
+{
+  const std::size_t as = AV ? stride : 1;
+  const std::size_t bs = BV ? stride : 1;
+  for (unsigned int j = 0 ; j < 4 ; ++j)
+    for (unsigned int i = 0 ; i < 3 ; ++i)
+    {
+      double *o = out + (j * 3 + i) * stride;
+      const double *a0 = a + i * as;
+      const double *a1 = a + (3 + i) * as;
+      const double *a2 = a + (6 + i) * as;
+      const double *b0 = b + (j * 3) * bs;
+      const double *b1 = b + (j * 3 + 1) * bs;
+      const double *b2 = b + (j * 3 + 2) * bs;
+      if (j < 3)
+        for (std::size_t n = 0 ; n < count ; ++n)
+          o[n] = a0[AV ? n : 0] * b0[BV ? n : 0] + a1[AV ? n : 0] * b1[BV ? n : 0] + a2[AV ? n : 0] * b2[BV ? n : 0];
+      else
+      {
+        const double *at = a + (9 + i) * as;
+        for (std::size_t n = 0 ; n < count ; ++n)
+          o[n] = a0[AV ? n : 0] * b0[BV ? n : 0] + a1[AV ? n : 0] * b1[BV ? n : 0] + a2[AV ? n : 0] * b2[BV ? n : 0] + at[AV ? n : 0];
+      }
+    }
+}
+
+}
+
+moveit::core::BatchForwardKinematics::BatchForwardKinematics(const RobotModelConstPtr &robot_model)
+  : robot_model_(robot_model)
+  , group_(NULL)
+  , variable_count_(robot_model->getVariableCount())
+  , state_count_(0)
+  , capacity_(0)
+{
+  initialize(robot_model_->getLinkModels());
+}
+
+moveit::core::BatchForwardKinematics::BatchForwardKinematics(const RobotModelConstPtr &robot_model, const JointModelGroup *group)
+  : robot_model_(robot_model)
+  , group_(group)
+  , variable_count_(group->getVariableCount())
+  , state_count_(0)
+  , capacity_(0)
+{
+  initialize(group->getUpdatedLinkModels());
+}
+
+moveit::core::BatchForwardKinematics::~BatchForwardKinematics()
+{
+}
+
+void moveit::core::BatchForwardKinematics::initialize(const std::vector<const LinkModel*> &links)
+{
+  // parents always come before their children when links are sorted by index
+  links_ = links;
+  std::sort(links_.begin(), links_.end(), linkIndexLess);
+
+  // where to find each robot variable in the blocks of positions passed to compute()
+  std::vector<int> variable_index(robot_model_->getVariableCount(), -1);
+  if (group_)
+  {
+    const std::vector<int> &il = group_->getVariableIndexList();
+    for (std::size_t i = 0 ; i < il.size() ; ++i)
+      variable_index[il[i]] = i;
+  }
+  else
+    for (std::size_t i = 0 ; i < variable_index.size() ; ++i)
+      variable_index[i] = i;
+
+  link_slot_.resize(robot_model_->getLinkModelCount(), -1);
+  entries_.resize(links_.size());
+  for (std::size_t k = 0 ; k < links_.size() ; ++k)
+  {
+    const LinkModel *link = links_[k];
+    LinkEntry &e = entries_[k];
+    link_slot_[link->getLinkIndex()] = k;
+
+    e.link_ = link;
+    e.parent_ = link->getParentLinkModel() ? link_slot_[link->getParentLinkModel()->getLinkIndex()] : -1;
+    e.joint_ = link->getParentJointModel();
+    e.type_ = link->parentJointIsFixed() ? JointModel::FIXED : e.joint_->getType();
+    e.axis_ = Eigen::Vector3d::Zero();
+    if (e.type_ == JointModel::REVOLUTE)
+      e.axis_ = static_cast<const RevoluteJointModel*>(e.joint_)->getAxis();
+    else
+      if (e.type_ == JointModel::PRISMATIC)
+        e.axis_ = static_cast<const PrismaticJointModel*>(e.joint_)->getAxis();
+    storeTransform(link->getJointOriginTransform(), e.origin_, 1, 0);
+
+    if (e.type_ != JointModel::FIXED)
+    {
+      e.variables_.resize(e.joint_->getVariableCount());
+      for (std::size_t v = 0 ; v < e.variables_.size() ; ++v)
+      {
+        VariableSource &src = e.variables_[v];
+        const JointModel *source_joint = e.joint_->getMimic() ? e.joint_->getMimic() : e.joint_;
+        src.robot_index_ = source_joint->getFirstVariableIndex() + v;
+        src.index_ = variable_index[src.robot_index_];
+        src.factor_ = e.joint_->getMimic() ? e.joint_->getMimicFactor() : 1.0;
+        src.offset_ = e.joint_->getMimic() ? e.joint_->getMimicOffset() : 0.0;
+      }
+    }
+  }
+}
+
+void moveit::core::BatchForwardKinematics::compute(const RobotState &reference, const double *positions, std::size_t count)
+{
+  state_count_ = count;
+  if (count > capacity_)
+  {
+    capacity_ = count;
+    transforms_.resize(entries_.size() * 12 * capacity_);
+    local_.resize(12 * capacity_);
+    parent_.resize(12 * capacity_);
+  }
+  if (count == 0)
+    return;
+
+  std::vector<double> joint_values;
+  double constant_parent[12];
+  for (std::size_t k = 0 ; k < entries_.size() ; ++k)
+  {
+    const LinkEntry &e = entries_[k];
+    double *out = elements(k);
+
+    // the parent transform is either computed for every state, or the same for all states
+    const double *parent = e.parent_ >= 0 ? elements(e.parent_) : NULL;
+    if (!parent)
+    {
+      const LinkModel *parent_link = e.link_->getParentLinkModel();
+      storeTransform(parent_link ? reference.getGlobalLinkTransform(parent_link) : Eigen::Affine3d::Identity(), constant_parent, 1, 0);
+    }
+
+    if (e.type_ == JointModel::FIXED)
+    {
+      if (parent)
+        multiplyTransforms<true, false>(parent, e.origin_, out, capacity_, count);
+      else
+        multiplyTransforms<false, false>(constant_parent, e.origin_, out, capacity_, count);
+      continue;
+    }
+
+    // compute the joint transform for every state
+    double *local = &local_[0];
+    if (e.type_ == JointModel::REVOLUTE || e.type_ == JointModel::PRISMATIC)
+    {
+      double *q = local + 9 * capacity_;
+      for (std::size_t n = 0 ; n < count ; ++n)
+        q[n] = value(e.variables_[0], reference, positions, n);
+
+      const double x = e.axis_.x(), y = e.axis_.y(), z = e.axis_.z();
+      if (e.type_ == JointModel::REVOLUTE)
+      {
+        for (std::size_t n = 0 ; n < count ; ++n)
+        {
+          const double c = cos(q[n]);
+          const double s = sin(q[n]);
+          const double t = 1.0 - c;
+          local[n] = t * x * x + c;
+          local[capacity_ + n] = t * x * y + s * z;
+          local[2 * capacity_ + n] = t * x * z - s * y;
+          local[3 * capacity_ + n] = t * x * y - s * z;
+          local[4 * capacity_ + n] = t * y * y + c;
+          local[5 * capacity_ + n] = t * y * z + s * x;
+          local[6 * capacity_ + n] = t * x * z + s * y;
+          local[7 * capacity_ + n] = t * y * z - s * x;
+          local[8 * capacity_ + n] = t * z * z + c;
+        }
+        std::fill(local + 9 * capacity_, local + 9 * capacity_ + count, 0.0);
+        std::fill(local + 10 * capacity_, local + 10 * capacity_ + count, 0.0);
+        std::fill(local + 11 * capacity_, local + 11 * capacity_ + count, 0.0);
+      }
+      else
+      {
+        for (unsigned int i = 0 ; i < 9 ; ++i)
+          std::fill(local + i * capacity_, local + i * capacity_ + count, i % 4 == 0 ? 1.0 : 0.0);
+        for (std::size_t n = 0 ; n < count ; ++n)
+        {
+          // q[] aliases the first translation component, so it is read before being overwritten
+          const double d = q[n];
+          local[9 * capacity_ + n] = x * d;
+          local[10 * capacity_ + n] = y * d;
+          local[11 * capacity_ + n] = z * d;
+        }
+      }
+    }
+    else
+    {
+      // planar and floating joints are evaluated one state at a time
+      joint_values.resize(e.variables_.size());
+      Eigen::Affine3d t;
+      for (std::size_t n = 0 ; n < count ; ++n)
+      {
+        for (std::size_t v = 0 ; v < e.variables_.size() ; ++v)
+          joint_values[v] = value(e.variables_[v], reference, positions, n);
+        e.joint_->computeTransform(&joint_values[0], t);
+        storeTransform(t, local, capacity_, n);
+      }
+    }
+
+    // global = parent * origin * joint
+    if (parent)
+    {
+      multiplyTransforms<true, false>(parent, e.origin_, &parent_[0], capacity_, count);
+      multiplyTransforms<true, true>(&parent_[0], local, out, capacity_, count);
+    }
+    else
+    {
+      double po[12];
+      multiplyTransforms<false, false>(constant_parent, e.origin_, po, 1, 1);
+      multiplyTransforms<false, true>(po, local, out, capacity_, count);
+    }
+  }
+}
+
+Eigen::Affine3d moveit::core::BatchForwardKinematics::getGlobalLinkTransform(const LinkModel *link, std::size_t state) const
+{
+  Eigen::Affine3d result;
+  result.matrix().row(3) = Eigen::Vector4d(0.0, 0.0, 0.0, 1.0);
+  int slot = link_slot_[link->getLinkIndex()];
+  if (slot < 0 || state >= state_count_)
+  {
+    logError("Transform of link '%s' for state %u is not available", link->getName().c_str(), (unsigned int)state);
+    result.setIdentity();
+    return result;
+  }
+  const double *e = elements(slot);
+  for (unsigned int j = 0 ; j < 4 ; ++j)
+    for (unsigned int i = 0 ; i < 3 ; ++i)
+      result.matrix()(i, j) = e[(j * 3 + i) * capacity_ + state];
+  return result;
+}
+
+Eigen::Affine3d moveit::core::BatchForwardKinematics::getCollisionBodyTransform(const LinkModel *link, std::size_t shape_index, std::size_t state) const
+{
+  return getGlobalLinkTransform(link, state) * link->getCollisionOriginTransforms()[shape_index];
+}
+
+const double* moveit::core::BatchForwardKinematics::getTransformElements(const LinkModel *link, unsigned int row, unsigned int col) const
+{
+  int slot = link_slot_[link->getLinkIndex()];
+  if (slot < 0 || row >= 3 || col >= 4)
+    return NULL;
+  return elements(slot) + (col * 3 + row) * capacity_;
+}
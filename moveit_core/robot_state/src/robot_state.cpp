@@ -133,8 +133,7 @@ void moveit::core::RobotState::copyFrom(const RobotState &other)
   // copy attached bodies
   clearAttachedBodies();
   for (std::map<std::string, AttachedBody*>::const_iterator it = other.attached_body_map_.begin() ; it != other.attached_body_map_.end() ; ++it)
-    attachBody(it->second->getName(), it->second->getShapes(), it->second->getFixedTransforms(),
-               it->second->getTouchLinks(), it->second->getAttachedLinkName(), it->second->getDetachPosture());
+    attachBody(new AttachedBody(*it->second));
 }
 
 bool moveit::core::RobotState::checkJointTransforms(const JointModel *joint) const
@@ -407,6 +406,24 @@ void moveit::core::RobotState::setJointGroupPositions(const JointModelGroup *gro
   markDirtyJointTransforms(group);
 }
 
+void moveit::core::RobotState::setJointGroupActivePositions(const JointModelGroup *group, const Eigen::VectorXd& values)
+{
+  const std::vector<const JointModel*> &jm = group->getActiveJointModels();
+  std::size_t k = 0;
+  for (std::size_t i = 0 ; i < jm.size() ; ++i)
+  {
+    const int fvi = jm[i]->getFirstVariableIndex();
+    for (std::size_t v = 0 ; v < jm[i]->getVariableCount() ; ++v)
+      position_[fvi + v] = values(k++);
+    // the joints that mimic this one may be outside the group
+    updateMimicJoint(jm[i]);
+    const std::vector<const JointModel*> &mim = jm[i]->getMimicRequests();
+    for (std::size_t m = 0 ; m < mim.size() ; ++m)
+      markDirtyJointTransforms(mim[m]);
+  }
+  markDirtyJointTransforms(group);
+}
+
 void moveit::core::RobotState::copyJointGroupPositions(const JointModelGroup *group, double *gstate) const
 {
   const std::vector<int> &il = group->getVariableIndexList();
@@ -531,6 +548,79 @@ void moveit::core::RobotState::updateLinkTransformsInternal(const JointModel *st
     it->second->computeTransform(global_link_transforms_[it->second->getAttachedLink()->getLinkIndex()]);
 }
 
+namespace
+{
+// The global transform of link, given the global transform of its parent link (NULL for the root link)
+// and the transform of its parent joint (NULL if the joint is fixed)
+inline void composeLinkTransform(const moveit::core::LinkModel *link, const Eigen::Affine3d *parent,
+                                 const Eigen::Affine3d *joint, Eigen::Affine3d &result)
+{
+  if (!joint)
+  {
+    if (parent)
+      result.matrix().noalias() = parent->matrix() * link->getJointOriginTransform().matrix();
+    else
+      result = link->getJointOriginTransform();
+  }
+  else if (link->jointOriginTransformIsIdentity())
+  {
+    if (parent)
+      result.matrix().noalias() = parent->matrix() * joint->matrix();
+    else
+      result = *joint;
+  }
+  else
+  {
+    if (parent)
+      result.matrix().noalias() = parent->matrix() * link->getJointOriginTransform().matrix() * joint->matrix();
+    else
+      result.matrix().noalias() = link->getJointOriginTransform().matrix() * joint->matrix();
+  }
+}
+}
+
+const Eigen::Affine3d& moveit::core::RobotState::computeGlobalLinkTransform(const LinkModel *link)
+{
+  // dirty_link_transforms_ is left as it is: links outside the chain still need updating
+  const std::vector<const LinkModel*> &chain = robot_model_->getLinkChain(link);
+  for (std::size_t i = getDirtyLinkChainStart(chain) ; i < chain.size() ; ++i)
+    composeLinkTransform(chain[i], i > 0 ? &global_link_transforms_[chain[i - 1]->getLinkIndex()] : NULL,
+                         chain[i]->parentJointIsFixed() ? NULL : &getJointTransform(chain[i]->getParentJointModel()),
+                         global_link_transforms_[chain[i]->getLinkIndex()]);
+  return global_link_transforms_[link->getLinkIndex()];
+}
+
+void moveit::core::RobotState::computeGlobalLinkTransform(const LinkModel *link, Eigen::Affine3d &transform) const
+{
+  const std::vector<const LinkModel*> &chain = robot_model_->getLinkChain(link);
+  std::size_t start = getDirtyLinkChainStart(chain);
+  if (start == chain.size())
+  {
+    transform = global_link_transforms_[link->getLinkIndex()];
+    return;
+  }
+
+  Eigen::Affine3d parent = start > 0 ? global_link_transforms_[chain[start - 1]->getLinkIndex()] : Eigen::Affine3d::Identity();
+  Eigen::Affine3d joint;
+  for (std::size_t i = start ; i < chain.size() ; ++i)
+  {
+    const Eigen::Affine3d *joint_transform = NULL;
+    if (!chain[i]->parentJointIsFixed())
+    {
+      const JointModel *jm = chain[i]->getParentJointModel();
+      if (dirty_joint_transforms_[jm->getJointIndex()])
+      {
+        jm->computeTransform(position_ + jm->getFirstVariableIndex(), joint);
+        joint_transform = &joint;
+      }
+      else
+        joint_transform = &variable_joint_transforms_[jm->getJointIndex()];
+    }
+    composeLinkTransform(chain[i], i > 0 ? &parent : NULL, joint_transform, transform);
+    parent = transform;
+  }
+}
+
 void moveit::core::RobotState::updateStateWithLinkAt(const LinkModel *link, const Eigen::Affine3d& transform, bool backward)
 {
   updateLinkTransforms(); // no link transforms must be dirty, otherwise the transform we set will be overwritten
@@ -1457,6 +1547,10 @@ bool moveit::core::RobotState::setFromIK(const JointModelGroup *jmg, const Eigen
   // Bijection
   const std::vector<unsigned int> &bij = jmg->getKinematicsSolverJointBijection();
 
+  // the random restarts that follow the first attempt do not depend on each other, so solvers that can run
+  // concurrent queries search them in one batch; batches only take a single pose and no consistency limits
+  bool batch_restarts = attempts > 2 && ik_queries.size() == 1 && consistency_limits.empty() && solver->supportsConcurrentQueries();
+
   bool first_seed = true;
   std::vector<double> initial_values;
   for (unsigned int st = 0 ; st < attempts ; ++st)
@@ -1471,25 +1565,12 @@ bool moveit::core::RobotState::setFromIK(const JointModelGroup *jmg, const Eigen
       for (std::size_t i = 0 ; i < bij.size() ; ++i)
         seed[i] = initial_values[bij[i]];
     }
+    else if (batch_restarts)
+      return setFromIKBatch(jmg, ik_queries[0], attempts - st, timeout, ik_callback_fn, options);
     else
     {
       logDebug("moveit.robot_state: Rerunning IK solver with random joint positions");
-
-      // sample a random seed
-      random_numbers::RandomNumberGenerator &rng = getRandomNumberGenerator();
-      std::vector<double> random_values;
-      jmg->getVariableRandomPositions(rng, random_values);
-      for (std::size_t i = 0 ; i < bij.size() ; ++i)
-        seed[i] = random_values[bij[i]];
-
-      if (options.lock_redundant_joints)
-      {
-        std::vector<unsigned int> red_joints;
-        solver->getRedundantJoints(red_joints);
-        copyJointGroupPositions(jmg, initial_values);
-        for(std::size_t i = 0 ; i < red_joints.size(); ++i)
-          seed[red_joints[i]] = initial_values[bij[red_joints[i]]];
-      }
+      getRandomIKSeed(jmg, options, seed);
     }
 
     // compute the IK solution
@@ -1508,6 +1589,59 @@ bool moveit::core::RobotState::setFromIK(const JointModelGroup *jmg, const Eigen
   return false;
 }
 
+void moveit::core::RobotState::getRandomIKSeed(const JointModelGroup *jmg, const kinematics::KinematicsQueryOptions &options,
+                                               std::vector<double> &seed)
+{
+  const std::vector<unsigned int> &bij = jmg->getKinematicsSolverJointBijection();
+  random_numbers::RandomNumberGenerator &rng = getRandomNumberGenerator();
+  std::vector<double> random_values;
+  jmg->getVariableRandomPositions(rng, random_values);
+  seed.resize(bij.size());
+  for (std::size_t i = 0 ; i < bij.size() ; ++i)
+    seed[i] = random_values[bij[i]];
+
+  if (options.lock_redundant_joints)
+  {
+    std::vector<unsigned int> red_joints;
+    jmg->getSolverInstance()->getRedundantJoints(red_joints);
+    std::vector<double> initial_values;
+    copyJointGroupPositions(jmg, initial_values);
+    for(std::size_t i = 0 ; i < red_joints.size(); ++i)
+      seed[red_joints[i]] = initial_values[bij[red_joints[i]]];
+  }
+}
+
+bool moveit::core::RobotState::setFromIKBatch(const JointModelGroup *jmg, const geometry_msgs::Pose &ik_query, unsigned int attempts,
+                                              double timeout, const kinematics::KinematicsBase::IKCallbackFn &ik_callback_fn,
+                                              const kinematics::KinematicsQueryOptions &options)
+{
+  logDebug("moveit.robot_state: Running IK solver from %u random joint positions at once", attempts);
+
+  std::vector<std::vector<double> > seeds(attempts);
+  for (std::size_t k = 0 ; k < seeds.size() ; ++k)
+    getRandomIKSeed(jmg, options, seeds[k]);
+
+  // every query keeps the timeout it would have had on its own; the callback uses this state as scratch space,
+  // which is safe because the batch serializes the calls to it
+  kinematics::KinematicsBatchOptions batch_options;
+  batch_options.query_timeout = timeout;
+  batch_options.max_solutions = 1;
+  batch_options.solution_callback = ik_callback_fn;
+  std::vector<kinematics::KinematicsBatchSolution> ik_solutions;
+  kinematics::KinematicsResult result;
+  if (!jmg->getSolverInstance()->searchPositionIKBatch(std::vector<geometry_msgs::Pose>(1, ik_query), seeds, timeout * attempts,
+                                                       ik_solutions, result, batch_options, options))
+    return false;
+
+  const std::vector<unsigned int> &bij = jmg->getKinematicsSolverJointBijection();
+  const std::vector<double> &ik_sol = ik_solutions.front().solution;
+  std::vector<double> solution(bij.size());
+  for (std::size_t i = 0 ; i < bij.size() ; ++i)
+    solution[bij[i]] = ik_sol[i];
+  setJointGroupPositions(jmg, solution);
+  return true;
+}
+
 bool moveit::core::RobotState::setFromIKSubgroups(const JointModelGroup *jmg, const EigenSTL::vector_Affine3d &poses_in,
                                                   const std::vector<std::string> &tips_in,
                                                   const std::vector<std::vector<double> > &consistency_limits,
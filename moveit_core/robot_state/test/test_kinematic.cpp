@@ -37,6 +37,7 @@
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
 #include <urdf_parser/urdf_parser.h>
+#include <geometric_shapes/shapes.h>
 #include <gtest/gtest.h>
 #include <sstream>
 #include <algorithm>
@@ -506,6 +507,76 @@ TEST(FK, OneRobot)
     state.enforceBounds();
     EXPECT_NEAR(state.getVariablePosition("joint_a"), -3.083185, 1e-3);
     EXPECT_TRUE(state.satisfiesBounds(model->getJointModel("joint_a")));
+
+    // only joint_f is active in the mimic group; mim_f follows it
+    ASSERT_EQ(g_mim->getActiveJointModels().size(), 1);
+    Eigen::VectorXd active(1);
+    active(0) = 0.05;
+    state.setJointGroupActivePositions(g_mim, active);
+    EXPECT_NEAR(0.05, state.getVariablePosition("joint_f"), 1e-9);
+    EXPECT_NEAR(0.175, state.getVariablePosition("mim_f"), 1e-9);
+}
+
+TEST(AttachedBody, CollisionCacheIsShared)
+{
+    static const std::string MODEL1 =
+        "<?xml version=\"1.0\" ?>"
+        "<robot name=\"myrobot\">"
+        "<link name=\"base_link\">"
+        "  <collision name=\"my_collision\">"
+        "    <origin rpy=\"0 0 0\" xyz=\"0 0 0\"/>"
+        "    <geometry>"
+        "      <box size=\"1 2 1\" />"
+        "    </geometry>"
+        "  </collision>"
+        "</link>"
+        "</robot>";
+
+    static const std::string SMODEL1 =
+        "<?xml version=\"1.0\" ?>"
+        "<robot name=\"myrobot\">"
+        "<virtual_joint name=\"base_joint\" child_link=\"base_link\" parent_frame=\"odom_combined\" type=\"planar\"/>"
+        "</robot>";
+
+    urdf::ModelInterfaceSharedPtr urdfModel = urdf::parseURDF(MODEL1);
+    boost::shared_ptr<srdf::Model> srdfModel(new srdf::Model());
+    srdfModel->initString(*urdfModel, SMODEL1);
+    moveit::core::RobotModelPtr model(new moveit::core::RobotModel(urdfModel, srdfModel));
+
+    moveit::core::RobotState state(model);
+    state.setToDefaultValues();
+    std::vector<shapes::ShapeConstPtr> shapes(1, shapes::ShapeConstPtr(new shapes::Box(0.1, 0.1, 0.1)));
+    EigenSTL::vector_Affine3d poses(1, Eigen::Affine3d::Identity());
+    state.attachBody("held", shapes, poses, std::set<std::string>(), "base_link");
+
+    static const moveit::core::AttachedBody::CollisionCacheKey key1("key1");
+    static const moveit::core::AttachedBody::CollisionCacheKey key2("key2");
+    boost::shared_ptr<const void> data(new int(1));
+    state.getAttachedBody("held")->setCollisionCache(key1, data);
+    EXPECT_TRUE(state.getAttachedBody("held")->getCollisionCache(key1) == data);
+    EXPECT_FALSE(state.getAttachedBody("held")->getCollisionCache(key2));
+
+    // copies of the state share the data
+    moveit::core::RobotState copy(state);
+    EXPECT_NE(state.getAttachedBody("held"), copy.getAttachedBody("held"));
+    EXPECT_TRUE(copy.getAttachedBody("held")->getCollisionCache(key1) == data);
+    moveit::core::RobotState assigned(model);
+    assigned = state;
+    EXPECT_TRUE(assigned.getAttachedBody("held")->getCollisionCache(key1) == data);
+
+    // data stored with a different key replaces it, only for that body
+    boost::shared_ptr<const void> other(new int(2));
+    copy.getAttachedBody("held")->setCollisionCache(key2, other);
+    EXPECT_FALSE(copy.getAttachedBody("held")->getCollisionCache(key1));
+    EXPECT_TRUE(copy.getAttachedBody("held")->getCollisionCache(key2) == other);
+    EXPECT_TRUE(state.getAttachedBody("held")->getCollisionCache(key1) == data);
+
+    // changing the shapes discards the data
+    moveit::core::AttachedBody body(*state.getAttachedBody("held"));
+    EXPECT_TRUE(body.getCollisionCache(key1) == data);
+    body.setPadding(0.01);
+    EXPECT_FALSE(body.getCollisionCache(key1));
+    EXPECT_TRUE(state.getAttachedBody("held")->getCollisionCache(key1) == data);
 }
 
 int main(int argc, char **argv)
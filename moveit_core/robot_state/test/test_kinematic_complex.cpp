@@ -37,6 +37,7 @@
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/robot_state/conversions.h>
+#include <moveit/robot_state/batch_forward_kinematics.h>
 #include <urdf_parser/urdf_parser.h>
 #include <fstream>
 #include <gtest/gtest.h>
@@ -278,6 +279,101 @@ TEST_F(LoadPlanningModelsPr2, FullTest)
   ASSERT_EQ(attached_bodies_2.size(), 0);
 }
 
+TEST_F(LoadPlanningModelsPr2, BatchForwardKinematics)
+{
+  const std::size_t count = 20;
+  moveit::core::RobotState reference(robot_model);
+  reference.setToRandomPositions();
+  reference.update();
+
+  // the whole robot
+  moveit::core::BatchForwardKinematics batch(robot_model);
+  std::vector<moveit::core::RobotState> states(count, reference);
+  std::vector<double> positions(count * batch.getVariableCount());
+  for (std::size_t n = 0 ; n < count ; ++n)
+  {
+    states[n].setToRandomPositions();
+    states[n].update();
+    std::copy(states[n].getVariablePositions(), states[n].getVariablePositions() + batch.getVariableCount(), positions.begin() + n * batch.getVariableCount());
+  }
+  batch.compute(reference, &positions[0], count);
+  ASSERT_EQ(count, batch.getStateCount());
+
+  const std::vector<const moveit::core::LinkModel*> &links = robot_model->getLinkModels();
+  for (std::size_t n = 0 ; n < count ; ++n)
+    for (std::size_t l = 0 ; l < links.size() ; ++l)
+    {
+      EXPECT_TRUE(batch.hasLinkModel(links[l]));
+      EXPECT_TRUE(batch.getGlobalLinkTransform(links[l], n).isApprox(states[n].getGlobalLinkTransform(links[l]), 1e-9)) << links[l]->getName();
+      for (std::size_t i = 0 ; i < links[l]->getShapes().size() ; ++i)
+        EXPECT_TRUE(batch.getCollisionBodyTransform(links[l], i, n).isApprox(states[n].getCollisionBodyTransform(links[l], i), 1e-9));
+    }
+
+  // a group; the other links keep the transforms of the reference state
+  const moveit::core::JointModelGroup *jmg = robot_model->getJointModelGroup("right_arm");
+  moveit::core::BatchForwardKinematics group_batch(robot_model, jmg);
+  positions.resize(count * group_batch.getVariableCount());
+  for (std::size_t n = 0 ; n < count ; ++n)
+  {
+    states[n] = reference;
+    states[n].setToRandomPositions(jmg);
+    states[n].update();
+    states[n].copyJointGroupPositions(jmg, &positions[n * group_batch.getVariableCount()]);
+  }
+  group_batch.compute(reference, &positions[0], count);
+
+  const std::vector<const moveit::core::LinkModel*> &updated = jmg->getUpdatedLinkModels();
+  EXPECT_EQ(updated.size(), group_batch.getLinkModels().size());
+  for (std::size_t n = 0 ; n < count ; ++n)
+    for (std::size_t l = 0 ; l < updated.size() ; ++l)
+      EXPECT_TRUE(group_batch.getGlobalLinkTransform(updated[l], n).isApprox(states[n].getGlobalLinkTransform(updated[l]), 1e-9)) << updated[l]->getName();
+  EXPECT_FALSE(group_batch.hasLinkModel(robot_model->getLinkModel("base_link")));
+}
+
+TEST_F(LoadPlanningModelsPr2, PartialForwardKinematics)
+{
+  const moveit::core::JointModelGroup *jmg = robot_model->getJointModelGroup("right_arm");
+  const moveit::core::LinkModel *link = robot_model->getLinkModel("r_wrist_roll_link");
+  const moveit::core::LinkModel *other = robot_model->getLinkModel("l_wrist_roll_link");
+
+  const std::vector<const moveit::core::LinkModel*> &chain = robot_model->getLinkChain(link);
+  ASSERT_FALSE(chain.empty());
+  EXPECT_EQ(robot_model->getRootLink(), chain.front());
+  EXPECT_EQ(link, chain.back());
+  for (std::size_t i = 1 ; i < chain.size() ; ++i)
+    EXPECT_EQ(chain[i - 1], chain[i]->getParentLinkModel());
+
+  moveit::core::RobotState state(robot_model);
+  state.setToRandomPositions();
+  moveit::core::RobotState reference(state);
+  reference.update();
+
+  // nothing is up to date in state yet
+  Eigen::Affine3d transform;
+  static_cast<const moveit::core::RobotState&>(state).computeGlobalLinkTransform(other, transform);
+  EXPECT_TRUE(transform.isApprox(reference.getGlobalLinkTransform(other), 1e-9));
+  EXPECT_TRUE(state.computeGlobalLinkTransform(link).isApprox(reference.getGlobalLinkTransform(link), 1e-9));
+
+  for (std::size_t n = 0 ; n < 100 ; ++n)
+  {
+    state.setToRandomPositions(jmg);
+    reference = state;
+    reference.update();
+
+    static_cast<const moveit::core::RobotState&>(state).computeGlobalLinkTransform(link, transform);
+    EXPECT_TRUE(transform.isApprox(reference.getGlobalLinkTransform(link), 1e-9));
+    EXPECT_TRUE(state.computeGlobalLinkTransform(link).isApprox(reference.getGlobalLinkTransform(link), 1e-9));
+    static_cast<const moveit::core::RobotState&>(state).computeGlobalLinkTransform(other, transform);
+    EXPECT_TRUE(transform.isApprox(reference.getGlobalLinkTransform(other), 1e-9));
+  }
+
+  // a full update after partial ones still brings every link up to date
+  state.update();
+  const std::vector<const moveit::core::LinkModel*> &links = robot_model->getLinkModels();
+  for (std::size_t l = 0 ; l < links.size() ; ++l)
+    EXPECT_TRUE(state.getGlobalLinkTransform(links[l]).isApprox(reference.getGlobalLinkTransform(links[l]), 1e-9)) << links[l]->getName();
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,278 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_ROBOT_TRAJECTORY_COMPACT_ROBOT_TRAJECTORY_
+#define MOVEIT_ROBOT_TRAJECTORY_COMPACT_ROBOT_TRAJECTORY_
+
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <Eigen/Core>
+#include <vector>
+
+namespace robot_trajectory
+{
+
+MOVEIT_CLASS_FORWARD(CompactRobotTrajectory);
+
+/** \brief Maintain a sequence of waypoints for the variables of a joint model group, and the time durations
+    between these waypoints.
+
+    Unlike RobotTrajectory, no RobotState is kept per waypoint. The positions (and, when available, velocities and
+    accelerations) of the group variables are stored contiguously, one column per waypoint, in the order
+    reported by JointModelGroup::getVariableNames(). Values for variables outside the group are taken from a single
+    reference state. Full RobotState instances are only constructed when explicitly requested. */
+class CompactRobotTrajectory
+{
+public:
+
+  typedef Eigen::Map<Eigen::MatrixXd> MatrixMap;
+  typedef Eigen::Map<const Eigen::MatrixXd> ConstMatrixMap;
+
+  /** \brief Construct an empty trajectory for \e group. Variables not in the group are set from \e reference_state
+      whenever a RobotState is materialized. */
+  CompactRobotTrajectory(const robot_model::RobotModelConstPtr &robot_model, const robot_model::JointModelGroup* group,
+                         const robot_state::RobotState &reference_state);
+
+  /** \brief Construct a compact copy of \e trajectory. The trajectory must have a group set. The first waypoint
+      (or the default state, for an empty trajectory) becomes the reference state. */
+  explicit CompactRobotTrajectory(const RobotTrajectory &trajectory);
+
+  const robot_model::RobotModelConstPtr& getRobotModel() const
+  {
+    return robot_model_;
+  }
+
+  const robot_model::JointModelGroup* getGroup() const
+  {
+    return group_;
+  }
+
+  const std::string& getGroupName() const
+  {
+    return group_->getName();
+  }
+
+  /** \brief The state that supplies values for variables outside the group */
+  const robot_state::RobotState& getReferenceState() const
+  {
+    return *reference_state_;
+  }
+
+  void setReferenceState(const robot_state::RobotState &state);
+
+  /** \brief The number of group variables stored for each waypoint */
+  std::size_t getVariableCount() const
+  {
+    return variable_count_;
+  }
+
+  std::size_t getWayPointCount() const
+  {
+    return duration_from_previous_.size();
+  }
+
+  bool empty() const
+  {
+    return duration_from_previous_.empty();
+  }
+
+  /** \brief Reserve memory for \e count waypoints */
+  void reserve(std::size_t count);
+
+  void clear();
+
+  bool hasVelocities() const
+  {
+    return !velocities_.empty();
+  }
+
+  bool hasAccelerations() const
+  {
+    return !accelerations_.empty();
+  }
+
+  /** \brief Get the positions of the group variables at waypoint \e index */
+  const double* getWayPointPositions(std::size_t index) const
+  {
+    return &positions_[index * variable_count_];
+  }
+
+  double* getWayPointPositions(std::size_t index)
+  {
+    return &positions_[index * variable_count_];
+  }
+
+  /** \brief Get the velocities of the group variables at waypoint \e index. Returns NULL if no velocities are stored. */
+  const double* getWayPointVelocities(std::size_t index) const
+  {
+    return velocities_.empty() ? NULL : &velocities_[index * variable_count_];
+  }
+
+  /** \brief Get the velocities of the group variables at waypoint \e index. If no velocities are stored yet,
+      storage initialized to zero is allocated for all waypoints. */
+  double* getWayPointVelocities(std::size_t index)
+  {
+    markVelocity();
+    return &velocities_[index * variable_count_];
+  }
+
+  /** \brief Get the accelerations of the group variables at waypoint \e index. Returns NULL if no accelerations are stored. */
+  const double* getWayPointAccelerations(std::size_t index) const
+  {
+    return accelerations_.empty() ? NULL : &accelerations_[index * variable_count_];
+  }
+
+  /** \brief Get the accelerations of the group variables at waypoint \e index. If no accelerations are stored yet,
+      storage initialized to zero is allocated for all waypoints. */
+  double* getWayPointAccelerations(std::size_t index)
+  {
+    markAcceleration();
+    return &accelerations_[index * variable_count_];
+  }
+
+  /** \brief Get the positions of all waypoints as a (variable count) x (waypoint count) matrix */
+  MatrixMap getPositions()
+  {
+    return MatrixMap(positions_.empty() ? NULL : &positions_[0], variable_count_, getWayPointCount());
+  }
+
+  ConstMatrixMap getPositions() const
+  {
+    return ConstMatrixMap(positions_.empty() ? NULL : &positions_[0], variable_count_, getWayPointCount());
+  }
+
+  /** \brief Get the velocities of all waypoints as a (variable count) x (waypoint count) matrix. Storage is allocated if needed. */
+  MatrixMap getVelocities()
+  {
+    markVelocity();
+    return MatrixMap(velocities_.empty() ? NULL : &velocities_[0], variable_count_, getWayPointCount());
+  }
+
+  /** \brief Get the accelerations of all waypoints as a (variable count) x (waypoint count) matrix. Storage is allocated if needed. */
+  MatrixMap getAccelerations()
+  {
+    markAcceleration();
+    return MatrixMap(accelerations_.empty() ? NULL : &accelerations_[0], variable_count_, getWayPointCount());
+  }
+
+  const std::vector<double>& getWayPointDurations() const
+  {
+    return duration_from_previous_;
+  }
+
+  double getWayPointDurationFromPrevious(std::size_t index) const
+  {
+    if (duration_from_previous_.size() > index)
+      return duration_from_previous_[index];
+    else
+      return 0.0;
+  }
+
+  void setWayPointDurationFromPrevious(std::size_t index, double value)
+  {
+    duration_from_previous_[index] = value;
+  }
+
+  /** @brief  Returns the duration after start that a waypoint will be reached.
+   *  @param  The waypoint index.
+   *  @return The duration from start */
+  double getWaypointDurationFromStart(std::size_t index) const;
+
+  /** \brief Add a point to the trajectory, given the positions of the group variables */
+  void addSuffixWayPoint(const double *positions, double dt);
+
+  /** \brief Add a point to the trajectory, copying the values of the group variables from \e state.
+      Velocities and accelerations are copied as well, if the state has them. */
+  void addSuffixWayPoint(const robot_state::RobotState &state, double dt);
+
+  /** \brief Copy the values of the group variables at waypoint \e index into \e state. Other variables are left
+      unchanged; the transforms of \e state are not updated. Reusing one state for several waypoints
+      avoids allocating memory for each of them. */
+  void getWayPoint(std::size_t index, robot_state::RobotState &state) const;
+
+  /** \brief Construct a full RobotState for waypoint \e index: the reference state with the
+      values of the group variables overwritten. The transforms of the returned state are up to date. */
+  robot_state::RobotStatePtr materializeWayPoint(std::size_t index) const;
+
+  /** \brief Replace the content of this trajectory with the group variables of \e trajectory */
+  void setRobotTrajectory(const RobotTrajectory &trajectory);
+
+  /** \brief Fill \e trajectory with one materialized RobotState per waypoint */
+  void getRobotTrajectory(RobotTrajectory &trajectory) const;
+
+  void getRobotTrajectoryMsg(moveit_msgs::RobotTrajectory &trajectory) const;
+
+  /** \brief Copy the content of the trajectory message into this class. Only the variables of the group are retained;
+      group variables missing from the message take their value from the reference state. */
+  void setRobotTrajectoryMsg(const trajectory_msgs::JointTrajectory &trajectory);
+
+  /** \brief Copy the content of the trajectory message into this class. Only the variables of the group are retained;
+      group variables missing from the message take their value from the reference state. */
+  void setRobotTrajectoryMsg(const moveit_msgs::RobotTrajectory &trajectory);
+
+  void unwind();
+
+private:
+
+  void markVelocity()
+  {
+    if (velocities_.empty())
+      velocities_.resize(positions_.size(), 0.0);
+  }
+
+  void markAcceleration()
+  {
+    if (accelerations_.empty())
+      accelerations_.resize(positions_.size(), 0.0);
+  }
+
+  /** \brief Append a waypoint whose group variables have the values found in the reference state */
+  double* addReferenceWayPoint(double dt);
+
+  robot_model::RobotModelConstPtr robot_model_;
+  const robot_model::JointModelGroup *group_;
+  robot_state::RobotStatePtr reference_state_;
+  std::size_t variable_count_;
+
+  /** \brief The values of the group variables at the reference state */
+  std::vector<double> reference_positions_;
+
+  std::vector<double> positions_;
+  std::vector<double> velocities_;
+  std::vector<double> accelerations_;
+  std::vector<double> duration_from_previous_;
+};
+
+}
+
+#endif
@@ -0,0 +1,431 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_trajectory/compact_robot_trajectory.h>
+#include <eigen_conversions/eigen_msg.h>
+#include <boost/math/constants/constants.hpp>
+#include <algorithm>
+#include <map>
+
+namespace
+{
+
+// Find the position of the first variable of each joint in the group variable ordering
+void getJointOffsets(const robot_model::JointModelGroup *group, const std::vector<const robot_model::JointModel*> &joints,
+                     std::vector<int> &offsets)
+{
+  const std::vector<std::string> &vars = group->getVariableNames();
+  std::map<std::string, int> index;
+  for (std::size_t i = 0 ; i < vars.size() ; ++i)
+    index[vars[i]] = i;
+  offsets.resize(joints.size(), -1);
+  for (std::size_t i = 0 ; i < joints.size() ; ++i)
+  {
+    std::map<std::string, int>::const_iterator it = index.find(joints[i]->getVariableNames()[0]);
+    if (it != index.end())
+      offsets[i] = it->second;
+  }
+}
+
+// Map the names of the variables in a trajectory message to their position in the group variable ordering (-1 if not in the group)
+void getVariableOffsets(const robot_model::JointModelGroup *group, const std::vector<std::string> &names,
+                        std::vector<int> &offsets)
+{
+  const std::vector<std::string> &vars = group->getVariableNames();
+  std::map<std::string, int> index;
+  for (std::size_t i = 0 ; i < vars.size() ; ++i)
+    index[vars[i]] = i;
+  offsets.resize(names.size(), -1);
+  for (std::size_t i = 0 ; i < names.size() ; ++i)
+  {
+    std::map<std::string, int>::const_iterator it = index.find(names[i]);
+    if (it != index.end())
+      offsets[i] = it->second;
+  }
+}
+
+}
+
+robot_trajectory::CompactRobotTrajectory::CompactRobotTrajectory(const robot_model::RobotModelConstPtr &robot_model,
+                                                                 const robot_model::JointModelGroup* group,
+                                                                 const robot_state::RobotState &reference_state) :
+  robot_model_(robot_model),
+  group_(group),
+  variable_count_(group->getVariableCount())
+{
+  setReferenceState(reference_state);
+}
+
+robot_trajectory::CompactRobotTrajectory::CompactRobotTrajectory(const RobotTrajectory &trajectory) :
+  robot_model_(trajectory.getRobotModel()),
+  group_(trajectory.getGroup()),
+  variable_count_(trajectory.getGroup()->getVariableCount())
+{
+  if (trajectory.empty())
+  {
+    robot_state::RobotState st(robot_model_);
+    st.setToDefaultValues();
+    setReferenceState(st);
+  }
+  else
+    setReferenceState(trajectory.getFirstWayPoint());
+  setRobotTrajectory(trajectory);
+}
+
+void robot_trajectory::CompactRobotTrajectory::setReferenceState(const robot_state::RobotState &state)
+{
+  reference_state_.reset(new robot_state::RobotState(state));
+  reference_positions_.resize(variable_count_);
+  if (variable_count_ > 0)
+    reference_state_->copyJointGroupPositions(group_, &reference_positions_[0]);
+}
+
+void robot_trajectory::CompactRobotTrajectory::reserve(std::size_t count)
+{
+  positions_.reserve(count * variable_count_);
+  if (!velocities_.empty())
+    velocities_.reserve(count * variable_count_);
+  if (!accelerations_.empty())
+    accelerations_.reserve(count * variable_count_);
+  duration_from_previous_.reserve(count);
+}
+
+void robot_trajectory::CompactRobotTrajectory::clear()
+{
+  positions_.clear();
+  velocities_.clear();
+  accelerations_.clear();
+  duration_from_previous_.clear();
+}
+
+double robot_trajectory::CompactRobotTrajectory::getWaypointDurationFromStart(std::size_t index) const
+{
+  if (duration_from_previous_.empty())
+    return 0.0;
+  if (index >= duration_from_previous_.size())
+    index = duration_from_previous_.size() - 1;
+
+  double time = 0.0;
+  for (std::size_t i = 0; i <= index; ++i)
+    time += duration_from_previous_[i];
+  return time;
+}
+
+double* robot_trajectory::CompactRobotTrajectory::addReferenceWayPoint(double dt)
+{
+  positions_.insert(positions_.end(), reference_positions_.begin(), reference_positions_.end());
+  if (!velocities_.empty())
+    velocities_.resize(positions_.size(), 0.0);
+  if (!accelerations_.empty())
+    accelerations_.resize(positions_.size(), 0.0);
+  duration_from_previous_.push_back(dt);
+  return getWayPointPositions(duration_from_previous_.size() - 1);
+}
+
+void robot_trajectory::CompactRobotTrajectory::addSuffixWayPoint(const double *positions, double dt)
+{
+  positions_.insert(positions_.end(), positions, positions + variable_count_);
+  if (!velocities_.empty())
+    velocities_.resize(positions_.size(), 0.0);
+  if (!accelerations_.empty())
+    accelerations_.resize(positions_.size(), 0.0);
+  duration_from_previous_.push_back(dt);
+}
+
+void robot_trajectory::CompactRobotTrajectory::addSuffixWayPoint(const robot_state::RobotState &state, double dt)
+{
+  double *pos = addReferenceWayPoint(dt);
+  state.copyJointGroupPositions(group_, pos);
+
+  const std::vector<int> &idx = group_->getVariableIndexList();
+  const std::size_t index = duration_from_previous_.size() - 1;
+  if (state.hasVelocities())
+  {
+    double *vel = getWayPointVelocities(index);
+    for (std::size_t j = 0 ; j < variable_count_ ; ++j)
+      vel[j] = state.getVariableVelocity(idx[j]);
+  }
+  if (state.hasAccelerations())
+  {
+    double *acc = getWayPointAccelerations(index);
+    for (std::size_t j = 0 ; j < variable_count_ ; ++j)
+      acc[j] = state.getVariableAcceleration(idx[j]);
+  }
+}
+
+void robot_trajectory::CompactRobotTrajectory::getWayPoint(std::size_t index, robot_state::RobotState &state) const
+{
+  state.setJointGroupPositions(group_, getWayPointPositions(index));
+
+  const std::vector<int> &idx = group_->getVariableIndexList();
+  if (hasVelocities())
+  {
+    const double *vel = getWayPointVelocities(index);
+    for (std::size_t j = 0 ; j < variable_count_ ; ++j)
+      state.setVariableVelocity(idx[j], vel[j]);
+  }
+  if (hasAccelerations())
+  {
+    const double *acc = getWayPointAccelerations(index);
+    for (std::size_t j = 0 ; j < variable_count_ ; ++j)
+      state.setVariableAcceleration(idx[j], acc[j]);
+  }
+}
+
+robot_state::RobotStatePtr robot_trajectory::CompactRobotTrajectory::materializeWayPoint(std::size_t index) const
+{
+  robot_state::RobotStatePtr state(new robot_state::RobotState(*reference_state_));
+  getWayPoint(index, *state);
+  state->update();
+  return state;
+}
+
+void robot_trajectory::CompactRobotTrajectory::setRobotTrajectory(const RobotTrajectory &trajectory)
+{
+  clear();
+  reserve(trajectory.getWayPointCount());
+  for (std::size_t i = 0 ; i < trajectory.getWayPointCount() ; ++i)
+    addSuffixWayPoint(trajectory.getWayPoint(i), trajectory.getWayPointDurationFromPrevious(i));
+}
+
+void robot_trajectory::CompactRobotTrajectory::getRobotTrajectory(RobotTrajectory &trajectory) const
+{
+  trajectory.clear();
+  trajectory.setGroupName(group_->getName());
+  for (std::size_t i = 0 ; i < getWayPointCount() ; ++i)
+    trajectory.addSuffixWayPoint(materializeWayPoint(i), duration_from_previous_[i]);
+}
+
+void robot_trajectory::CompactRobotTrajectory::unwind()
+{
+  if (empty())
+    return;
+
+  const std::vector<const robot_model::JointModel*> &cont_joints = group_->getContinuousJointModels();
+  std::vector<int> offsets;
+  getJointOffsets(group_, cont_joints, offsets);
+  const std::size_t num_points = getWayPointCount();
+
+  for (std::size_t i = 0 ; i < cont_joints.size() ; ++i)
+  {
+    if (offsets[i] < 0)
+      continue;
+
+    // unwrap continuous joints
+    double running_offset = 0.0;
+    double last_value = positions_[offsets[i]];
+
+    for (std::size_t j = 1 ; j < num_points ; ++j)
+    {
+      double &current_value = positions_[j * variable_count_ + offsets[i]];
+      if (last_value > current_value + boost::math::constants::pi<double>())
+        running_offset += 2.0 * boost::math::constants::pi<double>();
+      else
+        if (current_value > last_value + boost::math::constants::pi<double>())
+          running_offset -= 2.0 * boost::math::constants::pi<double>();
+
+      last_value = current_value;
+      current_value += running_offset;
+    }
+  }
+}
+
+void robot_trajectory::CompactRobotTrajectory::getRobotTrajectoryMsg(moveit_msgs::RobotTrajectory &trajectory) const
+{
+  trajectory = moveit_msgs::RobotTrajectory();
+  if (empty())
+    return;
+  const std::vector<const robot_model::JointModel*> &jnt = group_->getActiveJointModels();
+  std::vector<int> jnt_offsets;
+  getJointOffsets(group_, jnt, jnt_offsets);
+
+  std::vector<const robot_model::JointModel*> mdof;
+  std::vector<int> onedof_offsets;
+  std::vector<int> mdof_offsets;
+
+  for (std::size_t i = 0 ; i < jnt.size() ; ++i)
+    if (jnt[i]->getVariableCount() == 1)
+    {
+      trajectory.joint_trajectory.joint_names.push_back(jnt[i]->getName());
+      onedof_offsets.push_back(jnt_offsets[i]);
+    }
+    else
+    {
+      trajectory.multi_dof_joint_trajectory.joint_names.push_back(jnt[i]->getName());
+      mdof.push_back(jnt[i]);
+      mdof_offsets.push_back(jnt_offsets[i]);
+    }
+
+  const std::size_t num_points = getWayPointCount();
+  if (!onedof_offsets.empty())
+  {
+    trajectory.joint_trajectory.header.frame_id = robot_model_->getModelFrame();
+    trajectory.joint_trajectory.header.stamp = ros::Time(0);
+    trajectory.joint_trajectory.points.resize(num_points);
+  }
+
+  if (!mdof.empty())
+  {
+    trajectory.multi_dof_joint_trajectory.header.frame_id = robot_model_->getModelFrame();
+    trajectory.multi_dof_joint_trajectory.header.stamp = ros::Time(0);
+    trajectory.multi_dof_joint_trajectory.points.resize(num_points);
+  }
+
+  double total_time = 0.0;
+  for (std::size_t i = 0 ; i < num_points ; ++i)
+  {
+    total_time += duration_from_previous_[i];
+    const double *pos = getWayPointPositions(i);
+
+    if (!onedof_offsets.empty())
+    {
+      trajectory_msgs::JointTrajectoryPoint &point = trajectory.joint_trajectory.points[i];
+      point.positions.resize(onedof_offsets.size());
+      for (std::size_t j = 0 ; j < onedof_offsets.size() ; ++j)
+        point.positions[j] = pos[onedof_offsets[j]];
+      if (hasVelocities())
+      {
+        const double *vel = getWayPointVelocities(i);
+        point.velocities.resize(onedof_offsets.size());
+        for (std::size_t j = 0 ; j < onedof_offsets.size() ; ++j)
+          point.velocities[j] = vel[onedof_offsets[j]];
+      }
+      if (hasAccelerations())
+      {
+        const double *acc = getWayPointAccelerations(i);
+        point.accelerations.resize(onedof_offsets.size());
+        for (std::size_t j = 0 ; j < onedof_offsets.size() ; ++j)
+          point.accelerations[j] = acc[onedof_offsets[j]];
+      }
+      point.time_from_start = ros::Duration(total_time);
+    }
+    if (!mdof.empty())
+    {
+      trajectory_msgs::MultiDOFJointTrajectoryPoint &point = trajectory.multi_dof_joint_trajectory.points[i];
+      point.transforms.resize(mdof.size());
+      for (std::size_t j = 0 ; j < mdof.size() ; ++j)
+      {
+        Eigen::Affine3d t;
+        mdof[j]->computeTransform(pos + mdof_offsets[j], t);
+        tf::transformEigenToMsg(t, point.transforms[j]);
+      }
+      point.time_from_start = ros::Duration(total_time);
+    }
+  }
+}
+
+void robot_trajectory::CompactRobotTrajectory::setRobotTrajectoryMsg(const trajectory_msgs::JointTrajectory &trajectory)
+{
+  clear();
+  std::vector<int> offsets;
+  getVariableOffsets(group_, trajectory.joint_names, offsets);
+
+  const std::size_t state_count = trajectory.points.size();
+  reserve(state_count);
+  ros::Time last_time_stamp = trajectory.header.stamp;
+
+  for (std::size_t i = 0 ; i < state_count ; ++i)
+  {
+    const trajectory_msgs::JointTrajectoryPoint &point = trajectory.points[i];
+    ros::Time this_time_stamp = trajectory.header.stamp + point.time_from_start;
+    double *pos = addReferenceWayPoint((this_time_stamp - last_time_stamp).toSec());
+    last_time_stamp = this_time_stamp;
+
+    for (std::size_t j = 0 ; j < offsets.size() && j < point.positions.size() ; ++j)
+      if (offsets[j] >= 0)
+        pos[offsets[j]] = point.positions[j];
+    if (!point.velocities.empty())
+    {
+      double *vel = getWayPointVelocities(i);
+      for (std::size_t j = 0 ; j < offsets.size() && j < point.velocities.size() ; ++j)
+        if (offsets[j] >= 0)
+          vel[offsets[j]] = point.velocities[j];
+    }
+    if (!point.accelerations.empty())
+    {
+      double *acc = getWayPointAccelerations(i);
+      for (std::size_t j = 0 ; j < offsets.size() && j < point.accelerations.size() ; ++j)
+        if (offsets[j] >= 0)
+          acc[offsets[j]] = point.accelerations[j];
+    }
+  }
+}
+
+void robot_trajectory::CompactRobotTrajectory::setRobotTrajectoryMsg(const moveit_msgs::RobotTrajectory &trajectory)
+{
+  setRobotTrajectoryMsg(trajectory.joint_trajectory);
+
+  const trajectory_msgs::MultiDOFJointTrajectory &mdof_trajectory = trajectory.multi_dof_joint_trajectory;
+  if (mdof_trajectory.points.empty())
+    return;
+
+  // joints outside the group are ignored
+  std::vector<const robot_model::JointModel*> mdof;
+  std::vector<std::size_t> mdof_index;
+  for (std::size_t j = 0 ; j < mdof_trajectory.joint_names.size() ; ++j)
+    if (group_->hasJointModel(mdof_trajectory.joint_names[j]))
+    {
+      mdof.push_back(group_->getJointModel(mdof_trajectory.joint_names[j]));
+      mdof_index.push_back(j);
+    }
+  std::vector<int> offsets;
+  getJointOffsets(group_, mdof, offsets);
+
+  // as in RobotTrajectory, the time stamps of the multi-dof trajectory take precedence
+  ros::Time last_time_stamp = mdof_trajectory.header.stamp;
+  for (std::size_t i = 0 ; i < mdof_trajectory.points.size() ; ++i)
+  {
+    const trajectory_msgs::MultiDOFJointTrajectoryPoint &point = mdof_trajectory.points[i];
+    ros::Time this_time_stamp = mdof_trajectory.header.stamp + point.time_from_start;
+    double dt = (this_time_stamp - last_time_stamp).toSec();
+    last_time_stamp = this_time_stamp;
+
+    double *pos;
+    if (i < getWayPointCount())
+    {
+      pos = getWayPointPositions(i);
+      duration_from_previous_[i] = dt;
+    }
+    else
+      pos = addReferenceWayPoint(dt);
+
+    for (std::size_t j = 0 ; j < mdof.size() ; ++j)
+      if (offsets[j] >= 0 && mdof_index[j] < point.transforms.size())
+      {
+        Eigen::Affine3d t;
+        tf::transformMsgToEigen(point.transforms[mdof_index[j]], t);
+        mdof[j]->computeVariablePositions(t, pos + offsets[j]);
+      }
+  }
+}
@@ -41,6 +41,7 @@
 #include <moveit_msgs/JointLimits.h>
 #include <moveit_msgs/RobotState.h>
 #include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/robot_trajectory/compact_robot_trajectory.h>
 
 namespace trajectory_processing
 {
@@ -58,16 +59,38 @@ public:
                          const double max_velocity_scaling_factor = 1.0,
                          const double max_acceleration_scaling_factor = 1.0) const;
 
+  /// \brief Same as above, but operates directly on the contiguous storage of a compact trajectory
+  bool computeTimeStamps(robot_trajectory::CompactRobotTrajectory& trajectory,
+                         const double max_velocity_scaling_factor = 1.0,
+                         const double max_acceleration_scaling_factor = 1.0) const;
+
 private:
 
   unsigned int max_iterations_;         /// @brief maximum number of iterations to find solution
   double max_time_change_per_it_;       /// @brief maximum allowed time change per iteration in seconds
 
-  void applyVelocityConstraints(robot_trajectory::RobotTrajectory& rob_trajectory,
+  /// @brief positions holds the group variables of num_points waypoints, one waypoint after the other.
+  /// time_diff, velocities and accelerations (same layout as positions) are filled in; start_velocities may be NULL
+  void computeTimeStamps(const robot_model::JointModelGroup *group,
+                         const double *positions,
+                         std::size_t num_points,
+                         const double *start_velocities,
+                         std::vector<double> &time_diff,
+                         double *velocities,
+                         double *accelerations,
+                         const double max_velocity_scaling_factor,
+                         const double max_acceleration_scaling_factor) const;
+
+  void applyVelocityConstraints(const robot_model::JointModelGroup *group,
+                                const double *positions,
+                                std::size_t num_points,
                                 std::vector<double> &time_diff,
                                 const double max_velocity_scaling_factor) const;
 
-  void applyAccelerationConstraints(robot_trajectory::RobotTrajectory& rob_trajectory,
+  void applyAccelerationConstraints(const robot_model::JointModelGroup *group,
+                                    const double *positions,
+                                    std::size_t num_points,
+                                    const double *start_velocities,
                                     std::vector<double> & time_diff,
                                     const double max_acceleration_scaling_factor) const;
 
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2011-2012, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Tobias Kunz <tobias@gatech.edu>
+ * Date: 05/2012
+ *
+ * Humanoid Robotics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ * Algorithm details and publications:
+ * http://www.golems.org/node/1570
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials
+ *     provided with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Adapted for MoveIt! from the time-optimal trajectory generation of Tobias Kunz and Mike Stilman */
+
+#ifndef MOVEIT_TRAJECTORY_PROCESSING_TIME_OPTIMAL_TRAJECTORY_GENERATION_
+#define MOVEIT_TRAJECTORY_PROCESSING_TIME_OPTIMAL_TRAJECTORY_GENERATION_
+
+#include <moveit/robot_trajectory/robot_trajectory.h>
+
+namespace trajectory_processing
+{
+
+/// \brief This class computes a time-optimal parameterization of a trajectory that respects
+/// the velocity and acceleration limits of the joints, following
+/// T. Kunz and M. Stilman, "Time-Optimal Trajectory Generation for Path Following with Bounded
+/// Acceleration and Velocity", Robotics: Science and Systems, 2012.
+///
+/// The waypoints are connected by straight lines, with circular blends around the interior waypoints
+/// so the path is differentiable. The fastest velocity profile along that path is found by integrating
+/// in the phase plane (path position, path velocity) between switching points. Since the timing of the
+/// result does not line up with the input waypoints, the trajectory is resampled at a fixed time step.
+class TimeOptimalTrajectoryGeneration
+{
+public:
+  /// @param path_tolerance maximum distance (in joint space) the blended path may deviate from the interior waypoints
+  /// @param resample_dt time step at which the parameterized trajectory is sampled
+  TimeOptimalTrajectoryGeneration(double path_tolerance = 0.1, double resample_dt = 0.1);
+  ~TimeOptimalTrajectoryGeneration();
+
+  /// \brief Replace the waypoints of \e trajectory by samples of the time-optimal trajectory along its path.
+  /// Only groups made of single-variable joints are supported.
+  bool computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory,
+                         const double max_velocity_scaling_factor = 1.0,
+                         const double max_acceleration_scaling_factor = 1.0) const;
+
+private:
+
+  double path_tolerance_;               /// @brief maximum deviation of the blended path from the waypoints
+  double resample_dt_;                  /// @brief time step between the samples of the result
+};
+
+}
+
+#endif
@@ -98,15 +98,15 @@ void printStats(const trajectory_msgs::JointTrajectory& trajectory, const std::v
 }
 
 // Applies velocity
-void IterativeParabolicTimeParameterization::applyVelocityConstraints(robot_trajectory::RobotTrajectory& rob_trajectory,
+void IterativeParabolicTimeParameterization::applyVelocityConstraints(const robot_model::JointModelGroup *group,
+                                                                      const double *positions,
+                                                                      std::size_t num_points,
                                                                       std::vector<double> &time_diff,
                                                                       const double max_velocity_scaling_factor) const
 {
-  const robot_model::JointModelGroup *group = rob_trajectory.getGroup();
   const std::vector<std::string> &vars = group->getVariableNames();
-  const std::vector<int> &idx = group->getVariableIndexList();
   const robot_model::RobotModel &rmodel = group->getParentModel();
-  const int num_points = rob_trajectory.getWayPointCount();
+  const std::size_t num_vars = vars.size();
 
   double velocity_scaling_factor = 1.0;
 
@@ -118,20 +118,23 @@ void IterativeParabolicTimeParameterization::applyVelocityConstraints(robot_traj
     else
       logWarn("Invalid max_velocity_scaling_factor %f specified, defaulting to %f instead.", max_velocity_scaling_factor, velocity_scaling_factor);
 
-  for (int i = 0 ; i < num_points-1 ; ++i)
+  // the velocity limits do not change along the trajectory
+  std::vector<double> v_max(num_vars, 1.0);
+  for (std::size_t j = 0 ; j < num_vars ; ++j)
   {
-    const robot_state::RobotStatePtr &curr_waypoint = rob_trajectory.getWayPointPtr(i);
-    const robot_state::RobotStatePtr &next_waypoint = rob_trajectory.getWayPointPtr(i+1);
+    const robot_model::VariableBounds &b = rmodel.getVariableBounds(vars[j]);
+    if (b.velocity_bounded_)
+      v_max[j] = std::min(fabs(b.max_velocity_* velocity_scaling_factor), fabs(b.min_velocity_* velocity_scaling_factor));
+  }
 
-    for (std::size_t j = 0 ; j < vars.size() ; ++j)
+  for (std::size_t i = 0 ; i + 1 < num_points ; ++i)
+  {
+    const double *curr_waypoint = positions + i * num_vars;
+    const double *next_waypoint = curr_waypoint + num_vars;
+
+    for (std::size_t j = 0 ; j < num_vars ; ++j)
     {
-      double v_max = 1.0;
-      const robot_model::VariableBounds &b = rmodel.getVariableBounds(vars[j]);
-      if (b.velocity_bounded_)
-        v_max = std::min(fabs(b.max_velocity_* velocity_scaling_factor), fabs(b.min_velocity_* velocity_scaling_factor));
-      const double dq1 = curr_waypoint->getVariablePosition(idx[j]);
-      const double dq2 = next_waypoint->getVariablePosition(idx[j]);
-      const double t_min = std::abs(dq2-dq1) / v_max;
+      const double t_min = std::abs(next_waypoint[j] - curr_waypoint[j]) / v_max[j];
       if (t_min > time_diff[i])
         time_diff[i] = t_min;
     }
@@ -188,50 +191,23 @@ double IterativeParabolicTimeParameterization::findT2(const double dq1,
 namespace
 {
 
-// Takes the time differences, and updates the timestamps, velocities and accelerations
-// in the trajectory.
-void updateTrajectory(robot_trajectory::RobotTrajectory& rob_trajectory,
-                      const std::vector<double>& time_diff)
+// Takes the time differences, and computes the velocities and accelerations
+// at each waypoint. All arrays hold num_vars values per waypoint.
+void computeDerivatives(std::size_t num_vars,
+                        const double *positions,
+                        std::size_t num_points,
+                        const double *start_velocities,
+                        const std::vector<double>& time_diff,
+                        double *velocities,
+                        double *accelerations)
 {
-  // Error check
-  if (time_diff.empty())
-    return;
-
-  double time_sum = 0.0;
-
-  robot_state::RobotStatePtr prev_waypoint;
-  robot_state::RobotStatePtr curr_waypoint;
-  robot_state::RobotStatePtr next_waypoint;
-
-  const robot_model::JointModelGroup *group = rob_trajectory.getGroup();
-  const std::vector<std::string> &vars = group->getVariableNames();
-  const std::vector<int> &idx = group->getVariableIndexList();
-
-  int num_points = rob_trajectory.getWayPointCount();
-
-  rob_trajectory.setWayPointDurationFromPrevious(0, time_sum);
-
-  // Times
-  for (int i = 1; i < num_points; ++i)
-    // Update the time between the waypoints in the robot_trajectory.
-    rob_trajectory.setWayPointDurationFromPrevious(i, time_diff[i-1]);
-
-  // Return if there is only one point in the trajectory!
-  if (num_points <= 1)
-    return;
-
-  // Accelerations
-  for (int i = 0; i < num_points; ++i)
+  for (std::size_t i = 0; i < num_points; ++i)
   {
-    curr_waypoint = rob_trajectory.getWayPointPtr(i);
-
-    if (i > 0)
-      prev_waypoint = rob_trajectory.getWayPointPtr(i-1);
-
-    if (i < num_points-1)
-      next_waypoint = rob_trajectory.getWayPointPtr(i+1);
+    const double *curr_waypoint = positions + i * num_vars;
+    const double *prev_waypoint = i > 0 ? curr_waypoint - num_vars : NULL;
+    const double *next_waypoint = i < num_points-1 ? curr_waypoint + num_vars : NULL;
 
-    for (std::size_t j = 0; j < vars.size(); ++j)
+    for (std::size_t j = 0; j < num_vars; ++j)
     {
       double q1;
       double q2;
@@ -242,8 +218,8 @@ void updateTrajectory(robot_trajectory::RobotTrajectory& rob_trajectory,
       if (i == 0)
       {
         // First point
-        q1 = next_waypoint->getVariablePosition(idx[j]);
-        q2 = curr_waypoint->getVariablePosition(idx[j]);
+        q1 = next_waypoint[j];
+        q2 = curr_waypoint[j];
         q3 = q1;
 
         dt1 = dt2 = time_diff[i];
@@ -252,9 +228,9 @@ void updateTrajectory(robot_trajectory::RobotTrajectory& rob_trajectory,
         if (i < num_points-1)
         {
           // middle points
-          q1 = prev_waypoint->getVariablePosition(idx[j]);
-          q2 = curr_waypoint->getVariablePosition(idx[j]);
-          q3 = next_waypoint->getVariablePosition(idx[j]);
+          q1 = prev_waypoint[j];
+          q2 = curr_waypoint[j];
+          q3 = next_waypoint[j];
 
           dt1 = time_diff[i-1];
           dt2 = time_diff[i];
@@ -262,8 +238,8 @@ void updateTrajectory(robot_trajectory::RobotTrajectory& rob_trajectory,
         else
         {
           // last point
-          q1 = prev_waypoint->getVariablePosition(idx[j]);
-          q2 = curr_waypoint->getVariablePosition(idx[j]);
+          q1 = prev_waypoint[j];
+          q2 = curr_waypoint[j];
           q3 = q1;
 
           dt1 = dt2 = time_diff[i-1];
@@ -271,7 +247,6 @@ void updateTrajectory(robot_trajectory::RobotTrajectory& rob_trajectory,
 
       double v1, v2, a;
 
-      bool start_velocity = false;
       if (dt1 == 0.0 || dt2 == 0.0)
       {
         v1 = 0.0;
@@ -280,22 +255,15 @@ void updateTrajectory(robot_trajectory::RobotTrajectory& rob_trajectory,
       }
       else
       {
-        if (i == 0)
-        {
-          if (curr_waypoint->hasVelocities())
-          {
-            start_velocity = true;
-            v1 = curr_waypoint->getVariableVelocity(idx[j]);
-          }
-        }
-        v1 = start_velocity ? v1 : (q2-q1)/dt1;
+        bool start_velocity = i == 0 && start_velocities;
+        v1 = start_velocity ? start_velocities[j] : (q2-q1)/dt1;
         //v2 = (q3-q2)/dt2;
         v2 = start_velocity ? v1 : (q3-q2)/dt2; // Needed to ensure continuous velocity for first point
         a = 2.0*(v2-v1)/(dt1+dt2);
       }
 
-      curr_waypoint->setVariableVelocity(idx[j], (v2+v1)/2.0);
-      curr_waypoint->setVariableAcceleration(idx[j], a);
+      velocities[i * num_vars + j] = (v2+v1)/2.0;
+      accelerations[i * num_vars + j] = a;
     }
   }
 }
@@ -303,20 +271,17 @@ void updateTrajectory(robot_trajectory::RobotTrajectory& rob_trajectory,
 
 
 // Applies Acceleration constraints
-void IterativeParabolicTimeParameterization::applyAccelerationConstraints(robot_trajectory::RobotTrajectory& rob_trajectory,
+void IterativeParabolicTimeParameterization::applyAccelerationConstraints(const robot_model::JointModelGroup *group,
+                                                                          const double *positions,
+                                                                          std::size_t num_points_count,
+                                                                          const double *start_velocities,
                                                                           std::vector<double> & time_diff,
                                                                           const double max_acceleration_scaling_factor) const
 {
-  robot_state::RobotStatePtr prev_waypoint;
-  robot_state::RobotStatePtr curr_waypoint;
-  robot_state::RobotStatePtr next_waypoint;
-
-  const robot_model::JointModelGroup *group = rob_trajectory.getGroup();
   const std::vector<std::string> &vars = group->getVariableNames();
-  const std::vector<int> &idx = group->getVariableIndexList();
   const robot_model::RobotModel &rmodel = group->getParentModel();
 
-  const int num_points = rob_trajectory.getWayPointCount();
+  const int num_points = num_points_count;
   const unsigned int num_joints = group->getVariableCount();
   int num_updates = 0;
   int iteration = 0;
@@ -339,7 +304,16 @@ void IterativeParabolicTimeParameterization::applyAccelerationConstraints(robot_
       logDebug("A max_acceleration_scaling_factor of 0.0 was specified, defaulting to %f instead.", acceleration_scaling_factor);
     else
       logWarn("Invalid max_acceleration_scaling_factor %f specified, defaulting to %f instead.", max_acceleration_scaling_factor, acceleration_scaling_factor);
-  
+
+  // the acceleration limits do not change along the trajectory
+  std::vector<double> a_max(num_joints, 1.0);
+  for (unsigned int j = 0; j < num_joints ; ++j)
+  {
+    const robot_model::VariableBounds &b = rmodel.getVariableBounds(vars[j]);
+    if (b.acceleration_bounded_)
+      a_max[j] = std::min(fabs(b.max_acceleration_*acceleration_scaling_factor), fabs(b.min_acceleration_*acceleration_scaling_factor));
+  }
+
   do
   {
     num_updates = 0;
@@ -356,26 +330,16 @@ void IterativeParabolicTimeParameterization::applyAccelerationConstraints(robot_
         {
           int index = backwards ? (num_points-1)-i : i;
 
-          curr_waypoint = rob_trajectory.getWayPointPtr(index);
-
-          if (index > 0)
-            prev_waypoint = rob_trajectory.getWayPointPtr(index-1);
-
-          if (index < num_points-1)
-            next_waypoint = rob_trajectory.getWayPointPtr(index+1);
-
-          // Get acceleration limits
-          double a_max = 1.0;
-          const robot_model::VariableBounds &b = rmodel.getVariableBounds(vars[j]);
-          if (b.acceleration_bounded_)
-            a_max = std::min(fabs(b.max_acceleration_*acceleration_scaling_factor), fabs(b.min_acceleration_*acceleration_scaling_factor));
+          const double *curr_waypoint = positions + index * num_joints;
+          const double *prev_waypoint = index > 0 ? curr_waypoint - num_joints : NULL;
+          const double *next_waypoint = index < num_points-1 ? curr_waypoint + num_joints : NULL;
 
           if (index == 0)
           {
             // First point
-            q1 = next_waypoint->getVariablePosition(idx[j]);
-            q2 = curr_waypoint->getVariablePosition(idx[j]);
-            q3 = next_waypoint->getVariablePosition(idx[j]);
+            q1 = next_waypoint[j];
+            q2 = curr_waypoint[j];
+            q3 = next_waypoint[j];
 
             dt1 = dt2 = time_diff[index];
             assert(!backwards);
@@ -384,9 +348,9 @@ void IterativeParabolicTimeParameterization::applyAccelerationConstraints(robot_
             if (index < num_points-1)
             {
               // middle points
-              q1 = prev_waypoint->getVariablePosition(idx[j]);
-              q2 = curr_waypoint->getVariablePosition(idx[j]);
-              q3 = next_waypoint->getVariablePosition(idx[j]);
+              q1 = prev_waypoint[j];
+              q2 = curr_waypoint[j];
+              q3 = next_waypoint[j];
 
               dt1 = time_diff[index-1];
               dt2 = time_diff[index];
@@ -394,9 +358,9 @@ void IterativeParabolicTimeParameterization::applyAccelerationConstraints(robot_
             else
             {
               // last point - careful, there are only numpoints-1 time intervals
-              q1 = prev_waypoint->getVariablePosition(idx[j]);
-              q2 = curr_waypoint->getVariablePosition(idx[j]);
-              q3 = prev_waypoint->getVariablePosition(idx[j]);
+              q1 = prev_waypoint[j];
+              q2 = curr_waypoint[j];
+              q3 = prev_waypoint[j];
 
               dt1 = dt2 = time_diff[index-1];
               assert(backwards);
@@ -410,46 +374,25 @@ void IterativeParabolicTimeParameterization::applyAccelerationConstraints(robot_
           }
           else
           {
-            bool start_velocity = false;
-            if (index == 0)
-            {
-              if (curr_waypoint->hasVelocities())
-              {
-                start_velocity = true;
-                v1 = curr_waypoint->getVariableVelocity(idx[j]);
-              }
-            }
-            v1 = start_velocity ? v1 : (q2-q1)/dt1;
+            bool start_velocity = index == 0 && start_velocities;
+            v1 = start_velocity ? start_velocities[j] : (q2-q1)/dt1;
             v2 = (q3-q2)/dt2;
             a = 2.0*(v2-v1)/(dt1+dt2);
           }
 
-          if (fabs(a) > a_max + ROUNDING_THRESHOLD)
+          if (fabs(a) > a_max[j] + ROUNDING_THRESHOLD)
           {
             if (!backwards)
             {
-              dt2 = std::min(dt2 + max_time_change_per_it_, findT2(q2-q1, q3-q2, dt1, dt2, a_max));
+              dt2 = std::min(dt2 + max_time_change_per_it_, findT2(q2-q1, q3-q2, dt1, dt2, a_max[j]));
               time_diff[index] = dt2;
             }
             else
             {
-              dt1 = std::min(dt1 + max_time_change_per_it_, findT1(q2-q1, q3-q2, dt1, dt2, a_max));
+              dt1 = std::min(dt1 + max_time_change_per_it_, findT1(q2-q1, q3-q2, dt1, dt2, a_max[j]));
               time_diff[index-1] = dt1;
             }
             num_updates++;
-
-            if (dt1 == 0.0 || dt2 == 0.0)
-            {
-              v1 = 0.0;
-              v2 = 0.0;
-              a = 0.0;
-            }
-            else
-            {
-              v1 = (q2-q1)/dt1;
-              v2 = (q3-q2)/dt2;
-              a = 2*(v2-v1)/(dt1+dt2);
-            }
           }
         }
         backwards = !backwards;
@@ -459,6 +402,24 @@ void IterativeParabolicTimeParameterization::applyAccelerationConstraints(robot_
   } while (num_updates > 0 && iteration < static_cast<int>(max_iterations_));
 }
 
+void IterativeParabolicTimeParameterization::computeTimeStamps(const robot_model::JointModelGroup *group,
+                                                               const double *positions,
+                                                               std::size_t num_points,
+                                                               const double *start_velocities,
+                                                               std::vector<double> &time_diff,
+                                                               double *velocities,
+                                                               double *accelerations,
+                                                               const double max_velocity_scaling_factor,
+                                                               const double max_acceleration_scaling_factor) const
+{
+  time_diff.assign(num_points-1, 0.0);       // the time difference between adjacent points
+
+  applyVelocityConstraints(group, positions, num_points, time_diff, max_velocity_scaling_factor);
+  applyAccelerationConstraints(group, positions, num_points, start_velocities, time_diff, max_acceleration_scaling_factor);
+
+  computeDerivatives(group->getVariableCount(), positions, num_points, start_velocities, time_diff, velocities, accelerations);
+}
+
 bool IterativeParabolicTimeParameterization::computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory,
                                                                const double max_velocity_scaling_factor,
                                                                const double max_acceleration_scaling_factor) const
@@ -476,13 +437,78 @@ bool IterativeParabolicTimeParameterization::computeTimeStamps(robot_trajectory:
   // this lib does not actually work properly when angles wrap around, so we need to unwind the path first
   trajectory.unwind();
 
-  const int num_points = trajectory.getWayPointCount();
-  std::vector<double> time_diff(num_points-1, 0.0);       // the time difference between adjacent points
+  // Return if there is only one point in the trajectory!
+  const std::size_t num_points = trajectory.getWayPointCount();
+  if (num_points <= 1)
+    return true;
 
-  applyVelocityConstraints(trajectory, time_diff, max_velocity_scaling_factor);
-  applyAccelerationConstraints(trajectory, time_diff, max_acceleration_scaling_factor);
+  // gather the group variables into one contiguous block, so the iterations below do not go through the waypoint states
+  const std::size_t num_vars = group->getVariableCount();
+  const std::vector<int> &idx = group->getVariableIndexList();
+  std::vector<double> positions(num_points * num_vars);
+  for (std::size_t i = 0 ; i < num_points ; ++i)
+    trajectory.getWayPoint(i).copyJointGroupPositions(group, &positions[i * num_vars]);
+
+  std::vector<double> start_velocities;
+  const robot_state::RobotState &first_waypoint = trajectory.getFirstWayPoint();
+  if (first_waypoint.hasVelocities())
+    for (std::size_t j = 0 ; j < num_vars ; ++j)
+      start_velocities.push_back(first_waypoint.getVariableVelocity(idx[j]));
+
+  std::vector<double> time_diff;
+  std::vector<double> velocities(num_points * num_vars);
+  std::vector<double> accelerations(num_points * num_vars);
+  computeTimeStamps(group, &positions[0], num_points, start_velocities.empty() ? NULL : &start_velocities[0],
+                    time_diff, &velocities[0], &accelerations[0], max_velocity_scaling_factor, max_acceleration_scaling_factor);
+
+  trajectory.setWayPointDurationFromPrevious(0, 0.0);
+  for (std::size_t i = 1; i < num_points; ++i)
+    trajectory.setWayPointDurationFromPrevious(i, time_diff[i-1]);
+
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    const robot_state::RobotStatePtr &waypoint = trajectory.getWayPointPtr(i);
+    for (std::size_t j = 0 ; j < num_vars ; ++j)
+    {
+      waypoint->setVariableVelocity(idx[j], velocities[i * num_vars + j]);
+      waypoint->setVariableAcceleration(idx[j], accelerations[i * num_vars + j]);
+    }
+  }
+  return true;
+}
+
+bool IterativeParabolicTimeParameterization::computeTimeStamps(robot_trajectory::CompactRobotTrajectory& trajectory,
+                                                               const double max_velocity_scaling_factor,
+                                                               const double max_acceleration_scaling_factor) const
+{
+  if (trajectory.empty())
+    return true;
 
-  updateTrajectory(trajectory, time_diff);
+  // this lib does not actually work properly when angles wrap around, so we need to unwind the path first
+  trajectory.unwind();
+
+  // Return if there is only one point in the trajectory!
+  const std::size_t num_points = trajectory.getWayPointCount();
+  if (num_points <= 1)
+    return true;
+
+  const robot_model::JointModelGroup *group = trajectory.getGroup();
+  const std::size_t num_vars = trajectory.getVariableCount();
+
+  // the velocities are overwritten in place, so keep the ones given for the start point
+  std::vector<double> start_velocities;
+  if (trajectory.hasVelocities())
+    start_velocities.assign(trajectory.getWayPointVelocities(0), trajectory.getWayPointVelocities(0) + num_vars);
+
+  std::vector<double> time_diff;
+  computeTimeStamps(group, trajectory.getWayPointPositions(0), num_points,
+                    start_velocities.empty() ? NULL : &start_velocities[0], time_diff,
+                    trajectory.getWayPointVelocities(0), trajectory.getWayPointAccelerations(0),
+                    max_velocity_scaling_factor, max_acceleration_scaling_factor);
+
+  trajectory.setWayPointDurationFromPrevious(0, 0.0);
+  for (std::size_t i = 1; i < num_points; ++i)
+    trajectory.setWayPointDurationFromPrevious(i, time_diff[i-1]);
   return true;
 }
 
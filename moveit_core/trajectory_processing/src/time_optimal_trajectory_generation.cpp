@@ -0,0 +1,910 @@
+/*
+ * Copyright (c) 2011-2012, Georgia Tech Research Corporation
+ * All rights reserved.
+ *
+ * Author: Tobias Kunz <tobias@gatech.edu>
+ * Date: 05/2012
+ *
+ * Humanoid Robotics Lab      Georgia Institute of Technology
+ * Director: Mike Stilman     http://www.golems.org
+ *
+ * Algorithm details and publications:
+ * http://www.golems.org/node/1570
+ *
+ * This file is provided under the following "BSD-style" License:
+ *   Redistribution and use in source and binary forms, with or
+ *   without modification, are permitted provided that the following
+ *   conditions are met:
+ *   * Redistributions of source code must retain the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials
+ *     provided with the distribution.
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ *   CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ *   INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ *   MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *   DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ *   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ *   LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ *   USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ *   AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *   LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *   ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *   POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Adapted for MoveIt! from the time-optimal trajectory generation of Tobias Kunz and Mike Stilman */
+
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <console_bridge/console.h>
+#include <boost/shared_ptr.hpp>
+#include <Eigen/Core>
+#include <algorithm>
+#include <limits>
+#include <list>
+#include <cmath>
+
+namespace trajectory_processing
+{
+
+namespace
+{
+
+static const double EPS = 0.000001;
+static const double DEFAULT_VEL_MAX = 1.0;
+static const double DEFAULT_ACCEL_MAX = 1.0;
+
+// A piece of the path, parameterized by arc length in joint space
+class PathSegment
+{
+public:
+  PathSegment(double length = 0.0) : length_(length)
+  {
+  }
+
+  virtual ~PathSegment()
+  {
+  }
+
+  double getLength() const
+  {
+    return length_;
+  }
+
+  virtual Eigen::VectorXd getConfig(double s) const = 0;
+  virtual Eigen::VectorXd getTangent(double s) const = 0;
+  virtual Eigen::VectorXd getCurvature(double s) const = 0;
+
+  // positions along the segment where the sign of a tangent component changes
+  virtual std::list<double> getSwitchingPoints() const = 0;
+
+protected:
+  double length_;
+};
+
+class LinearPathSegment : public PathSegment
+{
+public:
+  LinearPathSegment(const Eigen::VectorXd &start, const Eigen::VectorXd &end) :
+    PathSegment((end - start).norm()), start_(start), end_(end)
+  {
+  }
+
+  virtual Eigen::VectorXd getConfig(double s) const
+  {
+    s /= length_;
+    s = std::max(0.0, std::min(1.0, s));
+    return (1.0 - s) * start_ + s * end_;
+  }
+
+  virtual Eigen::VectorXd getTangent(double s) const
+  {
+    return (end_ - start_) / length_;
+  }
+
+  virtual Eigen::VectorXd getCurvature(double s) const
+  {
+    return Eigen::VectorXd::Zero(start_.size());
+  }
+
+  virtual std::list<double> getSwitchingPoints() const
+  {
+    return std::list<double>();
+  }
+
+private:
+  Eigen::VectorXd start_;
+  Eigen::VectorXd end_;
+};
+
+// A circular arc that blends the corner at \e intersection between the lines coming from \e start and going to \e end
+class CircularPathSegment : public PathSegment
+{
+public:
+  CircularPathSegment(const Eigen::VectorXd &start, const Eigen::VectorXd &intersection, const Eigen::VectorXd &end,
+                      double max_deviation)
+  {
+    radius_ = 1.0;
+    center_ = intersection;
+    x_ = Eigen::VectorXd::Zero(start.size());
+    y_ = Eigen::VectorXd::Zero(start.size());
+    if ((intersection - start).norm() < EPS || (end - intersection).norm() < EPS)
+      return;
+
+    const Eigen::VectorXd start_direction = (intersection - start).normalized();
+    const Eigen::VectorXd end_direction = (end - intersection).normalized();
+    if ((start_direction - end_direction).norm() < EPS)
+      return;
+
+    // angle by which the path turns at the corner
+    const double angle = acos(std::max(-1.0, std::min(1.0, start_direction.dot(end_direction))));
+    const double distance = std::min((start - intersection).norm(), (end - intersection).norm());
+    const double half_angle = 0.5 * angle;
+
+    // the arc may neither come closer than max_deviation to the corner, nor extend beyond the adjacent segments
+    radius_ = std::min(max_deviation * cos(half_angle) / (1.0 - cos(half_angle)), distance / tan(half_angle));
+    length_ = angle * radius_;
+
+    center_ = intersection + (end_direction - start_direction).normalized() * radius_ / cos(half_angle);
+    x_ = (intersection - start_direction * radius_ * tan(half_angle) - center_).normalized();
+    y_ = start_direction;
+  }
+
+  virtual Eigen::VectorXd getConfig(double s) const
+  {
+    const double angle = s / radius_;
+    return center_ + radius_ * (x_ * cos(angle) + y_ * sin(angle));
+  }
+
+  virtual Eigen::VectorXd getTangent(double s) const
+  {
+    const double angle = s / radius_;
+    return -x_ * sin(angle) + y_ * cos(angle);
+  }
+
+  virtual Eigen::VectorXd getCurvature(double s) const
+  {
+    const double angle = s / radius_;
+    return -1.0 / radius_ * (x_ * cos(angle) + y_ * sin(angle));
+  }
+
+  virtual std::list<double> getSwitchingPoints() const
+  {
+    std::list<double> switching_points;
+    for (int i = 0 ; i < x_.size() ; ++i)
+    {
+      double switching_angle = atan2(y_[i], x_[i]);
+      if (switching_angle < 0.0)
+        switching_angle += M_PI;
+      const double switching_point = switching_angle * radius_;
+      if (switching_point < length_)
+        switching_points.push_back(switching_point);
+    }
+    switching_points.sort();
+    return switching_points;
+  }
+
+private:
+  double radius_;
+  Eigen::VectorXd center_;
+  Eigen::VectorXd x_;
+  Eigen::VectorXd y_;
+};
+
+// The waypoints connected by lines, with circular blends at the interior waypoints
+class Path
+{
+public:
+  Path(const std::vector<Eigen::VectorXd> &waypoints, double max_deviation) : length_(0.0)
+  {
+    if (waypoints.size() < 2)
+      return;
+
+    Eigen::VectorXd start_config = waypoints[0];
+    for (std::size_t i = 1 ; i < waypoints.size() ; ++i)
+    {
+      if (max_deviation > 0.0 && i + 1 < waypoints.size())
+      {
+        boost::shared_ptr<CircularPathSegment> blend(new CircularPathSegment(0.5 * (waypoints[i - 1] + waypoints[i]), waypoints[i],
+                                                                             0.5 * (waypoints[i] + waypoints[i + 1]), max_deviation));
+        const Eigen::VectorXd end_config = blend->getConfig(0.0);
+        if ((end_config - start_config).norm() > EPS)
+          segments_.push_back(boost::shared_ptr<PathSegment>(new LinearPathSegment(start_config, end_config)));
+        if (blend->getLength() > 0.0)
+        {
+          segments_.push_back(blend);
+          start_config = blend->getConfig(blend->getLength());
+        }
+        else
+          start_config = end_config;
+      }
+      else
+      {
+        if ((waypoints[i] - start_config).norm() > EPS)
+          segments_.push_back(boost::shared_ptr<PathSegment>(new LinearPathSegment(start_config, waypoints[i])));
+        start_config = waypoints[i];
+      }
+    }
+
+    // collect the switching point candidates; the boundaries between segments are discontinuities of the curvature
+    for (std::size_t i = 0 ; i < segments_.size() ; ++i)
+    {
+      segment_positions_.push_back(length_);
+      std::list<double> local_switching_points = segments_[i]->getSwitchingPoints();
+      for (std::list<double>::const_iterator it = local_switching_points.begin() ; it != local_switching_points.end() ; ++it)
+        switching_points_.push_back(std::make_pair(length_ + *it, false));
+      length_ += segments_[i]->getLength();
+      while (!switching_points_.empty() && switching_points_.back().first >= length_)
+        switching_points_.pop_back();
+      switching_points_.push_back(std::make_pair(length_, true));
+    }
+    if (!switching_points_.empty())
+      switching_points_.pop_back();
+  }
+
+  double getLength() const
+  {
+    return length_;
+  }
+
+  Eigen::VectorXd getConfig(double s) const
+  {
+    const PathSegment *segment = getPathSegment(s);
+    return segment->getConfig(s);
+  }
+
+  Eigen::VectorXd getTangent(double s) const
+  {
+    const PathSegment *segment = getPathSegment(s);
+    return segment->getTangent(s);
+  }
+
+  Eigen::VectorXd getCurvature(double s) const
+  {
+    const PathSegment *segment = getPathSegment(s);
+    return segment->getCurvature(s);
+  }
+
+  // the first switching point after s; the end of the path is reported as a discontinuity
+  double getNextSwitchingPoint(double s, bool &discontinuity) const
+  {
+    std::vector<std::pair<double, bool> >::const_iterator it =
+      std::upper_bound(switching_points_.begin(), switching_points_.end(), std::make_pair(s, true));
+    if (it == switching_points_.end())
+    {
+      discontinuity = true;
+      return length_;
+    }
+    discontinuity = it->second;
+    return it->first;
+  }
+
+  const std::vector<std::pair<double, bool> >& getSwitchingPoints() const
+  {
+    return switching_points_;
+  }
+
+private:
+
+  // find the segment containing s and make s relative to the start of that segment
+  const PathSegment* getPathSegment(double &s) const
+  {
+    std::vector<double>::const_iterator it = std::upper_bound(segment_positions_.begin(), segment_positions_.end(), s);
+    const std::size_t i = it == segment_positions_.begin() ? 0 : it - segment_positions_.begin() - 1;
+    s -= segment_positions_[i];
+    s = std::max(0.0, std::min(s, segments_[i]->getLength()));
+    return segments_[i].get();
+  }
+
+  double length_;
+  std::vector<boost::shared_ptr<PathSegment> > segments_;
+  std::vector<double> segment_positions_;
+  std::vector<std::pair<double, bool> > switching_points_;
+};
+
+struct TrajectoryStep
+{
+  TrajectoryStep(double path_pos = 0.0, double path_vel = 0.0) : path_pos_(path_pos), path_vel_(path_vel), time_(0.0)
+  {
+  }
+
+  double path_pos_;
+  double path_vel_;
+  double time_;
+};
+
+// The time-optimal velocity profile along a path, computed in the phase plane
+class PhasePlaneTrajectory
+{
+public:
+  PhasePlaneTrajectory(const Path &path, const Eigen::VectorXd &max_velocity, const Eigen::VectorXd &max_acceleration,
+                       double time_step = 0.001) :
+    path_(path), max_velocity_(max_velocity), max_acceleration_(max_acceleration), joint_num_(max_velocity.size()),
+    valid_(true), time_step_(time_step)
+  {
+    trajectory_.push_back(TrajectoryStep(0.0, 0.0));
+    double after_acceleration = getMinMaxPathAcceleration(0.0, 0.0, true);
+    while (valid_ && !integrateForward(trajectory_, after_acceleration) && valid_)
+    {
+      double before_acceleration = 0.0;
+      TrajectoryStep switching_point;
+      if (getNextSwitchingPoint(trajectory_.back().path_pos_, switching_point, before_acceleration, after_acceleration))
+        break;
+      integrateBackward(trajectory_, switching_point.path_pos_, switching_point.path_vel_, before_acceleration);
+    }
+
+    if (valid_)
+    {
+      double before_acceleration = getMinMaxPathAcceleration(path_.getLength(), 0.0, false);
+      integrateBackward(trajectory_, path_.getLength(), 0.0, before_acceleration);
+    }
+
+    if (valid_)
+    {
+      // the time of each step follows from the average path velocity over the step
+      std::list<TrajectoryStep>::iterator previous = trajectory_.begin();
+      std::list<TrajectoryStep>::iterator it = previous;
+      it->time_ = 0.0;
+      ++it;
+      while (it != trajectory_.end())
+      {
+        it->time_ = previous->time_ + (it->path_pos_ - previous->path_pos_) / ((it->path_vel_ + previous->path_vel_) / 2.0);
+        previous = it;
+        ++it;
+      }
+    }
+  }
+
+  bool isValid() const
+  {
+    return valid_;
+  }
+
+  double getDuration() const
+  {
+    return trajectory_.back().time_;
+  }
+
+  // position, velocity and acceleration of the joints at \e time
+  void getState(double time, Eigen::VectorXd &position, Eigen::VectorXd &velocity, Eigen::VectorXd &acceleration) const
+  {
+    std::list<TrajectoryStep>::const_iterator it = getTrajectorySegment(time);
+    std::list<TrajectoryStep>::const_iterator previous = it;
+    --previous;
+
+    double time_step = it->time_ - previous->time_;
+    const double path_acc = time_step > 0.0 ?
+      2.0 * (it->path_pos_ - previous->path_pos_ - time_step * previous->path_vel_) / (time_step * time_step) : 0.0;
+    time_step = time - previous->time_;
+    const double path_pos = previous->path_pos_ + time_step * previous->path_vel_ + 0.5 * time_step * time_step * path_acc;
+    const double path_vel = previous->path_vel_ + time_step * path_acc;
+
+    position = path_.getConfig(path_pos);
+    const Eigen::VectorXd tangent = path_.getTangent(path_pos);
+    velocity = tangent * path_vel;
+    acceleration = tangent * path_acc + path_.getCurvature(path_pos) * path_vel * path_vel;
+  }
+
+private:
+
+  // returns true if the end of the path is reached
+  bool getNextSwitchingPoint(double path_pos, TrajectoryStep &next_switching_point,
+                             double &before_acceleration, double &after_acceleration)
+  {
+    TrajectoryStep acceleration_switching_point(path_pos, 0.0);
+    double acceleration_before_acceleration = 0.0, acceleration_after_acceleration = 0.0;
+    bool acceleration_reached_end;
+    do
+    {
+      acceleration_reached_end = getNextAccelerationSwitchingPoint(acceleration_switching_point.path_pos_, acceleration_switching_point,
+                                                                   acceleration_before_acceleration, acceleration_after_acceleration);
+    } while (!acceleration_reached_end &&
+             acceleration_switching_point.path_vel_ > getVelocityMaxPathVelocity(acceleration_switching_point.path_pos_));
+
+    TrajectoryStep velocity_switching_point(path_pos, 0.0);
+    double velocity_before_acceleration = 0.0, velocity_after_acceleration = 0.0;
+    bool velocity_reached_end;
+    do
+    {
+      velocity_reached_end = getNextVelocitySwitchingPoint(velocity_switching_point.path_pos_, velocity_switching_point,
+                                                           velocity_before_acceleration, velocity_after_acceleration);
+    } while (!velocity_reached_end && velocity_switching_point.path_pos_ <= acceleration_switching_point.path_pos_ &&
+             (velocity_switching_point.path_vel_ > getAccelerationMaxPathVelocity(velocity_switching_point.path_pos_ - EPS) ||
+              velocity_switching_point.path_vel_ > getAccelerationMaxPathVelocity(velocity_switching_point.path_pos_ + EPS)));
+
+    if (acceleration_reached_end && velocity_reached_end)
+      return true;
+
+    if (!acceleration_reached_end && (velocity_reached_end || acceleration_switching_point.path_pos_ <= velocity_switching_point.path_pos_))
+    {
+      next_switching_point = acceleration_switching_point;
+      before_acceleration = acceleration_before_acceleration;
+      after_acceleration = acceleration_after_acceleration;
+    }
+    else
+    {
+      next_switching_point = velocity_switching_point;
+      before_acceleration = velocity_before_acceleration;
+      after_acceleration = velocity_after_acceleration;
+    }
+    return false;
+  }
+
+  bool getNextAccelerationSwitchingPoint(double path_pos, TrajectoryStep &next_switching_point,
+                                         double &before_acceleration, double &after_acceleration)
+  {
+    double switching_path_pos = path_pos;
+    double switching_path_vel = 0.0;
+    while (true)
+    {
+      bool discontinuity;
+      switching_path_pos = path_.getNextSwitchingPoint(switching_path_pos, discontinuity);
+
+      if (switching_path_pos > path_.getLength() - EPS)
+        return true;
+
+      if (discontinuity)
+      {
+        const double before_path_vel = getAccelerationMaxPathVelocity(switching_path_pos - EPS);
+        const double after_path_vel = getAccelerationMaxPathVelocity(switching_path_pos + EPS);
+        switching_path_vel = std::min(before_path_vel, after_path_vel);
+        before_acceleration = getMinMaxPathAcceleration(switching_path_pos - EPS, switching_path_vel, false);
+        after_acceleration = getMinMaxPathAcceleration(switching_path_pos + EPS, switching_path_vel, true);
+
+        if ((before_path_vel > after_path_vel ||
+             getMinMaxPhaseSlope(switching_path_pos - EPS, switching_path_vel, false) > getAccelerationMaxPathVelocityDeriv(switching_path_pos - 2.0 * EPS)) &&
+            (before_path_vel < after_path_vel ||
+             getMinMaxPhaseSlope(switching_path_pos + EPS, switching_path_vel, true) < getAccelerationMaxPathVelocityDeriv(switching_path_pos + 2.0 * EPS)))
+          break;
+      }
+      else
+      {
+        switching_path_vel = getAccelerationMaxPathVelocity(switching_path_pos);
+        before_acceleration = 0.0;
+        after_acceleration = 0.0;
+
+        if (getAccelerationMaxPathVelocityDeriv(switching_path_pos - EPS) < 0.0 &&
+            getAccelerationMaxPathVelocityDeriv(switching_path_pos + EPS) > 0.0)
+          break;
+      }
+    }
+
+    next_switching_point = TrajectoryStep(switching_path_pos, switching_path_vel);
+    return false;
+  }
+
+  bool getNextVelocitySwitchingPoint(double path_pos, TrajectoryStep &next_switching_point,
+                                     double &before_acceleration, double &after_acceleration)
+  {
+    const double step_size = 0.001;
+    const double accuracy = 0.000001;
+
+    bool start = false;
+    path_pos -= step_size;
+    do
+    {
+      path_pos += step_size;
+      if (getMinMaxPhaseSlope(path_pos, getVelocityMaxPathVelocity(path_pos), false) >= getVelocityMaxPathVelocityDeriv(path_pos))
+        start = true;
+    } while ((!start || getMinMaxPhaseSlope(path_pos, getVelocityMaxPathVelocity(path_pos), false) > getVelocityMaxPathVelocityDeriv(path_pos)) &&
+             path_pos < path_.getLength());
+
+    if (path_pos >= path_.getLength())
+      return true;
+
+    // refine the switching point by bisection
+    double before_path_pos = path_pos - step_size;
+    double after_path_pos = path_pos;
+    while (after_path_pos - before_path_pos > accuracy)
+    {
+      path_pos = (before_path_pos + after_path_pos) / 2.0;
+      if (getMinMaxPhaseSlope(path_pos, getVelocityMaxPathVelocity(path_pos), false) > getVelocityMaxPathVelocityDeriv(path_pos))
+        before_path_pos = path_pos;
+      else
+        after_path_pos = path_pos;
+    }
+
+    before_acceleration = getMinMaxPathAcceleration(before_path_pos, getVelocityMaxPathVelocity(before_path_pos), false);
+    after_acceleration = getMinMaxPathAcceleration(after_path_pos, getVelocityMaxPathVelocity(after_path_pos), true);
+    next_switching_point = TrajectoryStep(after_path_pos, getVelocityMaxPathVelocity(after_path_pos));
+    return false;
+  }
+
+  // integrate forward along the maximum acceleration; returns true if the end of the path is reached
+  bool integrateForward(std::list<TrajectoryStep> &trajectory, double acceleration)
+  {
+    double path_pos = trajectory.back().path_pos_;
+    double path_vel = trajectory.back().path_vel_;
+
+    const std::vector<std::pair<double, bool> > &switching_points = path_.getSwitchingPoints();
+    std::vector<std::pair<double, bool> >::const_iterator next_discontinuity = switching_points.begin();
+
+    while (true)
+    {
+      while (next_discontinuity != switching_points.end() &&
+             (next_discontinuity->first <= path_pos || !next_discontinuity->second))
+        ++next_discontinuity;
+
+      const double old_path_pos = path_pos;
+      const double old_path_vel = path_vel;
+
+      path_vel += time_step_ * acceleration;
+      path_pos += time_step_ * 0.5 * (old_path_vel + path_vel);
+
+      if (next_discontinuity != switching_points.end() && path_pos > next_discontinuity->first)
+      {
+        // do not stop just after a discontinuity, the next step would be almost identical
+        if (path_pos - next_discontinuity->first < EPS)
+          continue;
+        path_vel = old_path_vel + (next_discontinuity->first - old_path_pos) * (path_vel - old_path_vel) / (path_pos - old_path_pos);
+        path_pos = next_discontinuity->first;
+      }
+
+      if (path_pos > path_.getLength())
+      {
+        trajectory.push_back(TrajectoryStep(path_pos, path_vel));
+        return true;
+      }
+      else
+        if (path_vel < 0.0)
+        {
+          valid_ = false;
+          logError("Error while integrating forward: Negative path velocity");
+          return true;
+        }
+
+      if (path_vel > getVelocityMaxPathVelocity(path_pos) &&
+          getMinMaxPhaseSlope(old_path_pos, getVelocityMaxPathVelocity(old_path_pos), false) <= getVelocityMaxPathVelocityDeriv(old_path_pos))
+        path_vel = getVelocityMaxPathVelocity(path_pos);
+
+      trajectory.push_back(TrajectoryStep(path_pos, path_vel));
+      acceleration = getMinMaxPathAcceleration(path_pos, path_vel, true);
+
+      if (path_vel > getAccelerationMaxPathVelocity(path_pos) || path_vel > getVelocityMaxPathVelocity(path_pos))
+      {
+        // find a more accurate intersection with the maximum velocity curve by bisection
+        TrajectoryStep overshoot = trajectory.back();
+        trajectory.pop_back();
+        double before = trajectory.back().path_pos_;
+        double before_path_vel = trajectory.back().path_vel_;
+        double after = overshoot.path_pos_;
+        double after_path_vel = overshoot.path_vel_;
+        while (after - before > EPS)
+        {
+          const double midpoint = 0.5 * (before + after);
+          double midpoint_path_vel = 0.5 * (before_path_vel + after_path_vel);
+
+          if (midpoint_path_vel > getVelocityMaxPathVelocity(midpoint) &&
+              getMinMaxPhaseSlope(before, getVelocityMaxPathVelocity(before), false) <= getVelocityMaxPathVelocityDeriv(before))
+            midpoint_path_vel = getVelocityMaxPathVelocity(midpoint);
+
+          if (midpoint_path_vel > getAccelerationMaxPathVelocity(midpoint) || midpoint_path_vel > getVelocityMaxPathVelocity(midpoint))
+          {
+            after = midpoint;
+            after_path_vel = midpoint_path_vel;
+          }
+          else
+          {
+            before = midpoint;
+            before_path_vel = midpoint_path_vel;
+          }
+        }
+        trajectory.push_back(TrajectoryStep(before, before_path_vel));
+
+        if (getAccelerationMaxPathVelocity(after) < getVelocityMaxPathVelocity(after))
+        {
+          if (next_discontinuity != switching_points.end() && after > next_discontinuity->first)
+            return false;
+          else
+            if (getMinMaxPhaseSlope(trajectory.back().path_pos_, trajectory.back().path_vel_, true) >
+                getAccelerationMaxPathVelocityDeriv(trajectory.back().path_pos_))
+              return false;
+        }
+        else
+        {
+          if (getMinMaxPhaseSlope(trajectory.back().path_pos_, trajectory.back().path_vel_, false) >
+              getVelocityMaxPathVelocityDeriv(trajectory.back().path_pos_))
+            return false;
+        }
+      }
+    }
+  }
+
+  // integrate backward along the maximum deceleration from (path_pos, path_vel) until the curve meets \e start_trajectory
+  void integrateBackward(std::list<TrajectoryStep> &start_trajectory, double path_pos, double path_vel, double acceleration)
+  {
+    std::list<TrajectoryStep>::iterator start2 = start_trajectory.end();
+    --start2;
+    std::list<TrajectoryStep>::iterator start1 = start2;
+    --start1;
+    std::list<TrajectoryStep> trajectory;
+    double slope = 0.0;
+
+    while (start1 != start_trajectory.begin() || path_pos >= 0.0)
+    {
+      if (start1->path_pos_ <= path_pos)
+      {
+        trajectory.push_front(TrajectoryStep(path_pos, path_vel));
+        path_vel -= time_step_ * acceleration;
+        path_pos -= time_step_ * 0.5 * (path_vel + trajectory.front().path_vel_);
+        acceleration = getMinMaxPathAcceleration(path_pos, path_vel, false);
+        slope = (trajectory.front().path_vel_ - path_vel) / (trajectory.front().path_pos_ - path_pos);
+
+        if (path_vel < 0.0)
+        {
+          valid_ = false;
+          logError("Error while integrating backward: Negative path velocity");
+          return;
+        }
+      }
+      else
+      {
+        --start1;
+        --start2;
+      }
+
+      // check for an intersection between the current segments of the start trajectory and the backward trajectory
+      const double start_slope = (start2->path_vel_ - start1->path_vel_) / (start2->path_pos_ - start1->path_pos_);
+      const double intersection_path_pos = (start1->path_vel_ - path_vel + slope * path_pos - start_slope * start1->path_pos_) / (slope - start_slope);
+      if (std::max(start1->path_pos_, path_pos) - EPS <= intersection_path_pos &&
+          intersection_path_pos <= EPS + std::min(start2->path_pos_, trajectory.front().path_pos_))
+      {
+        const double intersection_path_vel = start1->path_vel_ + start_slope * (intersection_path_pos - start1->path_pos_);
+        start_trajectory.erase(start2, start_trajectory.end());
+        start_trajectory.push_back(TrajectoryStep(intersection_path_pos, intersection_path_vel));
+        start_trajectory.splice(start_trajectory.end(), trajectory);
+        return;
+      }
+    }
+
+    valid_ = false;
+    logError("Error while integrating backward: Did not hit start trajectory");
+  }
+
+  double getMinMaxPathAcceleration(double path_pos, double path_vel, bool max) const
+  {
+    const Eigen::VectorXd config_deriv = path_.getTangent(path_pos);
+    const Eigen::VectorXd config_deriv2 = path_.getCurvature(path_pos);
+    const double factor = max ? 1.0 : -1.0;
+    double max_path_acceleration = std::numeric_limits<double>::max();
+    for (unsigned int i = 0 ; i < joint_num_ ; ++i)
+      if (config_deriv[i] != 0.0)
+        max_path_acceleration = std::min(max_path_acceleration, max_acceleration_[i] / std::abs(config_deriv[i]) -
+                                         factor * config_deriv2[i] * path_vel * path_vel / config_deriv[i]);
+    return factor * max_path_acceleration;
+  }
+
+  double getMinMaxPhaseSlope(double path_pos, double path_vel, bool max) const
+  {
+    return getMinMaxPathAcceleration(path_pos, path_vel, max) / path_vel;
+  }
+
+  // the highest path velocity at which the acceleration limits can still be respected
+  double getAccelerationMaxPathVelocity(double path_pos) const
+  {
+    double max_path_velocity = std::numeric_limits<double>::infinity();
+    const Eigen::VectorXd config_deriv = path_.getTangent(path_pos);
+    const Eigen::VectorXd config_deriv2 = path_.getCurvature(path_pos);
+    for (unsigned int i = 0 ; i < joint_num_ ; ++i)
+    {
+      if (config_deriv[i] != 0.0)
+      {
+        for (unsigned int j = i + 1 ; j < joint_num_ ; ++j)
+          if (config_deriv[j] != 0.0)
+          {
+            const double a_ij = config_deriv2[i] / config_deriv[i] - config_deriv2[j] / config_deriv[j];
+            if (a_ij != 0.0)
+              max_path_velocity = std::min(max_path_velocity,
+                                           sqrt((max_acceleration_[i] / std::abs(config_deriv[i]) +
+                                                 max_acceleration_[j] / std::abs(config_deriv[j])) / std::abs(a_ij)));
+          }
+      }
+      else
+        if (config_deriv2[i] != 0.0)
+          max_path_velocity = std::min(max_path_velocity, sqrt(max_acceleration_[i] / std::abs(config_deriv2[i])));
+    }
+    return max_path_velocity;
+  }
+
+  // the highest path velocity that respects the velocity limits
+  double getVelocityMaxPathVelocity(double path_pos) const
+  {
+    const Eigen::VectorXd tangent = path_.getTangent(path_pos);
+    double max_path_velocity = std::numeric_limits<double>::max();
+    for (unsigned int i = 0 ; i < joint_num_ ; ++i)
+      max_path_velocity = std::min(max_path_velocity, max_velocity_[i] / std::abs(tangent[i]));
+    return max_path_velocity;
+  }
+
+  double getAccelerationMaxPathVelocityDeriv(double path_pos) const
+  {
+    return (getAccelerationMaxPathVelocity(path_pos + EPS) - getAccelerationMaxPathVelocity(path_pos - EPS)) / (2.0 * EPS);
+  }
+
+  double getVelocityMaxPathVelocityDeriv(double path_pos) const
+  {
+    const Eigen::VectorXd tangent = path_.getTangent(path_pos);
+    double max_path_velocity = std::numeric_limits<double>::max();
+    unsigned int active_constraint = 0;
+    for (unsigned int i = 0 ; i < joint_num_ ; ++i)
+    {
+      const double this_max_path_velocity = max_velocity_[i] / std::abs(tangent[i]);
+      if (this_max_path_velocity < max_path_velocity)
+      {
+        max_path_velocity = this_max_path_velocity;
+        active_constraint = i;
+      }
+    }
+    return -(max_velocity_[active_constraint] * path_.getCurvature(path_pos)[active_constraint]) /
+      (tangent[active_constraint] * std::abs(tangent[active_constraint]));
+  }
+
+  std::list<TrajectoryStep>::const_iterator getTrajectorySegment(double time) const
+  {
+    if (time >= trajectory_.back().time_)
+    {
+      std::list<TrajectoryStep>::const_iterator last = trajectory_.end();
+      --last;
+      return last;
+    }
+    std::list<TrajectoryStep>::const_iterator it = trajectory_.begin();
+    while (time >= it->time_)
+      ++it;
+    return it;
+  }
+
+  const Path &path_;
+  Eigen::VectorXd max_velocity_;
+  Eigen::VectorXd max_acceleration_;
+  unsigned int joint_num_;
+  bool valid_;
+  std::list<TrajectoryStep> trajectory_;
+  double time_step_;
+};
+
+}
+
+TimeOptimalTrajectoryGeneration::TimeOptimalTrajectoryGeneration(double path_tolerance, double resample_dt)
+  : path_tolerance_(path_tolerance),
+    resample_dt_(resample_dt)
+{}
+
+TimeOptimalTrajectoryGeneration::~TimeOptimalTrajectoryGeneration()
+{}
+
+bool TimeOptimalTrajectoryGeneration::computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory,
+                                                        const double max_velocity_scaling_factor,
+                                                        const double max_acceleration_scaling_factor) const
+{
+  if (trajectory.empty())
+    return true;
+
+  const robot_model::JointModelGroup *group = trajectory.getGroup();
+  if (!group)
+  {
+    logError("It looks like the planner did not set the group the plan was computed for");
+    return false;
+  }
+
+  double velocity_scaling_factor = 1.0;
+  if (max_velocity_scaling_factor > 0.0 && max_velocity_scaling_factor <= 1.0)
+    velocity_scaling_factor = max_velocity_scaling_factor;
+  else
+    if (max_velocity_scaling_factor == 0.0)
+      logDebug("A max_velocity_scaling_factor of 0.0 was specified, defaulting to %f instead.", velocity_scaling_factor);
+    else
+      logWarn("Invalid max_velocity_scaling_factor %f specified, defaulting to %f instead.", max_velocity_scaling_factor, velocity_scaling_factor);
+
+  double acceleration_scaling_factor = 1.0;
+  if (max_acceleration_scaling_factor > 0.0 && max_acceleration_scaling_factor <= 1.0)
+    acceleration_scaling_factor = max_acceleration_scaling_factor;
+  else
+    if (max_acceleration_scaling_factor == 0.0)
+      logDebug("A max_acceleration_scaling_factor of 0.0 was specified, defaulting to %f instead.", acceleration_scaling_factor);
+    else
+      logWarn("Invalid max_acceleration_scaling_factor %f specified, defaulting to %f instead.", max_acceleration_scaling_factor, acceleration_scaling_factor);
+
+  // the limits of the active joints come from their bounds
+  const std::vector<const robot_model::JointModel*> &joints = group->getActiveJointModels();
+  const std::size_t num_joints = joints.size();
+  Eigen::VectorXd max_velocity(num_joints);
+  Eigen::VectorXd max_acceleration(num_joints);
+  std::vector<int> idx(num_joints);
+  for (std::size_t j = 0 ; j < num_joints ; ++j)
+  {
+    if (joints[j]->getVariableCount() != 1)
+    {
+      logError("Time optimal parameterization only supports single-variable joints, but joint '%s' has %u variables",
+               joints[j]->getName().c_str(), (unsigned int)joints[j]->getVariableCount());
+      return false;
+    }
+    idx[j] = joints[j]->getFirstVariableIndex();
+
+    const robot_model::VariableBounds &b = joints[j]->getVariableBounds()[0];
+    max_velocity[j] = DEFAULT_VEL_MAX;
+    if (b.velocity_bounded_)
+      max_velocity[j] = std::min(fabs(b.max_velocity_), fabs(b.min_velocity_));
+    max_velocity[j] *= velocity_scaling_factor;
+    max_acceleration[j] = DEFAULT_ACCEL_MAX;
+    if (b.acceleration_bounded_)
+      max_acceleration[j] = std::min(fabs(b.max_acceleration_), fabs(b.min_acceleration_));
+    max_acceleration[j] *= acceleration_scaling_factor;
+  }
+
+  // this lib does not actually work properly when angles wrap around, so we need to unwind the path first
+  trajectory.unwind();
+
+  // consecutive duplicate waypoints would give segments of zero length
+  std::vector<Eigen::VectorXd> waypoints;
+  waypoints.reserve(trajectory.getWayPointCount());
+  for (std::size_t i = 0 ; i < trajectory.getWayPointCount() ; ++i)
+  {
+    const robot_state::RobotState &st = trajectory.getWayPoint(i);
+    Eigen::VectorXd point(num_joints);
+    for (std::size_t j = 0 ; j < num_joints ; ++j)
+      point[j] = st.getVariablePosition(idx[j]);
+    if (waypoints.empty() || (point - waypoints.back()).norm() > EPS)
+      waypoints.push_back(point);
+  }
+
+  robot_state::RobotState reference = trajectory.getFirstWayPoint();
+  if (waypoints.size() == 1)
+  {
+    // nothing to parameterize; the robot stays where it is
+    trajectory.clear();
+    const std::vector<int> &group_idx = group->getVariableIndexList();
+    for (std::size_t j = 0 ; j < group_idx.size() ; ++j)
+    {
+      reference.setVariableVelocity(group_idx[j], 0.0);
+      reference.setVariableAcceleration(group_idx[j], 0.0);
+    }
+    trajectory.addSuffixWayPoint(reference, 0.0);
+    return true;
+  }
+
+  Path path(waypoints, path_tolerance_);
+  PhasePlaneTrajectory parameterized(path, max_velocity, max_acceleration);
+  if (!parameterized.isValid())
+  {
+    logError("Unable to parameterize trajectory");
+    return false;
+  }
+
+  // sample the result at regular intervals
+  const double duration = parameterized.getDuration();
+  const std::size_t sample_count = std::max<std::size_t>(1, (std::size_t)ceil(duration / resample_dt_));
+  Eigen::VectorXd position, velocity, acceleration;
+  const std::vector<const robot_model::JointModel*> &mimic = group->getMimicJointModels();
+  trajectory.clear();
+  double last_t = 0.0;
+  for (std::size_t sample = 0 ; sample <= sample_count ; ++sample)
+  {
+    const double t = std::min(duration, sample * resample_dt_);
+    parameterized.getState(t, position, velocity, acceleration);
+    robot_state::RobotStatePtr st(new robot_state::RobotState(reference));
+    st->setJointGroupActivePositions(group, position);
+    for (std::size_t j = 0 ; j < num_joints ; ++j)
+    {
+      st->setVariableVelocity(idx[j], velocity[j]);
+      st->setVariableAcceleration(idx[j], acceleration[j]);
+    }
+    // the derivatives of the mimic joints scale with those of the joints they follow
+    for (std::size_t j = 0 ; j < mimic.size() ; ++j)
+    {
+      const int src = mimic[j]->getMimic()->getFirstVariableIndex();
+      const int dst = mimic[j]->getFirstVariableIndex();
+      st->setVariableVelocity(dst, mimic[j]->getMimicFactor() * st->getVariableVelocity(src));
+      st->setVariableAcceleration(dst, mimic[j]->getMimicFactor() * st->getVariableAcceleration(src));
+    }
+    trajectory.addSuffixWayPoint(st, t - last_t);
+    last_t = t;
+  }
+
+  return true;
+}
+
+}
@@ -0,0 +1,379 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt! contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <moveit/trajectory_processing/iterative_time_parameterization.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <moveit/robot_trajectory/compact_robot_trajectory.h>
+#include <urdf_parser/urdf_parser.h>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <boost/filesystem/path.hpp>
+#include <moveit_resources/config.h>
+
+class LoadPlanningModelsPr2 : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    boost::filesystem::path res_path(MOVEIT_TEST_RESOURCES_DIR);
+
+    srdf_model.reset(new srdf::Model());
+    std::string xml_string;
+    std::fstream xml_file((res_path / "pr2_description/urdf/robot.xml").string().c_str(), std::fstream::in);
+    if (xml_file.is_open())
+    {
+      while (xml_file.good())
+      {
+        std::string line;
+        std::getline(xml_file, line);
+        xml_string += (line + "\n");
+      }
+      xml_file.close();
+      urdf_model = urdf::parseURDF(xml_string);
+    }
+    srdf_model->initFile(*urdf_model, (res_path / "pr2_description/srdf/robot.xml").string());
+    robot_model.reset(new moveit::core::RobotModel(urdf_model, srdf_model));
+  };
+
+  virtual void TearDown()
+  {
+  }
+
+  // a path through random states of the right arm, with steps small enough for the continuous joints
+  void makeTrajectory(robot_trajectory::RobotTrajectory &trajectory, std::size_t count)
+  {
+    const robot_model::JointModelGroup *jmg = robot_model->getJointModelGroup("right_arm");
+    robot_state::RobotState from(robot_model), to(robot_model), st(robot_model);
+    from.setToDefaultValues();
+    to.setToDefaultValues();
+    to.setToRandomPositions(jmg);
+    for (std::size_t i = 0 ; i < count ; ++i)
+    {
+      from.interpolate(to, (double)i / (double)(count - 1), st);
+      trajectory.addSuffixWayPoint(st, 0.0);
+    }
+  }
+
+  // a path through several random states of the right arm, each leg sampled densely
+  void makeWaypointTrajectory(robot_trajectory::RobotTrajectory &trajectory, std::size_t legs, std::size_t count)
+  {
+    const robot_model::JointModelGroup *jmg = robot_model->getJointModelGroup("right_arm");
+    robot_state::RobotState from(robot_model), to(robot_model), st(robot_model);
+    from.setToDefaultValues();
+    to.setToDefaultValues();
+    for (std::size_t k = 0 ; k < legs ; ++k)
+    {
+      to.setToRandomPositions(jmg);
+      for (std::size_t i = k == 0 ? 0 : 1 ; i < count ; ++i)
+      {
+        from.interpolate(to, (double)i / (double)(count - 1), st);
+        trajectory.addSuffixWayPoint(st, 0.0);
+      }
+      from = to;
+    }
+  }
+
+protected:
+
+  robot_model::RobotModelPtr robot_model;
+  boost::shared_ptr<urdf::ModelInterface> urdf_model;
+  boost::shared_ptr<srdf::Model> srdf_model;
+};
+
+TEST_F(LoadPlanningModelsPr2, CompactTrajectoryConversion)
+{
+  robot_trajectory::RobotTrajectory trajectory(robot_model, "right_arm");
+  makeTrajectory(trajectory, 20);
+
+  robot_trajectory::CompactRobotTrajectory compact(trajectory);
+  ASSERT_EQ(trajectory.getWayPointCount(), compact.getWayPointCount());
+  EXPECT_EQ(trajectory.getGroup()->getVariableCount(), compact.getVariableCount());
+  EXPECT_FALSE(compact.hasVelocities());
+
+  moveit_msgs::RobotTrajectory msg1, msg2;
+  trajectory.getRobotTrajectoryMsg(msg1);
+  compact.getRobotTrajectoryMsg(msg2);
+  ASSERT_EQ(msg1.joint_trajectory.joint_names, msg2.joint_trajectory.joint_names);
+  ASSERT_EQ(msg1.joint_trajectory.points.size(), msg2.joint_trajectory.points.size());
+  for (std::size_t i = 0 ; i < msg1.joint_trajectory.points.size() ; ++i)
+    for (std::size_t j = 0 ; j < msg1.joint_trajectory.joint_names.size() ; ++j)
+      EXPECT_NEAR(msg1.joint_trajectory.points[i].positions[j], msg2.joint_trajectory.points[i].positions[j], 1e-12);
+
+  // read the message back and materialize states from it
+  robot_trajectory::CompactRobotTrajectory compact2(robot_model, trajectory.getGroup(), trajectory.getFirstWayPoint());
+  compact2.setRobotTrajectoryMsg(msg2);
+  ASSERT_EQ(compact.getWayPointCount(), compact2.getWayPointCount());
+  EXPECT_TRUE(compact.getPositions().isApprox(compact2.getPositions()));
+
+  for (std::size_t i = 0 ; i < trajectory.getWayPointCount() ; ++i)
+  {
+    robot_state::RobotStatePtr st = compact2.materializeWayPoint(i);
+    EXPECT_TRUE(st->distance(trajectory.getWayPoint(i)) < 1e-12);
+    EXPECT_TRUE(st->getGlobalLinkTransform("r_gripper_palm_link").isApprox(trajectory.getWayPoint(i).getGlobalLinkTransform("r_gripper_palm_link")));
+  }
+
+  robot_trajectory::RobotTrajectory trajectory2(robot_model, "");
+  compact2.getRobotTrajectory(trajectory2);
+  EXPECT_EQ(trajectory.getGroupName(), trajectory2.getGroupName());
+  EXPECT_EQ(trajectory.getWayPointCount(), trajectory2.getWayPointCount());
+}
+
+TEST_F(LoadPlanningModelsPr2, CompactTimeParameterization)
+{
+  robot_trajectory::RobotTrajectory trajectory(robot_model, "right_arm");
+  makeTrajectory(trajectory, 2000);
+  robot_trajectory::CompactRobotTrajectory compact(trajectory);
+
+  trajectory_processing::IterativeParabolicTimeParameterization iptp;
+  EXPECT_TRUE(iptp.computeTimeStamps(trajectory));
+  EXPECT_TRUE(iptp.computeTimeStamps(compact));
+
+  // both representations must give the same timing
+  ASSERT_TRUE(compact.hasVelocities());
+  ASSERT_TRUE(compact.hasAccelerations());
+  const std::vector<int> &idx = trajectory.getGroup()->getVariableIndexList();
+  for (std::size_t i = 0 ; i < trajectory.getWayPointCount() ; ++i)
+  {
+    EXPECT_NEAR(trajectory.getWayPointDurationFromPrevious(i), compact.getWayPointDurationFromPrevious(i), 1e-12);
+    const double *vel = compact.getWayPointVelocities(i);
+    const double *acc = compact.getWayPointAccelerations(i);
+    for (std::size_t j = 0 ; j < idx.size() ; ++j)
+    {
+      EXPECT_NEAR(trajectory.getWayPoint(i).getVariableVelocity(idx[j]), vel[j], 1e-12);
+      EXPECT_NEAR(trajectory.getWayPoint(i).getVariableAcceleration(idx[j]), acc[j], 1e-12);
+    }
+  }
+
+  moveit_msgs::RobotTrajectory msg;
+  compact.getRobotTrajectoryMsg(msg);
+  ASSERT_EQ(compact.getWayPointCount(), msg.joint_trajectory.points.size());
+  EXPECT_NEAR(compact.getWaypointDurationFromStart(compact.getWayPointCount() - 1),
+              msg.joint_trajectory.points.back().time_from_start.toSec(), 1e-9);
+  EXPECT_EQ(msg.joint_trajectory.joint_names.size(), msg.joint_trajectory.points.back().velocities.size());
+}
+
+// Durations and velocities computed by the iterative parabolic time parameterization before it was changed to
+// work on contiguous position arrays, for a fixed path of the right arm with the limits set in setGoldenLimits()
+static const std::size_t GOLDEN_WAYPOINTS = 8;
+static const std::size_t GOLDEN_VARIABLES = 7;
+static const char *GOLDEN_JOINTS[GOLDEN_VARIABLES] = {
+  "r_shoulder_pan_joint", "r_shoulder_lift_joint", "r_upper_arm_roll_joint", "r_elbow_flex_joint",
+  "r_forearm_roll_joint", "r_wrist_flex_joint", "r_wrist_roll_joint" };
+static const double GOLDEN_MAX_VELOCITY[GOLDEN_VARIABLES] = { 2.0, 2.0, 3.0, 3.0, 3.5, 3.0, 3.5 };
+static const double GOLDEN_MAX_ACCELERATION[GOLDEN_VARIABLES] = { 1.5, 1.5, 2.0, 2.0, 2.5, 2.5, 2.5 };
+static const double GOLDEN_POSITIONS[GOLDEN_WAYPOINTS][GOLDEN_VARIABLES] = {
+  { 0.0, 0.0, 0.0, -0.5, 0.0, -0.5, 0.0 },
+  { 0.1, 0.05, -0.1, -0.6, 0.2, -0.5, 0.3 },
+  { 0.3, 0.15, -0.2, -0.8, 0.5, -0.6, 0.7 },
+  { 0.5, 0.3, -0.2, -1.1, 0.9, -0.8, 1.2 },
+  { 0.6, 0.4, -0.1, -1.2, 1.2, -1.0, 1.5 },
+  { 0.5, 0.45, 0.1, -1.0, 1.3, -1.1, 1.4 },
+  { 0.3, 0.4, 0.2, -0.7, 1.2, -1.0, 1.0 },
+  { 0.2, 0.3, 0.2, -0.6, 1.0, -0.9, 0.8 } };
+
+// full velocity and acceleration limits
+static const double GOLDEN_DURATIONS[GOLDEN_WAYPOINTS - 1] = {
+  0.495714285714286, 0.26919585714285726, 0.312857142857143, 0.40571428571428597,
+  0.39883194468933353, 0.3411521025556028, 0.40629708628571448 };
+static const double GOLDEN_VELOCITIES[GOLDEN_WAYPOINTS][GOLDEN_VARIABLES] = {
+  { 0, 0, 0, 0, 0, 0, 0 },
+  { 0.47234129542063802, 0.23617064771031901, -0.28660292436737955, -0.47234129542063819, 0.75894421978801752, -0.18573837105325849, 1.045547144155397 },
+  { 0.69111144530286395, 0.42546439845051864, -0.18573837105325855, -0.85092879690103762, 1.1964845195524694, -0.50537307424960554, 1.5420402422039015 },
+  { 0.4428741398160651, 0.36296546401697843, 0.12323943661971824, -0.6026914914142385, 1.0089877162518484, -0.56611357643578342, 1.1688050678500219 },
+  { -0.0021266496875033125, 0.18592247977332904, 0.3739716092341614, 0.12749273599472496, 0.49508439616637623, -0.37184495954665808, 0.24435222355193312 },
+  { -0.41849047056541749, -0.010598052910938224, 0.39729436474354113, 0.69041874900173705, -0.021196105821876476, 0.021196105821876476, -0.71161485482361353 },
+  { -0.41618704379407856, -0.19634375560043163, 0.14656219212909799, 0.56274923592317661, -0.39268751120086332, 0.26962485166498074, -0.83237408758815701 },
+  { 0, 0, 0, 0, 0, 0, 0 } };
+
+// velocity and acceleration limits scaled by 0.5
+static const double GOLDEN_SCALED_DURATIONS[GOLDEN_WAYPOINTS - 1] = {
+  0.69142857142857184, 0.38200227420584204, 0.44571428571428584, 0.58142857142857174,
+  0.54333333333333367, 0.48517571428571443, 0.56428571428571461 };
+static const double GOLDEN_SCALED_VELOCITIES[GOLDEN_WAYPOINTS][GOLDEN_VARIABLES] = {
+  { 0, 0, 0, 0, 0, 0, 0 },
+  { 0.33409259582159573, 0.16704629791079786, -0.20320332270418628, -0.33409259582159578, 0.53729591852578207, -0.13088927311740944, 0.74049924122996824 },
+  { 0.48613752059379323, 0.29915850388664017, -0.13088927311740947, -0.59831700777328045, 0.84138576807017706, -0.35524824747638384, 1.0844545283670737 },
+  { 0.31035406035406021, 0.25426431676431671, 0.085995085995085957, -0.42253354753354733, 0.70670320670320641, -0.3963491463491462, 0.81888269388269364 },
+  { -0.006029453882214611, 0.13200735593373625, 0.27004416574968709, 0.098053993759515248, 0.35000979786255842, -0.2640147118674725, 0.16596071810795726 },
+  { -0.29813543342691284, -0.0055154534487527954, 0.28710452652940732, 0.49321542007901953, -0.011030906897505605, 0.011030906897505605, -0.50424632697652516 },
+  { -0.2947184884863211, -0.14013531832411191, 0.10305544677480616, 0.39777393526112725, -0.28027063664822383, 0.19166304171151505, -0.58943697697264208 },
+  { 0, 0, 0, 0, 0, 0, 0 } };
+
+TEST_F(LoadPlanningModelsPr2, IterativeParabolicGolden)
+{
+  const robot_model::JointModelGroup *jmg = robot_model->getJointModelGroup("right_arm");
+  ASSERT_EQ(GOLDEN_VARIABLES, jmg->getVariableCount());
+  // the order of the joints changes the order in which the time intervals are stretched
+  for (std::size_t j = 0 ; j < GOLDEN_VARIABLES ; ++j)
+    ASSERT_EQ(GOLDEN_JOINTS[j], jmg->getVariableNames()[j]);
+
+  // fixed limits, so the result does not depend on the robot description
+  for (std::size_t j = 0 ; j < GOLDEN_VARIABLES ; ++j)
+  {
+    robot_model::VariableBounds b = robot_model->getVariableBounds(GOLDEN_JOINTS[j]);
+    b.velocity_bounded_ = true;
+    b.max_velocity_ = GOLDEN_MAX_VELOCITY[j];
+    b.min_velocity_ = -GOLDEN_MAX_VELOCITY[j];
+    b.acceleration_bounded_ = true;
+    b.max_acceleration_ = GOLDEN_MAX_ACCELERATION[j];
+    b.min_acceleration_ = -GOLDEN_MAX_ACCELERATION[j];
+    robot_model->getJointModel(GOLDEN_JOINTS[j])->setVariableBounds(GOLDEN_JOINTS[j], b);
+  }
+
+  robot_trajectory::RobotTrajectory trajectory(robot_model, "right_arm");
+  robot_trajectory::RobotTrajectory scaled_trajectory(robot_model, "right_arm");
+  robot_state::RobotState st(robot_model);
+  st.setToDefaultValues();
+  for (std::size_t i = 0 ; i < GOLDEN_WAYPOINTS ; ++i)
+  {
+    st.setJointGroupPositions(jmg, GOLDEN_POSITIONS[i]);
+    trajectory.addSuffixWayPoint(st, 0.0);
+    scaled_trajectory.addSuffixWayPoint(st, 0.0);
+  }
+  robot_trajectory::CompactRobotTrajectory compact(trajectory);
+
+  trajectory_processing::IterativeParabolicTimeParameterization iptp;
+  ASSERT_TRUE(iptp.computeTimeStamps(trajectory));
+  ASSERT_TRUE(iptp.computeTimeStamps(scaled_trajectory, 0.5, 0.5));
+  ASSERT_TRUE(iptp.computeTimeStamps(compact));
+
+  const std::vector<int> &idx = jmg->getVariableIndexList();
+  for (std::size_t i = 0 ; i < GOLDEN_WAYPOINTS ; ++i)
+  {
+    const double duration = i == 0 ? 0.0 : GOLDEN_DURATIONS[i - 1];
+    const double scaled_duration = i == 0 ? 0.0 : GOLDEN_SCALED_DURATIONS[i - 1];
+    EXPECT_NEAR(duration, trajectory.getWayPointDurationFromPrevious(i), 1e-9) << i;
+    EXPECT_NEAR(duration, compact.getWayPointDurationFromPrevious(i), 1e-9) << i;
+    EXPECT_NEAR(scaled_duration, scaled_trajectory.getWayPointDurationFromPrevious(i), 1e-9) << i;
+    for (std::size_t j = 0 ; j < GOLDEN_VARIABLES ; ++j)
+    {
+      EXPECT_NEAR(GOLDEN_VELOCITIES[i][j], trajectory.getWayPoint(i).getVariableVelocity(idx[j]), 1e-9) << i << ' ' << j;
+      EXPECT_NEAR(GOLDEN_VELOCITIES[i][j], compact.getWayPointVelocities(i)[j], 1e-9) << i << ' ' << j;
+      EXPECT_NEAR(GOLDEN_SCALED_VELOCITIES[i][j], scaled_trajectory.getWayPoint(i).getVariableVelocity(idx[j]), 1e-9) << i << ' ' << j;
+    }
+  }
+}
+
+// the positions of the active joints of the group at every waypoint
+static std::vector<Eigen::VectorXd> getActivePositions(const robot_trajectory::RobotTrajectory &trajectory)
+{
+  const std::vector<const robot_model::JointModel*> &joints = trajectory.getGroup()->getActiveJointModels();
+  std::vector<Eigen::VectorXd> points(trajectory.getWayPointCount(), Eigen::VectorXd(joints.size()));
+  for (std::size_t i = 0 ; i < trajectory.getWayPointCount() ; ++i)
+    for (std::size_t j = 0 ; j < joints.size() ; ++j)
+      points[i][j] = trajectory.getWayPoint(i).getVariablePosition(joints[j]->getFirstVariableIndex());
+  return points;
+}
+
+// the joint space distance from a point to the polyline through the given points
+static double distanceToPolyline(const Eigen::VectorXd &point, const std::vector<Eigen::VectorXd> &polyline)
+{
+  double distance = (point - polyline[0]).norm();
+  for (std::size_t i = 1 ; i < polyline.size() ; ++i)
+  {
+    const Eigen::VectorXd segment = polyline[i] - polyline[i - 1];
+    const double length_sq = segment.squaredNorm();
+    double t = length_sq > 0.0 ? (point - polyline[i - 1]).dot(segment) / length_sq : 0.0;
+    t = std::max(0.0, std::min(1.0, t));
+    distance = std::min(distance, (polyline[i - 1] + t * segment - point).norm());
+  }
+  return distance;
+}
+
+TEST_F(LoadPlanningModelsPr2, TimeOptimalParameterization)
+{
+  static const double PATH_TOLERANCE = 0.1;
+  // the limits time optimal parameterization uses for joints without bounds
+  static const double DEFAULT_MAX_VELOCITY = 1.0;
+  static const double DEFAULT_MAX_ACCELERATION = 1.0;
+
+  robot_trajectory::RobotTrajectory trajectory(robot_model, "right_arm");
+  makeWaypointTrajectory(trajectory, 5, 50);
+  // both parameterizations unwind the continuous joints; do it here so the input is compared in the same frame
+  trajectory.unwind();
+  robot_state::RobotState first = trajectory.getFirstWayPoint();
+  robot_state::RobotState last = trajectory.getLastWayPoint();
+  const std::vector<Eigen::VectorXd> input = getActivePositions(trajectory);
+
+  robot_trajectory::RobotTrajectory iterative_trajectory(robot_model, "right_arm");
+  for (std::size_t i = 0 ; i < trajectory.getWayPointCount() ; ++i)
+    iterative_trajectory.addSuffixWayPoint(trajectory.getWayPoint(i), 0.0);
+  trajectory_processing::IterativeParabolicTimeParameterization iptp;
+  ASSERT_TRUE(iptp.computeTimeStamps(iterative_trajectory));
+
+  trajectory_processing::TimeOptimalTrajectoryGeneration totg(PATH_TOLERANCE);
+  ASSERT_TRUE(totg.computeTimeStamps(trajectory));
+  const double duration = trajectory.getWaypointDurationFromStart(trajectory.getWayPointCount() - 1);
+  EXPECT_GT(duration, 0.0);
+
+  // the same path with the same limits cannot take longer than with iterative parabolic parameterization
+  EXPECT_LE(duration, iterative_trajectory.getWaypointDurationFromStart(iterative_trajectory.getWayPointCount() - 1));
+
+  // the result starts and ends at rest, at the same states as the input
+  ASSERT_GE(trajectory.getWayPointCount(), 2u);
+  const robot_model::JointModelGroup *jmg = trajectory.getGroup();
+  EXPECT_LT(trajectory.getFirstWayPoint().distance(first, jmg), 1e-6);
+  EXPECT_LT(trajectory.getLastWayPoint().distance(last, jmg), 1e-6);
+
+  // the blends only cut the corners of the path by up to the tolerance; the samples are connected by straight
+  // segments, which lie slightly inside the blends
+  const std::vector<Eigen::VectorXd> output = getActivePositions(trajectory);
+  for (std::size_t i = 1 ; i + 1 < input.size() ; ++i)
+    EXPECT_LE(distanceToPolyline(input[i], output), PATH_TOLERANCE + 1e-2) << i;
+
+  const std::vector<const robot_model::JointModel*> &joints = jmg->getActiveJointModels();
+  for (std::size_t j = 0 ; j < joints.size() ; ++j)
+  {
+    const int index = joints[j]->getFirstVariableIndex();
+    EXPECT_NEAR(0.0, trajectory.getFirstWayPoint().getVariableVelocity(index), 1e-6);
+    EXPECT_NEAR(0.0, trajectory.getLastWayPoint().getVariableVelocity(index), 1e-6);
+
+    const robot_model::VariableBounds &b = joints[j]->getVariableBounds()[0];
+    const double max_velocity = b.velocity_bounded_ ? std::min(fabs(b.max_velocity_), fabs(b.min_velocity_)) : DEFAULT_MAX_VELOCITY;
+    const double max_acceleration = b.acceleration_bounded_ ?
+      std::min(fabs(b.max_acceleration_), fabs(b.min_acceleration_)) : DEFAULT_MAX_ACCELERATION;
+    for (std::size_t i = 0 ; i < trajectory.getWayPointCount() ; ++i)
+    {
+      EXPECT_LE(fabs(trajectory.getWayPoint(i).getVariableVelocity(index)), max_velocity + 1e-3) << i << ' ' << j;
+      EXPECT_LE(fabs(trajectory.getWayPoint(i).getVariableAcceleration(index)), max_acceleration + 1e-3) << i << ' ' << j;
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -67,6 +67,7 @@ struct GroupStateRepresentation {
       (*attached_body_decompositions_[i]) = (*gsr.attached_body_decompositions_[i]);
     }
     gradients_ = gsr.gradients_;
+    spheres_ = gsr.spheres_;
   }
 
   /** dfce used to generate this GSR */
@@ -82,6 +83,10 @@ struct GroupStateRepresentation {
    * detection.  One entry for each link and one entry for each attached
    * object. */
   std::vector<GradientInfo> gradients_;
+  /** the posed spheres of all links and attached bodies, in the same order as
+   * gradients_; links without geometry are present with no spheres.  This is
+   * the layout the collision checks run on. */
+  PackedSphereSet spheres_;
 };
 
 /** collision volume representation for a particular link group of a robot
@@ -390,6 +390,131 @@ typedef boost::shared_ptr<const PosedBodySphereDecompositionVector> PosedBodySph
 typedef boost::shared_ptr<PosedBodyPointDecompositionVector> PosedBodyPointDecompositionVectorPtr;
 typedef boost::shared_ptr<const PosedBodyPointDecompositionVector> PosedBodyPointDecompositionVectorConstPtr;
 
+/** \brief The posed collision spheres of a set of objects (links or attached bodies), stored as a structure of arrays.
+ *
+ * The coordinates and radii of all spheres are kept in separate contiguous arrays, so the loops over them can be
+ * vectorized by the compiler.  Every object also keeps a bounding sphere of its spheres, so objects can be rejected
+ * as a whole before any of their spheres is looked at.  Since the spheres of an object move rigidly, the bounding
+ * radius is computed when the object is added and only the center is updated afterwards.
+ */
+class PackedSphereSet
+{
+public:
+
+  PackedSphereSet()
+  {
+    object_begin_.push_back(0);
+  }
+
+  void clear();
+
+  /** \brief Add an object made of the given spheres; returns the index of the object. Objects without spheres are allowed. */
+  unsigned int addObject(const EigenSTL::vector_Vector3d& centers, const std::vector<double>& radii);
+
+  /** \brief Overwrite the centers of all the spheres of \e object and move its bounding sphere along */
+  void setSphereCenters(unsigned int object, const EigenSTL::vector_Vector3d& centers);
+
+  unsigned int getObjectCount() const {
+    return object_begin_.size() - 1;
+  }
+
+  std::size_t getSphereCount() const {
+    return radius_.size();
+  }
+
+  std::size_t getObjectBegin(unsigned int object) const {
+    return object_begin_[object];
+  }
+
+  std::size_t getObjectEnd(unsigned int object) const {
+    return object_begin_[object + 1];
+  }
+
+  const double* getX() const {
+    return &x_[0];
+  }
+
+  const double* getY() const {
+    return &y_[0];
+  }
+
+  const double* getZ() const {
+    return &z_[0];
+  }
+
+  const double* getRadii() const {
+    return &radius_[0];
+  }
+
+  Eigen::Vector3d getSphereCenter(std::size_t sphere) const {
+    return Eigen::Vector3d(x_[sphere], y_[sphere], z_[sphere]);
+  }
+
+  Eigen::Vector3d getBoundingSphereCenter(unsigned int object) const {
+    return Eigen::Vector3d(bound_x_[object], bound_y_[object], bound_z_[object]);
+  }
+
+  /** \brief The radius of the bounding sphere of \e object, including the radii of its spheres */
+  double getBoundingSphereRadius(unsigned int object) const {
+    return bound_radius_[object];
+  }
+
+  /** \brief Return the largest distance any sphere center moves between \e other and this set */
+  double getMaximumDisplacement(const PackedSphereSet& other) const;
+
+  /** \brief Return the smallest radius of any sphere in the set, or 0 if there are none */
+  double getMinimumRadius() const;
+
+private:
+
+  void updateBoundingSphereCenter(unsigned int object);
+
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> z_;
+  std::vector<double> radius_;
+  std::vector<std::size_t> object_begin_;
+  std::vector<double> bound_x_;
+  std::vector<double> bound_y_;
+  std::vector<double> bound_z_;
+  std::vector<double> bound_radius_;
+};
+
+/** \brief Check the spheres of one object of \e spheres against a distance field. This gives the same answers as
+ * getCollisionSphereCollision(), but only looks up distances (not gradients), and skips the object entirely
+ * when the distance at the center of its bounding sphere shows that none of its spheres can be in collision.
+ * The indices returned in \e colls are relative to the first sphere of the object. */
+bool getPackedSphereCollision(const distance_field::DistanceField* distance_field,
+                              const PackedSphereSet& spheres,
+                              unsigned int object,
+                              double maximum_value,
+                              double tolerance,
+                              unsigned int num_coll,
+                              std::vector<unsigned int>& colls);
+
+/** \brief Same as getCollisionSphereGradients(), for the spheres of one object of \e spheres */
+bool getPackedSphereGradients(const distance_field::DistanceField* distance_field,
+                              const PackedSphereSet& spheres,
+                              unsigned int object,
+                              GradientInfo& gradient,
+                              const CollisionType& type,
+                              double tolerance,
+                              bool subtract_radii,
+                              double maximum_value,
+                              bool stop_at_first_collision);
+
+/** \brief Return true if the bounding spheres of \e object1 in \e spheres1 and \e object2 in \e spheres2 intersect */
+bool doBoundingSpheresIntersect(const PackedSphereSet& spheres1, unsigned int object1,
+                                const PackedSphereSet& spheres2, unsigned int object2);
+
+/** \brief Find pairs of intersecting spheres between two objects; at most \e max_pairs pairs are reported (at
+ * least one pair is always looked for). The indices are relative to the first sphere of each object.
+ * @return True if any pair of spheres intersects */
+bool getPackedSpherePairCollisions(const PackedSphereSet& spheres1, unsigned int object1,
+                                   const PackedSphereSet& spheres2, unsigned int object2,
+                                   unsigned int max_pairs,
+                                   std::vector<std::pair<unsigned int, unsigned int> >& pairs);
+
 struct ProximityInfo 
 { 
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -53,6 +53,7 @@ static const bool DEFAULT_USE_SIGNED_DISTANCE_FIELD = false;
 static const double DEFAULT_RESOLUTION = .02;
 static const double DEFAULT_COLLISION_TOLERANCE = 0.0;
 static const double DEFAULT_MAX_PROPOGATION_DISTANCE = .25;
+static const unsigned int MAX_CONTINUOUS_COLLISION_STEPS = 100; // upper bound on the samples of a continuous check
 
 class CollisionRobotDistanceField : public CollisionRobot
 {
@@ -106,51 +107,42 @@ public:
                           const collision_detection::AllowedCollisionMatrix &acm,
                           boost::shared_ptr<GroupStateRepresentation>& gsr) const;
 
+  /** \brief Check for self collision along the motion from \e state1 to \e state2. The motion is sampled so that no
+      collision sphere moves by more than the smallest sphere radius between samples (up to
+      MAX_CONTINUOUS_COLLISION_STEPS samples); the spheres are posed from states interpolated in joint space. Only the joints of \e req.group_name may differ between the two states; otherwise only the two states
+      themselves are checked. */
   virtual void checkSelfCollision(const collision_detection::CollisionRequest &req, 
                                   collision_detection::CollisionResult &res, 
                                   const robot_state::RobotState &state1, 
-                                  const robot_state::RobotState &state2) const
-  {
-    logWarn("Not implemented");
-  };
+                                  const robot_state::RobotState &state2) const;
   
   virtual void checkSelfCollision(const collision_detection::CollisionRequest &req, 
                                   collision_detection::CollisionResult &res, 
                                   const robot_state::RobotState &state1, 
                                   const robot_state::RobotState &state2, 
-                                  const collision_detection::AllowedCollisionMatrix &acm) const
-  {
-    logWarn("Not implemented");
-  };
+                                  const collision_detection::AllowedCollisionMatrix &acm) const;
   
+  /** \brief Check for collisions between the spheres of this robot and those of \e other_robot, which needs to be
+      a CollisionRobotDistanceField as well */
   virtual void checkOtherCollision(const collision_detection::CollisionRequest &req, 
                                    collision_detection::CollisionResult &res, 
                                    const robot_state::RobotState &state,
                                    const CollisionRobot &other_robot, 
-                                   const robot_state::RobotState &other_state) const
-  {
-    logWarn("Not implemented");
-  };
+                                   const robot_state::RobotState &other_state) const;
 
   virtual void checkOtherCollision(const collision_detection::CollisionRequest &req, 
                                    collision_detection::CollisionResult &res, 
                                    const robot_state::RobotState &state,
                                    const CollisionRobot &other_robot, 
                                    const robot_state::RobotState &other_state,
-                                   const collision_detection::AllowedCollisionMatrix &acm) const
-  {
-    logWarn("Not implemented");
-  };
+                                   const collision_detection::AllowedCollisionMatrix &acm) const;
 
   virtual void checkOtherCollision(const collision_detection::CollisionRequest &req, collision_detection::CollisionResult &res, 
                                    const robot_state::RobotState &state1, 
                                    const robot_state::RobotState &state2,
                                    const CollisionRobot &other_robot, 
                                    const robot_state::RobotState &other_state1, 
-                                   const robot_state::RobotState &other_state2) const
-  {
-    logWarn("Not implemented");
-  };
+                                   const robot_state::RobotState &other_state2) const;
 
   virtual void checkOtherCollision(const collision_detection::CollisionRequest &req, 
                                    collision_detection::CollisionResult &res, 
@@ -159,10 +151,7 @@ public:
                                    const CollisionRobot &other_robot, 
                                    const robot_state::RobotState &other_state1, 
                                    const robot_state::RobotState &other_state2,
-                                   const collision_detection::AllowedCollisionMatrix &acm) const
-  {
-    logWarn("Not implemented");
-  };
+                                   const collision_detection::AllowedCollisionMatrix &acm) const;
   
   virtual double distanceSelf(const robot_state::RobotState &state) const
   {
@@ -211,6 +200,32 @@ protected:
                                 const collision_detection::AllowedCollisionMatrix *acm,
                                 boost::shared_ptr<GroupStateRepresentation>& gsr) const;
 
+  void checkSelfCollisionHelper(const collision_detection::CollisionRequest& req,
+                                collision_detection::CollisionResult& res,
+                                const robot_state::RobotState& state1,
+                                const robot_state::RobotState& state2,
+                                const collision_detection::AllowedCollisionMatrix *acm) const;
+
+  /** \brief Check against \e other_robot; the check is continuous if \e state2 and \e other_state2 are given
+      and discrete (only \e state1 against \e other_state1) if both are NULL */
+  void checkOtherCollisionHelper(const collision_detection::CollisionRequest& req,
+                                 collision_detection::CollisionResult& res,
+                                 const robot_state::RobotState& state1,
+                                 const robot_state::RobotState* state2,
+                                 const CollisionRobot& other_robot,
+                                 const robot_state::RobotState& other_state1,
+                                 const robot_state::RobotState* other_state2,
+                                 const collision_detection::AllowedCollisionMatrix *acm) const;
+
+  /** \brief Pose the spheres of all the links with geometry and all attached bodies, one object per link or body */
+  void getRobotSpheres(const robot_state::RobotState& state,
+                       PackedSphereSet& spheres,
+                       std::vector<std::string>& names,
+                       std::vector<collision_detection::BodyType>& types) const;
+
+  /** \brief Rebuild the packed spheres of \e gsr from its posed link and attached body decompositions */
+  void packGroupStateRepresentationSpheres(boost::shared_ptr<GroupStateRepresentation>& gsr) const;
+
   void updateGroupStateRepresentationState(const robot_state::RobotState& state,
                                            boost::shared_ptr<GroupStateRepresentation>& gsr) const;
 
@@ -230,6 +230,263 @@ bool collision_detection::doBoundingSpheresIntersect(const PosedBodySphereDecomp
   return false;
 }
 
+///
+/// PackedSphereSet
+///
+
+void collision_detection::PackedSphereSet::clear()
+{
+  x_.clear();
+  y_.clear();
+  z_.clear();
+  radius_.clear();
+  object_begin_.assign(1, 0);
+  bound_x_.clear();
+  bound_y_.clear();
+  bound_z_.clear();
+  bound_radius_.clear();
+}
+
+unsigned int collision_detection::PackedSphereSet::addObject(const EigenSTL::vector_Vector3d& centers,
+                                                             const std::vector<double>& radii)
+{
+  for(unsigned int i = 0; i < centers.size(); i++) {
+    x_.push_back(centers[i].x());
+    y_.push_back(centers[i].y());
+    z_.push_back(centers[i].z());
+    radius_.push_back(radii[i]);
+  }
+  object_begin_.push_back(radius_.size());
+  unsigned int object = object_begin_.size() - 2;
+  bound_x_.push_back(0.0);
+  bound_y_.push_back(0.0);
+  bound_z_.push_back(0.0);
+  updateBoundingSphereCenter(object);
+
+  // the spheres of an object move rigidly, so the radius only needs to be computed once
+  double radius = 0.0;
+  for(std::size_t i = object_begin_[object]; i < object_begin_[object + 1]; i++) {
+    double dx = x_[i] - bound_x_[object];
+    double dy = y_[i] - bound_y_[object];
+    double dz = z_[i] - bound_z_[object];
+    radius = std::max(radius, sqrt(dx*dx + dy*dy + dz*dz) + radius_[i]);
+  }
+  bound_radius_.push_back(radius);
+  return object;
+}
+
+void collision_detection::PackedSphereSet::setSphereCenters(unsigned int object, const EigenSTL::vector_Vector3d& centers)
+{
+  std::size_t begin = object_begin_[object];
+  std::size_t n = std::min(centers.size(), object_begin_[object + 1] - begin);
+  for(std::size_t i = 0; i < n; i++) {
+    x_[begin + i] = centers[i].x();
+    y_[begin + i] = centers[i].y();
+    z_[begin + i] = centers[i].z();
+  }
+  updateBoundingSphereCenter(object);
+}
+
+void collision_detection::PackedSphereSet::updateBoundingSphereCenter(unsigned int object)
+{
+  std::size_t begin = object_begin_[object];
+  std::size_t end = object_begin_[object + 1];
+  double sx = 0.0, sy = 0.0, sz = 0.0;
+  for(std::size_t i = begin; i < end; i++) {
+    sx += x_[i];
+    sy += y_[i];
+    sz += z_[i];
+  }
+  // the centroid moves rigidly with the spheres, which keeps the bounding radius valid
+  double scale = end > begin ? 1.0 / (end - begin) : 0.0;
+  bound_x_[object] = sx * scale;
+  bound_y_[object] = sy * scale;
+  bound_z_[object] = sz * scale;
+}
+
+double collision_detection::PackedSphereSet::getMaximumDisplacement(const PackedSphereSet& other) const
+{
+  const std::size_t n = std::min(radius_.size(), other.radius_.size());
+  double max_d2 = 0.0;
+  for(std::size_t i = 0; i < n; i++) {
+    double dx = x_[i] - other.x_[i];
+    double dy = y_[i] - other.y_[i];
+    double dz = z_[i] - other.z_[i];
+    max_d2 = std::max(max_d2, dx*dx + dy*dy + dz*dz);
+  }
+  return sqrt(max_d2);
+}
+
+double collision_detection::PackedSphereSet::getMinimumRadius() const
+{
+  if(radius_.empty()) {
+    return 0.0;
+  }
+  return *std::min_element(radius_.begin(), radius_.end());
+}
+
+namespace
+{
+
+// Look up the distance at a point, with the same bounds rule as DistanceField::getDistanceGradient()
+inline bool lookupDistance(const distance_field::DistanceField* distance_field,
+                           int max_x, int max_y, int max_z,
+                           double x, double y, double z, double& dist)
+{
+  int gx, gy, gz;
+  distance_field->worldToGrid(x, y, z, gx, gy, gz);
+  if(gx < 1 || gy < 1 || gz < 1 || gx >= max_x || gy >= max_y || gz >= max_z) {
+    return false;
+  }
+  dist = distance_field->getDistance(gx, gy, gz);
+  return true;
+}
+
+}
+
+bool collision_detection::getPackedSphereCollision(const distance_field::DistanceField* distance_field,
+                                                   const PackedSphereSet& spheres,
+                                                   unsigned int object,
+                                                   double maximum_value,
+                                                   double tolerance,
+                                                   unsigned int num_coll,
+                                                   std::vector<unsigned int>& colls)
+{
+  colls.clear();
+  const std::size_t begin = spheres.getObjectBegin(object);
+  const std::size_t end = spheres.getObjectEnd(object);
+  if(begin == end) {
+    return false;
+  }
+  const int max_x = distance_field->getXNumCells() - 1;
+  const int max_y = distance_field->getYNumCells() - 1;
+  const int max_z = distance_field->getZNumCells() - 1;
+
+  // Distances change by at most the distance travelled, so the distance at the center of the bounding sphere
+  // bounds the distance of every sphere from below. Distances are saturated at maximum_value, and each
+  // lookup may be off by half a cell diagonal.
+  Eigen::Vector3d center = spheres.getBoundingSphereCenter(object);
+  double center_dist;
+  if(lookupDistance(distance_field, max_x, max_y, max_z, center.x(), center.y(), center.z(), center_dist)) {
+    double lower = std::min(center_dist, maximum_value) - spheres.getBoundingSphereRadius(object)
+      - sqrt(3.0) * distance_field->getResolution();
+    if(lower >= tolerance) {
+      return false;
+    }
+  }
+
+  const double* x = spheres.getX();
+  const double* y = spheres.getY();
+  const double* z = spheres.getZ();
+  const double* r = spheres.getRadii();
+  for(std::size_t i = begin; i < end; i++) {
+    double dist;
+    if(!lookupDistance(distance_field, max_x, max_y, max_z, x[i], y[i], z[i], dist)) {
+      logError("Collision sphere point is out of bounds");
+      return true;
+    }
+    if(maximum_value > dist && dist - r[i] < tolerance) {
+      if(num_coll == 0) {
+        return true;
+      }
+      colls.push_back(i - begin);
+      if(colls.size() >= num_coll) {
+        return true;
+      }
+    }
+  }
+  return colls.size() > 0;
+}
+
+bool collision_detection::getPackedSphereGradients(const distance_field::DistanceField* distance_field,
+                                                   const PackedSphereSet& spheres,
+                                                   unsigned int object,
+                                                   GradientInfo& gradient,
+                                                   const CollisionType& type,
+                                                   double tolerance,
+                                                   bool subtract_radii,
+                                                   double maximum_value,
+                                                   bool stop_at_first_collision)
+{
+  //assumes gradient is properly initialized
+  const std::size_t begin = spheres.getObjectBegin(object);
+  const std::size_t end = spheres.getObjectEnd(object);
+  bool in_collision = false;
+  for(std::size_t i = begin; i < end; i++) {
+    const std::size_t k = i - begin;
+    double gx, gy, gz;
+    bool in_bounds;
+    double dist = distance_field->getDistanceGradient(spheres.getX()[i], spheres.getY()[i], spheres.getZ()[i], gx, gy, gz, in_bounds);
+    if(!in_bounds) {
+      logError("Collision sphere point is out of bounds %lf, %lf, %lf", spheres.getX()[i], spheres.getY()[i], spheres.getZ()[i]);
+      return true;
+    }
+    if(dist < maximum_value) {
+      if(subtract_radii) {
+        dist -= spheres.getRadii()[i];
+      }
+      if(dist <= tolerance) {
+        if(stop_at_first_collision) {
+          return true;
+        }
+        in_collision = true;
+      }
+      if(dist < gradient.closest_distance) {
+        gradient.closest_distance = dist;
+      }
+      if(dist < gradient.distances[k]) {
+        gradient.types[k] = type;
+        gradient.distances[k] = dist;
+        gradient.gradients[k] = Eigen::Vector3d(gx,gy,gz);
+      }
+    }
+  }
+  return in_collision;
+}
+
+bool collision_detection::doBoundingSpheresIntersect(const PackedSphereSet& spheres1, unsigned int object1,
+                                                     const PackedSphereSet& spheres2, unsigned int object2)
+{
+  double r = spheres1.getBoundingSphereRadius(object1) + spheres2.getBoundingSphereRadius(object2);
+  return (spheres1.getBoundingSphereCenter(object1) - spheres2.getBoundingSphereCenter(object2)).squaredNorm() < r*r;
+}
+
+bool collision_detection::getPackedSpherePairCollisions(const PackedSphereSet& spheres1, unsigned int object1,
+                                                        const PackedSphereSet& spheres2, unsigned int object2,
+                                                        unsigned int max_pairs,
+                                                        std::vector<std::pair<unsigned int, unsigned int> >& pairs)
+{
+  pairs.clear();
+  if(!doBoundingSpheresIntersect(spheres1, object1, spheres2, object2)) {
+    return false;
+  }
+  max_pairs = std::max(max_pairs, 1u);
+  const std::size_t begin1 = spheres1.getObjectBegin(object1), end1 = spheres1.getObjectEnd(object1);
+  const std::size_t begin2 = spheres2.getObjectBegin(object2), end2 = spheres2.getObjectEnd(object2);
+  const Eigen::Vector3d center2 = spheres2.getBoundingSphereCenter(object2);
+  const double bound2 = spheres2.getBoundingSphereRadius(object2);
+  const double *x2 = spheres2.getX(), *y2 = spheres2.getY(), *z2 = spheres2.getZ(), *r2 = spheres2.getRadii();
+  for(std::size_t k = begin1; k < end1; k++) {
+    const double x = spheres1.getX()[k], y = spheres1.getY()[k], z = spheres1.getZ()[k], r = spheres1.getRadii()[k];
+    // skip spheres that do not reach the bounding sphere of the other object
+    double dx = x - center2.x(), dy = y - center2.y(), dz = z - center2.z();
+    if(dx*dx + dy*dy + dz*dz >= (r + bound2)*(r + bound2)) {
+      continue;
+    }
+    for(std::size_t l = begin2; l < end2; l++) {
+      double ex = x - x2[l], ey = y - y2[l], ez = z - z2[l];
+      double rr = r + r2[l];
+      if(ex*ex + ey*ey + ez*ez < rr*rr) {
+        pairs.push_back(std::make_pair(k - begin1, l - begin2));
+        if(pairs.size() >= max_pairs) {
+          return true;
+        }
+      }
+    }
+  }
+  return !pairs.empty();
+}
+
 void collision_detection::getCollisionSphereMarkers(const std_msgs::ColorRGBA& color,
                                                          const std::string& frame_id,
                                                          const std::string& ns,
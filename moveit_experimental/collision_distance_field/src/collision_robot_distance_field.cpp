@@ -37,10 +37,44 @@
 #include <moveit/collision_distance_field/collision_robot_distance_field.h>
 #include <moveit/collision_distance_field/collision_common_distance_field.h>
 #include <moveit/distance_field/propagation_distance_field.h>
+#include <boost/scoped_ptr.hpp>
 
 namespace collision_detection
 {
 
+namespace
+{
+
+// number of segments used to estimate the length of the path of the spheres before a continuous check
+const unsigned int CONTINUOUS_MOTION_SEGMENTS = 8;
+
+// number of intervals needed so that no sphere moves by more than step between samples, capped so that a long
+// motion of a robot with small spheres cannot turn a single check into an unbounded amount of work
+unsigned int getContinuousStepCount(double motion, double step)
+{
+  if(step <= 0.0 || motion <= 0.0) {
+    return 0;
+  }
+  double steps = ceil(motion / step);
+  if(steps > MAX_CONTINUOUS_COLLISION_STEPS) {
+    logWarn("Continuous collision check would need %.0f samples; limiting to %u, so spheres move by up to %lf between samples "
+            "and collisions with obstacles thinner than that may be missed", steps, MAX_CONTINUOUS_COLLISION_STEPS,
+            motion / MAX_CONTINUOUS_COLLISION_STEPS);
+    return MAX_CONTINUOUS_COLLISION_STEPS;
+  }
+  return (unsigned int)steps;
+}
+
+// set sample to the state at fraction t of the motion from state1 to state2
+void setInterpolatedState(const robot_state::RobotState& state1, const robot_state::RobotState& state2, double t,
+                          robot_state::RobotState& sample)
+{
+  state1.interpolate(state2, t, sample);
+  sample.updateLinkTransforms();
+}
+
+}
+
 CollisionRobotDistanceField::CollisionRobotDistanceField(const robot_model::RobotModelConstPtr& kmodel)
   : CollisionRobot(kmodel)
 {  
@@ -229,38 +263,27 @@ bool CollisionRobotDistanceField::getSelfCollisions(const collision_detection::C
   for(unsigned int i = 0; i < gsr->dfce_->link_names_.size()+gsr->dfce_->attached_body_names_.size(); i++) {
     bool is_link = i < gsr->dfce_->link_names_.size();
     if((is_link && !gsr->dfce_->link_has_geometry_[i]) || !gsr->dfce_->self_collision_enabled_[i]) continue;
-    const std::vector<CollisionSphere>* collision_spheres_1;
-    const EigenSTL::vector_Vector3d* sphere_centers_1;
-    if(is_link) {
-      collision_spheres_1 = &(gsr->link_body_decompositions_[i]->getCollisionSpheres());
-      sphere_centers_1 = &(gsr->link_body_decompositions_[i]->getSphereCenters());
-    } else {
-      collision_spheres_1 = &(gsr->attached_body_decompositions_[i-gsr->dfce_->link_names_.size()]->getCollisionSpheres());
-      sphere_centers_1 = &(gsr->attached_body_decompositions_[i-gsr->dfce_->link_names_.size()]->getSphereCenters());
-    }
     if(req.contacts) {
       std::vector<unsigned int> colls;
-      bool coll = getCollisionSphereCollision(gsr->dfce_->distance_field_.get(),
-                                              *collision_spheres_1,
-                                              *sphere_centers_1,
-                                              max_propogation_distance_,
-                                              0.0,
-                                              std::min(req.max_contacts_per_pair, req.max_contacts-res.contact_count),
-                                              colls);
+      bool coll = getPackedSphereCollision(gsr->dfce_->distance_field_.get(),
+                                           gsr->spheres_,
+                                           i,
+                                           max_propogation_distance_,
+                                           0.0,
+                                           std::min(req.max_contacts_per_pair, req.max_contacts-res.contact_count),
+                                           colls);
       if(coll) {
         res.collision = true;
         for(unsigned int j = 0; j < colls.size(); j++) {
           collision_detection::Contact con;
+          con.pos = gsr->spheres_.getSphereCenter(gsr->spheres_.getObjectBegin(i) + colls[j]);
           if(is_link) {
-            con.pos = gsr->link_body_decompositions_[i]->getSphereCenters()[colls[j]];
             con.body_type_1 = collision_detection::BodyTypes::ROBOT_LINK;
             con.body_name_1 = gsr->dfce_->link_names_[i];
           } else {
-            con.pos = gsr->attached_body_decompositions_[i-gsr->dfce_->link_names_.size()]->getSphereCenters()[colls[j]];
             con.body_type_1 = collision_detection::BodyTypes::ROBOT_ATTACHED;
             con.body_name_1 = gsr->dfce_->attached_body_names_[i-gsr->dfce_->link_names_.size()];
           }
-          //std::cerr << "Self collision with " << con.body_name_1 << std::endl;
           con.body_type_2 = collision_detection::BodyTypes::ROBOT_LINK;
           con.body_name_2 = "self";
           res.contact_count++;
@@ -273,18 +296,16 @@ bool CollisionRobotDistanceField::getSelfCollisions(const collision_detection::C
         }
       }
     } else {
-      bool coll = getCollisionSphereCollision(gsr->dfce_->distance_field_.get(),
-                                              *collision_spheres_1,
-                                              *sphere_centers_1,
-                                              max_propogation_distance_,
-                                              0.0);
+      std::vector<unsigned int> colls;
+      bool coll = getPackedSphereCollision(gsr->dfce_->distance_field_.get(),
+                                           gsr->spheres_,
+                                           i,
+                                           max_propogation_distance_,
+                                           0.0,
+                                           0,
+                                           colls);
       if(coll) {
         logDebug("Link %s in self collision", gsr->dfce_->link_names_[i].c_str());
-        //if(is_link) {
-        //   std::cerr << "Link " << gsr->dfce_->link_names_[i] << " in self collision" << std::endl;
-        // } else {
-        //   std::cerr << "Attached body in self collision" << std::endl;
-        // }
         res.collision = true;
         return true;
       }
@@ -298,24 +319,15 @@ bool CollisionRobotDistanceField::getSelfProximityGradients(boost::shared_ptr<Gr
   for(unsigned int i = 0; i < gsr->dfce_->link_names_.size(); i++) {
     bool is_link = i < gsr->dfce_->link_names_.size();
     if((is_link && !gsr->dfce_->link_has_geometry_[i]) || !gsr->dfce_->self_collision_enabled_[i]) continue;
-    const std::vector<CollisionSphere>* collision_spheres_1;
-    const EigenSTL::vector_Vector3d* sphere_centers_1;
-    if(is_link) {
-      collision_spheres_1 = &(gsr->link_body_decompositions_[i]->getCollisionSpheres());
-      sphere_centers_1 = &(gsr->link_body_decompositions_[i]->getSphereCenters());
-    } else {
-      collision_spheres_1 = &(gsr->attached_body_decompositions_[i-gsr->dfce_->link_names_.size()]->getCollisionSpheres());
-      sphere_centers_1 = &(gsr->attached_body_decompositions_[i-gsr->dfce_->link_names_.size()]->getSphereCenters());
-    }
-    bool coll = getCollisionSphereGradients(gsr->dfce_->distance_field_.get(),
-                                            *collision_spheres_1,
-                                            *sphere_centers_1,
-                                            gsr->gradients_[i],
-                                            collision_detection::SELF,
-                                            0.0,
-                                            false,
-                                            max_propogation_distance_,
-                                            false);
+    bool coll = getPackedSphereGradients(gsr->dfce_->distance_field_.get(),
+                                         gsr->spheres_,
+                                         i,
+                                         gsr->gradients_[i],
+                                         collision_detection::SELF,
+                                         0.0,
+                                         false,
+                                         max_propogation_distance_,
+                                         false);
     if(coll) {
       in_collision = true;
     }
@@ -329,55 +341,15 @@ bool CollisionRobotDistanceField::getIntraGroupCollisions(const collision_detect
 {
   unsigned int num_links = gsr->dfce_->link_names_.size();
   unsigned int num_attached_bodies = gsr->dfce_->attached_body_names_.size();
+  std::vector<std::pair<unsigned int, unsigned int> > pairs;
   for(unsigned int i = 0; i < num_links+num_attached_bodies; i++) {
     for(unsigned int j = i+1; j < num_links+num_attached_bodies; j++) {    
-      if(i == j) continue;
       bool i_is_link = i < num_links;
       bool j_is_link = j < num_links;
       if((i_is_link && !gsr->dfce_->link_has_geometry_[i]) || (j_is_link && !gsr->dfce_->link_has_geometry_[j])) continue;
       if(!gsr->dfce_->intra_group_collision_enabled_[i][j]) continue;
-      if(i_is_link && j_is_link && !doBoundingSpheresIntersect(gsr->link_body_decompositions_[i],
-                                                               gsr->link_body_decompositions_[j])) {
-        //ROS_DEBUG_STREAM("Bounding spheres for " << gsr->dfce_->link_names_[i] << " and " << gsr->dfce_->link_names_[j]
-        //<< " don't intersect");
-        continue;
-      } else if(!i_is_link || !j_is_link) {
-        bool all_ok = true;
-        if(!i_is_link && j_is_link) {
-          for(unsigned int k = 0; k < gsr->attached_body_decompositions_[i-num_links]->getSize(); k++) {
-            if(doBoundingSpheresIntersect(gsr->link_body_decompositions_[j], 
-                                          gsr->attached_body_decompositions_[i-num_links]->getPosedBodySphereDecomposition(k))) {
-              all_ok = false;
-              break;
-            }
-          } 
-        } else if(i_is_link && !j_is_link) {
-          for(unsigned int k = 0; k < gsr->attached_body_decompositions_[j-num_links]->getSize(); k++) {
-            if(doBoundingSpheresIntersect(gsr->link_body_decompositions_[i], 
-                                          gsr->attached_body_decompositions_[j-num_links]->getPosedBodySphereDecomposition(k))) {
-              all_ok = false;
-              break;
-            }
-          } 
-        } else {
-          for(unsigned int k = 0; k < gsr->attached_body_decompositions_[i-num_links]->getSize() && all_ok; k++) {
-            for(unsigned int l = 0; l < gsr->attached_body_decompositions_[j-num_links]->getSize(); l++) {
-              if(doBoundingSpheresIntersect(gsr->attached_body_decompositions_[i-num_links]->getPosedBodySphereDecomposition(k),
-                                            gsr->attached_body_decompositions_[j-num_links]->getPosedBodySphereDecomposition(l))) {
-                
-                all_ok = false;
-                break;
-              }
-            }
-          }
-        }
-        if(all_ok) {
-          continue;
-        }
-        // std::cerr << "Bounding spheres for " << gsr->dfce_->link_names_[i] << " and " << gsr->dfce_->link_names_[j]
-        //           << " intersect" << std::endl;
-      }
-      int num_pair = -1;
+      // the bounding spheres cover all the collision spheres of links and attached bodies alike
+      if(!doBoundingSpheresIntersect(gsr->spheres_, i, gsr->spheres_, j)) continue;
       std::string name_1;
       std::string name_2;
       if(i_is_link) {
@@ -390,79 +362,44 @@ bool CollisionRobotDistanceField::getIntraGroupCollisions(const collision_detect
       } else {
         name_2 = gsr->dfce_->attached_body_names_[j-num_links];        
       }
+      unsigned int max_pairs = 1;
       if(req.contacts) {
         collision_detection::CollisionResult::ContactMap::iterator it = res.contacts.find(std::pair<std::string,std::string>(name_1, name_2));
-        if(it == res.contacts.end()) {
-          num_pair = 0;
-        } else {
-          num_pair = it->second.size();
-        }
+        unsigned int num_pair = it == res.contacts.end() ? 0 : it->second.size();
+        if(num_pair >= req.max_contacts_per_pair) continue;
+        max_pairs = req.max_contacts_per_pair - num_pair;
       }
-      const std::vector<CollisionSphere>* collision_spheres_1;
-      const std::vector<CollisionSphere>* collision_spheres_2;
-      const EigenSTL::vector_Vector3d* sphere_centers_1;
-      const EigenSTL::vector_Vector3d* sphere_centers_2;
-      if(i_is_link) {
-        collision_spheres_1 = &(gsr->link_body_decompositions_[i]->getCollisionSpheres());
-        sphere_centers_1 = &(gsr->link_body_decompositions_[i]->getSphereCenters());
-      } else {
-        collision_spheres_1 = &(gsr->attached_body_decompositions_[i-num_links]->getCollisionSpheres());
-        sphere_centers_1 = &(gsr->attached_body_decompositions_[i-num_links]->getSphereCenters());
-      }
-      if(j_is_link) {
-        collision_spheres_2 = &(gsr->link_body_decompositions_[j]->getCollisionSpheres());
-        sphere_centers_2 = &(gsr->link_body_decompositions_[j]->getSphereCenters());
-      } else {
-        collision_spheres_2 = &(gsr->attached_body_decompositions_[j-num_links]->getCollisionSpheres());
-        sphere_centers_2 = &(gsr->attached_body_decompositions_[j-num_links]->getSphereCenters());
+      if(!getPackedSpherePairCollisions(gsr->spheres_, i, gsr->spheres_, j, max_pairs, pairs)) continue;
+      logDebug("Intra-group contact between %s and %s", name_1.c_str(), name_2.c_str());
+      res.collision = true;
+      if(!req.contacts) {
+        return true;
       }
-      for(unsigned int k = 0; k < collision_spheres_1->size() && num_pair < (int)req.max_contacts_per_pair; k++) {
-        for(unsigned int l = 0; l < collision_spheres_2->size() && num_pair < (int)req.max_contacts_per_pair; l++) {
-          Eigen::Vector3d gradient = (*sphere_centers_1)[k] - (*sphere_centers_2)[l];
-          double dist = gradient.norm();
-          //std::cerr << "Dist is " << dist << " rad " << (*collision_spheres_1)[k].radius_+(*collision_spheres_2)[l].radius_ << std::endl;
-          if(dist < (*collision_spheres_1)[k].radius_+(*collision_spheres_2)[l].radius_) {
-            logDebug("Intra-group contact between %s and %s", name_1.c_str(), name_2.c_str());
-            res.collision = true;
-            if(req.contacts) {
-              collision_detection::Contact con;
-              con.pos = gsr->link_body_decompositions_[i]->getSphereCenters()[k];
-              con.body_name_1 = name_1;
-              con.body_name_2 = name_2;
-              if(i_is_link) {
-                con.body_type_1 = collision_detection::BodyTypes::ROBOT_LINK;
-              } else {
-                con.body_type_1 = collision_detection::BodyTypes::ROBOT_ATTACHED;
-              }
-              if(j_is_link) {
-                con.body_type_2 = collision_detection::BodyTypes::ROBOT_LINK;
-              } else {
-                con.body_type_2 = collision_detection::BodyTypes::ROBOT_ATTACHED;
-              }
-              res.contact_count++;
-              res.contacts[std::pair<std::string,std::string>(con.body_name_1, con.body_name_2)].push_back(con);
-              num_pair++;
-              //std::cerr << "Pushing back intra " << con.body_name_1 << " and " << con.body_name_2 << std::endl;
-              gsr->gradients_[i].types[k] = INTRA;
-              gsr->gradients_[i].collision = true;
-              gsr->gradients_[j].types[l] = INTRA;
-              gsr->gradients_[j].collision = true;
-              // ROS_INFO_STREAM("Sphere 1 " << (*sphere_centers_1)[k]);
-              // ROS_INFO_STREAM("Sphere 2 " << (*sphere_centers_2)[l]);
-              // ROS_INFO_STREAM("Norm " << gradient.norm());
-              // ROS_INFO_STREAM("Dist is " << dist 
-              //                 << " radius 1 " << (*collision_spheres_1)[k].radius_ 
-              //                 << " radius 2 " << (*collision_spheres_2)[l].radius_);
-              // ROS_INFO_STREAM("Gradient " << gradient);
-              // ROS_INFO_STREAM("Spheres intersect for " << gsr->dfce_->link_names_[i] << " and " << gsr->dfce_->link_names_[j]);
-              //std::cerr << "Spheres intersect for " << gsr->dfce_->link_names_[i] << " and " << gsr->dfce_->link_names_[j] << std::cerr;
-              if(res.contact_count >= req.max_contacts) {
-                return true;
-              }
-            } else {
-              return true;
-            }
-          }
+      for(unsigned int p = 0; p < pairs.size(); p++) {
+        unsigned int k = pairs[p].first;
+        unsigned int l = pairs[p].second;
+        collision_detection::Contact con;
+        con.pos = gsr->spheres_.getSphereCenter(gsr->spheres_.getObjectBegin(i) + k);
+        con.body_name_1 = name_1;
+        con.body_name_2 = name_2;
+        if(i_is_link) {
+          con.body_type_1 = collision_detection::BodyTypes::ROBOT_LINK;
+        } else {
+          con.body_type_1 = collision_detection::BodyTypes::ROBOT_ATTACHED;
+        }
+        if(j_is_link) {
+          con.body_type_2 = collision_detection::BodyTypes::ROBOT_LINK;
+        } else {
+          con.body_type_2 = collision_detection::BodyTypes::ROBOT_ATTACHED;
+        }
+        res.contact_count++;
+        res.contacts[std::pair<std::string,std::string>(con.body_name_1, con.body_name_2)].push_back(con);
+        gsr->gradients_[i].types[k] = INTRA;
+        gsr->gradients_[i].collision = true;
+        gsr->gradients_[j].types[l] = INTRA;
+        gsr->gradients_[j].collision = true;
+        if(res.contact_count >= req.max_contacts) {
+          return true;
         }
       }
     }
@@ -474,49 +411,39 @@ bool CollisionRobotDistanceField::getIntraGroupProximityGradients(boost::shared_
   bool in_collision = false;
   unsigned int num_links = gsr->dfce_->link_names_.size();
   unsigned int num_attached_bodies = gsr->dfce_->attached_body_names_.size();
+  const PackedSphereSet& spheres = gsr->spheres_;
   //TODO - deal with attached bodies
   for(unsigned int i = 0; i < num_links+num_attached_bodies; i++) {
     for(unsigned int j = i+1; j < num_links+num_attached_bodies; j++) {    
-      if(i == j) continue;
       bool i_is_link = i < num_links;
       bool j_is_link = j < num_links;
       if((i_is_link && !gsr->dfce_->link_has_geometry_[i]) || (j_is_link && !gsr->dfce_->link_has_geometry_[j])) continue;
       if(!gsr->dfce_->intra_group_collision_enabled_[i][j]) continue;
-      const std::vector<CollisionSphere>* collision_spheres_1;
-      const std::vector<CollisionSphere>* collision_spheres_2;
-      const EigenSTL::vector_Vector3d* sphere_centers_1;
-      const EigenSTL::vector_Vector3d* sphere_centers_2;
-      if(i_is_link) {
-        collision_spheres_1 = &(gsr->link_body_decompositions_[i]->getCollisionSpheres());
-        sphere_centers_1 = &(gsr->link_body_decompositions_[i]->getSphereCenters());
-      } else {
-        collision_spheres_1 = &(gsr->attached_body_decompositions_[i-num_links]->getCollisionSpheres());
-        sphere_centers_1 = &(gsr->attached_body_decompositions_[i-num_links]->getSphereCenters());
-      }
-      if(j_is_link) {
-        collision_spheres_2 = &(gsr->link_body_decompositions_[j]->getCollisionSpheres());
-        sphere_centers_2 = &(gsr->link_body_decompositions_[j]->getSphereCenters());
-      } else {
-        collision_spheres_2 = &(gsr->attached_body_decompositions_[j-num_links]->getCollisionSpheres());
-        sphere_centers_2 = &(gsr->attached_body_decompositions_[j-num_links]->getSphereCenters());
-      }
-      for(unsigned int k = 0; k < collision_spheres_1->size(); k++) {
-        for(unsigned int l = 0; l < collision_spheres_2->size(); l++) {
-          Eigen::Vector3d gradient = (*sphere_centers_1)[k] - (*sphere_centers_2)[l];
-          double dist = gradient.norm();
-          if(dist < gsr->gradients_[i].distances[k]) {
-            //ROS_INFO_STREAM("Gradient " << gradient);
-            //ROS_INFO_STREAM("Dist " << dist);
-            gsr->gradients_[i].distances[k] = dist;
-            gsr->gradients_[i].gradients[k] = gradient;
-            gsr->gradients_[i].types[k] = INTRA;
+      std::size_t begin_i = spheres.getObjectBegin(i), end_i = spheres.getObjectEnd(i);
+      std::size_t begin_j = spheres.getObjectBegin(j), end_j = spheres.getObjectEnd(j);
+      GradientInfo& gradient_i = gsr->gradients_[i];
+      GradientInfo& gradient_j = gsr->gradients_[j];
+      for(std::size_t k = begin_i; k < end_i; k++) {
+        for(std::size_t l = begin_j; l < end_j; l++) {
+          double dx = spheres.getX()[k] - spheres.getX()[l];
+          double dy = spheres.getY()[k] - spheres.getY()[l];
+          double dz = spheres.getZ()[k] - spheres.getZ()[l];
+          double dist2 = dx*dx + dy*dy + dz*dz;
+          // compare squared distances, and only take the square root for the distances that are kept
+          double di = gradient_i.distances[k-begin_i];
+          double dj = gradient_j.distances[l-begin_j];
+          if(dist2 >= di*di && dist2 >= dj*dj) continue;
+          double dist = sqrt(dist2);
+          Eigen::Vector3d gradient(dx, dy, dz);
+          if(dist < di) {
+            gradient_i.distances[k-begin_i] = dist;
+            gradient_i.gradients[k-begin_i] = gradient;
+            gradient_i.types[k-begin_i] = INTRA;
           }
-          if(dist < gsr->gradients_[j].distances[l]) {
-            //ROS_INFO_STREAM("Gradient sec " << gradient);
-            //ROS_INFO_STREAM("Dist sec " << dist);
-            gsr->gradients_[j].distances[l] = dist;
-            gsr->gradients_[j].gradients[l] = -gradient;
-            gsr->gradients_[j].types[l] = INTRA;
+          if(dist < dj) {
+            gradient_j.distances[l-begin_j] = dist;
+            gradient_j.gradients[l-begin_j] = -gradient;
+            gradient_j.types[l-begin_j] = INTRA;
           }
         }
       }
@@ -524,6 +451,7 @@ bool CollisionRobotDistanceField::getIntraGroupProximityGradients(boost::shared_
   }
   return in_collision;
 }
+
 boost::shared_ptr<DistanceFieldCacheEntry> 
 CollisionRobotDistanceField::generateDistanceFieldCacheEntry(const std::string& group_name,
                                                              const robot_state::RobotState& state,
@@ -797,6 +725,7 @@ void CollisionRobotDistanceField::updateGroupStateRepresentationState(const robo
     const robot_state::LinkState* ls = state.getLinkStateVector()[gsr->dfce_->link_state_indices_[i]];
     if(gsr->dfce_->link_has_geometry_[i]) {
       gsr->link_body_decompositions_[i]->updatePose(ls->getGlobalCollisionBodyTransform());
+      gsr->spheres_.setSphereCenters(i, gsr->link_body_decompositions_[i]->getSphereCenters());
       gsr->gradients_[i].closest_distance = DBL_MAX;
       gsr->gradients_[i].collision = false;
       gsr->gradients_[i].types.assign(gsr->link_body_decompositions_[i]->getCollisionSpheres().size(), NONE);
@@ -820,6 +749,7 @@ void CollisionRobotDistanceField::updateGroupStateRepresentationState(const robo
     for(unsigned int j = 0; j < att->getShapes().size(); j++) {
       gsr->attached_body_decompositions_[i]->updatePose(j, att->getGlobalCollisionBodyTransforms()[j]);
     }
+    gsr->spheres_.setSphereCenters(i+gsr->dfce_->link_names_.size(), gsr->attached_body_decompositions_[i]->getSphereCenters());
     gsr->gradients_[i+gsr->dfce_->link_names_.size()].closest_distance = DBL_MAX;
     gsr->gradients_[i+gsr->dfce_->link_names_.size()].collision = false;
     gsr->gradients_[i+gsr->dfce_->link_names_.size()].types.assign(gsr->attached_body_decompositions_[i]->getCollisionSpheres().size(), NONE);
@@ -884,6 +814,271 @@ void CollisionRobotDistanceField::getGroupStateRepresentation(const boost::share
     gsr->gradients_[i+dfce->link_names_.size()].sphere_radii = gsr->attached_body_decompositions_.back()->getSphereRadii();
     gsr->gradients_[i+dfce->link_names_.size()].joint_name = ls->getLinkModel()->getParentJointModel()->getName();
   }
+  packGroupStateRepresentationSpheres(gsr);
+}
+
+void CollisionRobotDistanceField::packGroupStateRepresentationSpheres(boost::shared_ptr<GroupStateRepresentation>& gsr) const
+{
+  gsr->spheres_.clear();
+  for(unsigned int i = 0; i < gsr->link_body_decompositions_.size(); i++) {
+    if(gsr->link_body_decompositions_[i]) {
+      gsr->spheres_.addObject(gsr->link_body_decompositions_[i]->getSphereCenters(),
+                              gsr->link_body_decompositions_[i]->getSphereRadii());
+    } else {
+      gsr->spheres_.addObject(EigenSTL::vector_Vector3d(), std::vector<double>());
+    }
+  }
+  for(unsigned int i = 0; i < gsr->attached_body_decompositions_.size(); i++) {
+    gsr->spheres_.addObject(gsr->attached_body_decompositions_[i]->getSphereCenters(),
+                            gsr->attached_body_decompositions_[i]->getSphereRadii());
+  }
+}
+
+void CollisionRobotDistanceField::getRobotSpheres(const robot_state::RobotState& state,
+                                                  PackedSphereSet& spheres,
+                                                  std::vector<std::string>& names,
+                                                  std::vector<collision_detection::BodyType>& types) const
+{
+  spheres.clear();
+  names.clear();
+  types.clear();
+  const std::vector<robot_state::LinkState*>& lsv = state.getLinkStateVector();
+  for(unsigned int i = 0; i < lsv.size(); i++) {
+    std::map<std::string, unsigned int>::const_iterator it = link_body_decomposition_index_map_.find(lsv[i]->getName());
+    if(it != link_body_decomposition_index_map_.end()) {
+      PosedBodySphereDecompositionPtr posed = getPosedLinkBodySphereDecomposition(lsv[i], it->second);
+      spheres.addObject(posed->getSphereCenters(), posed->getSphereRadii());
+      names.push_back(lsv[i]->getName());
+      types.push_back(collision_detection::BodyTypes::ROBOT_LINK);
+    }
+    std::vector<const robot_state::AttachedBody*> attached_bodies;
+    lsv[i]->getAttachedBodies(attached_bodies);
+    for(unsigned int j = 0; j < attached_bodies.size(); j++) {
+      PosedBodySphereDecompositionVectorPtr posed = getAttachedBodySphereDecomposition(attached_bodies[j], resolution_);
+      spheres.addObject(posed->getSphereCenters(), posed->getSphereRadii());
+      names.push_back(attached_bodies[j]->getName());
+      types.push_back(collision_detection::BodyTypes::ROBOT_ATTACHED);
+    }
+  }
+}
+
+void CollisionRobotDistanceField::checkSelfCollision(const collision_detection::CollisionRequest& req,
+                                                     collision_detection::CollisionResult& res,
+                                                     const robot_state::RobotState& state1,
+                                                     const robot_state::RobotState& state2) const
+{
+  checkSelfCollisionHelper(req, res, state1, state2, NULL);
+}
+
+void CollisionRobotDistanceField::checkSelfCollision(const collision_detection::CollisionRequest& req,
+                                                     collision_detection::CollisionResult& res,
+                                                     const robot_state::RobotState& state1,
+                                                     const robot_state::RobotState& state2,
+                                                     const collision_detection::AllowedCollisionMatrix &acm) const
+{
+  checkSelfCollisionHelper(req, res, state1, state2, &acm);
+}
+
+void CollisionRobotDistanceField::checkSelfCollisionHelper(const collision_detection::CollisionRequest& req,
+                                                           collision_detection::CollisionResult& res,
+                                                           const robot_state::RobotState& state1,
+                                                           const robot_state::RobotState& state2,
+                                                           const collision_detection::AllowedCollisionMatrix *acm) const
+{
+  boost::shared_ptr<GroupStateRepresentation> gsr;
+  boost::shared_ptr<GroupStateRepresentation> gsr2;
+  generateCollisionCheckingStructures(req.group_name, state1, acm, gsr, true);
+  generateCollisionCheckingStructures(req.group_name, state2, acm, gsr2, true);
+  if(gsr->dfce_ != gsr2->dfce_ || gsr->spheres_.getSphereCount() != gsr2->spheres_.getSphereCount()) {
+    logWarn("Joints outside of group %s move between the two states; only checking the states themselves", req.group_name.c_str());
+    bool done = getSelfCollisions(req, res, gsr);
+    if(!done) {
+      done = getIntraGroupCollisions(req, res, gsr);
+    }
+    if(!done) {
+      done = getSelfCollisions(req, res, gsr2);
+    }
+    if(!done) {
+      getIntraGroupCollisions(req, res, gsr2);
+    }
+    return;
+  }
+
+  // the spheres are posed from interpolated states, so they follow the arcs the links move along; the length of
+  // those arcs is estimated from a few intermediate states, and the motion is then sampled densely enough that no
+  // sphere moves by more than the smallest radius between samples
+  robot_state::RobotState sample(state1);
+  PackedSphereSet previous = gsr->spheres_;
+  double motion = 0.0;
+  for(unsigned int k = 1; k <= CONTINUOUS_MOTION_SEGMENTS; k++) {
+    setInterpolatedState(state1, state2, (double)k / (double)CONTINUOUS_MOTION_SEGMENTS, sample);
+    updateGroupStateRepresentationState(sample, gsr);
+    motion += gsr->spheres_.getMaximumDisplacement(previous);
+    previous = gsr->spheres_;
+  }
+  unsigned int steps = getContinuousStepCount(motion, previous.getMinimumRadius());
+  for(unsigned int s = 0; s <= steps; s++) {
+    setInterpolatedState(state1, state2, steps > 0 ? (double)s / (double)steps : 0.0, sample);
+    updateGroupStateRepresentationState(sample, gsr);
+    bool done = getSelfCollisions(req, res, gsr);
+    if(!done) {
+      getIntraGroupCollisions(req, res, gsr);
+    }
+    // report the contacts at the first sample that is in collision
+    if(res.collision) {
+      return;
+    }
+  }
+}
+
+void CollisionRobotDistanceField::checkOtherCollision(const collision_detection::CollisionRequest &req,
+                                                      collision_detection::CollisionResult &res,
+                                                      const robot_state::RobotState &state,
+                                                      const CollisionRobot &other_robot,
+                                                      const robot_state::RobotState &other_state) const
+{
+  checkOtherCollisionHelper(req, res, state, NULL, other_robot, other_state, NULL, NULL);
+}
+
+void CollisionRobotDistanceField::checkOtherCollision(const collision_detection::CollisionRequest &req,
+                                                      collision_detection::CollisionResult &res,
+                                                      const robot_state::RobotState &state,
+                                                      const CollisionRobot &other_robot,
+                                                      const robot_state::RobotState &other_state,
+                                                      const collision_detection::AllowedCollisionMatrix &acm) const
+{
+  checkOtherCollisionHelper(req, res, state, NULL, other_robot, other_state, NULL, &acm);
+}
+
+void CollisionRobotDistanceField::checkOtherCollision(const collision_detection::CollisionRequest &req,
+                                                      collision_detection::CollisionResult &res,
+                                                      const robot_state::RobotState &state1,
+                                                      const robot_state::RobotState &state2,
+                                                      const CollisionRobot &other_robot,
+                                                      const robot_state::RobotState &other_state1,
+                                                      const robot_state::RobotState &other_state2) const
+{
+  checkOtherCollisionHelper(req, res, state1, &state2, other_robot, other_state1, &other_state2, NULL);
+}
+
+void CollisionRobotDistanceField::checkOtherCollision(const collision_detection::CollisionRequest &req,
+                                                      collision_detection::CollisionResult &res,
+                                                      const robot_state::RobotState &state1,
+                                                      const robot_state::RobotState &state2,
+                                                      const CollisionRobot &other_robot,
+                                                      const robot_state::RobotState &other_state1,
+                                                      const robot_state::RobotState &other_state2,
+                                                      const collision_detection::AllowedCollisionMatrix &acm) const
+{
+  checkOtherCollisionHelper(req, res, state1, &state2, other_robot, other_state1, &other_state2, &acm);
+}
+
+void CollisionRobotDistanceField::checkOtherCollisionHelper(const collision_detection::CollisionRequest& req,
+                                                            collision_detection::CollisionResult& res,
+                                                            const robot_state::RobotState& state1,
+                                                            const robot_state::RobotState* state2,
+                                                            const CollisionRobot& other_robot,
+                                                            const robot_state::RobotState& other_state1,
+                                                            const robot_state::RobotState* other_state2,
+                                                            const collision_detection::AllowedCollisionMatrix *acm) const
+{
+  const CollisionRobotDistanceField* other = dynamic_cast<const CollisionRobotDistanceField*>(&other_robot);
+  if(!other) {
+    logError("Checking collisions with another robot requires both robots to use distance field collision checking");
+    return;
+  }
+
+  PackedSphereSet spheres, spheres_end;
+  PackedSphereSet other_spheres, other_spheres_end;
+  std::vector<std::string> names, other_names;
+  std::vector<collision_detection::BodyType> types, other_types;
+  getRobotSpheres(state1, spheres, names, types);
+  other->getRobotSpheres(other_state1, other_spheres, other_names, other_types);
+
+  unsigned int steps = 0;
+  std::vector<std::string> names_end;
+  std::vector<collision_detection::BodyType> types_end;
+  boost::scoped_ptr<robot_state::RobotState> sample, other_sample;
+  if(state2 && other_state2) {
+    getRobotSpheres(*state2, spheres_end, names_end, types_end);
+    if(names_end != names || spheres_end.getSphereCount() != spheres.getSphereCount()) {
+      logError("Continuous collision checking requires the same bodies to be attached to the robot at the start and end of the motion");
+      return;
+    }
+    other->getRobotSpheres(*other_state2, other_spheres_end, names_end, types_end);
+    if(names_end != other_names || other_spheres_end.getSphereCount() != other_spheres.getSphereCount()) {
+      logError("Continuous collision checking requires the same bodies to be attached to the robot at the start and end of the motion");
+      return;
+    }
+
+    // as for self collisions, the spheres are posed from interpolated states and the length of their paths is
+    // estimated from a few intermediate states
+    sample.reset(new robot_state::RobotState(state1));
+    other_sample.reset(new robot_state::RobotState(other_state1));
+    PackedSphereSet previous = spheres;
+    PackedSphereSet other_previous = other_spheres;
+    double motion = 0.0;
+    for(unsigned int k = 1; k <= CONTINUOUS_MOTION_SEGMENTS; k++) {
+      double t = (double)k / (double)CONTINUOUS_MOTION_SEGMENTS;
+      setInterpolatedState(state1, *state2, t, *sample);
+      getRobotSpheres(*sample, spheres_end, names_end, types_end);
+      setInterpolatedState(other_state1, *other_state2, t, *other_sample);
+      other->getRobotSpheres(*other_sample, other_spheres_end, names_end, types_end);
+      motion += std::max(spheres_end.getMaximumDisplacement(previous), other_spheres_end.getMaximumDisplacement(other_previous));
+      previous = spheres_end;
+      other_previous = other_spheres_end;
+    }
+    steps = getContinuousStepCount(motion, std::min(spheres.getMinimumRadius(), other_spheres.getMinimumRadius()));
+  }
+
+  std::vector<std::pair<unsigned int, unsigned int> > pairs;
+  for(unsigned int s = 0; s <= steps; s++) {
+    if(s > 0) {
+      double t = (double)s / (double)steps;
+      setInterpolatedState(state1, *state2, t, *sample);
+      getRobotSpheres(*sample, spheres, names_end, types_end);
+      setInterpolatedState(other_state1, *other_state2, t, *other_sample);
+      other->getRobotSpheres(*other_sample, other_spheres, names_end, types_end);
+    }
+    for(unsigned int i = 0; i < spheres.getObjectCount(); i++) {
+      for(unsigned int j = 0; j < other_spheres.getObjectCount(); j++) {
+        if(acm) {
+          collision_detection::AllowedCollision::Type t;
+          if(acm->getEntry(names[i], other_names[j], t) && t == collision_detection::AllowedCollision::ALWAYS) continue;
+        }
+        unsigned int max_pairs = 1;
+        if(req.contacts) {
+          collision_detection::CollisionResult::ContactMap::iterator it = res.contacts.find(std::pair<std::string,std::string>(names[i], other_names[j]));
+          unsigned int num_pair = it == res.contacts.end() ? 0 : it->second.size();
+          if(num_pair >= req.max_contacts_per_pair) continue;
+          max_pairs = req.max_contacts_per_pair - num_pair;
+        }
+        if(!getPackedSpherePairCollisions(spheres, i, other_spheres, j, max_pairs, pairs)) continue;
+        logDebug("Contact between %s and %s of the other robot", names[i].c_str(), other_names[j].c_str());
+        res.collision = true;
+        if(!req.contacts) {
+          return;
+        }
+        for(unsigned int p = 0; p < pairs.size(); p++) {
+          collision_detection::Contact con;
+          con.pos = spheres.getSphereCenter(spheres.getObjectBegin(i) + pairs[p].first);
+          con.body_name_1 = names[i];
+          con.body_type_1 = types[i];
+          con.body_name_2 = other_names[j];
+          con.body_type_2 = other_types[j];
+          res.contact_count++;
+          res.contacts[std::pair<std::string,std::string>(con.body_name_1, con.body_name_2)].push_back(con);
+          if(res.contact_count >= req.max_contacts) {
+            return;
+          }
+        }
+      }
+    }
+    // report the contacts at the first sample that is in collision
+    if(res.collision) {
+      return;
+    }
+  }
 }
 
 bool CollisionRobotDistanceField::compareCacheEntryToState(const boost::shared_ptr<const DistanceFieldCacheEntry>& dfce, 
@@ -345,34 +345,24 @@ bool CollisionWorldDistanceField::getEnvironmentCollisions(const CollisionReques
   for(unsigned int i = 0; i < gsr->dfce_->link_names_.size()+gsr->dfce_->attached_body_names_.size(); i++) {
     bool is_link = i < gsr->dfce_->link_names_.size();
     if(is_link && !gsr->dfce_->link_has_geometry_[i]) continue;
-    const std::vector<CollisionSphere>* collision_spheres_1;
-    const EigenSTL::vector_Vector3d* sphere_centers_1;
-    if(is_link) {
-      collision_spheres_1 = &(gsr->link_body_decompositions_[i]->getCollisionSpheres());
-      sphere_centers_1 = &(gsr->link_body_decompositions_[i]->getSphereCenters());
-    } else {
-      collision_spheres_1 = &(gsr->attached_body_decompositions_[i-gsr->dfce_->link_names_.size()]->getCollisionSpheres());
-      sphere_centers_1 = &(gsr->attached_body_decompositions_[i-gsr->dfce_->link_names_.size()]->getSphereCenters());
-    }
     if(req.contacts) {
       std::vector<unsigned int> colls;
-      bool coll = getCollisionSphereCollision(env_distance_field.get(),
-                                              *collision_spheres_1,
-                                              *sphere_centers_1,
-                                              max_propogation_distance_,
-                                              0.0,
-                                              std::min(req.max_contacts_per_pair, req.max_contacts-res.contact_count),
-                                              colls);
+      bool coll = getPackedSphereCollision(env_distance_field.get(),
+                                           gsr->spheres_,
+                                           i,
+                                           max_propogation_distance_,
+                                           0.0,
+                                           std::min(req.max_contacts_per_pair, req.max_contacts-res.contact_count),
+                                           colls);
       if(coll) {
         res.collision = true;
         for(unsigned int j = 0; j < colls.size(); j++) {
           Contact con;
+          con.pos = gsr->spheres_.getSphereCenter(gsr->spheres_.getObjectBegin(i) + colls[j]);
           if(is_link) {
-            con.pos = gsr->link_body_decompositions_[i]->getSphereCenters()[colls[j]];
             con.body_type_1 = BodyTypes::ROBOT_LINK;
             con.body_name_1 = gsr->dfce_->link_names_[i];
           } else {
-            con.pos = gsr->attached_body_decompositions_[i-gsr->dfce_->link_names_.size()]->getSphereCenters()[colls[j]];
             con.body_type_1 = BodyTypes::ROBOT_ATTACHED;
             con.body_name_1 = gsr->dfce_->attached_body_names_[i-gsr->dfce_->link_names_.size()];
           }
@@ -389,11 +379,14 @@ bool CollisionWorldDistanceField::getEnvironmentCollisions(const CollisionReques
         }
       } 
     } else {
-      bool coll = getCollisionSphereCollision(env_distance_field.get(),
-                                              *collision_spheres_1,
-                                              *sphere_centers_1,
-                                              max_propogation_distance_,
-                                              false);
+      std::vector<unsigned int> colls;
+      bool coll = getPackedSphereCollision(env_distance_field.get(),
+                                           gsr->spheres_,
+                                           i,
+                                           max_propogation_distance_,
+                                           0.0,
+                                           0,
+                                           colls);
       if(coll) {
         res.collision = true;
         return true;
@@ -40,6 +40,7 @@
 #include <moveit/collision_distance_field/collision_distance_field_types.h>
 #include <moveit/collision_distance_field/collision_robot_distance_field.h>
 #include <moveit/collision_distance_field/collision_world_distance_field.h>
+#include <moveit/distance_field/propagation_distance_field.h>
 #include <moveit_resources/config.h>
 
 #include <geometric_shapes/shape_operations.h>
@@ -358,6 +359,243 @@ TEST_F(DistanceFieldCollisionDetectionTester, AttachedBodyTester) {
   ASSERT_TRUE(res.collision);  
 }
 
+TEST(PackedSphereSet, MatchesUnpackedChecks)
+{
+  distance_field::PropagationDistanceField df(1.0, 1.0, 1.0, .02, -.5, -.5, -.5, .25);
+  EigenSTL::vector_Vector3d points;
+  for(double x = -.1; x <= .1; x += .02) {
+    points.push_back(Eigen::Vector3d(x, 0.0, 0.0));
+    points.push_back(Eigen::Vector3d(0.0, x, .05));
+  }
+  df.addPointsToField(points);
+
+  std::vector<collision_detection::CollisionSphere> sphere_list;
+  std::vector<double> radii;
+  for(unsigned int i = 0; i < 8; i++) {
+    sphere_list.push_back(collision_detection::CollisionSphere(Eigen::Vector3d(.03*i, 0.0, 0.0), .01 + .005*i));
+    radii.push_back(sphere_list.back().radius_);
+  }
+
+  collision_detection::PackedSphereSet packed;
+  EigenSTL::vector_Vector3d centers(sphere_list.size(), Eigen::Vector3d(0.0, 0.0, 0.0));
+  packed.addObject(centers, radii);
+
+  unsigned int num_colliding = 0;
+  for(double ox = -.4; ox <= .2; ox += .05) {
+    for(double oy = -.2; oy <= .2; oy += .05) {
+      for(unsigned int i = 0; i < sphere_list.size(); i++) {
+        centers[i] = Eigen::Vector3d(ox, oy, .02) + sphere_list[i].relative_vec_;
+      }
+      packed.setSphereCenters(0, centers);
+
+      std::vector<unsigned int> colls, packed_colls;
+      bool coll = collision_detection::getCollisionSphereCollision(&df, sphere_list, centers, .25, 0.0);
+      EXPECT_EQ(coll, collision_detection::getPackedSphereCollision(&df, packed, 0, .25, 0.0, 0, packed_colls));
+      EXPECT_EQ(collision_detection::getCollisionSphereCollision(&df, sphere_list, centers, .25, 0.0, 100, colls),
+                collision_detection::getPackedSphereCollision(&df, packed, 0, .25, 0.0, 100, packed_colls));
+      EXPECT_EQ(colls, packed_colls);
+      if(coll) {
+        num_colliding++;
+      }
+
+      collision_detection::GradientInfo gradient, packed_gradient;
+      gradient.types.assign(sphere_list.size(), collision_detection::NONE);
+      gradient.distances.assign(sphere_list.size(), DBL_MAX);
+      gradient.gradients.assign(sphere_list.size(), Eigen::Vector3d(0.0, 0.0, 0.0));
+      packed_gradient = gradient;
+      EXPECT_EQ(collision_detection::getCollisionSphereGradients(&df, sphere_list, centers, gradient,
+                                                                 collision_detection::ENVIRONMENT, 0.0, true, .25, false),
+                collision_detection::getPackedSphereGradients(&df, packed, 0, packed_gradient,
+                                                              collision_detection::ENVIRONMENT, 0.0, true, .25, false));
+      EXPECT_EQ(gradient.closest_distance, packed_gradient.closest_distance);
+      EXPECT_EQ(gradient.distances, packed_gradient.distances);
+      EXPECT_EQ(gradient.types, packed_gradient.types);
+      for(unsigned int i = 0; i < sphere_list.size(); i++) {
+        EXPECT_TRUE(gradient.gradients[i].isApprox(packed_gradient.gradients[i]));
+      }
+    }
+  }
+  // make sure both colliding and free placements were compared
+  EXPECT_GT(num_colliding, 0);
+  EXPECT_LT(num_colliding, 13*9);
+}
+
+TEST_F(DistanceFieldCollisionDetectionTester, SelfCollisionKnownPoses)
+{
+  collision_detection::CollisionRequest req;
+  req.group_name = "whole_body";
+  acm_->setEntry("r_gripper_palm_link", "l_gripper_palm_link", false);
+
+  robot_state::RobotState kstate(kmodel_);
+  kstate.setToDefaultValues();
+
+  Eigen::Affine3d pos1 = Eigen::Affine3d::Identity();
+  Eigen::Affine3d pos2 = Eigen::Affine3d::Identity();
+  pos2.translation().y() = .5;
+  kstate.getLinkState("r_gripper_palm_link")->updateGivenGlobalLinkTransform(pos1);
+  kstate.getLinkState("l_gripper_palm_link")->updateGivenGlobalLinkTransform(pos2);
+
+  collision_detection::CollisionResult res;
+  crobot_->checkSelfCollision(req, res, kstate, *acm_);
+  EXPECT_FALSE(res.collision);
+
+  pos2.translation().y() = .01;
+  kstate.getLinkState("l_gripper_palm_link")->updateGivenGlobalLinkTransform(pos2);
+  res = collision_detection::CollisionResult();
+  crobot_->checkSelfCollision(req, res, kstate, *acm_);
+  EXPECT_TRUE(res.collision);
+}
+
+TEST_F(DistanceFieldCollisionDetectionTester, SelfCollisionContinuous)
+{
+  collision_detection::CollisionRequest req;
+  req.group_name = "whole_body";
+  acm_->setEntry("r_gripper_palm_link", "l_gripper_palm_link", false);
+
+  robot_state::RobotState kstate1(kmodel_);
+  kstate1.setToDefaultValues();
+
+  // the right arm is turned in so its palm lies on the circle the left palm sweeps as the left shoulder pans; the
+  // left palm crosses it part way through the motion, while the chord between its end positions passes well clear
+  std::map<std::string, double> arm_val;
+  arm_val["r_shoulder_pan_joint"] = 0.24;
+  arm_val["l_shoulder_pan_joint"] = -0.7;
+  kstate1.setStateValues(arm_val);
+
+  robot_state::RobotState kstate2(kstate1);
+  arm_val["l_shoulder_pan_joint"] = 1.0;
+  kstate2.setStateValues(arm_val);
+
+  collision_detection::CollisionResult res;
+  crobot_->checkSelfCollision(req, res, kstate1, *acm_);
+  ASSERT_FALSE(res.collision);
+  res = collision_detection::CollisionResult();
+  crobot_->checkSelfCollision(req, res, kstate2, *acm_);
+  ASSERT_FALSE(res.collision);
+
+  res = collision_detection::CollisionResult();
+  crobot_->checkSelfCollision(req, res, kstate1, kstate2, *acm_);
+  EXPECT_TRUE(res.collision);
+
+  // a motion between two distinct but equal states is the same as a discrete check
+  robot_state::RobotState kstate3(kstate1);
+  res = collision_detection::CollisionResult();
+  crobot_->checkSelfCollision(req, res, kstate1, kstate3, *acm_);
+  EXPECT_FALSE(res.collision);
+}
+
+TEST_F(DistanceFieldCollisionDetectionTester, OtherRobotCollision)
+{
+  collision_detection::CollisionRequest req;
+  std::map<std::string, std::vector<collision_detection::CollisionSphere> > link_body_decompositions;
+  DefaultCRobotType other_robot(kmodel_, link_body_decompositions);
+
+  robot_state::RobotState kstate(kmodel_);
+  kstate.setToDefaultValues();
+  robot_state::RobotState other_state(kmodel_);
+  other_state.setToDefaultValues();
+
+  // both robots in the same place
+  collision_detection::CollisionResult res;
+  crobot_->checkOtherCollision(req, res, kstate, other_robot, other_state);
+  EXPECT_TRUE(res.collision);
+
+  // all pairs allowed
+  res = collision_detection::CollisionResult();
+  crobot_->checkOtherCollision(req, res, kstate, other_robot, other_state, *acm_);
+  EXPECT_FALSE(res.collision);
+
+  std::map<std::string, double> base_val;
+  base_val["world_joint/x"] = 5.0;
+  other_state.setStateValues(base_val);
+  res = collision_detection::CollisionResult();
+  crobot_->checkOtherCollision(req, res, kstate, other_robot, other_state);
+  EXPECT_FALSE(res.collision);
+
+  req.contacts = true;
+  req.max_contacts = 10;
+  base_val["world_joint/x"] = 0.0;
+  other_state.setStateValues(base_val);
+  res = collision_detection::CollisionResult();
+  crobot_->checkOtherCollision(req, res, kstate, other_robot, other_state);
+  EXPECT_TRUE(res.collision);
+  EXPECT_GT(res.contact_count, 0);
+  EXPECT_LE(res.contact_count, 10);
+}
+
+TEST_F(DistanceFieldCollisionDetectionTester, OtherRobotCollisionContinuous)
+{
+  collision_detection::CollisionRequest req;
+  std::map<std::string, std::vector<collision_detection::CollisionSphere> > link_body_decompositions;
+  DefaultCRobotType other_robot(kmodel_, link_body_decompositions);
+
+  robot_state::RobotState kstate(kmodel_);
+  kstate.setToDefaultValues();
+
+  // the other robot drives through this one, and is clear of it at both ends of the motion
+  std::map<std::string, double> base_val;
+  robot_state::RobotState other_state1(kmodel_);
+  other_state1.setToDefaultValues();
+  base_val["world_joint/x"] = -5.0;
+  other_state1.setStateValues(base_val);
+  robot_state::RobotState other_state2(kmodel_);
+  other_state2.setToDefaultValues();
+  base_val["world_joint/x"] = 5.0;
+  other_state2.setStateValues(base_val);
+
+  collision_detection::CollisionResult res;
+  crobot_->checkOtherCollision(req, res, kstate, other_robot, other_state1);
+  ASSERT_FALSE(res.collision);
+  res = collision_detection::CollisionResult();
+  crobot_->checkOtherCollision(req, res, kstate, other_robot, other_state2);
+  ASSERT_FALSE(res.collision);
+
+  res = collision_detection::CollisionResult();
+  crobot_->checkOtherCollision(req, res, kstate, kstate, other_robot, other_state1, other_state2);
+  EXPECT_TRUE(res.collision);
+
+  // the same robot state passed as both ends of the motion, with distinct but equal states for the other robot
+  robot_state::RobotState other_state3(other_state1);
+  res = collision_detection::CollisionResult();
+  crobot_->checkOtherCollision(req, res, kstate, kstate, other_robot, other_state1, other_state3);
+  EXPECT_FALSE(res.collision);
+}
+
+TEST_F(DistanceFieldCollisionDetectionTester, OtherRobotCollisionContinuousRotation)
+{
+  collision_detection::CollisionRequest req;
+  std::map<std::string, std::vector<collision_detection::CollisionSphere> > link_body_decompositions;
+  DefaultCRobotType other_robot(kmodel_, link_body_decompositions);
+
+  robot_state::RobotState kstate(kmodel_);
+  kstate.setToDefaultValues();
+
+  // the other robot stands behind this one and turns in place; its arms point sideways at both ends of the motion
+  // and reach into this robot only while they swing past the middle of the turn. Interpolating the sphere centers
+  // along chords would keep the arms well behind this robot throughout.
+  std::map<std::string, double> base_val;
+  base_val["world_joint/x"] = -1.0;
+  robot_state::RobotState other_state1(kmodel_);
+  other_state1.setToDefaultValues();
+  base_val["world_joint/theta"] = -1.4;
+  other_state1.setStateValues(base_val);
+  robot_state::RobotState other_state2(kmodel_);
+  other_state2.setToDefaultValues();
+  base_val["world_joint/theta"] = 1.4;
+  other_state2.setStateValues(base_val);
+
+  collision_detection::CollisionResult res;
+  crobot_->checkOtherCollision(req, res, kstate, other_robot, other_state1);
+  ASSERT_FALSE(res.collision);
+  res = collision_detection::CollisionResult();
+  crobot_->checkOtherCollision(req, res, kstate, other_robot, other_state2);
+  ASSERT_FALSE(res.collision);
+
+  res = collision_detection::CollisionResult();
+  crobot_->checkOtherCollision(req, res, kstate, kstate, other_robot, other_state1, other_state2);
+  EXPECT_TRUE(res.collision);
+}
+
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
@@ -245,6 +245,27 @@ public:
                         moveit_msgs::MoveItErrorCodes &error_code,
                         const kinematics::KinematicsQueryOptions &options = kinematics::KinematicsQueryOptions()) const;
 
+  /**
+   * @brief Batched search over many poses and seeds. When there are no free parameters and no solution callback,
+   * the IKFast solution does not depend on the seed, so each pose is solved once and reported for the first seed;
+   * otherwise the default implementation is used.
+   */
+  bool searchPositionIKBatch(const std::vector<geometry_msgs::Pose> &ik_poses,
+                             const std::vector<std::vector<double> > &ik_seed_states,
+                             double timeout,
+                             std::vector<kinematics::KinematicsBatchSolution> &solutions,
+                             kinematics::KinematicsResult &result,
+                             const kinematics::KinematicsBatchOptions &batch_options = kinematics::KinematicsBatchOptions(),
+                             const kinematics::KinematicsQueryOptions &options = kinematics::KinematicsQueryOptions()) const;
+
+  /**
+   * @brief The IKFast solver keeps no state between calls, so queries can run concurrently
+   */
+  bool supportsConcurrentQueries() const
+  {
+    return true;
+  }
+
   /**
    * @brief Given a set of joint angles and a set of links, compute their pose
    *
@@ -988,6 +1009,47 @@ bool IKFastKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose &ik_pose
   return false;
 }
 
+bool IKFastKinematicsPlugin::searchPositionIKBatch(const std::vector<geometry_msgs::Pose> &ik_poses,
+                                                   const std::vector<std::vector<double> > &ik_seed_states,
+                                                   double timeout,
+                                                   std::vector<kinematics::KinematicsBatchSolution> &solutions,
+                                                   kinematics::KinematicsResult &result,
+                                                   const kinematics::KinematicsBatchOptions &batch_options,
+                                                   const kinematics::KinematicsQueryOptions &options) const
+{
+  if(free_params_.size() != 0 || batch_options.solution_callback || ik_poses.empty() || ik_seed_states.empty() ||
+     (batch_options.seed_per_pose && ik_seed_states.size() != ik_poses.size()))
+    return kinematics::KinematicsBase::searchPositionIKBatch(ik_poses, ik_seed_states, timeout, solutions, result, batch_options, options);
+
+  ROS_DEBUG_STREAM_NAMED("ikfast","searchPositionIKBatch for " << ik_poses.size() << " poses");
+
+  // Without free params every seed leads to the same solution, so solve each pose once
+  solutions.clear();
+  ros::WallTime deadline = ros::WallTime::now() + ros::WallDuration(timeout);
+  std::size_t attempted = 0;
+  std::vector<double> solution;
+  moveit_msgs::MoveItErrorCodes error_code;
+  for(std::size_t i = 0; i < ik_poses.size(); ++i)
+  {
+    if(ros::WallTime::now() > deadline ||
+       (batch_options.max_solutions > 0 && solutions.size() >= batch_options.max_solutions))
+      break;
+    ++attempted;
+    std::size_t seed = batch_options.seed_per_pose ? i : 0;
+    if(getPositionIK(ik_poses[i], ik_seed_states[seed], solution, error_code, options))
+    {
+      solutions.resize(solutions.size() + 1);
+      solutions.back().pose_index = i;
+      solutions.back().seed_index = seed;
+      solutions.back().solution.swap(solution);
+    }
+  }
+
+  result.solution_percentage = attempted > 0 ? (double)solutions.size() / (double)attempted : 0.0;
+  result.kinematic_error = solutions.empty() ? kinematics::KinematicErrors::NO_SOLUTION : kinematics::KinematicErrors::OK;
+  return !solutions.empty();
+}
+
 // Used when there are no redundant joints - aka no free params
 bool IKFastKinematicsPlugin::getPositionIK(const geometry_msgs::Pose &ik_pose,
                                            const std::vector<double> &ik_seed_state,
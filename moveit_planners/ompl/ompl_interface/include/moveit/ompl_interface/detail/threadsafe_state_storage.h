@@ -43,6 +43,9 @@
 namespace ompl_interface
 {
 
+/** \brief Hand out one RobotState per thread, copied from a start state the first time a thread asks for it.
+    Every thread keeps a small lock-free cache of the states it was given, so the lock is only taken the
+    first time a thread uses an instance (or after the entry was evicted by other instances) */
 class TSStateStorage
 {
 public:
@@ -55,7 +58,12 @@ public:
 
 private:
 
+  robot_state::RobotState* lookupStateStorage() const;
+
   robot_state::RobotState                                       start_state_;
+
+  /// Identifies this instance in the per-thread caches; never reused, so stale cache entries cannot match
+  unsigned int                                                  id_;
   mutable std::map<boost::thread::id, robot_state::RobotState*> thread_states_;
   mutable boost::mutex                                                  lock_;
 };
@@ -62,9 +62,11 @@ void ompl_interface::ProjectionEvaluatorLinkPose::defaultCellSizes()
 void ompl_interface::ProjectionEvaluatorLinkPose::project(const ompl::base::State *state, ompl::base::EuclideanProjection &projection) const
 {
   robot_state::RobotState *s = tss_.getStateStorage();
-  planning_context_->getOMPLStateSpace()->copyToRobotState(*s, state);
+  // copy only the joint values (copyToRobotState() would update all transforms) and compute
+  // forward kinematics just for the chain of links up to link_
+  s->setJointGroupPositions(planning_context_->getJointModelGroup(), state->as<ModelBasedStateSpace::StateType>()->values);
 
-  const Eigen::Vector3d &o = s->getGlobalLinkTransform(link_).translation();
+  const Eigen::Vector3d &o = s->computeGlobalLinkTransform(link_).translation();
   projection(0) = o.x();
   projection(1) = o.y();
   projection(2) = o.z();
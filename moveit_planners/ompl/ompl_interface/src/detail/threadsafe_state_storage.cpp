@@ -36,12 +36,49 @@
 
 #include <moveit/ompl_interface/detail/threadsafe_state_storage.h>
 
-ompl_interface::TSStateStorage::TSStateStorage(const robot_model::RobotModelPtr &kmodel) : start_state_(kmodel)
+namespace
+{
+
+struct ThreadStateCache
+{
+  static const std::size_t SIZE = 4;
+
+  ThreadStateCache() : next_(0)
+  {
+    for (std::size_t i = 0 ; i < SIZE ; ++i)
+    {
+      ids_[i] = 0;
+      states_[i] = NULL;
+    }
+  }
+
+  unsigned int             ids_[SIZE];
+  robot_state::RobotState *states_[SIZE];
+  std::size_t              next_;
+};
+
+boost::thread_specific_ptr<ThreadStateCache>& threadStateCache()
+{
+  static boost::thread_specific_ptr<ThreadStateCache> cache;
+  return cache;
+}
+
+unsigned int nextStorageId()
+{
+  static boost::mutex lock;
+  static unsigned int id = 0;
+  boost::mutex::scoped_lock slock(lock);
+  return ++id;
+}
+
+}
+
+ompl_interface::TSStateStorage::TSStateStorage(const robot_model::RobotModelPtr &kmodel) : start_state_(kmodel), id_(nextStorageId())
 {
   start_state_.setToDefaultValues();
 }
 
-ompl_interface::TSStateStorage::TSStateStorage(const robot_state::RobotState &start_state) : start_state_(start_state)
+ompl_interface::TSStateStorage::TSStateStorage(const robot_state::RobotState &start_state) : start_state_(start_state), id_(nextStorageId())
 {
 }
 
@@ -52,9 +89,29 @@ ompl_interface::TSStateStorage::~TSStateStorage()
 }
 
 robot_state::RobotState* ompl_interface::TSStateStorage::getStateStorage() const
+{
+  boost::thread_specific_ptr<ThreadStateCache> &tsc = threadStateCache();
+  ThreadStateCache *cache = tsc.get();
+  if (!cache)
+  {
+    cache = new ThreadStateCache();
+    tsc.reset(cache);
+  }
+  for (std::size_t i = 0 ; i < ThreadStateCache::SIZE ; ++i)
+    if (cache->ids_[i] == id_)
+      return cache->states_[i];
+
+  robot_state::RobotState *st = lookupStateStorage();
+  cache->ids_[cache->next_] = id_;
+  cache->states_[cache->next_] = st;
+  cache->next_ = (cache->next_ + 1) % ThreadStateCache::SIZE;
+  return st;
+}
+
+robot_state::RobotState* ompl_interface::TSStateStorage::lookupStateStorage() const
 {
   robot_state::RobotState *st = NULL;
-  boost::mutex::scoped_lock slock(lock_);/// \todo use Thread Local Storage?
+  boost::mutex::scoped_lock slock(lock_);
   std::map<boost::thread::id, robot_state::RobotState*>::const_iterator it = thread_states_.find(boost::this_thread::get_id());
   if (it == thread_states_.end())
   {
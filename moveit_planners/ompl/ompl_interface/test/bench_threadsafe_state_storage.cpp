@@ -0,0 +1,97 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Measures how many state lookups per second TSStateStorage serves as the number of threads grows.
+   Not part of the tests, as the numbers only mean something on an otherwise idle machine. */
+
+#include <moveit/ompl_interface/detail/threadsafe_state_storage.h>
+#include <moveit_resources/config.h>
+
+#include <urdf_parser/urdf_parser.h>
+
+#include <fstream>
+#include <cstdio>
+#include <boost/filesystem/path.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+static void useStorage(const ompl_interface::TSStateStorage *tss, unsigned int count, double *sum)
+{
+  double s = 0.0;
+  for (unsigned int i = 0 ; i < count ; ++i)
+  {
+    robot_state::RobotState *st = tss->getStateStorage();
+    st->getVariablePositions()[0] = i;
+    s += st->getVariablePosition(0);
+  }
+  *sum = s;
+}
+
+int main(int argc, char **argv)
+{
+  boost::filesystem::path res_path(MOVEIT_TEST_RESOURCES_DIR);
+  std::string xml_string;
+  std::fstream xml_file((res_path / "pr2_description/urdf/robot.xml").string().c_str(), std::fstream::in);
+  while (xml_file.good())
+  {
+    std::string line;
+    std::getline(xml_file, line);
+    xml_string += (line + "\n");
+  }
+  urdf::ModelInterfaceSharedPtr urdf_model = urdf::parseURDF(xml_string);
+  if (!urdf_model)
+  {
+    fprintf(stderr, "Unable to load the PR2 model from '%s'\n", res_path.string().c_str());
+    return 1;
+  }
+  boost::shared_ptr<srdf::Model> srdf_model(new srdf::Model());
+  srdf_model->initFile(*urdf_model, (res_path / "pr2_description/srdf/robot.xml").string());
+  robot_model::RobotModelPtr robot_model(new moveit::core::RobotModel(urdf_model, srdf_model));
+
+  ompl_interface::TSStateStorage tss(robot_model);
+  const unsigned int count = 1000000;
+  for (unsigned int n = 1 ; n <= 8 ; n *= 2)
+  {
+    std::vector<double> sums(n, 0.0);
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    boost::thread_group threads;
+    for (unsigned int i = 0 ; i < n ; ++i)
+      threads.create_thread(boost::bind(&useStorage, &tss, count, &sums[i]));
+    threads.join_all();
+    double elapsed = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() / 1000000.0;
+    printf("%u thread(s): %lf million state lookups per second\n", n, (double)(n * count) / (elapsed * 1000000.0));
+  }
+  return 0;
+}
@@ -0,0 +1,170 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/threadsafe_state_storage.h>
+#include <moveit_resources/config.h>
+
+#include <urdf_parser/urdf_parser.h>
+
+#include <gtest/gtest.h>
+#include <fstream>
+#include <set>
+#include <boost/filesystem/path.hpp>
+#include <boost/bind.hpp>
+
+class LoadPlanningModelsPr2 : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    boost::filesystem::path res_path(MOVEIT_TEST_RESOURCES_DIR);
+
+    srdf_model_.reset(new srdf::Model());
+    std::string xml_string;
+    std::fstream xml_file((res_path / "pr2_description/urdf/robot.xml").string().c_str(), std::fstream::in);
+    if (xml_file.is_open())
+    {
+      while (xml_file.good())
+      {
+        std::string line;
+        std::getline(xml_file, line);
+        xml_string += (line + "\n");
+      }
+      xml_file.close();
+      urdf_model_ = urdf::parseURDF(xml_string);
+    }
+    srdf_model_->initFile(*urdf_model_, (res_path / "pr2_description/srdf/robot.xml").string());
+    robot_model_.reset(new moveit::core::RobotModel(urdf_model_, srdf_model_));
+  };
+
+  virtual void TearDown()
+  {
+  }
+
+protected:
+  robot_model::RobotModelPtr     robot_model_;
+  urdf::ModelInterfaceSharedPtr  urdf_model_;
+  boost::shared_ptr<srdf::Model> srdf_model_;
+};
+
+static void getStorage(const ompl_interface::TSStateStorage *tss, robot_state::RobotState **result)
+{
+  *result = tss->getStateStorage();
+}
+
+static void useStorage(const ompl_interface::TSStateStorage *tss, unsigned int count, double *sum)
+{
+  double s = 0.0;
+  for (unsigned int i = 0 ; i < count ; ++i)
+  {
+    robot_state::RobotState *st = tss->getStateStorage();
+    st->getVariablePositions()[0] = i;
+    s += st->getVariablePosition(0);
+  }
+  *sum = s;
+}
+
+TEST_F(LoadPlanningModelsPr2, PerThreadStates)
+{
+  ompl_interface::TSStateStorage tss1(robot_model_);
+  ompl_interface::TSStateStorage tss2(robot_model_);
+
+  robot_state::RobotState *st = tss1.getStateStorage();
+  EXPECT_EQ(st, tss1.getStateStorage());
+  EXPECT_NE(st, tss2.getStateStorage());
+  EXPECT_EQ(st, tss1.getStateStorage());
+
+  // more instances than the per-thread cache holds must still give stable answers
+  std::vector<boost::shared_ptr<ompl_interface::TSStateStorage> > many;
+  std::vector<robot_state::RobotState*> many_states;
+  for (int i = 0 ; i < 10 ; ++i)
+  {
+    many.push_back(boost::shared_ptr<ompl_interface::TSStateStorage>(new ompl_interface::TSStateStorage(robot_model_)));
+    many_states.push_back(many.back()->getStateStorage());
+  }
+  for (std::size_t i = 0 ; i < many.size() ; ++i)
+    EXPECT_EQ(many_states[i], many[i]->getStateStorage());
+  EXPECT_EQ(st, tss1.getStateStorage());
+
+  const unsigned int n = 4;
+  std::vector<robot_state::RobotState*> states(n, NULL);
+  boost::thread_group threads;
+  for (unsigned int i = 0 ; i < n ; ++i)
+    threads.create_thread(boost::bind(&getStorage, &tss1, &states[i]));
+  threads.join_all();
+
+  std::set<robot_state::RobotState*> distinct(states.begin(), states.end());
+  distinct.insert(st);
+  EXPECT_EQ(n + 1, distinct.size());
+}
+
+TEST_F(LoadPlanningModelsPr2, ReusedInstanceAddress)
+{
+  robot_state::RobotState *st = NULL;
+  {
+    ompl_interface::TSStateStorage tss(robot_model_);
+    st = tss.getStateStorage();
+    st->setVariablePosition(0, 1.0);
+  }
+  robot_state::RobotState start(robot_model_);
+  start.setToDefaultValues();
+  start.setVariablePosition(0, 2.0);
+
+  // a new instance (possibly at the same address) must not hand out the state of the destroyed one
+  ompl_interface::TSStateStorage tss(start);
+  EXPECT_EQ(2.0, tss.getStateStorage()->getVariablePosition(0));
+}
+
+TEST_F(LoadPlanningModelsPr2, ConcurrentUse)
+{
+  ompl_interface::TSStateStorage tss(robot_model_);
+  const unsigned int n = 4;
+  const unsigned int count = 10000;
+  std::vector<double> sums(n, 0.0);
+  boost::thread_group threads;
+  for (unsigned int i = 0 ; i < n ; ++i)
+    threads.create_thread(boost::bind(&useStorage, &tss, count, &sums[i]));
+  threads.join_all();
+
+  // every thread works on its own state, so none of them sees the values written by another
+  for (unsigned int i = 0 ; i < n ; ++i)
+    EXPECT_EQ((double)count * (count - 1) / 2.0, sums[i]);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,165 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt! contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#ifndef MOVEIT_ROS_BENCHMARKS_BENCHMARK_CORPUS_
+#define MOVEIT_ROS_BENCHMARKS_BENCHMARK_CORPUS_
+
+#include <ros/ros.h>
+#include <ros/serialization.h>
+#include <boost/shared_ptr.hpp>
+#include <boost/shared_array.hpp>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace boost
+{
+namespace interprocess
+{
+class mapped_region;
+}
+}
+
+namespace moveit_ros_benchmarks
+{
+/// The kinds of messages a benchmark corpus stores
+enum CorpusEntryType
+{
+  CORPUS_PLANNING_SCENE,
+  CORPUS_PLANNING_SCENE_WORLD,
+  CORPUS_MOTION_PLAN_REQUEST,
+  CORPUS_ROBOT_STATE,
+  CORPUS_CONSTRAINTS,
+  CORPUS_TRAJECTORY_CONSTRAINTS
+};
+
+/// A benchmark corpus is a directory with the serialized planning scenes, queries, start states and constraints
+/// of a benchmark, so that benchmarks can be run without a warehouse database.  The messages are concatenated in a
+/// data file; a text index file lists the type, scene, name, offset and size of each of them.
+/// Motion plan requests are named per scene, all other entries have an empty scene name.
+class BenchmarkCorpus
+{
+public:
+  static const std::string INDEX_FILE;
+  static const std::string DATA_FILE;
+
+  BenchmarkCorpus();
+  ~BenchmarkCorpus();
+
+  /// Read the index of the corpus in the given directory and memory-map its data file
+  bool open(const std::string& directory);
+  void close();
+  bool isOpen() const;
+
+  bool hasEntry(CorpusEntryType type, const std::string& name, const std::string& scene = "") const;
+
+  /// Get the names of the entries of the given type that match regex anywhere in the name.  An empty regex matches
+  /// all names.
+  void getEntryNames(CorpusEntryType type, const std::string& regex, std::vector<std::string>& names,
+                     const std::string& scene = "") const;
+
+  /// Deserialize an entry into msg.  Returns false if there is no such entry or it cannot be read.
+  template <typename T>
+  bool getEntry(CorpusEntryType type, const std::string& name, const std::string& scene, T& msg) const
+  {
+    const uint8_t* data;
+    std::size_t size;
+    if (!getEntryData(type, name, scene, data, size))
+      return false;
+    try
+    {
+      // deserialization only reads from the stream, the mapping itself is read-only
+      ros::serialization::IStream stream(const_cast<uint8_t*>(data), size);
+      ros::serialization::deserialize(stream, msg);
+    }
+    catch (ros::Exception& ex)
+    {
+      ROS_ERROR("Failed to read '%s' from the benchmark corpus: %s", name.c_str(), ex.what());
+      return false;
+    }
+    return true;
+  }
+
+private:
+  struct Entry
+  {
+    std::size_t offset;
+    std::size_t size;
+  };
+
+  /// Entries of one type, by (scene, name)
+  typedef std::map<std::pair<std::string, std::string>, Entry> EntryMap;
+
+  bool getEntryData(CorpusEntryType type, const std::string& name, const std::string& scene, const uint8_t*& data,
+                    std::size_t& size) const;
+
+  std::vector<EntryMap> entries_;
+  boost::shared_ptr<boost::interprocess::mapped_region> region_;
+  bool open_;
+};
+
+/// Writes the messages of a benchmark corpus, see BenchmarkCorpus for the format
+class BenchmarkCorpusWriter
+{
+public:
+  BenchmarkCorpusWriter();
+  ~BenchmarkCorpusWriter();
+
+  /// Create (or overwrite) the corpus in the given directory
+  bool open(const std::string& directory);
+  /// Finish writing the corpus.  Returns false if any of the data could not be written
+  bool close();
+
+  template <typename T>
+  bool addEntry(CorpusEntryType type, const std::string& name, const std::string& scene, const T& msg)
+  {
+    uint32_t size = ros::serialization::serializationLength(msg);
+    boost::shared_array<uint8_t> buffer(new uint8_t[size]);
+    ros::serialization::OStream stream(buffer.get(), size);
+    ros::serialization::serialize(stream, msg);
+    return addEntryData(type, name, scene, buffer.get(), size);
+  }
+
+private:
+  bool addEntryData(CorpusEntryType type, const std::string& name, const std::string& scene, const uint8_t* data,
+                    std::size_t size);
+
+  std::ofstream index_;
+  std::ofstream data_;
+  std::size_t offset_;
+};
+}
+
+#endif
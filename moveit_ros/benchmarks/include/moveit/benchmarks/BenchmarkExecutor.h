@@ -38,6 +38,7 @@
 #define MOVEIT_ROS_BENCHMARKS_BENCHMARK_EXECUTOR_
 
 #include <moveit/benchmarks/BenchmarkOptions.h>
+#include <moveit/benchmarks/BenchmarkCorpus.h>
 
 #include <moveit/planning_scene_monitor/planning_scene_monitor.h>
 
@@ -53,7 +54,10 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <fstream>
 #include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/progress.hpp>
 
 namespace moveit_ros_benchmarks
 {
@@ -111,6 +115,28 @@ public:
 
   virtual bool runBenchmarks(const BenchmarkOptions& opts);
 
+  /// Append the data of a finished run to a journal.  Each run is one line with the plugin, planner, run index,
+  /// property count and the (name, value) pairs of the run, separated by tabs
+  static void writeJournalEntry(std::ostream& out, const std::pair<std::string, std::string>& planner, int run,
+                                const PlannerRunData& run_data);
+
+  /// Restore the runs recorded in a journal into data (one entry per planner, with runs entries each), marking them in
+  /// done.  Comments, malformed and cut-off records and runs of other planners are skipped.  Returns the number of runs
+  /// that were restored
+  static std::size_t readJournal(const std::string& filename,
+                                 const std::vector<std::pair<std::string, std::string>>& planners, int runs,
+                                 std::vector<PlannerBenchmarkData>& data, std::vector<std::vector<bool>>& done);
+
+  /// Open a journal for writing.  When resuming, the runs already recorded are kept and a record that was cut off
+  /// when the sweep was interrupted is terminated; otherwise the journal is truncated
+  static bool openJournal(std::ofstream& journal, const std::string& filename, bool resume);
+
+  /// Mark the query of a journal as completely benchmarked
+  static void markJournalComplete(const std::string& filename);
+
+  /// Check whether the query of a journal was completely benchmarked
+  static bool isJournalComplete(const std::string& filename);
+
 protected:
   struct BenchmarkRequest
   {
@@ -136,11 +162,40 @@ protected:
     std::string name;
   };
 
+  /// The runs of a single query that are shared out among the benchmark workers
+  struct RunSchedule
+  {
+    moveit_msgs::MotionPlanRequest request;
+
+    /// (plugin, planner id) pairs, in the order of benchmark_data_
+    std::vector<std::pair<std::string, std::string>> planners;
+
+    /// (planner index, run index) pairs that still need to be executed
+    std::vector<std::pair<std::size_t, int>> tasks;
+    std::size_t next_task;
+
+    /// Number of unfinished runs for each planner
+    std::vector<int> remaining_runs;
+    std::vector<bool> started;
+
+    /// The scene each worker plans in
+    std::vector<planning_scene::PlanningScenePtr> scenes;
+
+    /// Protects the task list, the events, the journal and the progress display
+    boost::mutex lock;
+    /// Serializes the creation of planning contexts
+    boost::mutex context_lock;
+
+    std::ofstream journal;
+    boost::progress_display* progress;
+  };
+
   virtual bool initializeBenchmarks(const BenchmarkOptions& opts, moveit_msgs::PlanningScene& scene_msg,
                                     std::vector<BenchmarkRequest>& queries);
 
+  /// Compute the metrics of a run; the trajectories are checked against scene, the scene the run planned in
   virtual void collectMetrics(PlannerRunData& metrics, const planning_interface::MotionPlanDetailedResponse& mp_res,
-                              bool solved, double total_time);
+                              bool solved, double total_time, const planning_scene::PlanningScene& scene);
 
   virtual void writeOutput(const BenchmarkRequest& brequest, const std::string& start_time, double benchmark_duration);
 
@@ -174,9 +229,17 @@ protected:
                                  const std::vector<PathConstraints>& path_constraints,
                                  std::vector<BenchmarkRequest>& combos);
 
-  /// Execute the given motion plan request on the set of planners for the set number of runs
+  /// Execute the given motion plan request on the set of planners for the set number of runs.  Completed runs are
+  /// appended to journal_file as they finish; when resuming, the runs already recorded there are not repeated.
   void runBenchmark(moveit_msgs::MotionPlanRequest request,
-                    const std::map<std::string, std::vector<std::string>>& planners, int runs);
+                    const std::map<std::string, std::vector<std::string>>& planners, int runs,
+                    const std::string& journal_file = "");
+
+  /// Execute runs from the schedule until none are left
+  void runWorker(RunSchedule& schedule, unsigned int worker);
+
+  /// Name of the file that records the finished runs of the given query
+  std::string getJournalFileName(const BenchmarkRequest& brequest) const;
 
   planning_scene_monitor::PlanningSceneMonitor* psm_;
   moveit_warehouse::PlanningSceneStorage* pss_;
@@ -186,6 +249,9 @@ protected:
   moveit_warehouse::TrajectoryConstraintsStorage* tcs_;
 
   warehouse_ros::DatabaseLoader dbloader;
+
+  /// Used instead of the warehouse when the options name a corpus directory
+  BenchmarkCorpus corpus_;
   planning_scene::PlanningScenePtr planning_scene_;
 
   BenchmarkOptions options_;
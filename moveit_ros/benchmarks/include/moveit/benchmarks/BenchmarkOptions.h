@@ -57,6 +57,7 @@ public:
   const std::string& getHostName() const;
   int getPort() const;
   const std::string& getSceneName() const;
+  const std::string& getCorpusDirectory() const;
 
   int getNumRuns() const;
   double getTimeout() const;
@@ -72,6 +73,10 @@ public:
   const std::map<std::string, std::vector<std::string>>& getPlannerConfigurations() const;
   void getPlannerPluginList(std::vector<std::string>& plugin_list) const;
 
+  int getNumWorkers() const;
+  bool getPinWorkers() const;
+  bool getResume() const;
+
   const std::string& getWorkspaceFrameID() const;
   const moveit_msgs::WorkspaceParameters& getWorkspaceParameters() const;
 
@@ -89,6 +94,7 @@ protected:
   std::string hostname_;
   int port_;
   std::string scene_name_;
+  std::string corpus_directory_;
 
   /// benchmark parameters
   int runs_;
@@ -103,6 +109,11 @@ protected:
   std::string trajectory_constraint_regex_;
   double goal_offsets[6];
 
+  /// run scheduling
+  int workers_;
+  bool pin_workers_;
+  bool resume_;
+
   /// planner configurations
   std::map<std::string, std::vector<std::string>> planners_;
 
@@ -0,0 +1,260 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt! contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <moveit/benchmarks/BenchmarkCorpus.h>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/regex.hpp>
+#include <algorithm>
+
+using namespace moveit_ros_benchmarks;
+
+const std::string BenchmarkCorpus::INDEX_FILE = "corpus.index";
+const std::string BenchmarkCorpus::DATA_FILE = "corpus.data";
+
+namespace
+{
+const std::string INDEX_HEADER = "moveit_benchmark_corpus 1";
+
+const char* ENTRY_TYPE_NAMES[] = { "planning_scene", "planning_scene_world", "motion_plan_request",
+                                   "robot_state",    "constraints",          "trajectory_constraints" };
+const std::size_t ENTRY_TYPE_COUNT = sizeof(ENTRY_TYPE_NAMES) / sizeof(ENTRY_TYPE_NAMES[0]);
+
+std::string getCorpusFileName(const std::string& directory, const std::string& file)
+{
+  return (boost::filesystem::path(directory) / file).string();
+}
+}
+
+BenchmarkCorpus::BenchmarkCorpus() : entries_(ENTRY_TYPE_COUNT), open_(false)
+{
+}
+
+BenchmarkCorpus::~BenchmarkCorpus()
+{
+}
+
+bool BenchmarkCorpus::open(const std::string& directory)
+{
+  close();
+
+  std::string index_file = getCorpusFileName(directory, INDEX_FILE);
+  std::ifstream index(index_file.c_str());
+  if (!index)
+  {
+    ROS_ERROR("Failed to open benchmark corpus index '%s'", index_file.c_str());
+    return false;
+  }
+
+  std::string line;
+  if (!std::getline(index, line) || line != INDEX_HEADER)
+  {
+    ROS_ERROR("'%s' is not a benchmark corpus index", index_file.c_str());
+    return false;
+  }
+
+  // Each line is: type, scene, name, offset, size; separated by tabs
+  std::size_t data_size = 0;
+  std::vector<std::string> fields;
+  while (std::getline(index, line))
+  {
+    if (line.empty())
+      continue;
+    boost::split(fields, line, boost::is_any_of("\t"));
+
+    std::size_t type = std::find(ENTRY_TYPE_NAMES, ENTRY_TYPE_NAMES + ENTRY_TYPE_COUNT, fields[0]) - ENTRY_TYPE_NAMES;
+    Entry entry;
+    try
+    {
+      if (fields.size() != 5 || type == ENTRY_TYPE_COUNT)
+        throw boost::bad_lexical_cast();
+      entry.offset = boost::lexical_cast<std::size_t>(fields[3]);
+      entry.size = boost::lexical_cast<std::size_t>(fields[4]);
+    }
+    catch (boost::bad_lexical_cast&)
+    {
+      ROS_ERROR("Malformed entry in benchmark corpus index '%s': '%s'", index_file.c_str(), line.c_str());
+      close();
+      return false;
+    }
+
+    entries_[type][std::make_pair(fields[1], fields[2])] = entry;
+    data_size = std::max(data_size, entry.offset + entry.size);
+  }
+
+  // A corpus without entries has an empty data file, which cannot be mapped
+  if (data_size > 0)
+  {
+    std::string data_file = getCorpusFileName(directory, DATA_FILE);
+    try
+    {
+      boost::interprocess::file_mapping file(data_file.c_str(), boost::interprocess::read_only);
+      region_.reset(new boost::interprocess::mapped_region(file, boost::interprocess::read_only));
+    }
+    catch (boost::interprocess::interprocess_exception& ex)
+    {
+      ROS_ERROR("Failed to map benchmark corpus data '%s': %s", data_file.c_str(), ex.what());
+      close();
+      return false;
+    }
+
+    if (region_->get_size() < data_size)
+    {
+      ROS_ERROR("Benchmark corpus data '%s' is shorter than its index", data_file.c_str());
+      close();
+      return false;
+    }
+  }
+
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < entries_.size(); ++i)
+    count += entries_[i].size();
+  ROS_INFO("Opened benchmark corpus '%s' with %lu entries", directory.c_str(), count);
+
+  open_ = true;
+  return true;
+}
+
+void BenchmarkCorpus::close()
+{
+  entries_.assign(ENTRY_TYPE_COUNT, EntryMap());
+  region_.reset();
+  open_ = false;
+}
+
+bool BenchmarkCorpus::isOpen() const
+{
+  return open_;
+}
+
+bool BenchmarkCorpus::hasEntry(CorpusEntryType type, const std::string& name, const std::string& scene) const
+{
+  return entries_[type].find(std::make_pair(scene, name)) != entries_[type].end();
+}
+
+void BenchmarkCorpus::getEntryNames(CorpusEntryType type, const std::string& regex, std::vector<std::string>& names,
+                                    const std::string& scene) const
+{
+  names.clear();
+  boost::regex name_regex(regex);
+
+  // entries are sorted by scene first, so all entries of the scene are adjacent
+  for (EntryMap::const_iterator it = entries_[type].lower_bound(std::make_pair(scene, std::string()));
+       it != entries_[type].end() && it->first.first == scene; ++it)
+    if (regex.empty() || boost::regex_search(it->first.second, name_regex))
+      names.push_back(it->first.second);
+}
+
+bool BenchmarkCorpus::getEntryData(CorpusEntryType type, const std::string& name, const std::string& scene,
+                                   const uint8_t*& data, std::size_t& size) const
+{
+  EntryMap::const_iterator it = entries_[type].find(std::make_pair(scene, name));
+  if (it == entries_[type].end())
+    return false;
+
+  data = static_cast<const uint8_t*>(region_->get_address()) + it->second.offset;
+  size = it->second.size;
+  return true;
+}
+
+BenchmarkCorpusWriter::BenchmarkCorpusWriter() : offset_(0)
+{
+}
+
+BenchmarkCorpusWriter::~BenchmarkCorpusWriter()
+{
+  close();
+}
+
+bool BenchmarkCorpusWriter::open(const std::string& directory)
+{
+  close();
+
+  boost::filesystem::create_directories(directory);
+  std::string index_file = getCorpusFileName(directory, BenchmarkCorpus::INDEX_FILE);
+  std::string data_file = getCorpusFileName(directory, BenchmarkCorpus::DATA_FILE);
+  index_.open(index_file.c_str(), std::ios::trunc);
+  data_.open(data_file.c_str(), std::ios::binary | std::ios::trunc);
+  if (!index_ || !data_)
+  {
+    ROS_ERROR("Failed to create benchmark corpus in '%s'", directory.c_str());
+    close();
+    return false;
+  }
+
+  index_ << INDEX_HEADER << std::endl;
+  offset_ = 0;
+  return true;
+}
+
+bool BenchmarkCorpusWriter::close()
+{
+  bool ok = true;
+  if (index_.is_open())
+  {
+    index_.close();
+    ok = ok && !index_.fail();
+  }
+  if (data_.is_open())
+  {
+    data_.close();
+    ok = ok && !data_.fail();
+  }
+  return ok;
+}
+
+bool BenchmarkCorpusWriter::addEntryData(CorpusEntryType type, const std::string& name, const std::string& scene,
+                                         const uint8_t* data, std::size_t size)
+{
+  if (!index_.is_open() || !data_.is_open())
+  {
+    ROS_ERROR("Benchmark corpus is not open for writing");
+    return false;
+  }
+
+  if (name.find_first_of("\t\n") != std::string::npos || scene.find_first_of("\t\n") != std::string::npos)
+  {
+    ROS_ERROR("Cannot store '%s' in the benchmark corpus: names may not contain tabs or line breaks", name.c_str());
+    return false;
+  }
+
+  data_.write(reinterpret_cast<const char*>(data), size);
+  index_ << ENTRY_TYPE_NAMES[type] << '\t' << scene << '\t' << name << '\t' << offset_ << '\t' << size << '\n';
+  offset_ += size;
+  return data_.good() && index_.good();
+}
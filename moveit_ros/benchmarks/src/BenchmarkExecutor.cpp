@@ -43,7 +43,15 @@
 #include <boost/math/constants/constants.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
 #include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <cstring>
+#include <algorithm>
 
 using namespace moveit_ros_benchmarks;
 
@@ -61,6 +69,25 @@ static std::string getHostname()
   }
 }
 
+static const char* JOURNAL_COMPLETE = "# complete";
+
+static void pinThreadToCore(unsigned int worker)
+{
+#ifdef __linux__
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cores < 1)
+    return;
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(worker % cores, &cpu_set);
+  int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  if (err != 0)
+    ROS_WARN("Failed to pin benchmark worker %u to core %ld: %s", worker, worker % cores, strerror(err));
+#else
+  ROS_WARN_ONCE("Pinning benchmark workers to cores is not supported on this platform");
+#endif
+}
+
 BenchmarkExecutor::BenchmarkExecutor(const std::string& robot_description_param)
 {
   pss_ = NULL;
@@ -171,6 +198,7 @@ void BenchmarkExecutor::clear()
     delete tcs_;
     tcs_ = NULL;
   }
+  corpus_.close();
 
   benchmark_data_.clear();
   pre_event_fns_.clear();
@@ -229,6 +257,14 @@ bool BenchmarkExecutor::runBenchmarks(const BenchmarkOptions& opts)
 
     for (std::size_t i = 0; i < queries.size(); ++i)
     {
+      std::string journal_file = getJournalFileName(queries[i]);
+      if (options_.getResume() && isJournalComplete(journal_file))
+      {
+        ROS_INFO("Skipping query '%s' (%lu of %lu), it was already benchmarked", queries[i].name.c_str(), i + 1,
+                 queries.size());
+        continue;
+      }
+
       // Configure planning scene
       if (scene_msg.robot_model_name != planning_scene_->getRobotModel()->getName())
       {
@@ -248,13 +284,16 @@ bool BenchmarkExecutor::runBenchmarks(const BenchmarkOptions& opts)
 
       ROS_INFO("Benchmarking query '%s' (%lu of %lu)", queries[i].name.c_str(), i + 1, queries.size());
       ros::WallTime start_time = ros::WallTime::now();
-      runBenchmark(queries[i].request, options_.getPlannerConfigurations(), options_.getNumRuns());
+      runBenchmark(queries[i].request, options_.getPlannerConfigurations(), options_.getNumRuns(), journal_file);
       double duration = (ros::WallTime::now() - start_time).toSec();
 
       for (std::size_t j = 0; j < query_end_fns_.size(); ++j)
         query_end_fns_[j](queries[i].request, planning_scene_);
 
       writeOutput(queries[i], boost::posix_time::to_iso_extended_string(start_time.toBoost()), duration);
+
+      // Mark the query as done so that resuming the sweep does not benchmark it again
+      markJournalComplete(journal_file);
     }
 
     return true;
@@ -289,29 +328,38 @@ bool BenchmarkExecutor::initializeBenchmarks(const BenchmarkOptions& opts, movei
   if (!plannerConfigurationsExist(opts.getPlannerConfigurations(), opts.getGroupName()))
     return false;
 
-  try
+  if (!opts.getCorpusDirectory().empty())
+  {
+    if (!corpus_.open(opts.getCorpusDirectory()))
+      return false;
+  }
+  else
   {
-    warehouse_ros::DatabaseConnection::Ptr conn = dbloader.loadDatabase();
-    conn->setParams(opts.getHostName(), opts.getPort(), 20);
-    if (conn->connect())
+    corpus_.close();
+    try
     {
-      pss_ = new moveit_warehouse::PlanningSceneStorage(conn);
-      psws_ = new moveit_warehouse::PlanningSceneWorldStorage(conn);
-      rs_ = new moveit_warehouse::RobotStateStorage(conn);
-      cs_ = new moveit_warehouse::ConstraintsStorage(conn);
-      tcs_ = new moveit_warehouse::TrajectoryConstraintsStorage(conn);
+      warehouse_ros::DatabaseConnection::Ptr conn = dbloader.loadDatabase();
+      conn->setParams(opts.getHostName(), opts.getPort(), 20);
+      if (conn->connect())
+      {
+        pss_ = new moveit_warehouse::PlanningSceneStorage(conn);
+        psws_ = new moveit_warehouse::PlanningSceneWorldStorage(conn);
+        rs_ = new moveit_warehouse::RobotStateStorage(conn);
+        cs_ = new moveit_warehouse::ConstraintsStorage(conn);
+        tcs_ = new moveit_warehouse::TrajectoryConstraintsStorage(conn);
+      }
+      else
+      {
+        ROS_ERROR("Failed to connect to DB");
+        return false;
+      }
     }
-    else
+    catch (std::runtime_error& e)
     {
-      ROS_ERROR("Failed to connect to DB");
+      ROS_ERROR("Failed to initialize benchmark server: '%s'", e.what());
       return false;
     }
   }
-  catch (std::runtime_error& e)
-  {
-    ROS_ERROR("Failed to initialize benchmark server: '%s'", e.what());
-    return false;
-  }
 
   std::vector<StartState> start_states;
   std::vector<PathConstraints> path_constraints;
@@ -562,6 +610,20 @@ bool BenchmarkExecutor::plannerConfigurationsExist(const std::map<std::string, s
 
 bool BenchmarkExecutor::loadPlanningScene(const std::string& scene_name, moveit_msgs::PlanningScene& scene_msg)
 {
+  if (corpus_.isOpen())
+  {
+    if (corpus_.hasEntry(CORPUS_PLANNING_SCENE, scene_name))
+      return corpus_.getEntry(CORPUS_PLANNING_SCENE, scene_name, "", scene_msg);
+    if (corpus_.hasEntry(CORPUS_PLANNING_SCENE_WORLD, scene_name))
+    {
+      scene_msg.robot_model_name =
+          "NO ROBOT INFORMATION. ONLY WORLD GEOMETRY";  // this will be fixed when running benchmark
+      return corpus_.getEntry(CORPUS_PLANNING_SCENE_WORLD, scene_name, "", scene_msg.world);
+    }
+    ROS_ERROR("Failed to find planning scene '%s'", scene_name.c_str());
+    return false;
+  }
+
   bool ok = false;
   try
   {
@@ -603,15 +665,18 @@ bool BenchmarkExecutor::loadQueries(const std::string& regex, const std::string&
     return true;
 
   std::vector<std::string> query_names;
-  try
-  {
-    pss_->getPlanningQueriesNames(regex, query_names, scene_name);
-  }
-  catch (std::runtime_error& ex)
-  {
-    ROS_ERROR("Error loading motion planning queries: %s", ex.what());
-    return false;
-  }
+  if (corpus_.isOpen())
+    corpus_.getEntryNames(CORPUS_MOTION_PLAN_REQUEST, regex, query_names, scene_name);
+  else
+    try
+    {
+      pss_->getPlanningQueriesNames(regex, query_names, scene_name);
+    }
+    catch (std::runtime_error& ex)
+    {
+      ROS_ERROR("Error loading motion planning queries: %s", ex.what());
+      return false;
+    }
 
   if (query_names.empty())
   {
@@ -621,6 +686,15 @@ bool BenchmarkExecutor::loadQueries(const std::string& regex, const std::string&
 
   for (std::size_t i = 0; i < query_names.size(); ++i)
   {
+    if (corpus_.isOpen())
+    {
+      BenchmarkRequest query;
+      query.name = query_names[i];
+      if (corpus_.getEntry(CORPUS_MOTION_PLAN_REQUEST, query_names[i], scene_name, query.request))
+        queries.push_back(query);
+      continue;
+    }
+
     moveit_warehouse::MotionPlanRequestWithMetadata planning_query;
     try
     {
@@ -647,12 +721,24 @@ bool BenchmarkExecutor::loadStates(const std::string& regex, std::vector<StartSt
   {
     boost::regex start_regex(regex);
     std::vector<std::string> state_names;
-    rs_->getKnownRobotStates(state_names);
+    if (corpus_.isOpen())
+      corpus_.getEntryNames(CORPUS_ROBOT_STATE, "", state_names);
+    else
+      rs_->getKnownRobotStates(state_names);
     for (std::size_t i = 0; i < state_names.size(); ++i)
     {
       boost::cmatch match;
       if (boost::regex_match(state_names[i].c_str(), match, start_regex))
       {
+        if (corpus_.isOpen())
+        {
+          StartState start_state;
+          start_state.name = state_names[i];
+          if (corpus_.getEntry(CORPUS_ROBOT_STATE, state_names[i], "", start_state.state))
+            start_states.push_back(start_state);
+          continue;
+        }
+
         moveit_warehouse::RobotStateWithMetadata robot_state;
         try
         {
@@ -684,10 +770,23 @@ bool BenchmarkExecutor::loadPathConstraints(const std::string& regex, std::vecto
   if (regex.size())
   {
     std::vector<std::string> cnames;
-    cs_->getKnownConstraints(regex, cnames);
+    if (corpus_.isOpen())
+      corpus_.getEntryNames(CORPUS_CONSTRAINTS, regex, cnames);
+    else
+      cs_->getKnownConstraints(regex, cnames);
 
     for (std::size_t i = 0; i < cnames.size(); ++i)
     {
+      if (corpus_.isOpen())
+      {
+        PathConstraints constraint;
+        constraint.constraints.resize(1);
+        constraint.name = cnames[i];
+        if (corpus_.getEntry(CORPUS_CONSTRAINTS, cnames[i], "", constraint.constraints[0]))
+          constraints.push_back(constraint);
+        continue;
+      }
+
       moveit_warehouse::ConstraintsWithMetadata constr;
       try
       {
@@ -720,10 +819,22 @@ bool BenchmarkExecutor::loadTrajectoryConstraints(const std::string& regex,
   if (regex.size())
   {
     std::vector<std::string> cnames;
-    tcs_->getKnownTrajectoryConstraints(regex, cnames);
+    if (corpus_.isOpen())
+      corpus_.getEntryNames(CORPUS_TRAJECTORY_CONSTRAINTS, regex, cnames);
+    else
+      tcs_->getKnownTrajectoryConstraints(regex, cnames);
 
     for (std::size_t i = 0; i < cnames.size(); ++i)
     {
+      if (corpus_.isOpen())
+      {
+        TrajectoryConstraints constraint;
+        constraint.name = cnames[i];
+        if (corpus_.getEntry(CORPUS_TRAJECTORY_CONSTRAINTS, cnames[i], "", constraint.constraints))
+          constraints.push_back(constraint);
+        continue;
+      }
+
       moveit_warehouse::TrajectoryConstraintsWithMetadata constr;
       try
       {
@@ -751,72 +862,276 @@ bool BenchmarkExecutor::loadTrajectoryConstraints(const std::string& regex,
 }
 
 void BenchmarkExecutor::runBenchmark(moveit_msgs::MotionPlanRequest request,
-                                     const std::map<std::string, std::vector<std::string>>& planners, int runs)
+                                     const std::map<std::string, std::vector<std::string>>& planners, int runs,
+                                     const std::string& journal_file)
 {
-  benchmark_data_.clear();
-
-  unsigned int num_planners = 0;
+  RunSchedule schedule;
+  schedule.request = request;
   for (std::map<std::string, std::vector<std::string>>::const_iterator it = planners.begin(); it != planners.end();
        ++it)
-    num_planners += it->second.size();
+    for (std::size_t i = 0; i < it->second.size(); ++i)
+      schedule.planners.push_back(std::make_pair(it->first, it->second[i]));
 
-  boost::progress_display progress(num_planners * runs, std::cout);
+  // This container stores all of the benchmark data, one entry per planner
+  benchmark_data_.assign(schedule.planners.size(), PlannerBenchmarkData(runs));
 
-  // Iterate through all planner plugins
-  for (std::map<std::string, std::vector<std::string>>::const_iterator it = planners.begin(); it != planners.end();
-       ++it)
+  std::vector<std::vector<bool>> done(schedule.planners.size(), std::vector<bool>(runs, false));
+  if (options_.getResume() && !journal_file.empty())
   {
-    // Iterate through all planners associated with the plugin
-    for (std::size_t i = 0; i < it->second.size(); ++i)
-    {
-      // This container stores all of the benchmark data for this planner
-      PlannerBenchmarkData planner_data(runs);
+    std::size_t restored = readJournal(journal_file, schedule.planners, runs, benchmark_data_, done);
+    ROS_INFO("Restored %lu runs from '%s'", restored, journal_file.c_str());
+  }
 
-      request.planner_id = it->second[i];
+  // Runs are handed out planner by planner, so that a worker can keep its planning context for consecutive runs
+  schedule.next_task = 0;
+  schedule.remaining_runs.assign(schedule.planners.size(), 0);
+  schedule.started.assign(schedule.planners.size(), false);
+  for (std::size_t i = 0; i < schedule.planners.size(); ++i)
+    for (int j = 0; j < runs; ++j)
+      if (!done[i][j])
+      {
+        schedule.tasks.push_back(std::make_pair(i, j));
+        ++schedule.remaining_runs[i];
+      }
 
-      // Planner start events
+  // Planners whose runs were all restored from the journal still get their events
+  for (std::size_t i = 0; i < schedule.planners.size(); ++i)
+    if (schedule.remaining_runs[i] == 0)
+    {
+      request.planner_id = schedule.planners[i].second;
       for (std::size_t j = 0; j < planner_start_fns_.size(); ++j)
-        planner_start_fns_[j](request, planner_data);
+        planner_start_fns_[j](request, benchmark_data_[i]);
+      for (std::size_t j = 0; j < planner_completion_fns_.size(); ++j)
+        planner_completion_fns_[j](request, benchmark_data_[i]);
+      schedule.started[i] = true;
+    }
+
+  if (!journal_file.empty() && !openJournal(schedule.journal, journal_file, options_.getResume()))
+    ROS_WARN("Failed to open '%s', finished runs will not be recorded", journal_file.c_str());
+
+  unsigned int num_workers = std::min<std::size_t>(options_.getNumWorkers(), schedule.tasks.size());
 
-      planning_interface::PlanningContextPtr context =
-          planner_interfaces_[it->first]->getPlanningContext(planning_scene_, request);
-      for (int j = 0; j < runs; ++j)
+  // Every worker plans in its own copy of the scene; a single worker can use the scene directly
+  schedule.scenes.resize(num_workers);
+  for (unsigned int i = 0; i < num_workers; ++i)
+    schedule.scenes[i] = num_workers == 1 ? planning_scene_ : planning_scene::PlanningScene::clone(planning_scene_);
+
+  boost::progress_display progress(schedule.tasks.size(), std::cout);
+  schedule.progress = &progress;
+
+  boost::thread_group workers;
+  for (unsigned int i = 0; i < num_workers; ++i)
+    workers.create_thread(boost::bind(&BenchmarkExecutor::runWorker, this, boost::ref(schedule), i));
+  workers.join_all();
+}
+
+void BenchmarkExecutor::runWorker(RunSchedule& schedule, unsigned int worker)
+{
+  if (options_.getPinWorkers())
+    pinThreadToCore(worker);
+
+  planning_interface::PlanningContextPtr context;
+  std::size_t context_planner = schedule.planners.size();
+
+  while (true)
+  {
+    std::size_t planner;
+    int run;
+    moveit_msgs::MotionPlanRequest request;
+
+    {
+      boost::mutex::scoped_lock slock(schedule.lock);
+      if (schedule.next_task >= schedule.tasks.size())
+        break;
+      planner = schedule.tasks[schedule.next_task].first;
+      run = schedule.tasks[schedule.next_task].second;
+      ++schedule.next_task;
+
+      request = schedule.request;
+      request.planner_id = schedule.planners[planner].second;
+
+      // Planner start events, before any run of the planner is handed out
+      if (!schedule.started[planner])
       {
-        // Pre-run events
-        for (std::size_t k = 0; k < pre_event_fns_.size(); ++k)
-          pre_event_fns_[k](request);
-
-        // Solve problem
-        planning_interface::MotionPlanDetailedResponse mp_res;
-        ros::WallTime start = ros::WallTime::now();
-        bool solved = context->solve(mp_res);
-        double total_time = (ros::WallTime::now() - start).toSec();
-
-        // Collect data
-        start = ros::WallTime::now();
-
-        // Post-run events
-        for (std::size_t k = 0; k < post_event_fns_.size(); ++k)
-          post_event_fns_[k](request, mp_res, planner_data[j]);
-        collectMetrics(planner_data[j], mp_res, solved, total_time);
-        double metrics_time = (ros::WallTime::now() - start).toSec();
-        ROS_DEBUG("Spent %lf seconds collecting metrics", metrics_time);
-
-        ++progress;
+        for (std::size_t j = 0; j < planner_start_fns_.size(); ++j)
+          planner_start_fns_[j](request, benchmark_data_[planner]);
+        schedule.started[planner] = true;
       }
+    }
+
+    if (context_planner != planner)
+    {
+      boost::mutex::scoped_lock slock(schedule.context_lock);
+      context = planner_interfaces_[schedule.planners[planner].first]->getPlanningContext(schedule.scenes[worker],
+                                                                                            request);
+      context_planner = planner;
+    }
+
+    {
+      boost::mutex::scoped_lock slock(schedule.lock);
+
+      // Pre-run events
+      for (std::size_t k = 0; k < pre_event_fns_.size(); ++k)
+        pre_event_fns_[k](request);
+    }
+
+    // Solve problem
+    planning_interface::MotionPlanDetailedResponse mp_res;
+    bool solved = false;
+    double total_time = 0.0;
+    if (context)
+    {
+      ros::WallTime start = ros::WallTime::now();
+      solved = context->solve(mp_res);
+      total_time = (ros::WallTime::now() - start).toSec();
+    }
+    else
+      ROS_ERROR("Failed to create a planning context for planner '%s'", request.planner_id.c_str());
+
+    // Collect data
+    ros::WallTime start = ros::WallTime::now();
+    PlannerRunData& run_data = benchmark_data_[planner][run];
+
+    {
+      boost::mutex::scoped_lock slock(schedule.lock);
+
+      // Post-run events
+      for (std::size_t k = 0; k < post_event_fns_.size(); ++k)
+        post_event_fns_[k](request, mp_res, run_data);
+    }
+
+    // The trajectories are checked in the scene of this worker, so the metrics are collected concurrently
+    collectMetrics(run_data, mp_res, solved, total_time, *schedule.scenes[worker]);
+    double metrics_time = (ros::WallTime::now() - start).toSec();
+    ROS_DEBUG("Spent %lf seconds collecting metrics", metrics_time);
+
+    {
+      boost::mutex::scoped_lock slock(schedule.lock);
+      if (schedule.journal.is_open())
+        writeJournalEntry(schedule.journal, schedule.planners[planner], run, run_data);
+      ++(*schedule.progress);
 
       // Planner completion events
-      for (std::size_t j = 0; j < planner_completion_fns_.size(); ++j)
-        planner_completion_fns_[j](request, planner_data);
+      if (--schedule.remaining_runs[planner] == 0)
+        for (std::size_t j = 0; j < planner_completion_fns_.size(); ++j)
+          planner_completion_fns_[j](request, benchmark_data_[planner]);
+    }
+  }
+}
+
+std::string BenchmarkExecutor::getJournalFileName(const BenchmarkRequest& brequest) const
+{
+  std::string filename = options_.getOutputDirectory();
+  if (filename.size() && filename[filename.size() - 1] != '/')
+    filename.append("/");
 
-      benchmark_data_.push_back(planner_data);
+  // Ensure directories exist
+  boost::filesystem::create_directories(filename);
+
+  return filename + (options_.getBenchmarkName().empty() ? "" : options_.getBenchmarkName() + "_") + brequest.name +
+         ".journal";
+}
+
+void BenchmarkExecutor::writeJournalEntry(std::ostream& out, const std::pair<std::string, std::string>& planner,
+                                          int run, const PlannerRunData& run_data)
+{
+  // One line per run: plugin, planner, run index, property count and the (name, value) pairs, separated by tabs
+  out << planner.first << '\t' << planner.second << '\t' << run << '\t' << run_data.size();
+  for (PlannerRunData::const_iterator it = run_data.begin(); it != run_data.end(); ++it)
+    out << '\t' << it->first << '\t' << it->second;
+  out << std::endl;
+}
+
+std::size_t BenchmarkExecutor::readJournal(const std::string& filename,
+                                           const std::vector<std::pair<std::string, std::string>>& planners, int runs,
+                                           std::vector<PlannerBenchmarkData>& data, std::vector<std::vector<bool>>& done)
+{
+  std::ifstream in(filename.c_str());
+  if (!in)
+    return 0;
+
+  std::size_t restored = 0;
+  std::string line;
+  while (std::getline(in, line))
+  {
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    std::vector<std::string> fields;
+    boost::split(fields, line, boost::is_any_of("\t"));
+
+    int run;
+    std::size_t count;
+    try
+    {
+      if (fields.size() < 4)
+        throw boost::bad_lexical_cast();
+      run = boost::lexical_cast<int>(fields[2]);
+      count = boost::lexical_cast<std::size_t>(fields[3]);
+    }
+    catch (boost::bad_lexical_cast&)
+    {
+      ROS_WARN("Ignoring malformed entry in '%s'", filename.c_str());
+      continue;
+    }
+
+    // A record that was cut off when the sweep was interrupted is run again
+    if (fields.size() != 4 + 2 * count || run < 0 || run >= runs)
+    {
+      ROS_WARN("Ignoring incomplete entry in '%s'", filename.c_str());
+      continue;
+    }
+
+    std::size_t planner = std::find(planners.begin(), planners.end(), std::make_pair(fields[0], fields[1])) -
+                          planners.begin();
+    if (planner == planners.size())
+      continue;
+
+    PlannerRunData& run_data = benchmark_data_[planner][run];
+    run_data.clear();
+    for (std::size_t i = 0; i < count; ++i)
+      run_data[fields[4 + 2 * i]] = fields[5 + 2 * i];
+
+    if (!done[planner][run])
+    {
+      done[planner][run] = true;
+      ++restored;
     }
   }
+
+  return restored;
+}
+
+bool BenchmarkExecutor::openJournal(std::ofstream& journal, const std::string& filename, bool resume)
+{
+  journal.open(filename.c_str(), resume ? std::ios::app : std::ios::trunc);
+  if (!journal)
+    return false;
+  if (resume)
+    // terminate a record that may have been cut off when the sweep was interrupted
+    journal << std::endl;
+  return true;
+}
+
+void BenchmarkExecutor::markJournalComplete(const std::string& filename)
+{
+  std::ofstream journal(filename.c_str(), std::ios::app);
+  journal << JOURNAL_COMPLETE << std::endl;
+}
+
+bool BenchmarkExecutor::isJournalComplete(const std::string& filename)
+{
+  std::ifstream in(filename.c_str());
+  std::string line;
+  while (std::getline(in, line))
+    if (line == JOURNAL_COMPLETE)
+      return true;
+  return false;
 }
 
 void BenchmarkExecutor::collectMetrics(PlannerRunData& metrics,
                                        const planning_interface::MotionPlanDetailedResponse& mp_res, bool solved,
-                                       double total_time)
+                                       double total_time, const planning_scene::PlanningScene& scene)
 {
   metrics["time REAL"] = boost::lexical_cast<std::string>(total_time);
   metrics["solved BOOLEAN"] = boost::lexical_cast<std::string>(solved);
@@ -847,12 +1162,12 @@ void BenchmarkExecutor::collectMetrics(PlannerRunData& metrics,
       for (std::size_t k = 0; k < p.getWayPointCount(); ++k)
       {
         collision_detection::CollisionResult res;
-        planning_scene_->checkCollisionUnpadded(req, res, p.getWayPoint(k));
+        scene.checkCollisionUnpadded(req, res, p.getWayPoint(k));
         if (res.collision)
           correct = false;
         if (!p.getWayPoint(k).satisfiesBounds())
           correct = false;
-        double d = planning_scene_->distanceToCollisionUnpadded(p.getWayPoint(k));
+        double d = scene.distanceToCollisionUnpadded(p.getWayPoint(k));
         if (d > 0.0)  // in case of collision, distance is negative
           clearance += d;
       }
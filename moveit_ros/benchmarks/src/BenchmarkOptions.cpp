@@ -38,7 +38,7 @@
 
 using namespace moveit_ros_benchmarks;
 
-BenchmarkOptions::BenchmarkOptions()
+BenchmarkOptions::BenchmarkOptions() : workers_(1), pin_workers_(false), resume_(false)
 {
 }
 
@@ -88,6 +88,11 @@ const std::string& BenchmarkOptions::getSceneName() const
   return scene_name_;
 }
 
+const std::string& BenchmarkOptions::getCorpusDirectory() const
+{
+  return corpus_directory_;
+}
+
 int BenchmarkOptions::getNumRuns() const
 {
   return runs_;
@@ -157,6 +162,21 @@ void BenchmarkOptions::getPlannerPluginList(std::vector<std::string>& plugin_lis
     plugin_list.push_back(it->first);
 }
 
+int BenchmarkOptions::getNumWorkers() const
+{
+  return workers_;
+}
+
+bool BenchmarkOptions::getPinWorkers() const
+{
+  return pin_workers_;
+}
+
+bool BenchmarkOptions::getResume() const
+{
+  return resume_;
+}
+
 const std::string& BenchmarkOptions::getWorkspaceFrameID() const
 {
   return workspace_.header.frame_id;
@@ -171,12 +191,18 @@ void BenchmarkOptions::readWarehouseOptions(ros::NodeHandle& nh)
 {
   nh.param(std::string("benchmark_config/warehouse/host"), hostname_, std::string("127.0.0.1"));
   nh.param(std::string("benchmark_config/warehouse/port"), port_, 33829);
+  nh.param(std::string("benchmark_config/warehouse/corpus"), corpus_directory_, std::string(""));
 
   if (!nh.getParam("benchmark_config/warehouse/scene_name", scene_name_))
     ROS_WARN("Benchmark scene_name NOT specified");
 
-  ROS_INFO("Benchmark host: %s", hostname_.c_str());
-  ROS_INFO("Benchmark port: %d", port_);
+  if (corpus_directory_.empty())
+  {
+    ROS_INFO("Benchmark host: %s", hostname_.c_str());
+    ROS_INFO("Benchmark port: %d", port_);
+  }
+  else
+    ROS_INFO("Benchmark corpus: %s", corpus_directory_.c_str());
   ROS_INFO("Benchmark scene: %s", scene_name_.c_str());
 }
 
@@ -192,6 +218,15 @@ void BenchmarkOptions::readBenchmarkParameters(ros::NodeHandle& nh)
   nh.param(std::string("benchmark_config/parameters/path_constraints"), path_constraint_regex_, std::string(""));
   nh.param(std::string("benchmark_config/parameters/trajectory_constraints"), trajectory_constraint_regex_,
            std::string(""));
+  nh.param(std::string("benchmark_config/parameters/workers"), workers_, 1);
+  nh.param(std::string("benchmark_config/parameters/pin_workers"), pin_workers_, false);
+  nh.param(std::string("benchmark_config/parameters/resume"), resume_, false);
+
+  if (workers_ < 1)
+  {
+    ROS_WARN("Benchmark workers must be at least 1, not %d", workers_);
+    workers_ = 1;
+  }
 
   if (!nh.getParam(std::string("benchmark_config/parameters/group"), group_name_))
     ROS_WARN("Benchmark group NOT specified");
@@ -218,6 +253,9 @@ void BenchmarkOptions::readBenchmarkParameters(ros::NodeHandle& nh)
   ROS_INFO("Benchmark goal offsets (%f %f %f, %f %f %f)", goal_offsets[0], goal_offsets[1], goal_offsets[2],
            goal_offsets[3], goal_offsets[4], goal_offsets[5]);
   ROS_INFO("Benchmark output directory: %s", output_directory_.c_str());
+  ROS_INFO("Benchmark workers: %d%s", workers_, pin_workers_ ? " (pinned)" : "");
+  if (resume_)
+    ROS_INFO("Benchmark resuming previously interrupted runs");
   ROS_INFO_STREAM("Benchmark workspace: " << workspace_);
 }
 
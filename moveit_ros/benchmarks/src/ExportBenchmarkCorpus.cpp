@@ -0,0 +1,183 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt! contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <moveit/benchmarks/BenchmarkCorpus.h>
+#include <moveit/warehouse/planning_scene_storage.h>
+#include <moveit/warehouse/planning_scene_world_storage.h>
+#include <moveit/warehouse/state_storage.h>
+#include <moveit/warehouse/constraints_storage.h>
+#include <moveit/warehouse/trajectory_constraints_storage.h>
+#include <boost/program_options/cmdline.hpp>
+#include <boost/program_options/options_description.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <ros/ros.h>
+
+using namespace moveit_ros_benchmarks;
+
+/// Copy the contents of a warehouse database into a benchmark corpus
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "moveit_export_benchmark_corpus", ros::init_options::AnonymousName);
+
+  boost::program_options::options_description desc;
+  desc.add_options()
+    ("help", "Show help message")
+    ("host", boost::program_options::value<std::string>(), "Host for the DB.")
+    ("port", boost::program_options::value<std::size_t>(), "Port for the DB.")
+    ("output", boost::program_options::value<std::string>(), "Directory to write the corpus to.");
+
+  boost::program_options::variables_map vm;
+  boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), vm);
+  boost::program_options::notify(vm);
+
+  if (vm.count("help") || !vm.count("output"))
+  {
+    std::cout << desc << std::endl;
+    return 1;
+  }
+
+  warehouse_ros::DatabaseConnection::Ptr conn = moveit_warehouse::loadDatabase();
+  if (vm.count("host") && vm.count("port"))
+    conn->setParams(vm["host"].as<std::string>(), vm["port"].as<std::size_t>());
+  if (!conn->connect())
+    return 1;
+
+  moveit_warehouse::PlanningSceneStorage pss(conn);
+  moveit_warehouse::PlanningSceneWorldStorage psws(conn);
+  moveit_warehouse::RobotStateStorage rs(conn);
+  moveit_warehouse::ConstraintsStorage cs(conn);
+  moveit_warehouse::TrajectoryConstraintsStorage tcs(conn);
+
+  BenchmarkCorpusWriter corpus;
+  if (!corpus.open(vm["output"].as<std::string>()))
+    return 1;
+
+  // entries that could not be read from the warehouse or written to the corpus
+  std::size_t failures = 0;
+
+  std::vector<std::string> names;
+  pss.getPlanningSceneNames(names);
+  for (std::size_t i = 0; i < names.size(); ++i)
+  {
+    moveit_warehouse::PlanningSceneWithMetadata scene;
+    if (!pss.getPlanningScene(scene, names[i]) ||
+        !corpus.addEntry(CORPUS_PLANNING_SCENE, names[i], "", static_cast<const moveit_msgs::PlanningScene&>(*scene)))
+    {
+      ROS_ERROR("Failed to export planning scene '%s'", names[i].c_str());
+      ++failures;
+    }
+
+    std::vector<std::string> query_names;
+    pss.getPlanningQueriesNames(query_names, names[i]);
+    for (std::size_t j = 0; j < query_names.size(); ++j)
+    {
+      moveit_warehouse::MotionPlanRequestWithMetadata query;
+      if (!pss.getPlanningQuery(query, names[i], query_names[j]) ||
+          !corpus.addEntry(CORPUS_MOTION_PLAN_REQUEST, query_names[j], names[i],
+                           static_cast<const moveit_msgs::MotionPlanRequest&>(*query)))
+      {
+        ROS_ERROR("Failed to export query '%s' of scene '%s'", query_names[j].c_str(), names[i].c_str());
+        ++failures;
+      }
+    }
+    ROS_INFO("Exported scene '%s' with %lu queries", names[i].c_str(), query_names.size());
+  }
+
+  psws.getKnownPlanningSceneWorlds(names);
+  for (std::size_t i = 0; i < names.size(); ++i)
+  {
+    moveit_warehouse::PlanningSceneWorldWithMetadata world;
+    if (!psws.getPlanningSceneWorld(world, names[i]) ||
+        !corpus.addEntry(CORPUS_PLANNING_SCENE_WORLD, names[i], "",
+                         static_cast<const moveit_msgs::PlanningSceneWorld&>(*world)))
+    {
+      ROS_ERROR("Failed to export planning scene world '%s'", names[i].c_str());
+      ++failures;
+    }
+  }
+  ROS_INFO("Exported %lu planning scene worlds", names.size());
+
+  rs.getKnownRobotStates(names);
+  for (std::size_t i = 0; i < names.size(); ++i)
+  {
+    moveit_warehouse::RobotStateWithMetadata state;
+    if (!rs.getRobotState(state, names[i]) ||
+        !corpus.addEntry(CORPUS_ROBOT_STATE, names[i], "", static_cast<const moveit_msgs::RobotState&>(*state)))
+    {
+      ROS_ERROR("Failed to export robot state '%s'", names[i].c_str());
+      ++failures;
+    }
+  }
+  ROS_INFO("Exported %lu robot states", names.size());
+
+  cs.getKnownConstraints(names);
+  for (std::size_t i = 0; i < names.size(); ++i)
+  {
+    moveit_warehouse::ConstraintsWithMetadata constraints;
+    if (!cs.getConstraints(constraints, names[i]) ||
+        !corpus.addEntry(CORPUS_CONSTRAINTS, names[i], "", static_cast<const moveit_msgs::Constraints&>(*constraints)))
+    {
+      ROS_ERROR("Failed to export constraints '%s'", names[i].c_str());
+      ++failures;
+    }
+  }
+  ROS_INFO("Exported %lu constraints", names.size());
+
+  tcs.getKnownTrajectoryConstraints(names);
+  for (std::size_t i = 0; i < names.size(); ++i)
+  {
+    moveit_warehouse::TrajectoryConstraintsWithMetadata constraints;
+    if (!tcs.getTrajectoryConstraints(constraints, names[i]) ||
+        !corpus.addEntry(CORPUS_TRAJECTORY_CONSTRAINTS, names[i], "",
+                         static_cast<const moveit_msgs::TrajectoryConstraints&>(*constraints)))
+    {
+      ROS_ERROR("Failed to export trajectory constraints '%s'", names[i].c_str());
+      ++failures;
+    }
+  }
+  ROS_INFO("Exported %lu trajectory constraints", names.size());
+
+  if (!corpus.close())
+  {
+    ROS_ERROR("Failed to write the benchmark corpus");
+    return 1;
+  }
+  if (failures > 0)
+  {
+    ROS_ERROR("Failed to export %lu entries", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,224 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt! contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include <moveit/benchmarks/BenchmarkCorpus.h>
+#include <moveit_msgs/PlanningScene.h>
+#include <moveit_msgs/MotionPlanRequest.h>
+#include <moveit_msgs/RobotState.h>
+#include <moveit_msgs/Constraints.h>
+#include <moveit_msgs/TrajectoryConstraints.h>
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+using namespace moveit_ros_benchmarks;
+
+class BenchmarkCorpusTest : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    directory_ =
+        (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("corpus-%%%%-%%%%")).string();
+
+    scene_.name = "kitchen";
+    scene_.robot_model_name = "pr2";
+    moveit_msgs::CollisionObject table;
+    table.id = "table";
+    table.operation = moveit_msgs::CollisionObject::ADD;
+    scene_.world.collision_objects.push_back(table);
+
+    request_.group_name = "right_arm";
+    request_.num_planning_attempts = 3;
+    request_.allowed_planning_time = 2.5;
+
+    state_.joint_state.name.push_back("shoulder_pan_joint");
+    state_.joint_state.name.push_back("elbow_flex_joint");
+    state_.joint_state.position.push_back(0.25);
+    state_.joint_state.position.push_back(-1.5);
+
+    moveit_msgs::JointConstraint joint;
+    joint.joint_name = "elbow_flex_joint";
+    joint.position = -1.0;
+    joint.tolerance_above = 0.1;
+    joint.tolerance_below = 0.2;
+    joint.weight = 1.0;
+    constraints_.name = "elbow_down";
+    constraints_.joint_constraints.push_back(joint);
+
+    trajectory_constraints_.constraints.push_back(constraints_);
+    trajectory_constraints_.constraints.push_back(constraints_);
+  }
+
+  virtual void TearDown()
+  {
+    boost::filesystem::remove_all(directory_);
+  }
+
+  void writeCorpus()
+  {
+    BenchmarkCorpusWriter writer;
+    ASSERT_TRUE(writer.open(directory_));
+    EXPECT_TRUE(writer.addEntry(CORPUS_PLANNING_SCENE, "kitchen", "", scene_));
+    EXPECT_TRUE(writer.addEntry(CORPUS_MOTION_PLAN_REQUEST, "reach_shelf", "kitchen", request_));
+    EXPECT_TRUE(writer.addEntry(CORPUS_MOTION_PLAN_REQUEST, "reach_table", "kitchen", request_));
+    EXPECT_TRUE(writer.addEntry(CORPUS_ROBOT_STATE, "tucked", "", state_));
+    EXPECT_TRUE(writer.addEntry(CORPUS_CONSTRAINTS, "elbow_down", "", constraints_));
+    EXPECT_TRUE(writer.addEntry(CORPUS_TRAJECTORY_CONSTRAINTS, "elbow_down_path", "", trajectory_constraints_));
+    EXPECT_TRUE(writer.close());
+  }
+
+  std::string directory_;
+  moveit_msgs::PlanningScene scene_;
+  moveit_msgs::MotionPlanRequest request_;
+  moveit_msgs::RobotState state_;
+  moveit_msgs::Constraints constraints_;
+  moveit_msgs::TrajectoryConstraints trajectory_constraints_;
+};
+
+TEST_F(BenchmarkCorpusTest, RoundTrip)
+{
+  writeCorpus();
+
+  BenchmarkCorpus corpus;
+  ASSERT_TRUE(corpus.open(directory_));
+  EXPECT_TRUE(corpus.isOpen());
+
+  moveit_msgs::PlanningScene scene;
+  ASSERT_TRUE(corpus.getEntry(CORPUS_PLANNING_SCENE, "kitchen", "", scene));
+  EXPECT_EQ("kitchen", scene.name);
+  EXPECT_EQ("pr2", scene.robot_model_name);
+  ASSERT_EQ(1u, scene.world.collision_objects.size());
+  EXPECT_EQ("table", scene.world.collision_objects[0].id);
+  EXPECT_EQ(moveit_msgs::CollisionObject::ADD, scene.world.collision_objects[0].operation);
+
+  moveit_msgs::MotionPlanRequest request;
+  ASSERT_TRUE(corpus.getEntry(CORPUS_MOTION_PLAN_REQUEST, "reach_table", "kitchen", request));
+  EXPECT_EQ("right_arm", request.group_name);
+  EXPECT_EQ(3, request.num_planning_attempts);
+  EXPECT_DOUBLE_EQ(2.5, request.allowed_planning_time);
+
+  moveit_msgs::RobotState state;
+  ASSERT_TRUE(corpus.getEntry(CORPUS_ROBOT_STATE, "tucked", "", state));
+  EXPECT_EQ(state_.joint_state.name, state.joint_state.name);
+  EXPECT_EQ(state_.joint_state.position, state.joint_state.position);
+
+  moveit_msgs::Constraints constraints;
+  ASSERT_TRUE(corpus.getEntry(CORPUS_CONSTRAINTS, "elbow_down", "", constraints));
+  EXPECT_EQ("elbow_down", constraints.name);
+  ASSERT_EQ(1u, constraints.joint_constraints.size());
+  EXPECT_EQ("elbow_flex_joint", constraints.joint_constraints[0].joint_name);
+  EXPECT_DOUBLE_EQ(-1.0, constraints.joint_constraints[0].position);
+  EXPECT_DOUBLE_EQ(0.1, constraints.joint_constraints[0].tolerance_above);
+  EXPECT_DOUBLE_EQ(0.2, constraints.joint_constraints[0].tolerance_below);
+
+  moveit_msgs::TrajectoryConstraints trajectory_constraints;
+  ASSERT_TRUE(corpus.getEntry(CORPUS_TRAJECTORY_CONSTRAINTS, "elbow_down_path", "", trajectory_constraints));
+  ASSERT_EQ(2u, trajectory_constraints.constraints.size());
+  EXPECT_EQ("elbow_down", trajectory_constraints.constraints[1].name);
+  ASSERT_EQ(1u, trajectory_constraints.constraints[1].joint_constraints.size());
+  EXPECT_DOUBLE_EQ(-1.0, trajectory_constraints.constraints[1].joint_constraints[0].position);
+}
+
+TEST_F(BenchmarkCorpusTest, EntriesAreTypedAndScoped)
+{
+  writeCorpus();
+
+  BenchmarkCorpus corpus;
+  ASSERT_TRUE(corpus.open(directory_));
+
+  EXPECT_TRUE(corpus.hasEntry(CORPUS_PLANNING_SCENE, "kitchen"));
+  EXPECT_FALSE(corpus.hasEntry(CORPUS_PLANNING_SCENE_WORLD, "kitchen"));
+  EXPECT_FALSE(corpus.hasEntry(CORPUS_ROBOT_STATE, "kitchen"));
+  EXPECT_TRUE(corpus.hasEntry(CORPUS_MOTION_PLAN_REQUEST, "reach_shelf", "kitchen"));
+  EXPECT_FALSE(corpus.hasEntry(CORPUS_MOTION_PLAN_REQUEST, "reach_shelf"));
+  EXPECT_FALSE(corpus.hasEntry(CORPUS_MOTION_PLAN_REQUEST, "reach_shelf", "garage"));
+
+  std::vector<std::string> names;
+  corpus.getEntryNames(CORPUS_MOTION_PLAN_REQUEST, "", names, "kitchen");
+  ASSERT_EQ(2u, names.size());
+
+  corpus.getEntryNames(CORPUS_MOTION_PLAN_REQUEST, "table", names, "kitchen");
+  ASSERT_EQ(1u, names.size());
+  EXPECT_EQ("reach_table", names[0]);
+
+  corpus.getEntryNames(CORPUS_MOTION_PLAN_REQUEST, "", names, "garage");
+  EXPECT_TRUE(names.empty());
+
+  // a stored message of one type is not returned for another
+  moveit_msgs::RobotState state;
+  EXPECT_FALSE(corpus.getEntry(CORPUS_ROBOT_STATE, "elbow_down", "", state));
+
+  corpus.close();
+  EXPECT_FALSE(corpus.isOpen());
+  EXPECT_FALSE(corpus.hasEntry(CORPUS_PLANNING_SCENE, "kitchen"));
+}
+
+TEST_F(BenchmarkCorpusTest, RejectsBadEntries)
+{
+  BenchmarkCorpusWriter writer;
+  EXPECT_FALSE(writer.addEntry(CORPUS_ROBOT_STATE, "tucked", "", state_));
+
+  ASSERT_TRUE(writer.open(directory_));
+  EXPECT_FALSE(writer.addEntry(CORPUS_ROBOT_STATE, "tab\tname", "", state_));
+  EXPECT_FALSE(writer.addEntry(CORPUS_ROBOT_STATE, "line\nbreak", "", state_));
+  EXPECT_FALSE(writer.addEntry(CORPUS_MOTION_PLAN_REQUEST, "reach", "bad\tscene", request_));
+  EXPECT_TRUE(writer.addEntry(CORPUS_ROBOT_STATE, "tucked", "", state_));
+  EXPECT_TRUE(writer.close());
+
+  // the rejected entries did not corrupt the index
+  BenchmarkCorpus corpus;
+  ASSERT_TRUE(corpus.open(directory_));
+  std::vector<std::string> names;
+  corpus.getEntryNames(CORPUS_ROBOT_STATE, "", names);
+  ASSERT_EQ(1u, names.size());
+  EXPECT_EQ("tucked", names[0]);
+  moveit_msgs::RobotState state;
+  ASSERT_TRUE(corpus.getEntry(CORPUS_ROBOT_STATE, "tucked", "", state));
+  EXPECT_EQ(state_.joint_state.name, state.joint_state.name);
+  EXPECT_EQ(state_.joint_state.position, state.joint_state.position);
+}
+
+TEST_F(BenchmarkCorpusTest, MissingCorpus)
+{
+  BenchmarkCorpus corpus;
+  EXPECT_FALSE(corpus.open(directory_));
+  EXPECT_FALSE(corpus.isOpen());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,189 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt! contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <moveit/benchmarks/BenchmarkExecutor.h>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+
+using moveit_ros_benchmarks::BenchmarkExecutor;
+
+class BenchmarkJournalTest : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    filename_ = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.journal")).string();
+    planners_.push_back(std::make_pair("ompl_interface/OMPLPlanner", "RRTConnectkConfigDefault"));
+    planners_.push_back(std::make_pair("ompl_interface/OMPLPlanner", "PRMkConfigDefault"));
+  }
+
+  virtual void TearDown()
+  {
+    boost::filesystem::remove(filename_);
+  }
+
+  BenchmarkExecutor::PlannerRunData makeRun(double time, bool solved)
+  {
+    BenchmarkExecutor::PlannerRunData run_data;
+    run_data["time REAL"] = boost::lexical_cast<std::string>(time);
+    run_data["solved BOOLEAN"] = boost::lexical_cast<std::string>(solved);
+    return run_data;
+  }
+
+  std::size_t read(int runs, std::vector<BenchmarkExecutor::PlannerBenchmarkData>& data,
+                   std::vector<std::vector<bool>>& done)
+  {
+    data.assign(planners_.size(), BenchmarkExecutor::PlannerBenchmarkData(runs));
+    done.assign(planners_.size(), std::vector<bool>(runs, false));
+    return BenchmarkExecutor::readJournal(filename_, planners_, runs, data, done);
+  }
+
+  std::string filename_;
+  std::vector<std::pair<std::string, std::string>> planners_;
+};
+
+TEST_F(BenchmarkJournalTest, RecordFormat)
+{
+  std::stringstream out;
+  BenchmarkExecutor::writeJournalEntry(out, planners_[0], 3, makeRun(0.5, true));
+  EXPECT_EQ("ompl_interface/OMPLPlanner\tRRTConnectkConfigDefault\t3\t2\tsolved BOOLEAN\t1\ttime REAL\t0.5\n",
+            out.str());
+
+  std::stringstream empty;
+  BenchmarkExecutor::writeJournalEntry(empty, planners_[1], 0, BenchmarkExecutor::PlannerRunData());
+  EXPECT_EQ("ompl_interface/OMPLPlanner\tPRMkConfigDefault\t0\t0\n", empty.str());
+}
+
+TEST_F(BenchmarkJournalTest, WriteRead)
+{
+  {
+    std::ofstream journal;
+    ASSERT_TRUE(BenchmarkExecutor::openJournal(journal, filename_, false));
+    BenchmarkExecutor::writeJournalEntry(journal, planners_[0], 0, makeRun(0.25, true));
+    BenchmarkExecutor::writeJournalEntry(journal, planners_[1], 2, makeRun(1.5, false));
+    BenchmarkExecutor::writeJournalEntry(journal, planners_[0], 2, BenchmarkExecutor::PlannerRunData());
+  }
+
+  std::vector<BenchmarkExecutor::PlannerBenchmarkData> data;
+  std::vector<std::vector<bool>> done;
+  EXPECT_EQ(3u, read(3, data, done));
+  EXPECT_TRUE(done[0][0]);
+  EXPECT_FALSE(done[0][1]);
+  EXPECT_TRUE(done[0][2]);
+  EXPECT_FALSE(done[1][0]);
+  EXPECT_FALSE(done[1][1]);
+  EXPECT_TRUE(done[1][2]);
+  EXPECT_TRUE(data[0][0] == makeRun(0.25, true));
+  EXPECT_TRUE(data[1][2] == makeRun(1.5, false));
+  EXPECT_TRUE(data[0][2].empty());
+
+  // opening without resuming starts a new journal
+  {
+    std::ofstream journal;
+    ASSERT_TRUE(BenchmarkExecutor::openJournal(journal, filename_, false));
+  }
+  EXPECT_EQ(0u, read(3, data, done));
+}
+
+TEST_F(BenchmarkJournalTest, SkipsBadRecords)
+{
+  {
+    std::ofstream journal(filename_.c_str());
+    journal << "# a comment" << std::endl;
+    BenchmarkExecutor::writeJournalEntry(journal, planners_[0], 1, makeRun(0.5, true));
+    // unknown planner, run out of range, malformed run index and wrong property count
+    BenchmarkExecutor::writeJournalEntry(journal, std::make_pair("other", "planner"), 0, makeRun(0.5, true));
+    BenchmarkExecutor::writeJournalEntry(journal, planners_[1], 5, makeRun(0.5, true));
+    journal << "ompl_interface/OMPLPlanner\tPRMkConfigDefault\tx\t0" << std::endl;
+    journal << "ompl_interface/OMPLPlanner\tPRMkConfigDefault\t0\t2\ttime REAL\t0.5" << std::endl;
+    journal << "too\tshort" << std::endl;
+  }
+
+  std::vector<BenchmarkExecutor::PlannerBenchmarkData> data;
+  std::vector<std::vector<bool>> done;
+  EXPECT_EQ(1u, read(2, data, done));
+  EXPECT_TRUE(done[0][1]);
+  EXPECT_FALSE(done[1][0]);
+  EXPECT_FALSE(done[1][1]);
+  EXPECT_TRUE(data[1][0].empty());
+}
+
+TEST_F(BenchmarkJournalTest, Resume)
+{
+  // a sweep that was interrupted in the middle of writing a record
+  {
+    std::ofstream journal;
+    ASSERT_TRUE(BenchmarkExecutor::openJournal(journal, filename_, false));
+    BenchmarkExecutor::writeJournalEntry(journal, planners_[0], 0, makeRun(0.25, true));
+    journal << "ompl_interface/OMPLPlanner\tPRMkConfigDefault\t1\t2\ttime REAL";
+  }
+  EXPECT_FALSE(BenchmarkExecutor::isJournalComplete(filename_));
+
+  std::vector<BenchmarkExecutor::PlannerBenchmarkData> data;
+  std::vector<std::vector<bool>> done;
+  EXPECT_EQ(1u, read(2, data, done));
+  EXPECT_TRUE(done[0][0]);
+  EXPECT_FALSE(done[1][1]);
+
+  // resuming keeps the finished run and runs the cut off one again
+  {
+    std::ofstream journal;
+    ASSERT_TRUE(BenchmarkExecutor::openJournal(journal, filename_, true));
+    BenchmarkExecutor::writeJournalEntry(journal, planners_[1], 1, makeRun(0.75, false));
+  }
+  EXPECT_EQ(2u, read(2, data, done));
+  EXPECT_TRUE(done[0][0]);
+  EXPECT_TRUE(done[1][1]);
+  EXPECT_TRUE(data[0][0] == makeRun(0.25, true));
+  EXPECT_TRUE(data[1][1] == makeRun(0.75, false));
+
+  // once the query is marked complete it is skipped, and the marker does not affect the runs
+  EXPECT_FALSE(BenchmarkExecutor::isJournalComplete(filename_));
+  BenchmarkExecutor::markJournalComplete(filename_);
+  EXPECT_TRUE(BenchmarkExecutor::isJournalComplete(filename_));
+  EXPECT_EQ(2u, read(2, data, done));
+
+  // a missing journal restores nothing and is not complete
+  boost::filesystem::remove(filename_);
+  EXPECT_FALSE(BenchmarkExecutor::isJournalComplete(filename_));
+  EXPECT_EQ(0u, read(2, data, done));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -36,6 +36,8 @@
 
 #include <moveit/pick_place/reachable_valid_pose_filter.h>
 #include <moveit/kinematic_constraints/utils.h>
+#include <moveit/constraint_samplers/default_constraint_samplers.h>
+#include <moveit/constraint_samplers/union_constraint_sampler.h>
 #include <eigen_conversions/eigen_msg.h>
 #include <boost/bind.hpp>
 #include <ros/console.h>
@@ -87,6 +89,16 @@ bool isStateCollisionFree(const planning_scene::PlanningScene *planning_scene,
     }
   return planning_scene->isStateFeasible(*state);
 }
+
+// goal sampling makes many attempts for every grasp, so let the IK samplers solve them in batches
+void enableBatchIK(const constraint_samplers::ConstraintSamplerPtr &sampler)
+{
+  if (constraint_samplers::IKConstraintSampler *ik_sampler = dynamic_cast<constraint_samplers::IKConstraintSampler*>(sampler.get()))
+    ik_sampler->setUseBatchIK(true);
+  else if (constraint_samplers::UnionConstraintSampler *union_sampler = dynamic_cast<constraint_samplers::UnionConstraintSampler*>(sampler.get()))
+    for (std::size_t i = 0 ; i < union_sampler->getSamplers().size() ; ++i)
+      enableBatchIK(union_sampler->getSamplers()[i]);
+}
 }
 
 bool pick_place::ReachableAndValidPoseFilter::isEndEffectorFree(const ManipulationPlanPtr &plan, robot_state::RobotState &token_state) const
@@ -130,6 +142,7 @@ bool pick_place::ReachableAndValidPoseFilter::evaluate(const ManipulationPlanPtr
       plan->goal_sampler_->setGroupStateValidityCallback(boost::bind(&isStateCollisionFree, planning_scene_.get(), collision_matrix_.get(),
                                                                      verbose_, plan.get(), _1, _2, _3));
       plan->goal_sampler_->setVerbose(verbose_);
+      enableBatchIK(plan->goal_sampler_);
       if (plan->goal_sampler_->sample(*token_state, plan->shared_data_->max_goal_sampling_attempts_))
       {
         plan->possible_goal_states_.push_back(token_state);
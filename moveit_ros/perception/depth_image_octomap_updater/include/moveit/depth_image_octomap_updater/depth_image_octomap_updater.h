@@ -91,6 +91,8 @@ private:
   double padding_offset_;
   unsigned int skip_vertical_pixels_;
   unsigned int skip_horizontal_pixels_;
+  bool software_rendering_;
+  unsigned int render_threads_;
 
   unsigned int image_callback_count_;
   double average_callback_dt_;
@@ -60,6 +60,8 @@ DepthImageOctomapUpdater::DepthImageOctomapUpdater() :
   padding_offset_(0.02),
   skip_vertical_pixels_(4),
   skip_horizontal_pixels_(6),
+  software_rendering_(false),
+  render_threads_(1),
   image_callback_count_(0),
   average_callback_dt_(0.0),
   good_tf_(5), // start optimistically, so we do not output warnings right from the beginning
@@ -90,6 +92,9 @@ bool DepthImageOctomapUpdater::setParams(XmlRpc::XmlRpcValue &params)
     readXmlParam(params, "padding_offset", &padding_offset_);
     readXmlParam(params, "skip_vertical_pixels", &skip_vertical_pixels_);
     readXmlParam(params, "skip_horizontal_pixels", &skip_horizontal_pixels_);
+    if (params.hasMember("software_rendering"))
+      software_rendering_ = (bool) params["software_rendering"];
+    readXmlParam(params, "render_threads", &render_threads_);
     if (params.hasMember("filtered_cloud_topic"))
       filtered_cloud_topic_ = static_cast<const std::string&>(params["filtered_cloud_topic"]);
   }
@@ -109,8 +114,10 @@ bool DepthImageOctomapUpdater::initialize()
 
   // create our mesh filter
   mesh_filter_.reset(new mesh_filter::MeshFilter<mesh_filter::StereoCameraModel>(mesh_filter::MeshFilterBase::TransformCallback(),
-                                                                                 mesh_filter::StereoCameraModel::RegisteredPSDKParams));
+                                                                                 mesh_filter::StereoCameraModel::RegisteredPSDKParams,
+                                                                                 software_rendering_));
   mesh_filter_->parameters().setDepthRange(near_clipping_plane_distance_, far_clipping_plane_distance_);
+  mesh_filter_->setRenderThreadCount(render_threads_);
   mesh_filter_->setShadowThreshold(shadow_threshold_);
   mesh_filter_->setPaddingOffset(padding_offset_);
   mesh_filter_->setPaddingScale(padding_scale_);
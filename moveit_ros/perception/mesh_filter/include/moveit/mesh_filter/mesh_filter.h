@@ -70,10 +70,12 @@ class MeshFilter : public MeshFilterBase
      * \brief Constructor
      * \author Suat Gedikli (gedikli@willowgarage.com)
      * \param[in] transform_callback Callback function that is called for each mesh to obtain the current transformation.
+     * \param[in] software_rendering render on the CPU instead of with OpenGL, e.g. on machines without display
      * \note the callback expects the mesh handle but no time stamp. Its the users responsibility to return the correct transformation.
      */
     MeshFilter (const TransformCallback& transform_callback = TransformCallback(),
-                const typename SensorType::Parameters& sensor_parameters = typename SensorType::Parameters ());
+                const typename SensorType::Parameters& sensor_parameters = typename SensorType::Parameters (),
+                bool software_rendering = false);
 
     /**
      * \brief returns the Sensor Parameters
@@ -92,10 +94,12 @@ class MeshFilter : public MeshFilterBase
 
 template<typename SensorType>
 MeshFilter<SensorType>::MeshFilter (const TransformCallback& transform_callback,
-                                    const typename SensorType::Parameters& sensor_parameters)
+                                    const typename SensorType::Parameters& sensor_parameters,
+                                    bool software_rendering)
 : MeshFilterBase (transform_callback, sensor_parameters,
                   SensorType::renderVertexShaderSource, SensorType::renderFragmentShaderSource,
-                  SensorType::filterVertexShaderSource, SensorType::filterFragmentShaderSource)
+                  SensorType::filterVertexShaderSource, SensorType::filterFragmentShaderSource,
+                  software_rendering)
 {
 }
 
@@ -40,6 +40,7 @@
 #include <map>
 #include <moveit/macros/class_forward.h>
 #include <moveit/mesh_filter/gl_renderer.h>
+#include <moveit/mesh_filter/software_renderer.h>
 #include <moveit/mesh_filter/sensor_model.h>
 #include <boost/function.hpp>
 #include <boost/thread/mutex.hpp>
@@ -57,6 +58,7 @@ namespace mesh_filter
 
 MOVEIT_CLASS_FORWARD(Job);
 MOVEIT_CLASS_FORWARD(GLMesh);
+MOVEIT_CLASS_FORWARD(SoftwareMesh);
 
 typedef unsigned int MeshHandle;
 typedef uint32_t LabelType;
@@ -74,12 +76,15 @@ class MeshFilterBase
      * \brief Constructor
      * \author Suat Gedikli (gedikli@willowgarage.com)
      * \param[in] transform_callback Callback function that is called for each mesh to obtain the current transformation.
+     * \param[in] software_rendering render on the CPU with a SoftwareRenderer instead of OpenGL. No OpenGL context
+     *            is created and the shaders are not used; the sensor parameters need to support software rendering.
      * \note the callback expects the mesh handle but no time stamp. Its the users responsibility to return the correct transformation.
      */
     MeshFilterBase (const TransformCallback& transform_callback,
                     const SensorModel::Parameters& sensor_parameters,
                     const std::string& render_vertex_shader = "", const std::string& render_fragment_shader = "",
-                    const std::string& filter_vertex_shader = "", const std::string& filter_fragment_shader = "");
+                    const std::string& filter_vertex_shader = "", const std::string& filter_fragment_shader = "",
+                    bool software_rendering = false);
 
     /** \brief Desctructor */
     ~MeshFilterBase ();
@@ -168,6 +173,17 @@ class MeshFilterBase
      */
     void setPaddingOffset (float offset);
 
+    /**
+     * \brief returns whether the meshes are rendered on the CPU instead of with OpenGL
+     */
+    bool usesSoftwareRendering () const;
+
+    /**
+     * \brief set the number of threads used to render and filter on the CPU. Only used with software rendering.
+     * \param[in] thread_count the number of threads
+     */
+    void setRenderThreadCount (unsigned thread_count);
+
   protected:
 
     /**
@@ -194,6 +210,26 @@ class MeshFilterBase
      */
     void doFilter (const void* sensor_data, const int encoding) const;
 
+    /**
+     * \brief the filter method used with software rendering. It renders the meshes with the SoftwareRenderer and
+     *        labels the sensor data the same way the filter shader of the StereoCameraModel does
+     * \param[in] sensor_data pointer to the buffer containing the depth readings
+     * \param[in] encoding the representation of the depth readings in the buffer
+     */
+    void doSoftwareFilter (const void* sensor_data, const int encoding) const;
+
+    /**
+     * \brief copies the filtered depth of the last doSoftwareFilter call, as normalized depth values
+     * \param[out] depth pointer to buffer to be filled with depth values.
+     */
+    void getSoftwareFilteredDepth (float* depth) const;
+
+    /**
+     * \brief copies the filtered labels of the last doSoftwareFilter call
+     * \param[out] labels pointer to buffer to be filled with labels
+     */
+    void getSoftwareFilteredLabels (LabelType* labels) const;
+
     /**
      * \brief used within a Job to allow the main thread adding meshes
      * \param[in] handle the handle of the mesh that is predetermined and passed
@@ -224,6 +260,9 @@ class MeshFilterBase
     /** \brief storage for meshed to be filtered */
     std::map<MeshHandle, GLMeshPtr> meshes_;
 
+    /** \brief storage for meshes to be filtered with software rendering*/
+    std::map<MeshHandle, SoftwareMeshPtr> software_meshes_;
+
     /** \brief the parameters of the used sensor model*/
     SensorModel::ParametersPtr sensor_parameters_;
 
@@ -260,6 +299,15 @@ class MeshFilterBase
     /** \brief second pass renderer for filtering the results of first pass*/
     GLRendererPtr depth_filter_;
 
+    /** \brief renderer used instead of mesh_renderer_ and depth_filter_ with software rendering*/
+    SoftwareRendererPtr software_renderer_;
+
+    /** \brief normalized depth values resulting from software filtering*/
+    mutable std::vector<float> software_filtered_depth_;
+
+    /** \brief labels resulting from software filtering*/
+    mutable std::vector<LabelType> software_filtered_labels_;
+
     /** \brief canvas element (screen-filling quad) for second pass*/
     GLuint canvas_;
 
@@ -45,6 +45,7 @@ namespace mesh_filter
 
 //forward declarations
 class GLRenderer;
+class SoftwareRenderer;
 
 /**
  * \brief Abstract Interface defining a sensor model for mesh filtering
@@ -84,6 +85,13 @@ public:
      */
     virtual void setRenderParameters (GLRenderer& renderer) const = 0;
 
+    /**
+     * \brief method that sets required parameters for the software renderer that is used instead of OpenGL.
+     * The default implementation throws, since only the sensor knows its projection.
+     * \param renderer the renderer that needs to be updated
+     */
+    virtual void setRenderParameters (SoftwareRenderer& renderer) const;
+
     /**
      * \brief sets the specific Filter Renderer parameters
      * \param renderer renderer the renderer that needs to be updated
@@ -0,0 +1,99 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_MESH_FILTER_SOFTWARE_MESH_
+#define MOVEIT_MESH_FILTER_SOFTWARE_MESH_
+
+#include <moveit/macros/class_forward.h>
+#include <Eigen/Eigen>
+#include <vector>
+
+namespace shapes
+{
+  class Mesh;
+}
+
+namespace mesh_filter
+{
+
+MOVEIT_CLASS_FORWARD(SoftwareMesh);
+
+/**
+ * \brief SoftwareMesh represents a mesh from geometric_shapes for rendering with the SoftwareRenderer
+ */
+class SoftwareMesh
+{
+  public:
+    /**
+     * \brief Constucts a SoftwareMesh object for given mesh and label
+     * \param[in] mesh the mesh to be rendered. Vertex normals need to be computed.
+     * \param[in] mesh_label the label written to the label buffer for pixels covered by this mesh
+     */
+    SoftwareMesh (const shapes::Mesh& mesh, unsigned int mesh_label);
+
+    /** \brief the vertices of the mesh */
+    const std::vector<Eigen::Vector3f>& getVertices () const
+    {
+      return vertices_;
+    }
+
+    /** \brief the normals of the vertices of the mesh */
+    const std::vector<Eigen::Vector3f>& getVertexNormals () const
+    {
+      return normals_;
+    }
+
+    /** \brief three consecutive indices into the vertices per triangle */
+    const std::vector<unsigned int>& getTriangles () const
+    {
+      return triangles_;
+    }
+
+    /** \brief label of this mesh */
+    unsigned int getLabel () const
+    {
+      return mesh_label_;
+    }
+
+  private:
+
+    std::vector<Eigen::Vector3f> vertices_;
+    std::vector<Eigen::Vector3f> normals_;
+    std::vector<unsigned int> triangles_;
+
+    /** \brief label of current mesh*/
+    unsigned int mesh_label_;
+};
+} // namespace mesh_filter
+#endif
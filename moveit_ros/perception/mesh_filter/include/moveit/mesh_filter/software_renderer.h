@@ -0,0 +1,236 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_MESH_FILTER_SOFTWARE_RENDERER_
+#define MOVEIT_MESH_FILTER_SOFTWARE_RENDERER_
+
+#include <moveit/macros/class_forward.h>
+#include <Eigen/Eigen>
+#include <vector>
+#include <stdint.h>
+
+namespace mesh_filter
+{
+
+class SoftwareMesh;
+
+MOVEIT_CLASS_FORWARD(SoftwareRenderer);
+
+/**
+ * \brief Renders meshes into a depth and a label buffer on the CPU. The buffers have the same layout and the same
+ *        depth encoding as the frame buffers of the GLRenderer with the shaders of the StereoCameraModel, so they can be
+ *        used where no OpenGL context is available.
+ *
+ * Rendering a frame is split in three steps: begin() clears the buffers, addMesh() transforms, pads and clips the
+ * triangles of a mesh and sets up their edge equations, and end() rasterizes all triangles into the buffers. For
+ * rasterization the image is divided into square tiles that are processed independently and in parallel if more
+ * than one thread is used.
+ */
+class SoftwareRenderer
+{
+public:
+  /**
+   * \brief Constructor
+   * \param[in] width the width of the buffers
+   * \param[in] height height of the buffers
+   * \param[in] near distance of the near clipping plane in meters
+   * \param[in] far distance of the far clipping plane in meters
+   */
+  SoftwareRenderer (unsigned width, unsigned height, float near = 0.1, float far = 10.0);
+
+  /** \brief clears the buffers and the triangles of the previous frame */
+  void begin ();
+
+  /**
+   * \brief adds the triangles of a mesh to the current frame
+   * \param[in] mesh the mesh to be rendered
+   * \param[in] transform the pose of the mesh in the camera coordinate frame
+   * \param[in] padding_coefficients vertices are moved along their normals by
+   *            padding_coefficients[0] * z^2 + padding_coefficients[1] * z + padding_coefficients[2]
+   *            with z the (negative) OpenGL eye space depth of the vertex
+   */
+  void addMesh (const SoftwareMesh& mesh, const Eigen::Affine3d& transform, const Eigen::Vector3f& padding_coefficients);
+
+  /** \brief rasterizes the triangles added since begin() into the buffers */
+  void end ();
+
+  /**
+   * \brief retrieves the label buffer. Pixels not covered by any mesh have label 0.
+   * \param[out] buffer pointer to memory where width * height labels need to be stored
+   */
+  void getColorBuffer (unsigned char* buffer) const;
+
+  /**
+   * \brief retrieves the depth buffer with normalized values in [0, 1] as written by OpenGL
+   * \param[out] buffer pointer to memory where width * height depth values need to be stored
+   */
+  void getDepthBuffer (float* buffer) const;
+
+  /** \brief direct access to the label buffer */
+  const std::vector<uint32_t>& getLabels () const
+  {
+    return labels_;
+  }
+
+  /** \brief direct access to the depth buffer */
+  const std::vector<float>& getDepth () const
+  {
+    return depth_;
+  }
+
+  /**
+   * \brief set the camera parameters
+   * \param[in] fx focal length in x-direction
+   * \param[in] fy focal length in y-direction
+   * \param[in] cx x component of principal point
+   * \param[in] cy y component of principal point
+   */
+  void setCameraParameters (float fx, float fy, float cx, float cy);
+
+  /**
+   * \brief sets the near and far clipping plane distances in meters
+   * \param[in] near distance of the near clipping plane in meters
+   * \param[in] far distance of the far clipping plane in meters
+   */
+  void setClippingRange (float near, float far);
+
+  /**
+   * \brief set the buffer dimensions
+   * \param[in] width width of the buffers in pixels
+   * \param[in] height height of the buffers in pixels
+   */
+  void setBufferSize (unsigned width, unsigned height);
+
+  /**
+   * \brief set the number of threads used for rasterization
+   * \param[in] thread_count the number of threads; 1 rasterizes in the calling thread
+   */
+  void setThreadCount (unsigned thread_count);
+
+  /** \brief returns the number of threads used for rasterization */
+  unsigned getThreadCount () const
+  {
+    return thread_count_;
+  }
+
+  /** \brief returns the width of the buffers */
+  unsigned getWidth () const
+  {
+    return width_;
+  }
+
+  /** \brief returns the height of the buffers */
+  unsigned getHeight () const
+  {
+    return height_;
+  }
+
+  /** \brief returns the distance of the near clipping plane in meters */
+  const float& getNearClippingDistance () const
+  {
+    return near_;
+  }
+
+  /** \brief returns the distance of the far clipping plane in meters */
+  const float& getFarClippingDistance () const
+  {
+    return far_;
+  }
+
+private:
+
+  /** \brief projects the clipped camera space triangles collected by addMesh() and sets up their edge and depth equations */
+  void setupTriangles ();
+
+  /** \brief rasterizes the triangles binned to a tile */
+  void rasterizeTile (unsigned tile);
+
+  /** \brief width of the buffers*/
+  unsigned width_;
+
+  /** \brief height of the buffers*/
+  unsigned height_;
+
+  /** \brief distance of near clipping plane*/
+  float near_;
+
+  /** \brief distance of far clipping plane*/
+  float far_;
+
+  /** \brief focal length in x-direction of camera model*/
+  float fx_;
+
+  /** \brief focal length in y-direction of camera model*/
+  float fy_;
+
+  /** \brief x component of principal point of camera model*/
+  float cx_;
+
+  /** \brief y component of principal point of camera model*/
+  float cy_;
+
+  /** \brief number of threads used for rasterization*/
+  unsigned thread_count_;
+
+  /** \brief normalized depth of each pixel*/
+  std::vector<float> depth_;
+
+  /** \brief label of each pixel*/
+  std::vector<uint32_t> labels_;
+
+  /** \brief camera space vertices of the triangles of the current frame, three per triangle, after near plane clipping*/
+  std::vector<Eigen::Vector3f> clipped_vertices_;
+
+  /** \brief label of the triangles of the current frame*/
+  std::vector<uint32_t> clipped_labels_;
+
+  /* per triangle setup, one array per value so the setup loop can be vectorized: the edge equations
+     e(x, y) = a * x + b * y + c that are positive inside the triangle, the depth plane d(x, y) = da * x + db * y + dc
+     and the bounding box in pixels */
+  std::vector<double> edge_a_[3];
+  std::vector<double> edge_b_[3];
+  std::vector<double> edge_c_[3];
+  std::vector<double> depth_a_;
+  std::vector<double> depth_b_;
+  std::vector<double> depth_c_;
+  std::vector<int> min_x_, max_x_, min_y_, max_y_;
+
+  /** \brief number of tiles in x and y direction*/
+  unsigned tiles_x_, tiles_y_;
+
+  /** \brief indices of the triangles overlapping each tile, in the order they were added*/
+  std::vector<std::vector<unsigned> > tile_triangles_;
+};
+} // namespace mesh_filter
+#endif
@@ -87,6 +87,12 @@ public:
        */
       void setRenderParameters (GLRenderer& renderer) const;
 
+      /**
+       * \brief set the projection of the software renderer used instead of OpenGL
+       * \param[in] renderer the software renderer
+       */
+      void setRenderParameters (SoftwareRenderer& renderer) const;
+
       /**
        * \brief set the shader parameters required for the mesh filtering
        * @param[in] renderer the renderer that holds the filtering shader
@@ -36,6 +36,7 @@
 
 #include <moveit/mesh_filter/mesh_filter_base.h>
 #include <moveit/mesh_filter/gl_mesh.h>
+#include <moveit/mesh_filter/software_mesh.h>
 #include <moveit/mesh_filter/filter_job.h>
 
 #include <geometric_shapes/shapes.h>
@@ -55,7 +56,8 @@
 mesh_filter::MeshFilterBase::MeshFilterBase (const TransformCallback& transform_callback,
               const SensorModel::Parameters& sensor_parameters,
               const std::string& render_vertex_shader, const std::string& render_fragment_shader,
-              const std::string& filter_vertex_shader, const std::string& filter_fragment_shader)
+              const std::string& filter_vertex_shader, const std::string& filter_fragment_shader,
+              bool software_rendering)
 : sensor_parameters_ (sensor_parameters.clone ())
 , next_handle_ (FirstLabel) // 0 and 1 are reserved!
 , min_handle_ (FirstLabel)
@@ -65,6 +67,15 @@ mesh_filter::MeshFilterBase::MeshFilterBase (const TransformCallback& transform_
 , padding_offset_ (0.01)
 , shadow_threshold_ (0.5)
 {
+  // the software renderer needs no context, so it is created here; this also reports
+  // sensor models that do not support software rendering to the caller
+  if (software_rendering)
+  {
+    software_renderer_.reset (new SoftwareRenderer (sensor_parameters_->getWidth(), sensor_parameters_->getHeight(),
+                                                    sensor_parameters_->getNearClippingPlaneDistance (),
+                                                    sensor_parameters_->getFarClippingPlaneDistance ()));
+    sensor_parameters_->setRenderParameters (*software_renderer_);
+  }
   filter_thread_ = boost::thread(boost::bind(&MeshFilterBase::run, this,
                                        render_vertex_shader, render_fragment_shader, filter_vertex_shader, filter_fragment_shader));
 }
@@ -72,6 +83,9 @@ mesh_filter::MeshFilterBase::MeshFilterBase (const TransformCallback& transform_
 void mesh_filter::MeshFilterBase::initialize (const std::string& render_vertex_shader, const std::string& render_fragment_shader,
                                               const std::string& filter_vertex_shader, const std::string& filter_fragment_shader)
 {
+  if (software_renderer_)
+    return;
+
   mesh_renderer_.reset (new GLRenderer (sensor_parameters_->getWidth(), sensor_parameters_->getHeight(),
                                         sensor_parameters_->getNearClippingPlaneDistance (),
                                         sensor_parameters_->getFarClippingPlaneDistance ()));
@@ -141,6 +155,12 @@ void mesh_filter::MeshFilterBase::addJob (const JobPtr &job) const
 
 void mesh_filter::MeshFilterBase::deInitialize ()
 {
+  if (software_renderer_)
+  {
+    software_meshes_.clear ();
+    return;
+  }
+
   glDeleteLists (canvas_, 1);
   glDeleteTextures (1, &sensor_depth_texture_);
 
@@ -151,6 +171,13 @@ void mesh_filter::MeshFilterBase::deInitialize ()
 
 void mesh_filter::MeshFilterBase::setSize (unsigned int width, unsigned int height)
 {
+  if (software_renderer_)
+  {
+    software_renderer_->setBufferSize (width, height);
+    software_renderer_->setCameraParameters (width, width, width >> 1, height >> 1);
+    return;
+  }
+
   mesh_renderer_->setBufferSize (width, height);
   mesh_renderer_->setCameraParameters (width, width, width >> 1, height >> 1);
 
@@ -172,9 +199,9 @@ mesh_filter::MeshHandle mesh_filter::MeshFilterBase::addMesh (const shapes::Mesh
   addJob(job);
   job->wait ();
   mesh_filter::MeshHandle ret = next_handle_;
-  const std::size_t sz = min_handle_ + meshes_.size() + 1;
+  const std::size_t sz = min_handle_ + meshes_.size() + software_meshes_.size() + 1;
   for (std::size_t i = min_handle_ ; i < sz ; ++i)
-    if (meshes_.find(i) == meshes_.end())
+    if (meshes_.find(i) == meshes_.end() && software_meshes_.find(i) == software_meshes_.end())
     {
       next_handle_ = i;
       break;
@@ -185,7 +212,10 @@ mesh_filter::MeshHandle mesh_filter::MeshFilterBase::addMesh (const shapes::Mesh
 
 void mesh_filter::MeshFilterBase::addMeshHelper (MeshHandle handle, const shapes::Mesh *cmesh)
 {
-  meshes_[handle] = GLMeshPtr (new GLMesh (*cmesh, handle));
+  if (software_renderer_)
+    software_meshes_[handle] = SoftwareMeshPtr (new SoftwareMesh (*cmesh, handle));
+  else
+    meshes_[handle] = GLMeshPtr (new GLMesh (*cmesh, handle));
 }
 
 void mesh_filter::MeshFilterBase::removeMesh (MeshHandle handle)
@@ -203,7 +233,7 @@ void mesh_filter::MeshFilterBase::removeMesh (MeshHandle handle)
 
 bool mesh_filter::MeshFilterBase::removeMeshHelper (MeshHandle handle)
 {
-  std::size_t erased = meshes_.erase (handle);
+  std::size_t erased = meshes_.erase (handle) + software_meshes_.erase (handle);
   return (erased != 0);
 }
 
@@ -214,14 +244,22 @@ void mesh_filter::MeshFilterBase::setShadowThreshold (float threshold)
 
 void mesh_filter::MeshFilterBase::getModelLabels (LabelType* labels) const
 {
-  JobPtr job (new FilterJob<void> (boost::bind (&GLRenderer::getColorBuffer, mesh_renderer_.get(), (unsigned char*) labels)));
+  JobPtr job;
+  if (software_renderer_)
+    job.reset (new FilterJob<void> (boost::bind (&SoftwareRenderer::getColorBuffer, software_renderer_.get(), (unsigned char*) labels)));
+  else
+    job.reset (new FilterJob<void> (boost::bind (&GLRenderer::getColorBuffer, mesh_renderer_.get(), (unsigned char*) labels)));
   addJob(job);
   job->wait ();
 }
 
 void mesh_filter::MeshFilterBase::getModelDepth (float* depth) const
 {
-  JobPtr job1 (new FilterJob<void> (boost::bind (&GLRenderer::getDepthBuffer, mesh_renderer_.get(), depth)));
+  JobPtr job1;
+  if (software_renderer_)
+    job1.reset (new FilterJob<void> (boost::bind (&SoftwareRenderer::getDepthBuffer, software_renderer_.get(), depth)));
+  else
+    job1.reset (new FilterJob<void> (boost::bind (&GLRenderer::getDepthBuffer, mesh_renderer_.get(), depth)));
   JobPtr job2 (new FilterJob<void> (boost::bind (&SensorModel::Parameters::transformModelDepthToMetricDepth, sensor_parameters_.get(), depth)));
   {
     boost::unique_lock<boost::mutex> lock (jobs_mutex_);
@@ -235,7 +273,11 @@ void mesh_filter::MeshFilterBase::getModelDepth (float* depth) const
 
 void mesh_filter::MeshFilterBase::getFilteredDepth (float* depth) const
 {
-  JobPtr job1 (new FilterJob<void> (boost::bind (&GLRenderer::getDepthBuffer, depth_filter_.get(), depth)));
+  JobPtr job1;
+  if (software_renderer_)
+    job1.reset (new FilterJob<void> (boost::bind (&MeshFilterBase::getSoftwareFilteredDepth, this, depth)));
+  else
+    job1.reset (new FilterJob<void> (boost::bind (&GLRenderer::getDepthBuffer, depth_filter_.get(), depth)));
   JobPtr job2 (new FilterJob<void> (boost::bind (&SensorModel::Parameters::transformFilteredDepthToMetricDepth, sensor_parameters_.get(), depth)));
   {
     boost::unique_lock<boost::mutex> lock (jobs_mutex_);
@@ -249,7 +291,11 @@ void mesh_filter::MeshFilterBase::getFilteredDepth (float* depth) const
 
 void mesh_filter::MeshFilterBase::getFilteredLabels (LabelType* labels) const
 {
-  JobPtr job (new FilterJob<void> (boost::bind (&GLRenderer::getColorBuffer, depth_filter_.get(), (unsigned char*) labels)));
+  JobPtr job;
+  if (software_renderer_)
+    job.reset (new FilterJob<void> (boost::bind (&MeshFilterBase::getSoftwareFilteredLabels, this, labels)));
+  else
+    job.reset (new FilterJob<void> (boost::bind (&GLRenderer::getColorBuffer, depth_filter_.get(), (unsigned char*) labels)));
   addJob(job);
   job->wait ();
 }
@@ -288,7 +334,8 @@ void mesh_filter::MeshFilterBase::filter (const void* sensor_data, GLushort type
     throw std::runtime_error (msg.str ());
   }
 
-  JobPtr job (new FilterJob<void> (boost::bind (&MeshFilterBase::doFilter, this, sensor_data, type)));
+  JobPtr job (new FilterJob<void> (boost::bind (software_renderer_ ? &MeshFilterBase::doSoftwareFilter : &MeshFilterBase::doFilter,
+                                                this, sensor_data, type)));
   addJob(job);
   if (wait)
     job->wait ();
@@ -381,3 +428,103 @@ void mesh_filter::MeshFilterBase::setPaddingScale (float scale)
 {
   padding_scale_ = scale;
 }
+
+bool mesh_filter::MeshFilterBase::usesSoftwareRendering () const
+{
+  return software_renderer_.get () != NULL;
+}
+
+void mesh_filter::MeshFilterBase::setRenderThreadCount (unsigned thread_count)
+{
+  if (!software_renderer_)
+    return;
+  JobPtr job (new FilterJob<void> (boost::bind (&SoftwareRenderer::setThreadCount, software_renderer_.get(), thread_count)));
+  addJob(job);
+  job->wait ();
+}
+
+void mesh_filter::MeshFilterBase::doSoftwareFilter (const void* sensor_data, const int encoding) const
+{
+  boost::mutex::scoped_lock _(transform_callback_mutex_);
+
+  sensor_parameters_->setRenderParameters (*software_renderer_);
+  software_renderer_->begin ();
+
+  Eigen::Vector3f padding_coefficients = sensor_parameters_->getPaddingCoefficients () * padding_scale_ + Eigen::Vector3f (0, 0, padding_offset_);
+  Eigen::Affine3d transform;
+  for (std::map<MeshHandle, SoftwareMeshPtr>::const_iterator meshIt = software_meshes_.begin (); meshIt != software_meshes_.end (); ++meshIt)
+    if (transform_callback_ (meshIt->first, transform))
+      software_renderer_->addMesh (*meshIt->second, transform, padding_coefficients);
+
+  software_renderer_->end ();
+
+  // now compare the sensor data with the rendered model, as the filter shader of the StereoCameraModel does.
+  // Sensor readings are mapped to [0, 1] between the clipping planes and clamped, like the sensor depth texture.
+  const int size = software_renderer_->getWidth () * software_renderer_->getHeight ();
+  software_filtered_depth_.resize (size);
+  software_filtered_labels_.resize (size);
+
+  const float near = sensor_parameters_->getNearClippingPlaneDistance ();
+  const float far = sensor_parameters_->getFarClippingPlaneDistance ();
+  const float f_n = far - near;
+  const float scale = 1.0 / f_n;
+  const float sensor_scale = (encoding == GL_UNSIGNED_SHORT) ? scale * 0.001 : scale;
+  const float sensor_offset = -scale * near;
+  const float threshold = shadow_threshold_ / f_n;
+
+  const float* model_depth = &software_renderer_->getDepth () [0];
+  const uint32_t* model_labels = &software_renderer_->getLabels () [0];
+  const unsigned short* sensor_ushort = static_cast<const unsigned short*> (sensor_data);
+  const float* sensor_float = static_cast<const float*> (sensor_data);
+  const unsigned thread_count = software_renderer_->getThreadCount ();
+
+#pragma omp parallel for num_threads(thread_count) if (thread_count > 1)
+  for (int idx = 0; idx < size; ++idx)
+  {
+    float sValue = ((encoding == GL_UNSIGNED_SHORT) ? sensor_ushort [idx] : sensor_float [idx]) * sensor_scale + sensor_offset;
+    // invalid readings (NaN) end up on the near clipping plane
+    sValue = (sValue > 0) ? std::min (sValue, 1.0f) : 0.0f;
+
+    if (sValue <= 0)
+    {
+      software_filtered_labels_ [idx] = NearClip;
+      software_filtered_depth_ [idx] = 0;
+    }
+    else
+    {
+      const float dValue = model_depth [idx];
+      const float zValue = dValue * near / (far - dValue * f_n);
+      const float diff = sValue - zValue;
+      if (diff < 0 && sValue < 1)
+      {
+        software_filtered_labels_ [idx] = Background;
+        software_filtered_depth_ [idx] = sValue;
+      }
+      else if (diff > threshold)
+      {
+        software_filtered_labels_ [idx] = Shadow;
+        software_filtered_depth_ [idx] = sValue;
+      }
+      else if (sValue == 1)
+      {
+        software_filtered_labels_ [idx] = FarClip;
+        software_filtered_depth_ [idx] = sValue;
+      }
+      else
+      {
+        software_filtered_labels_ [idx] = model_labels [idx];
+        software_filtered_depth_ [idx] = 0;
+      }
+    }
+  }
+}
+
+void mesh_filter::MeshFilterBase::getSoftwareFilteredDepth (float* depth) const
+{
+  std::copy (software_filtered_depth_.begin (), software_filtered_depth_.end (), depth);
+}
+
+void mesh_filter::MeshFilterBase::getSoftwareFilteredLabels (LabelType* labels) const
+{
+  std::copy (software_filtered_labels_.begin (), software_filtered_labels_.end (), labels);
+}
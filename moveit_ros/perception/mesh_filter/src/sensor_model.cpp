@@ -54,6 +54,11 @@ mesh_filter::SensorModel::Parameters::~Parameters ()
 {
 }
 
+void mesh_filter::SensorModel::Parameters::setRenderParameters (SoftwareRenderer& renderer) const
+{
+  throw std::runtime_error ("This sensor model does not support software rendering!");
+}
+
 void mesh_filter::SensorModel::Parameters::setImageSize (unsigned width, unsigned height)
 {
   width_ = width;
@@ -0,0 +1,53 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/mesh_filter/software_mesh.h>
+#include <geometric_shapes/shapes.h>
+#include <stdexcept>
+
+mesh_filter::SoftwareMesh::SoftwareMesh (const shapes::Mesh& mesh, unsigned int mesh_label)
+: mesh_label_ (mesh_label)
+{
+  if (!mesh.vertex_normals)
+    throw std::runtime_error("Vertex normals are not computed for input mesh. Call computeVertexNormals() before passing as input to mesh_filter.");
+
+  vertices_.resize (mesh.vertex_count);
+  normals_.resize (mesh.vertex_count);
+  for (unsigned vIdx = 0; vIdx < mesh.vertex_count; ++vIdx)
+  {
+    vertices_ [vIdx] = Eigen::Vector3f (mesh.vertices [3 * vIdx], mesh.vertices [3 * vIdx + 1], mesh.vertices [3 * vIdx + 2]);
+    normals_ [vIdx] = Eigen::Vector3f (mesh.vertex_normals [3 * vIdx], mesh.vertex_normals [3 * vIdx + 1], mesh.vertex_normals [3 * vIdx + 2]);
+  }
+  triangles_.assign (mesh.triangles, mesh.triangles + 3 * mesh.triangle_count);
+}
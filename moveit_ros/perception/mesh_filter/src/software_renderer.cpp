@@ -0,0 +1,329 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/mesh_filter/software_renderer.h>
+#include <moveit/mesh_filter/software_mesh.h>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cmath>
+
+namespace
+{
+// edge length of the square tiles the image is divided into for rasterization
+static const unsigned TILE_SIZE = 32;
+
+// converts a pixel coordinate to int, clamped to [-1, size] so it can not overflow
+inline int toPixel (double value, unsigned size)
+{
+  return int (std::min (std::max (value, -1.0), double (size)));
+}
+}
+
+mesh_filter::SoftwareRenderer::SoftwareRenderer (unsigned width, unsigned height, float near, float far)
+  : width_ (0)
+  , height_ (0)
+  , near_ (near)
+  , far_ (far)
+  , fx_ (width >> 1) // 90 degree wide angle
+  , fy_ (fx_)
+  , cx_ (width >> 1)
+  , cy_ (height >> 1)
+  , thread_count_ (1)
+  , tiles_x_ (0)
+  , tiles_y_ (0)
+{
+  setBufferSize (width, height);
+}
+
+void mesh_filter::SoftwareRenderer::setBufferSize (unsigned width, unsigned height)
+{
+  if (width_ != width || height_ != height || depth_.empty ())
+  {
+    width_ = width;
+    height_ = height;
+    depth_.resize (width_ * height_);
+    labels_.resize (width_ * height_);
+    tiles_x_ = (width_ + TILE_SIZE - 1) / TILE_SIZE;
+    tiles_y_ = (height_ + TILE_SIZE - 1) / TILE_SIZE;
+    tile_triangles_.resize (tiles_x_ * tiles_y_);
+  }
+}
+
+void mesh_filter::SoftwareRenderer::setClippingRange (float near, float far)
+{
+  if (near <= 0)
+    throw std::runtime_error ("near clipping plane distance needs to be larger than 0");
+  if (far <= near)
+    throw std::runtime_error ("far clipping plane needs to be larger than near clipping plane distance");
+  near_ = near;
+  far_ = far;
+}
+
+void mesh_filter::SoftwareRenderer::setCameraParameters (float fx, float fy, float cx, float cy)
+{
+  fx_ = fx;
+  fy_ = fy;
+  cx_ = cx;
+  cy_ = cy;
+}
+
+void mesh_filter::SoftwareRenderer::setThreadCount (unsigned thread_count)
+{
+  thread_count_ = std::max (1u, thread_count);
+}
+
+void mesh_filter::SoftwareRenderer::begin ()
+{
+  std::fill (depth_.begin (), depth_.end (), 1.0f);
+  std::fill (labels_.begin (), labels_.end (), 0);
+  clipped_vertices_.clear ();
+  clipped_labels_.clear ();
+}
+
+void mesh_filter::SoftwareRenderer::addMesh (const SoftwareMesh& mesh, const Eigen::Affine3d& transform,
+                                             const Eigen::Vector3f& padding_coefficients)
+{
+  const std::vector<Eigen::Vector3f>& vertices = mesh.getVertices ();
+  const std::vector<Eigen::Vector3f>& normals = mesh.getVertexNormals ();
+  const std::vector<unsigned int>& triangles = mesh.getTriangles ();
+
+  // same as the vertex shader of the StereoCameraModel: move each vertex along its normal by the padding
+  // for its depth. OpenGL eye space looks along the negative z-axis, so the eye space depth is -z here.
+  const Eigen::Affine3f pose = transform.cast<float> ();
+  const Eigen::Matrix3f normal_matrix = pose.linear ().inverse ().transpose ();
+  std::vector<Eigen::Vector3f> padded (vertices.size ());
+  for (std::size_t vIdx = 0; vIdx < vertices.size (); ++vIdx)
+  {
+    const Eigen::Vector3f vertex = pose * vertices [vIdx];
+    const Eigen::Vector3f normal = (normal_matrix * normals [vIdx]).normalized ();
+    const float z = -vertex.z ();
+    const float lambda = padding_coefficients.x () * z * z + padding_coefficients.y () * z + padding_coefficients.z ();
+    padded [vIdx] = vertex + lambda * normal;
+  }
+
+  // clip the triangles at the near plane; a triangle with one vertex in front of the plane stays a triangle,
+  // one with two vertices in front of it becomes a quad that is split in two triangles
+  for (std::size_t tIdx = 0; tIdx + 2 < triangles.size (); tIdx += 3)
+  {
+    const Eigen::Vector3f* corners [3] = { &padded [triangles [tIdx]], &padded [triangles [tIdx + 1]], &padded [triangles [tIdx + 2]] };
+    if (corners [0]->z () > far_ && corners [1]->z () > far_ && corners [2]->z () > far_)
+      continue;
+
+    Eigen::Vector3f polygon [4];
+    unsigned count = 0;
+    for (unsigned cIdx = 0; cIdx < 3; ++cIdx)
+    {
+      const Eigen::Vector3f& current = *corners [cIdx];
+      const Eigen::Vector3f& next = *corners [(cIdx + 1) % 3];
+      const bool current_inside = current.z () > near_;
+      const bool next_inside = next.z () > near_;
+      if (current_inside)
+        polygon [count++] = current;
+      if (current_inside != next_inside)
+      {
+        const float t = (near_ - current.z ()) / (next.z () - current.z ());
+        polygon [count] = current + t * (next - current);
+        polygon [count++].z () = near_;
+      }
+    }
+
+    for (unsigned pIdx = 2; pIdx < count; ++pIdx)
+    {
+      clipped_vertices_.push_back (polygon [0]);
+      clipped_vertices_.push_back (polygon [pIdx - 1]);
+      clipped_vertices_.push_back (polygon [pIdx]);
+      clipped_labels_.push_back (mesh.getLabel ());
+    }
+  }
+}
+
+void mesh_filter::SoftwareRenderer::setupTriangles ()
+{
+  const std::size_t triangle_count = clipped_labels_.size ();
+  const std::size_t vertex_count = clipped_vertices_.size ();
+
+  // project the vertices to pixel coordinates and normalized depth. Image row y is at OpenGL window coordinate y,
+  // which is what the flipped y-axis in the vertex shader and the look-at transformation of the GLRenderer produce.
+  std::vector<double> px (vertex_count), py (vertex_count), pd (vertex_count);
+  const double depth_scale = double (far_) / (double (far_) - double (near_));
+  for (std::size_t vIdx = 0; vIdx < vertex_count; ++vIdx)
+  {
+    const Eigen::Vector3f& vertex = clipped_vertices_ [vIdx];
+    const double inv_z = 1.0 / vertex.z ();
+    px [vIdx] = fx_ * vertex.x () * inv_z + cx_;
+    py [vIdx] = fy_ * vertex.y () * inv_z + cy_;
+    pd [vIdx] = depth_scale * (1.0 - near_ * inv_z);
+  }
+
+  for (int i = 0; i < 3; ++i)
+  {
+    edge_a_ [i].resize (triangle_count);
+    edge_b_ [i].resize (triangle_count);
+    edge_c_ [i].resize (triangle_count);
+  }
+  depth_a_.resize (triangle_count);
+  depth_b_.resize (triangle_count);
+  depth_c_.resize (triangle_count);
+  min_x_.resize (triangle_count);
+  max_x_.resize (triangle_count);
+  min_y_.resize (triangle_count);
+  max_y_.resize (triangle_count);
+
+  for (std::size_t tIdx = 0; tIdx < triangle_count; ++tIdx)
+  {
+    const double x0 = px [3 * tIdx], x1 = px [3 * tIdx + 1], x2 = px [3 * tIdx + 2];
+    const double y0 = py [3 * tIdx], y1 = py [3 * tIdx + 1], y2 = py [3 * tIdx + 2];
+    const double d0 = pd [3 * tIdx], d1 = pd [3 * tIdx + 1], d2 = pd [3 * tIdx + 2];
+
+    // twice the signed area; the filter renders with front faces (counter clockwise in window coordinates) culled,
+    // which because of the flipped y-axis are the faces pointing away from the camera
+    const double area = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+    const bool visible = area < 0.0;
+
+    // orient the edge equations so they are positive inside the triangle
+    const double sign = visible ? -1.0 : 1.0;
+    edge_a_ [0][tIdx] = sign * (y0 - y1);
+    edge_b_ [0][tIdx] = sign * (x1 - x0);
+    edge_c_ [0][tIdx] = sign * ((y1 - y0) * x0 - (x1 - x0) * y0);
+    edge_a_ [1][tIdx] = sign * (y1 - y2);
+    edge_b_ [1][tIdx] = sign * (x2 - x1);
+    edge_c_ [1][tIdx] = sign * ((y2 - y1) * x1 - (x2 - x1) * y1);
+    edge_a_ [2][tIdx] = sign * (y2 - y0);
+    edge_b_ [2][tIdx] = sign * (x0 - x2);
+    edge_c_ [2][tIdx] = sign * ((y0 - y2) * x2 - (x0 - x2) * y2);
+
+    // the normalized depth is affine in window coordinates
+    const double inv_area = 1.0 / (visible ? area : 1.0);
+    depth_a_ [tIdx] = ((d1 - d0) * (y2 - y0) - (d2 - d0) * (y1 - y0)) * inv_area;
+    depth_b_ [tIdx] = ((x1 - x0) * (d2 - d0) - (x2 - x0) * (d1 - d0)) * inv_area;
+    depth_c_ [tIdx] = d0 - depth_a_ [tIdx] * x0 - depth_b_ [tIdx] * y0;
+
+    // pixels whose centers (x + 0.5, y + 0.5) lie in the bounding box of the triangle; empty if it is culled
+    if (visible)
+    {
+      min_x_ [tIdx] = std::max (0, toPixel (std::ceil (std::min (x0, std::min (x1, x2)) - 0.5), width_));
+      max_x_ [tIdx] = std::min (int (width_) - 1, toPixel (std::floor (std::max (x0, std::max (x1, x2)) - 0.5), width_));
+      min_y_ [tIdx] = std::max (0, toPixel (std::ceil (std::min (y0, std::min (y1, y2)) - 0.5), height_));
+      max_y_ [tIdx] = std::min (int (height_) - 1, toPixel (std::floor (std::max (y0, std::max (y1, y2)) - 0.5), height_));
+    }
+    else
+    {
+      min_x_ [tIdx] = min_y_ [tIdx] = 0;
+      max_x_ [tIdx] = max_y_ [tIdx] = -1;
+    }
+  }
+
+  // bin the triangles to the tiles they overlap, keeping the order in which they were added
+  for (std::size_t tile = 0; tile < tile_triangles_.size (); ++tile)
+    tile_triangles_ [tile].clear ();
+  for (std::size_t tIdx = 0; tIdx < triangle_count; ++tIdx)
+  {
+    if (min_x_ [tIdx] > max_x_ [tIdx] || min_y_ [tIdx] > max_y_ [tIdx])
+      continue;
+    for (int ty = min_y_ [tIdx] / TILE_SIZE; ty <= max_y_ [tIdx] / int (TILE_SIZE); ++ty)
+      for (int tx = min_x_ [tIdx] / TILE_SIZE; tx <= max_x_ [tIdx] / int (TILE_SIZE); ++tx)
+        tile_triangles_ [ty * tiles_x_ + tx].push_back (tIdx);
+  }
+}
+
+void mesh_filter::SoftwareRenderer::rasterizeTile (unsigned tile)
+{
+  const int tile_min_x = (tile % tiles_x_) * TILE_SIZE;
+  const int tile_min_y = (tile / tiles_x_) * TILE_SIZE;
+  const int tile_max_x = std::min (tile_min_x + int (TILE_SIZE), int (width_)) - 1;
+  const int tile_max_y = std::min (tile_min_y + int (TILE_SIZE), int (height_)) - 1;
+
+  const std::vector<unsigned>& triangles = tile_triangles_ [tile];
+  for (std::size_t i = 0; i < triangles.size (); ++i)
+  {
+    const unsigned tIdx = triangles [i];
+    const int x_begin = std::max (min_x_ [tIdx], tile_min_x);
+    const int x_end = std::min (max_x_ [tIdx], tile_max_x);
+    const int y_begin = std::max (min_y_ [tIdx], tile_min_y);
+    const int y_end = std::min (max_y_ [tIdx], tile_max_y);
+
+    const double a0 = edge_a_ [0][tIdx], b0 = edge_b_ [0][tIdx], c0 = edge_c_ [0][tIdx];
+    const double a1 = edge_a_ [1][tIdx], b1 = edge_b_ [1][tIdx], c1 = edge_c_ [1][tIdx];
+    const double a2 = edge_a_ [2][tIdx], b2 = edge_b_ [2][tIdx], c2 = edge_c_ [2][tIdx];
+    const double da = depth_a_ [tIdx], db = depth_b_ [tIdx], dc = depth_c_ [tIdx];
+
+    // a pixel center exactly on an edge belongs to the triangle for which the edge function increases
+    // with x (or with y for horizontal edges), so pixels on edges shared by two triangles are drawn once
+    const bool tie0 = a0 > 0 || (a0 == 0 && b0 > 0);
+    const bool tie1 = a1 > 0 || (a1 == 0 && b1 > 0);
+    const bool tie2 = a2 > 0 || (a2 == 0 && b2 > 0);
+    const uint32_t label = clipped_labels_ [tIdx];
+
+    for (int y = y_begin; y <= y_end; ++y)
+    {
+      const double sy = y + 0.5;
+      const double row0 = b0 * sy + c0, row1 = b1 * sy + c1, row2 = b2 * sy + c2, row_depth = db * sy + dc;
+      float* depth = &depth_ [y * width_];
+      uint32_t* labels = &labels_ [y * width_];
+      for (int x = x_begin; x <= x_end; ++x)
+      {
+        const double sx = x + 0.5;
+        const double e0 = a0 * sx + row0, e1 = a1 * sx + row1, e2 = a2 * sx + row2;
+        const float d = std::max (0.0, da * sx + row_depth);
+        const bool inside = (e0 > 0 || (e0 == 0 && tie0)) && (e1 > 0 || (e1 == 0 && tie1)) && (e2 > 0 || (e2 == 0 && tie2));
+        if (inside && d < depth [x])
+        {
+          depth [x] = d;
+          labels [x] = label;
+        }
+      }
+    }
+  }
+}
+
+void mesh_filter::SoftwareRenderer::end ()
+{
+  setupTriangles ();
+
+  const int tile_count = tile_triangles_.size ();
+#pragma omp parallel for schedule(dynamic) num_threads(thread_count_) if (thread_count_ > 1)
+  for (int tile = 0; tile < tile_count; ++tile)
+    rasterizeTile (tile);
+}
+
+void mesh_filter::SoftwareRenderer::getColorBuffer (unsigned char* buffer) const
+{
+  memcpy (buffer, &labels_ [0], labels_.size () * sizeof (uint32_t));
+}
+
+void mesh_filter::SoftwareRenderer::getDepthBuffer (float* buffer) const
+{
+  memcpy (buffer, &depth_ [0], depth_.size () * sizeof (float));
+}
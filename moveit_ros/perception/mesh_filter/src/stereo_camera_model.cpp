@@ -36,6 +36,7 @@
 
 #include <moveit/mesh_filter/stereo_camera_model.h>
 #include <moveit/mesh_filter/gl_renderer.h>
+#include <moveit/mesh_filter/software_renderer.h>
 
 using namespace std;
 
@@ -95,6 +96,13 @@ void mesh_filter::StereoCameraModel::Parameters::setRenderParameters (GLRenderer
 //                                        padding_coefficients_3_ * padding_scale_  + padding_offset_ );
 }
 
+void mesh_filter::StereoCameraModel::Parameters::setRenderParameters (SoftwareRenderer& renderer) const
+{
+  renderer.setClippingRange (near_clipping_plane_distance_, far_clipping_plane_distance_);
+  renderer.setBufferSize (width_, height_);
+  renderer.setCameraParameters (fx_, fy_, cx_, cy_);
+}
+
 const Eigen::Vector3f& mesh_filter::StereoCameraModel::Parameters::getPaddingCoefficients () const
 {
   return padding_coefficients_;
@@ -49,6 +49,13 @@ using namespace boost;
 namespace mesh_filter_test
 {
 
+// the same tests are built once for OpenGL and once for software rendering
+#ifdef MESH_FILTER_TEST_SOFTWARE_RENDERING
+static const bool SOFTWARE_RENDERING = true;
+#else
+static const bool SOFTWARE_RENDERING = false;
+#endif
+
 template<typename Type> inline const Type getRandomNumber (const Type& min, const Type& max)
 {
   return Type(min + (max-min) * double(rand ()) / double(RAND_MAX));
@@ -111,7 +118,7 @@ MeshFilterTest<Type>::MeshFilterTest (unsigned width, unsigned height, double ne
 , shadow_ (shadow)
 , epsilon_ (epsilon)
 , sensor_parameters_ (width, height, near_, far_, width >> 1, height >> 1, width >> 1, height >> 1, 0.1, 0.1)
-, filter_ (boost::bind(&MeshFilterTest<Type>::transform_callback, this, _1, _2), sensor_parameters_)
+, filter_ (boost::bind(&MeshFilterTest<Type>::transform_callback, this, _1, _2), sensor_parameters_, SOFTWARE_RENDERING)
 , sensor_data_ (width_ * height_)
 , distance_ (0.0)
 {
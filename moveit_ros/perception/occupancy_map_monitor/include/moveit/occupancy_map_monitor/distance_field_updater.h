@@ -0,0 +1,159 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_OCCUPANCY_MAP_MONITOR_DISTANCE_FIELD_UPDATER_
+#define MOVEIT_OCCUPANCY_MAP_MONITOR_DISTANCE_FIELD_UPDATER_
+
+#include <moveit/macros/class_forward.h>
+#include <moveit/occupancy_map_monitor/occupancy_map.h>
+#include <moveit/distance_field/distance_field.h>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <Eigen/Core>
+#include <set>
+
+namespace occupancy_map_monitor
+{
+
+MOVEIT_CLASS_FORWARD(DistanceFieldUpdater);
+
+/** @brief Keeps a distance field up to date with an OccMapTree.
+
+    Once started, every update of the tree applies the cells that changed
+    occupancy since the revision the field reflects through
+    DistanceField::updatePointsInField(). The field is only rebuilt from the
+    whole tree when the change history of the tree no longer covers that
+    revision. The updater enables change tracking on the tree for as long
+    as it exists. A voxel of the field is occupied when the tree cell at the
+    center of the voxel is occupied, so the field should not be coarser than
+    the tree. Obstacles added to the field by other means may be removed
+    when tree cells overlapping them become free.
+
+    The propagation runs on a thread of the updater, so the sensor threads
+    that update the tree are not held up by it. Updates that arrive while
+    the field is being propagated are applied together afterwards. The field
+    must only be read with the read lock held. */
+class DistanceFieldUpdater
+{
+public:
+
+  typedef boost::shared_lock<boost::shared_mutex> ReadLock;
+
+  DistanceFieldUpdater(const OccMapTreePtr &tree, const distance_field::DistanceFieldPtr &field);
+  ~DistanceFieldUpdater();
+
+  /** @brief Bring the field up to date and keep updating it in the background whenever the tree is updated */
+  void start();
+
+  /** @brief Stop updating the field when the tree is updated. Waits for an update in progress to finish */
+  void stop();
+
+  /** @brief Apply the changes made to the tree since the last update to the field, on the calling thread.
+   *  After start(), this happens automatically in the background */
+  void update();
+
+  /** @brief Get the distance field. It may only be read while the lock returned by reading() (or taken by
+   *  lockRead()) is held */
+  distance_field::DistanceFieldConstPtr getDistanceField() const
+  {
+    return field_;
+  }
+
+  /** @brief Lock the distance field for reading; it is not updated while the returned lock is held */
+  ReadLock reading() const
+  {
+    return ReadLock(field_mutex_);
+  }
+
+  /** @brief Lock the distance field for reading. It will not be updated until unlockRead() is called */
+  void lockRead() const
+  {
+    field_mutex_.lock_shared();
+  }
+
+  /** @brief Unlock the distance field */
+  void unlockRead() const
+  {
+    field_mutex_.unlock_shared();
+  }
+
+  /** @brief Get the revision of the tree the distance field reflects; 0 if it was never updated.
+   *  Call with the read lock held for a value that matches the field */
+  unsigned int getRevision() const
+  {
+    return revision_;
+  }
+
+  /** @brief Get the number of times the distance field was rebuilt from the whole tree */
+  std::size_t getFullUpdateCount() const
+  {
+    return full_update_count_;
+  }
+
+private:
+
+  /** @brief Collect the voxels whose centers lie in a tree cell */
+  void getCellVoxels(const octomap::point3d &center, double size, std::set<std::size_t> &voxels) const;
+
+  std::size_t getVoxelIndex(int x, int y, int z) const;
+  Eigen::Vector3d getVoxelCenter(std::size_t index) const;
+
+  /** @brief Called by the tree after it is updated; wakes up the update thread */
+  void requestUpdate();
+
+  void updateThread();
+
+  OccMapTreePtr tree_;
+  distance_field::DistanceFieldPtr field_;
+  mutable boost::shared_mutex field_mutex_;
+  boost::mutex update_lock_;
+
+  boost::thread update_thread_;
+  boost::mutex request_lock_;
+  boost::condition_variable request_condition_;
+  bool update_requested_;
+  bool stop_requested_;
+
+  std::set<std::size_t> occupied_;  // voxels this updater added to the field
+  unsigned int revision_;
+  std::size_t full_update_count_;
+  bool active_;
+  unsigned int callback_handle_;
+};
+
+}
+
+#endif
@@ -39,8 +39,11 @@
 
 #include <octomap/octomap.h>
 #include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/function.hpp>
 #include <memory>
+#include <deque>
+#include <map>
 
 namespace occupancy_map_monitor
 {
@@ -53,10 +56,12 @@ public:
 
   OccMapTree(double resolution) : octomap::OcTree(resolution)
   {
+    initChangeHistory();
   }
 
   OccMapTree(const std::string &filename) : octomap::OcTree(filename)
   {
+    initChangeHistory();
   }
 
   /** @brief lock the underlying octree. it will not be read or written by the
@@ -79,29 +84,86 @@ public:
     tree_mutex_.lock();
   }
 
-  /** @brief unlock the underlying octree. */
+  /** @brief unlock the underlying octree. If nodes were updated while the
+   *  lock was held, this starts a new revision of the tree */
   void unlockWrite()
   {
+    recordChanges();
     tree_mutex_.unlock();
   }
 
   typedef boost::shared_lock<boost::shared_mutex> ReadLock;
-  typedef boost::unique_lock<boost::shared_mutex> WriteLock;
+
+  /** @brief Holds the write lock of a tree, like lockWrite() and unlockWrite() */
+  class WriteLock
+  {
+  public:
+    WriteLock() : tree_(NULL)
+    {
+    }
+
+    explicit WriteLock(OccMapTree &tree) : tree_(&tree)
+    {
+      tree_->lockWrite();
+    }
+
+    WriteLock(WriteLock &&other) : tree_(other.tree_)
+    {
+      other.tree_ = NULL;
+    }
+
+    WriteLock& operator=(WriteLock &&other)
+    {
+      if (this != &other)
+      {
+        unlock();
+        tree_ = other.tree_;
+        other.tree_ = NULL;
+      }
+      return *this;
+    }
+
+    ~WriteLock()
+    {
+      unlock();
+    }
+
+    void unlock()
+    {
+      if (tree_)
+      {
+        tree_->unlockWrite();
+        tree_ = NULL;
+      }
+    }
+
+  private:
+    WriteLock(const WriteLock&);
+    WriteLock& operator=(const WriteLock&);
+
+    OccMapTree *tree_;
+  };
 
   ReadLock reading()
   {
     return ReadLock(tree_mutex_);
   }
 
+  /** @brief Lock the tree for writing; the changes made while the returned
+   *  lock is held are recorded as a revision when it is released */
   WriteLock writing()
   {
-    return WriteLock(tree_mutex_);
+    return WriteLock(*this);
   }
 
   void triggerUpdateCallback(void)
   {
     if (update_callback_)
       update_callback_();
+    boost::mutex::scoped_lock slock(callbacks_lock_);
+    for (std::map<unsigned int, boost::function<void()> >::const_iterator it = additional_update_callbacks_.begin() ;
+         it != additional_update_callbacks_.end() ; ++it)
+      it->second();
   }
 
   /** @brief Set the callback to trigger when updates are received */
@@ -110,9 +172,175 @@ public:
     update_callback_ = update_callback;
   }
 
+  /** @brief Add a callback to trigger when updates are received, in addition to
+   *  the one set by setUpdateCallback(). The callback must not add or remove
+   *  callbacks itself. Returns a handle for removeUpdateCallback() */
+  unsigned int addUpdateCallback(const boost::function<void()> &update_callback)
+  {
+    boost::mutex::scoped_lock slock(callbacks_lock_);
+    additional_update_callbacks_[++callback_count_] = update_callback;
+    return callback_count_;
+  }
+
+  /** @brief Remove a callback added by addUpdateCallback(). Waits for the
+   *  callback to finish if it is running */
+  void removeUpdateCallback(unsigned int handle)
+  {
+    boost::mutex::scoped_lock slock(callbacks_lock_);
+    additional_update_callbacks_.erase(handle);
+  }
+
+  using octomap::OcTree::updateNode;
+  using octomap::OcTree::setNodeValue;
+
+  /** @brief Update the log-odds of a node, recording its key as changed if change tracking is enabled */
+  virtual OccMapNode* updateNode(const octomap::OcTreeKey &key, float log_odds_update, bool lazy_eval = false)
+  {
+    noteChange(key);
+    return octomap::OcTree::updateNode(key, log_odds_update, lazy_eval);
+  }
+
+  /** @brief Set the log-odds of a node, recording its key as changed if change tracking is enabled */
+  virtual OccMapNode* setNodeValue(const octomap::OcTreeKey &key, float log_odds_value, bool lazy_eval = false)
+  {
+    noteChange(key);
+    return octomap::OcTree::setNodeValue(key, log_odds_value, lazy_eval);
+  }
+
+  /** @brief Start recording the keys of updated nodes for getChangedKeys().
+   *  Recording is off by default, as it costs time and memory on every
+   *  update. Each user of the changes (e.g., a publisher of octomap deltas)
+   *  enables it once and calls disableChangeTracking() when it no longer
+   *  needs it; the changes are known from the current revision on. Must not
+   *  be called with a lock of the tree held */
+  void enableChangeTracking()
+  {
+    boost::unique_lock<boost::shared_mutex> lock(tree_mutex_);
+    if (tracking_users_++ == 0)
+      clearChangeHistory();
+  }
+
+  /** @brief Undo one call to enableChangeTracking(). Recording stops when
+   *  every user disabled it. Must not be called with a lock of the tree held */
+  void disableChangeTracking()
+  {
+    boost::unique_lock<boost::shared_mutex> lock(tree_mutex_);
+    if (tracking_users_ > 0 && --tracking_users_ == 0)
+      clearChangeHistory();
+  }
+
+  /** @brief Check whether the keys of updated nodes are being recorded */
+  bool isTrackingChanges() const
+  {
+    return tracking_users_ > 0;
+  }
+
+  /** @brief Get the current revision of the tree. The revision is incremented
+   *  every time the write lock is released after nodes were updated */
+  unsigned int getRevision() const
+  {
+    return revision_;
+  }
+
+  /** @brief Collect the keys of the nodes whose value was updated since
+   *  revision \e since, whether or not their occupancy changed. Returns false
+   *  if the changes made since that revision are not recorded (because they
+   *  are too old, or change tracking was not enabled), in which case the full
+   *  tree needs to be used. Must be called with the read lock held */
+  bool getChangedKeys(unsigned int since, octomap::KeySet &keys) const
+  {
+    keys.clear();
+    if (since < history_start_ || since > revision_)
+      return false;
+    for (std::size_t i = since - history_start_ ; i < history_.size() ; ++i)
+      keys.insert(history_[i].begin(), history_[i].end());
+    return true;
+  }
+
+  /** @brief Forget the recorded changes. This must be called (with the write
+   *  lock held) after the tree is modified by means other than updateNode()
+   *  or setNodeValue(), e.g., when it is cleared or read from a file */
+  void resetChangeHistory()
+  {
+    ++revision_;
+    clearChangeHistory();
+  }
+
+  /** @brief Set the maximum number of revisions for which changes are kept */
+  void setMaxChangeHistory(std::size_t revisions)
+  {
+    max_history_ = revisions;
+    while (history_.size() > max_history_)
+    {
+      history_.pop_front();
+      ++history_start_;
+    }
+  }
+
 private:
+
+  void initChangeHistory()
+  {
+    revision_ = 1;
+    history_start_ = 1;
+    max_history_ = 64;
+    tracking_users_ = 0;
+    modified_ = false;
+    callback_count_ = 0;
+  }
+
+  void noteChange(const octomap::OcTreeKey &key)
+  {
+    if (tracking_users_ > 0)
+      changed_values_.insert(key);
+    else
+      modified_ = true;
+  }
+
+  /** @brief Forget the recorded changes; they are known again from the current revision on */
+  void clearChangeHistory()
+  {
+    changed_values_.clear();
+    history_.clear();
+    history_start_ = revision_;
+    modified_ = false;
+  }
+
+  void recordChanges()
+  {
+    if (changed_values_.empty())
+    {
+      // without change tracking only the revision moves on
+      if (modified_)
+      {
+        ++revision_;
+        clearChangeHistory();
+      }
+      return;
+    }
+    history_.push_back(octomap::KeySet());
+    history_.back().swap(changed_values_);
+    ++revision_;
+    if (history_.size() > max_history_)
+    {
+      history_.pop_front();
+      ++history_start_;
+    }
+  }
+
   boost::shared_mutex tree_mutex_;
   boost::function<void()> update_callback_;
+  boost::mutex callbacks_lock_;
+  std::map<unsigned int, boost::function<void()> > additional_update_callbacks_;
+  unsigned int callback_count_;
+
+  octomap::KeySet changed_values_;       // the keys updated since the last revision was recorded
+  unsigned int revision_;                // the current revision of the tree
+  unsigned int history_start_;           // the oldest revision changes are known from
+  std::deque<octomap::KeySet> history_;  // history_[i] has the keys changed from revision history_start_ + i to the next one
+  std::size_t max_history_;
+  unsigned int tracking_users_;          // the number of calls to enableChangeTracking() not undone yet
+  bool modified_;                        // nodes were updated since the last revision while changes were not tracked
 };
 
 typedef std::shared_ptr<OccMapTree> OccMapTreePtr;
@@ -0,0 +1,240 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/occupancy_map_monitor/distance_field_updater.h>
+#include <ros/console.h>
+#include <boost/bind.hpp>
+#include <cmath>
+
+namespace occupancy_map_monitor
+{
+
+DistanceFieldUpdater::DistanceFieldUpdater(const OccMapTreePtr &tree, const distance_field::DistanceFieldPtr &field) :
+  tree_(tree),
+  field_(field),
+  update_requested_(false),
+  stop_requested_(false),
+  revision_(0),
+  full_update_count_(0),
+  active_(false),
+  callback_handle_(0)
+{
+  if (field_->getResolution() > tree_->getResolution())
+    ROS_WARN("Distance field resolution %lf is coarser than octree resolution %lf; small obstacles may be missed",
+             field_->getResolution(), tree_->getResolution());
+  tree_->enableChangeTracking();
+}
+
+DistanceFieldUpdater::~DistanceFieldUpdater()
+{
+  stop();
+  tree_->disableChangeTracking();
+}
+
+void DistanceFieldUpdater::start()
+{
+  if (active_)
+    return;
+  update();
+  update_requested_ = false;
+  stop_requested_ = false;
+  update_thread_ = boost::thread(boost::bind(&DistanceFieldUpdater::updateThread, this));
+  callback_handle_ = tree_->addUpdateCallback(boost::bind(&DistanceFieldUpdater::requestUpdate, this));
+  active_ = true;
+}
+
+void DistanceFieldUpdater::stop()
+{
+  if (!active_)
+    return;
+  tree_->removeUpdateCallback(callback_handle_);
+  {
+    boost::mutex::scoped_lock slock(request_lock_);
+    stop_requested_ = true;
+  }
+  request_condition_.notify_all();
+  update_thread_.join();
+  active_ = false;
+}
+
+void DistanceFieldUpdater::requestUpdate()
+{
+  {
+    boost::mutex::scoped_lock slock(request_lock_);
+    update_requested_ = true;
+  }
+  request_condition_.notify_all();
+}
+
+void DistanceFieldUpdater::updateThread()
+{
+  while (true)
+  {
+    {
+      boost::mutex::scoped_lock slock(request_lock_);
+      while (!update_requested_ && !stop_requested_)
+        request_condition_.wait(slock);
+      if (stop_requested_)
+        return;
+      update_requested_ = false;
+    }
+    update();
+  }
+}
+
+std::size_t DistanceFieldUpdater::getVoxelIndex(int x, int y, int z) const
+{
+  return ((std::size_t)x * field_->getYNumCells() + y) * field_->getZNumCells() + z;
+}
+
+Eigen::Vector3d DistanceFieldUpdater::getVoxelCenter(std::size_t index) const
+{
+  int z = index % field_->getZNumCells();
+  index /= field_->getZNumCells();
+  int y = index % field_->getYNumCells();
+  int x = index / field_->getYNumCells();
+  Eigen::Vector3d center;
+  field_->gridToWorld(x, y, z, center.x(), center.y(), center.z());
+  return center;
+}
+
+void DistanceFieldUpdater::getCellVoxels(const octomap::point3d &center, double size, std::set<std::size_t> &voxels) const
+{
+  const double origin[3] = { field_->getOriginX(), field_->getOriginY(), field_->getOriginZ() };
+  const int num_cells[3] = { field_->getXNumCells(), field_->getYNumCells(), field_->getZNumCells() };
+  const double resolution = field_->getResolution();
+
+  // voxel i has its center at origin + i * resolution; find the voxels
+  // with centers in [center - size / 2, center + size / 2)
+  int lo[3], hi[3];
+  for (int d = 0 ; d < 3 ; ++d)
+  {
+    lo[d] = std::max(0, (int)ceil((center(d) - size / 2.0 - origin[d]) / resolution));
+    hi[d] = std::min(num_cells[d] - 1, (int)ceil((center(d) + size / 2.0 - origin[d]) / resolution) - 1);
+    if (lo[d] > hi[d])
+      return;
+  }
+  for (int x = lo[0] ; x <= hi[0] ; ++x)
+    for (int y = lo[1] ; y <= hi[1] ; ++y)
+      for (int z = lo[2] ; z <= hi[2] ; ++z)
+        voxels.insert(getVoxelIndex(x, y, z));
+}
+
+void DistanceFieldUpdater::update()
+{
+  boost::mutex::scoped_lock ulock(update_lock_);
+
+  std::set<std::size_t> affected;
+  std::set<std::size_t> occupied;
+  bool full_update = false;
+  unsigned int revision;
+
+  tree_->lockRead();
+  try
+  {
+    revision = tree_->getRevision();
+    if (revision == revision_)
+    {
+      tree_->unlockRead();
+      return;
+    }
+
+    octomap::KeySet keys;
+    if (revision_ == 0 || !tree_->getChangedKeys(revision_, keys))
+    {
+      // the changes are not known; use every occupied leaf in the volume of the field
+      full_update = true;
+      const double half_resolution = field_->getResolution() / 2.0;
+      octomap::point3d bbx_min(field_->getOriginX() - half_resolution,
+                               field_->getOriginY() - half_resolution,
+                               field_->getOriginZ() - half_resolution);
+      octomap::point3d bbx_max(field_->getOriginX() + field_->getXNumCells() * field_->getResolution() - half_resolution,
+                               field_->getOriginY() + field_->getYNumCells() * field_->getResolution() - half_resolution,
+                               field_->getOriginZ() + field_->getZNumCells() * field_->getResolution() - half_resolution);
+      for (OccMapTree::leaf_bbx_iterator it = tree_->begin_leafs_bbx(bbx_min, bbx_max), end = tree_->end_leafs_bbx() ; it != end ; ++it)
+        if (tree_->isNodeOccupied(*it))
+          getCellVoxels(it.getCoordinate(), it.getSize(), occupied);
+    }
+    else
+    {
+      for (octomap::KeySet::const_iterator it = keys.begin() ; it != keys.end() ; ++it)
+        getCellVoxels(tree_->keyToCoord(*it), tree_->getResolution(), affected);
+      for (std::set<std::size_t>::const_iterator it = affected.begin() ; it != affected.end() ; ++it)
+      {
+        Eigen::Vector3d center = getVoxelCenter(*it);
+        OccMapNode *node = tree_->search(center.x(), center.y(), center.z());
+        if (node && tree_->isNodeOccupied(node))
+          occupied.insert(*it);
+      }
+    }
+  }
+  catch (...)
+  {
+    tree_->unlockRead();
+    ROS_ERROR("Internal error while reading octree for distance field update");
+    return;
+  }
+  tree_->unlockRead();
+
+  EigenSTL::vector_Vector3d old_points;
+  EigenSTL::vector_Vector3d new_points;
+  for (std::set<std::size_t>::const_iterator it = occupied.begin() ; it != occupied.end() ; ++it)
+    new_points.push_back(getVoxelCenter(*it));
+
+  boost::unique_lock<boost::shared_mutex> wlock(field_mutex_);
+  if (full_update)
+  {
+    field_->reset();
+    field_->addPointsToField(new_points);
+    occupied_.swap(occupied);
+    ++full_update_count_;
+    ROS_DEBUG("Rebuilt distance field from %u occupied voxels", (unsigned int)new_points.size());
+  }
+  else
+  {
+    // voxels that keep their state are in both sets and are left untouched
+    for (std::set<std::size_t>::const_iterator it = affected.begin() ; it != affected.end() ; ++it)
+    {
+      bool was_occupied = occupied_.erase(*it) > 0;
+      if (was_occupied)
+        old_points.push_back(getVoxelCenter(*it));
+    }
+    occupied_.insert(occupied.begin(), occupied.end());
+    field_->updatePointsInField(old_points, new_points);
+    ROS_DEBUG("Updated %u voxels of the distance field", (unsigned int)affected.size());
+  }
+  revision_ = revision;
+}
+
+}
@@ -321,6 +321,8 @@ bool OccupancyMapMonitor::loadMapCallback(moveit_msgs::LoadMap::Request& request
     ROS_ERROR("Failed to load map from file");
     response.success = false;
   }
+  // the loaded map replaces the contents of the tree, so changes cannot be sent incrementally
+  tree_->resetChangeHistory();
   tree_->unlockWrite();
 
   return true;
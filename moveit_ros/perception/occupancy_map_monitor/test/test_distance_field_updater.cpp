@@ -0,0 +1,222 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/occupancy_map_monitor/distance_field_updater.h>
+#include <moveit/distance_field/propagation_distance_field.h>
+#include <gtest/gtest.h>
+#include <boost/thread/thread.hpp>
+
+using namespace occupancy_map_monitor;
+
+static const double TREE_RESOLUTION = 0.05;
+static const double FIELD_SIZE = 1.0;
+static const double FIELD_ORIGIN = 0.025;  // voxel centers at the centers of the tree cells
+static const double MAX_DIST = 0.3;
+
+static distance_field::DistanceFieldPtr makeField()
+{
+  return distance_field::DistanceFieldPtr(
+    new distance_field::PropagationDistanceField(FIELD_SIZE, FIELD_SIZE, FIELD_SIZE, TREE_RESOLUTION,
+                                                 FIELD_ORIGIN, FIELD_ORIGIN, FIELD_ORIGIN, MAX_DIST));
+}
+
+static bool areFieldsEqual(const distance_field::DistanceField &df1, const distance_field::DistanceField &df2)
+{
+  if (df1.getXNumCells() != df2.getXNumCells() || df1.getYNumCells() != df2.getYNumCells() ||
+      df1.getZNumCells() != df2.getZNumCells())
+    return false;
+  for (int x = 0 ; x < df1.getXNumCells() ; ++x)
+    for (int y = 0 ; y < df1.getYNumCells() ; ++y)
+      for (int z = 0 ; z < df1.getZNumCells() ; ++z)
+        if (df1.getDistance(x, y, z) != df2.getDistance(x, y, z))
+        {
+          ADD_FAILURE() << "Distances differ at " << x << " " << y << " " << z << ": "
+                        << df1.getDistance(x, y, z) << " " << df2.getDistance(x, y, z);
+          return false;
+        }
+  return true;
+}
+
+// rebuild a field from the current tree and compare it to the field of the updater
+static bool matchesFullRebuild(const OccMapTreePtr &tree, const DistanceFieldUpdater &updater)
+{
+  distance_field::DistanceFieldPtr reference_field = makeField();
+  DistanceFieldUpdater reference(tree, reference_field);
+  reference.update();
+  EXPECT_EQ(1u, reference.getFullUpdateCount());
+  DistanceFieldUpdater::ReadLock lock = updater.reading();
+  return areFieldsEqual(*updater.getDistanceField(), *reference_field);
+}
+
+static void setOccupied(const OccMapTreePtr &tree, double x, double y, double z, bool occupied)
+{
+  tree->setNodeValue(octomap::point3d(x, y, z),
+                     occupied ? tree->getClampingThresMaxLog() : tree->getClampingThresMinLog());
+}
+
+static void addBlock(const OccMapTreePtr &tree, double x0, double y0, double z0, int n, bool occupied)
+{
+  OccMapTree::WriteLock lock = tree->writing();
+  for (int i = 0 ; i < n ; ++i)
+    for (int j = 0 ; j < n ; ++j)
+      for (int k = 0 ; k < n ; ++k)
+        setOccupied(tree, x0 + i * TREE_RESOLUTION, y0 + j * TREE_RESOLUTION, z0 + k * TREE_RESOLUTION, occupied);
+}
+
+TEST(DistanceFieldUpdater, TracksChangesOnlyWhenEnabled)
+{
+  OccMapTreePtr tree(new OccMapTree(TREE_RESOLUTION));
+  octomap::KeySet keys;
+  unsigned int revision = tree->getRevision();
+  addBlock(tree, 0.2, 0.2, 0.2, 2, true);
+  EXPECT_FALSE(tree->isTrackingChanges());
+  EXPECT_LT(revision, tree->getRevision());
+  EXPECT_FALSE(tree->getChangedKeys(revision, keys));
+
+  tree->enableChangeTracking();
+  revision = tree->getRevision();
+  addBlock(tree, 0.6, 0.5, 0.3, 2, true);
+  EXPECT_TRUE(tree->getChangedKeys(revision, keys));
+  EXPECT_EQ(8u, keys.size());
+
+  tree->disableChangeTracking();
+  revision = tree->getRevision();
+  addBlock(tree, 0.6, 0.5, 0.3, 2, false);
+  EXPECT_FALSE(tree->isTrackingChanges());
+  EXPECT_FALSE(tree->getChangedKeys(revision, keys));
+}
+
+TEST(DistanceFieldUpdater, IncrementalMatchesFullRebuild)
+{
+  OccMapTreePtr tree(new OccMapTree(TREE_RESOLUTION));
+  addBlock(tree, 0.2, 0.2, 0.2, 4, true);
+
+  distance_field::DistanceFieldPtr field = makeField();
+  DistanceFieldUpdater updater(tree, field);
+  updater.update();
+  EXPECT_EQ(1u, updater.getFullUpdateCount());
+  EXPECT_EQ(tree->getRevision(), updater.getRevision());
+  EXPECT_TRUE(matchesFullRebuild(tree, updater));
+
+  // add cells, free part of the first block and add cells outside of the field
+  addBlock(tree, 0.6, 0.5, 0.3, 3, true);
+  addBlock(tree, 0.2, 0.2, 0.2, 2, false);
+  addBlock(tree, 1.5, 1.5, 1.5, 2, true);
+  updater.update();
+  EXPECT_EQ(1u, updater.getFullUpdateCount());
+  EXPECT_EQ(tree->getRevision(), updater.getRevision());
+  EXPECT_TRUE(matchesFullRebuild(tree, updater));
+
+  // updating cells without changing their occupancy leaves the field as it is
+  addBlock(tree, 0.6, 0.5, 0.3, 3, true);
+  updater.update();
+  EXPECT_EQ(1u, updater.getFullUpdateCount());
+  EXPECT_TRUE(matchesFullRebuild(tree, updater));
+}
+
+TEST(DistanceFieldUpdater, RebuildsWhenHistoryIsLost)
+{
+  OccMapTreePtr tree(new OccMapTree(TREE_RESOLUTION));
+  tree->setMaxChangeHistory(2);
+  addBlock(tree, 0.2, 0.2, 0.2, 4, true);
+
+  distance_field::DistanceFieldPtr field = makeField();
+  DistanceFieldUpdater updater(tree, field);
+  updater.update();
+  EXPECT_EQ(1u, updater.getFullUpdateCount());
+
+  // more revisions than the tree keeps
+  addBlock(tree, 0.6, 0.5, 0.3, 3, true);
+  addBlock(tree, 0.2, 0.2, 0.2, 2, false);
+  addBlock(tree, 0.4, 0.7, 0.6, 2, true);
+  updater.update();
+  EXPECT_EQ(2u, updater.getFullUpdateCount());
+  EXPECT_EQ(tree->getRevision(), updater.getRevision());
+  EXPECT_TRUE(matchesFullRebuild(tree, updater));
+
+  // the history also ends when the tree is modified without recording changes
+  {
+    OccMapTree::WriteLock lock = tree->writing();
+    tree->clear();
+    tree->resetChangeHistory();
+  }
+  addBlock(tree, 0.5, 0.5, 0.5, 2, true);
+  updater.update();
+  EXPECT_EQ(3u, updater.getFullUpdateCount());
+  EXPECT_TRUE(matchesFullRebuild(tree, updater));
+
+  // and incremental updates resume afterwards
+  addBlock(tree, 0.1, 0.1, 0.1, 2, true);
+  updater.update();
+  EXPECT_EQ(3u, updater.getFullUpdateCount());
+  EXPECT_TRUE(matchesFullRebuild(tree, updater));
+}
+
+TEST(DistanceFieldUpdater, UpdatesInBackground)
+{
+  OccMapTreePtr tree(new OccMapTree(TREE_RESOLUTION));
+  addBlock(tree, 0.2, 0.2, 0.2, 4, true);
+
+  distance_field::DistanceFieldPtr field = makeField();
+  DistanceFieldUpdater updater(tree, field);
+  updater.start();
+  EXPECT_EQ(tree->getRevision(), updater.getRevision());
+
+  for (int i = 0 ; i < 5 ; ++i)
+  {
+    addBlock(tree, 0.1 + 0.15 * i, 0.6, 0.4, 2, true);
+    tree->triggerUpdateCallback();
+  }
+
+  // wait for the update thread to catch up
+  unsigned int revision = tree->getRevision();
+  for (int i = 0 ; i < 500 ; ++i)
+  {
+    {
+      DistanceFieldUpdater::ReadLock lock = updater.reading();
+      if (updater.getRevision() == revision)
+        break;
+    }
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+  }
+  updater.stop();
+  EXPECT_EQ(revision, updater.getRevision());
+  EXPECT_TRUE(matchesFullRebuild(tree, updater));
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
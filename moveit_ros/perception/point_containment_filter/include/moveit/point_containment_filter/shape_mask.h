@@ -79,6 +79,15 @@ public:
 
   void setTransformCallback (const TransformCallback& transform_callback);
 
+  /** \brief Set the number of threads maskContainment() distributes the points of a cloud over (default 1) */
+  void setThreadCount(unsigned int thread_count);
+
+  /** \brief Get the number of threads maskContainment() distributes the points of a cloud over */
+  unsigned int getThreadCount() const
+  {
+    return thread_count_;
+  }
+
   /** \brief Compute the containment mask (INSIDE or OUTSIDE) for a given pointcloud. If a mask element is INSIDE, the point
       is inside the robot. The point is outside if the mask element is OUTSIDE.
   */
@@ -120,9 +129,30 @@ private:
     }
   };
 
+  /** \brief The parameters of a posed body in a form that can be tested against many points at once */
+  struct PackedBody
+  {
+    int type;
+    Eigen::Vector3d center;
+    Eigen::Vector3d axis[3];
+
+    /** \brief Half extents for boxes; half length and squared radius for cylinders; squared radius for spheres */
+    double extent[3];
+
+    /** \brief The body itself, used for the shapes that have no packed containment test */
+    const bodies::Body *body;
+    bodies::BoundingSphere bsphere;
+  };
+
   /** \brief Free memory. */
   void freeMemory();
 
+  /** \brief Fill packed_bodies_ from the current poses of the bodies */
+  void packBodies();
+
+  /** \brief Test the candidate points in [begin, end) against all bodies */
+  void maskCandidates(std::size_t begin, std::size_t end);
+
   TransformCallback transform_callback_;
   ShapeHandle next_handle_;
   ShapeHandle min_handle_;
@@ -131,6 +161,16 @@ private:
   std::set<SeeShape, SortBodies> bodies_;
   std::map<ShapeHandle, std::set<SeeShape, SortBodies>::iterator> used_handles_;
   std::vector<bodies::BoundingSphere> bspheres_;
+  unsigned int thread_count_;
+
+  /* scratch space for maskContainment(): the points inside the bounding sphere of
+     the robot, stored as separate coordinate arrays, and their containment result */
+  std::vector<PackedBody> packed_bodies_;
+  std::vector<unsigned int> candidates_;
+  std::vector<double> candidates_x_;
+  std::vector<double> candidates_y_;
+  std::vector<double> candidates_z_;
+  std::vector<unsigned char> candidates_inside_;
 };
 
 }
@@ -0,0 +1,159 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Compare the per point containment test with ShapeMask::maskContainment() on a synthetic cloud */
+
+#include <moveit/point_containment_filter/shape_mask.h>
+#include <moveit/profiler/profiler.h>
+#include <geometric_shapes/shapes.h>
+#include <geometric_shapes/mesh_operations.h>
+#include <sensor_msgs/point_cloud2_iterator.h>
+#include <boost/bind.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <map>
+
+static bool getTransform(const std::map<point_containment_filter::ShapeHandle, Eigen::Affine3d> *poses,
+                         point_containment_filter::ShapeHandle handle, Eigen::Affine3d &transform)
+{
+  std::map<point_containment_filter::ShapeHandle, Eigen::Affine3d>::const_iterator it = poses->find(handle);
+  if (it == poses->end())
+    return false;
+  transform = it->second;
+  return true;
+}
+
+static double randomValue(double min, double max)
+{
+  return min + (max - min) * rand() / RAND_MAX;
+}
+
+int main(int argc, char **argv)
+{
+  static const unsigned int WIDTH = 640;
+  static const unsigned int HEIGHT = 480;
+  static const unsigned int BODIES = 40;
+  static const int TRIALS = 20;
+  srand(0);
+
+  // bodies of mixed types spread over a robot sized volume in front of the sensor
+  std::map<point_containment_filter::ShapeHandle, Eigen::Affine3d> poses;
+  point_containment_filter::ShapeMask mask(boost::bind(&getTransform, &poses, _1, _2));
+  shapes::Box mesh_box(0.1, 0.15, 0.2);
+  for (unsigned int i = 0 ; i < BODIES ; ++i)
+  {
+    shapes::Shape *shape;
+    switch (i % 4)
+    {
+    case 0:
+      shape = new shapes::Sphere(randomValue(0.05, 0.15));
+      break;
+    case 1:
+      shape = new shapes::Box(randomValue(0.05, 0.3), randomValue(0.05, 0.3), randomValue(0.05, 0.3));
+      break;
+    case 2:
+      shape = new shapes::Cylinder(randomValue(0.03, 0.1), randomValue(0.1, 0.4));
+      break;
+    default:
+      shape = shapes::createMeshFromShape(&mesh_box);
+    }
+    point_containment_filter::ShapeHandle handle = mask.addShape(shapes::ShapeConstPtr(shape), 1.0, 0.02);
+    poses[handle] = Eigen::Translation3d(randomValue(-0.5, 0.5), randomValue(-0.5, 0.5), randomValue(1.0, 2.0)) *
+      Eigen::AngleAxisd(randomValue(-M_PI, M_PI), Eigen::Vector3d(randomValue(-1.0, 1.0), randomValue(-1.0, 1.0), 1.0).normalized());
+  }
+
+  // a depth image like cloud; points hit a wall behind the bodies, or the bodies in the center of the image
+  sensor_msgs::PointCloud2 cloud;
+  sensor_msgs::PointCloud2Modifier modifier(cloud);
+  modifier.setPointCloud2FieldsByString(1, "xyz");
+  modifier.resize(WIDTH * HEIGHT);
+  cloud.width = WIDTH;
+  cloud.height = HEIGHT;
+  sensor_msgs::PointCloud2Iterator<float> iter_x(cloud, "x");
+  sensor_msgs::PointCloud2Iterator<float> iter_y(cloud, "y");
+  sensor_msgs::PointCloud2Iterator<float> iter_z(cloud, "z");
+  for (unsigned int v = 0 ; v < HEIGHT ; ++v)
+    for (unsigned int u = 0 ; u < WIDTH ; ++u, ++iter_x, ++iter_y, ++iter_z)
+    {
+      double depth = (u > WIDTH / 4 && u < 3 * WIDTH / 4 && v > HEIGHT / 4 && v < 3 * HEIGHT / 4) ? randomValue(1.0, 2.0) : 3.0;
+      *iter_x = ((double)u - WIDTH / 2.0) / 525.0 * depth;
+      *iter_y = ((double)v - HEIGHT / 2.0) / 525.0 * depth;
+      *iter_z = depth;
+    }
+
+  printf("Evaluating %u bodies on a %ux%u cloud using %d trials for each test\n", BODIES, WIDTH, HEIGHT, TRIALS);
+  moveit::tools::Profiler::Clear();
+  moveit::tools::Profiler::Start();
+
+  // the containment test the mask used to run on each point
+  std::vector<int> per_point(WIDTH * HEIGHT);
+  printf("Evaluating per point containment ...\n");
+  for (int t = 0 ; t < TRIALS ; ++t)
+  {
+    moveit::tools::Profiler::Begin("Per point");
+    sensor_msgs::PointCloud2ConstIterator<float> it_x(cloud, "x");
+    sensor_msgs::PointCloud2ConstIterator<float> it_y(cloud, "y");
+    sensor_msgs::PointCloud2ConstIterator<float> it_z(cloud, "z");
+    for (std::size_t i = 0 ; i < per_point.size() ; ++i, ++it_x, ++it_y, ++it_z)
+    {
+      Eigen::Vector3d pt(*it_x, *it_y, *it_z);
+      double d = pt.norm();
+      per_point[i] = (d < 0.3 || d > 5.0) ? (int)point_containment_filter::ShapeMask::CLIP : mask.getMaskContainment(pt);
+    }
+    moveit::tools::Profiler::End("Per point");
+  }
+
+  unsigned int thread_counts[] = { 1, 2, 4 };
+  for (std::size_t c = 0 ; c < sizeof(thread_counts) / sizeof(thread_counts[0]) ; ++c)
+  {
+    char name[64];
+    snprintf(name, sizeof(name), "Batched, %u thread(s)", thread_counts[c]);
+    printf("Evaluating %s ...\n", name);
+    mask.setThreadCount(thread_counts[c]);
+    std::vector<int> batched;
+    for (int t = 0 ; t < TRIALS ; ++t)
+    {
+      moveit::tools::Profiler::Begin(name);
+      mask.maskContainment(cloud, Eigen::Vector3d::Zero(), 0.3, 5.0, batched);
+      moveit::tools::Profiler::End(name);
+    }
+    if (batched != per_point)
+      printf("%s: masks differ from the per point test\n", name);
+  }
+
+  moveit::tools::Profiler::Stop();
+  moveit::tools::Profiler::Status();
+  return 0;
+}
@@ -38,11 +38,20 @@
 #include <geometric_shapes/body_operations.h>
 #include <ros/console.h>
 #include <sensor_msgs/point_cloud2_iterator.h>
+#include <cmath>
+
+namespace
+{
+// number of candidate points tested against all bodies at once; small enough
+// for the coordinates to stay in cache, large enough to amortize the per body setup
+static const std::size_t CANDIDATE_BLOCK_SIZE = 256;
+}
 
 point_containment_filter::ShapeMask::ShapeMask(const TransformCallback& transform_callback) :
   transform_callback_(transform_callback),
   next_handle_ (1),
-  min_handle_ (1)
+  min_handle_ (1),
+  thread_count_ (1)
 {
 }
 
@@ -64,6 +73,12 @@ void point_containment_filter::ShapeMask::setTransformCallback(const TransformCa
   transform_callback_ = transform_callback;
 }
 
+void point_containment_filter::ShapeMask::setThreadCount(unsigned int thread_count)
+{
+  boost::mutex::scoped_lock _(shapes_lock_);
+  thread_count_ = std::max(1u, thread_count);
+}
+
 point_containment_filter::ShapeHandle point_containment_filter::ShapeMask::addShape(const shapes::ShapeConstPtr &shape, double scale, double padding)
 {
   boost::mutex::scoped_lock _(shapes_lock_);
@@ -142,27 +157,160 @@ void point_containment_filter::ShapeMask::maskContainment(const sensor_msgs::Poi
     bodies::mergeBoundingSpheres(bspheres_, bound);
     const double radiusSquared = bound.radius * bound.radius;
 
-    // we now decide which points we keep
+    // we first decide which points are clipped or certainly outside; the remaining
+    // points are copied to separate coordinate arrays so they can be tested in batches
+    candidates_.clear();
+    candidates_x_.clear();
+    candidates_y_.clear();
+    candidates_z_.clear();
+
     sensor_msgs::PointCloud2ConstIterator<float> iter_x(data_in, "x");
     sensor_msgs::PointCloud2ConstIterator<float> iter_y(data_in, "y");
     sensor_msgs::PointCloud2ConstIterator<float> iter_z(data_in, "z");
-
-    // Cloud iterators are not incremented in the for loop, because of the pragma
-// Comment out below parallelization as it can result in very high CPU consumption    
-//#pragma omp parallel for schedule(dynamic)
-    for (int i = 0 ; i < (int)np ; ++i)
+    for (unsigned int i = 0 ; i < np ; ++i, ++iter_x, ++iter_y, ++iter_z)
     {
-      Eigen::Vector3d pt = Eigen::Vector3d(*(iter_x+i), *(iter_y+i), *(iter_z+i));
+      Eigen::Vector3d pt = Eigen::Vector3d(*iter_x, *iter_y, *iter_z);
       double d = pt.norm();
-      int out = OUTSIDE;
       if (d < min_sensor_dist || d > max_sensor_dist)
-        out = CLIP;
+        mask[i] = CLIP;
       else
         if ((bound.center - pt).squaredNorm() < radiusSquared)
-          for (std::set<SeeShape>::const_iterator it = bodies_.begin() ; it != bodies_.end() && out == OUTSIDE ; ++it)
-            if (it->body->containsPoint(pt))
-              out = INSIDE;
-      mask[i] = out;
+        {
+          candidates_.push_back(i);
+          candidates_x_.push_back(pt.x());
+          candidates_y_.push_back(pt.y());
+          candidates_z_.push_back(pt.z());
+        }
+        else
+          mask[i] = OUTSIDE;
+    }
+
+    if (!candidates_.empty())
+    {
+      packBodies();
+      candidates_inside_.assign(candidates_.size(), 0);
+
+      const int num_blocks = (candidates_.size() + CANDIDATE_BLOCK_SIZE - 1) / CANDIDATE_BLOCK_SIZE;
+#pragma omp parallel for schedule(dynamic) num_threads(thread_count_) if (thread_count_ > 1)
+      for (int b = 0 ; b < num_blocks ; ++b)
+        maskCandidates(b * CANDIDATE_BLOCK_SIZE, std::min((b + 1) * CANDIDATE_BLOCK_SIZE, candidates_.size()));
+
+      for (std::size_t k = 0 ; k < candidates_.size() ; ++k)
+        mask[candidates_[k]] = candidates_inside_[k] ? INSIDE : OUTSIDE;
+    }
+  }
+}
+
+void point_containment_filter::ShapeMask::packBodies()
+{
+  packed_bodies_.resize(bodies_.size());
+  std::size_t j = 0;
+  for (std::set<SeeShape>::const_iterator it = bodies_.begin() ; it != bodies_.end() ; ++it, ++j)
+  {
+    PackedBody &pb = packed_bodies_[j];
+    const bodies::Body *body = it->body;
+    const std::vector<double> &dims = body->getDimensions();
+    const Eigen::Affine3d &pose = body->getPose();
+    const double scale = body->getScale();
+    const double padding = body->getPadding();
+
+    pb.body = body;
+    pb.center = pose.translation();
+    for (int d = 0 ; d < 3 ; ++d)
+      pb.axis[d] = pose.linear().col(d);
+    body->computeBoundingSphere(pb.bsphere);
+
+    // these mirror the scaled and padded dimensions the bodies use in containsPoint()
+    pb.type = body->getType();
+    if (pb.type == shapes::SPHERE && dims.size() == 1)
+    {
+      const double radius = dims[0] * scale + padding;
+      pb.extent[0] = radius * radius;
+    }
+    else
+      if (pb.type == shapes::BOX && dims.size() == 3)
+      {
+        for (int d = 0 ; d < 3 ; ++d)
+          pb.extent[d] = dims[d] * scale / 2.0 + padding;
+      }
+      else
+        if (pb.type == shapes::CYLINDER && dims.size() == 2)
+        {
+          const double radius = dims[0] * scale + padding;
+          pb.extent[0] = dims[1] * scale / 2.0 + padding;
+          pb.extent[1] = radius * radius;
+        }
+        else
+          pb.type = shapes::UNKNOWN_SHAPE;
+  }
+}
+
+void point_containment_filter::ShapeMask::maskCandidates(std::size_t begin, std::size_t end)
+{
+  const double *x = &candidates_x_[0];
+  const double *y = &candidates_y_[0];
+  const double *z = &candidates_z_[0];
+  unsigned char *inside = &candidates_inside_[0];
+
+  // the loops for the primitive shapes have no branches so they can be vectorized
+  for (std::size_t j = 0 ; j < packed_bodies_.size() ; ++j)
+  {
+    const PackedBody &pb = packed_bodies_[j];
+    const double cx = pb.center.x(), cy = pb.center.y(), cz = pb.center.z();
+    switch (pb.type)
+    {
+    case shapes::SPHERE:
+      {
+        const double radius2 = pb.extent[0];
+        for (std::size_t k = begin ; k < end ; ++k)
+        {
+          const double vx = cx - x[k], vy = cy - y[k], vz = cz - z[k];
+          inside[k] |= (vx * vx + vy * vy + vz * vz < radius2);
+        }
+      }
+      break;
+    case shapes::BOX:
+      {
+        const Eigen::Vector3d &nl = pb.axis[0], &nw = pb.axis[1], &nh = pb.axis[2];
+        const double length2 = pb.extent[0], width2 = pb.extent[1], height2 = pb.extent[2];
+        for (std::size_t k = begin ; k < end ; ++k)
+        {
+          const double vx = x[k] - cx, vy = y[k] - cy, vz = z[k] - cz;
+          const double pl = vx * nl.x() + vy * nl.y() + vz * nl.z();
+          const double pw = vx * nw.x() + vy * nw.y() + vz * nw.z();
+          const double ph = vx * nh.x() + vy * nh.y() + vz * nh.z();
+          inside[k] |= (fabs(pl) <= length2) & (fabs(pw) <= width2) & (fabs(ph) <= height2);
+        }
+      }
+      break;
+    case shapes::CYLINDER:
+      {
+        const Eigen::Vector3d &nb1 = pb.axis[0], &nb2 = pb.axis[1], &nh = pb.axis[2];
+        const double length2 = pb.extent[0], radius2 = pb.extent[1];
+        for (std::size_t k = begin ; k < end ; ++k)
+        {
+          const double vx = x[k] - cx, vy = y[k] - cy, vz = z[k] - cz;
+          const double ph = vx * nh.x() + vy * nh.y() + vz * nh.z();
+          const double pb1 = vx * nb1.x() + vy * nb1.y() + vz * nb1.z();
+          const double pb2 = vx * nb2.x() + vy * nb2.y() + vz * nb2.z();
+          inside[k] |= (fabs(ph) <= length2) & (pb2 * pb2 < radius2 - pb1 * pb1);
+        }
+      }
+      break;
+    default:
+      {
+        // meshes and other shapes: only points inside the bounding sphere of the body
+        // that are not already known to be inside the robot go through the exact test
+        const double bx = pb.bsphere.center.x(), by = pb.bsphere.center.y(), bz = pb.bsphere.center.z();
+        const double bradius2 = pb.bsphere.radius * pb.bsphere.radius;
+        for (std::size_t k = begin ; k < end ; ++k)
+          if (!inside[k])
+          {
+            const double vx = bx - x[k], vy = by - y[k], vz = bz - z[k];
+            if (vx * vx + vy * vy + vz * vz <= bradius2 && pb.body->containsPoint(Eigen::Vector3d(x[k], y[k], z[k])))
+              inside[k] = 1;
+          }
+      }
     }
   }
 }
@@ -0,0 +1,188 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/point_containment_filter/shape_mask.h>
+#include <geometric_shapes/shapes.h>
+#include <geometric_shapes/mesh_operations.h>
+#include <geometric_shapes/body_operations.h>
+#include <sensor_msgs/point_cloud2_iterator.h>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <gtest/gtest.h>
+#include <cstdlib>
+
+using namespace point_containment_filter;
+
+class ShapeMaskTest : public testing::Test
+{
+protected:
+
+  virtual void SetUp()
+  {
+    srand(0);
+    mask_.setTransformCallback(boost::bind(&ShapeMaskTest::getTransform, this, _1, _2));
+  }
+
+  // add a shape with a pose that is rotated about all axes; a reference body with the same parameters is kept
+  void addShape(shapes::Shape *shape, const Eigen::Vector3d &position, double angle, double scale, double padding)
+  {
+    shapes::ShapeConstPtr s(shape);
+    ShapeHandle handle = mask_.addShape(s, scale, padding);
+    ASSERT_NE(0u, handle);
+    Eigen::Affine3d pose = Eigen::Translation3d(position) *
+      Eigen::AngleAxisd(angle, Eigen::Vector3d(1.0, 2.0, 3.0).normalized());
+    poses_[handle] = pose;
+
+    boost::shared_ptr<bodies::Body> body(bodies::createBodyFromShape(shape));
+    body->setScale(scale);
+    body->setPadding(padding);
+    body->setPose(pose);
+    reference_.push_back(body);
+  }
+
+  bool getTransform(ShapeHandle handle, Eigen::Affine3d &transform) const
+  {
+    std::map<ShapeHandle, Eigen::Affine3d>::const_iterator it = poses_.find(handle);
+    if (it == poses_.end())
+      return false;
+    transform = it->second;
+    return true;
+  }
+
+  // random points in a cube around the shapes
+  void makeCloud(std::size_t count, double size)
+  {
+    sensor_msgs::PointCloud2Modifier modifier(cloud_);
+    modifier.setPointCloud2FieldsByString(1, "xyz");
+    modifier.resize(count);
+    sensor_msgs::PointCloud2Iterator<float> iter_x(cloud_, "x");
+    sensor_msgs::PointCloud2Iterator<float> iter_y(cloud_, "y");
+    sensor_msgs::PointCloud2Iterator<float> iter_z(cloud_, "z");
+    for (std::size_t i = 0 ; i < count ; ++i, ++iter_x, ++iter_y, ++iter_z)
+    {
+      *iter_x = size * ((double)rand() / RAND_MAX - 0.5);
+      *iter_y = size * ((double)rand() / RAND_MAX - 0.5);
+      *iter_z = size * ((double)rand() / RAND_MAX - 0.5);
+    }
+  }
+
+  // check the mask against containsPoint() of the reference bodies; returns the number of points inside
+  std::size_t checkMask(const std::vector<int> &mask, double min_sensor_dist, double max_sensor_dist)
+  {
+    std::size_t num_inside = 0;
+    sensor_msgs::PointCloud2ConstIterator<float> iter_x(cloud_, "x");
+    sensor_msgs::PointCloud2ConstIterator<float> iter_y(cloud_, "y");
+    sensor_msgs::PointCloud2ConstIterator<float> iter_z(cloud_, "z");
+    EXPECT_EQ(cloud_.width * cloud_.height, mask.size());
+    for (std::size_t i = 0 ; i < mask.size() ; ++i, ++iter_x, ++iter_y, ++iter_z)
+    {
+      Eigen::Vector3d pt(*iter_x, *iter_y, *iter_z);
+      int expected = ShapeMask::OUTSIDE;
+      if (pt.norm() < min_sensor_dist || pt.norm() > max_sensor_dist)
+        expected = ShapeMask::CLIP;
+      else
+        for (std::size_t j = 0 ; j < reference_.size() ; ++j)
+          if (reference_[j]->containsPoint(pt))
+          {
+            expected = ShapeMask::INSIDE;
+            ++num_inside;
+            break;
+          }
+      EXPECT_EQ(expected, mask[i]) << "point " << i << " at " << pt.transpose();
+      EXPECT_EQ(mask[i] == ShapeMask::CLIP ? ShapeMask::OUTSIDE : mask[i], mask_.getMaskContainment(pt));
+    }
+    return num_inside;
+  }
+
+  ShapeMask mask_;
+  std::map<ShapeHandle, Eigen::Affine3d> poses_;
+  std::vector<boost::shared_ptr<bodies::Body> > reference_;
+  sensor_msgs::PointCloud2 cloud_;
+};
+
+TEST_F(ShapeMaskTest, Sphere)
+{
+  addShape(new shapes::Sphere(0.3), Eigen::Vector3d(0.1, -0.2, 0.3), 0.0, 1.0, 0.0);
+  addShape(new shapes::Sphere(0.2), Eigen::Vector3d(-0.4, 0.3, -0.1), 0.7, 1.2, 0.05);
+  makeCloud(20000, 2.0);
+  std::vector<int> mask;
+  mask_.maskContainment(cloud_, Eigen::Vector3d::Zero(), 0.0, 10.0, mask);
+  EXPECT_GT(checkMask(mask, 0.0, 10.0), 0u);
+}
+
+TEST_F(ShapeMaskTest, Box)
+{
+  addShape(new shapes::Box(0.4, 0.2, 0.6), Eigen::Vector3d(0.1, -0.2, 0.3), 0.4, 1.0, 0.0);
+  addShape(new shapes::Box(0.3, 0.5, 0.1), Eigen::Vector3d(-0.4, 0.3, -0.1), -1.1, 1.5, 0.03);
+  makeCloud(20000, 2.0);
+  std::vector<int> mask;
+  mask_.maskContainment(cloud_, Eigen::Vector3d::Zero(), 0.0, 10.0, mask);
+  EXPECT_GT(checkMask(mask, 0.0, 10.0), 0u);
+}
+
+TEST_F(ShapeMaskTest, Cylinder)
+{
+  addShape(new shapes::Cylinder(0.2, 0.7), Eigen::Vector3d(0.1, -0.2, 0.3), 0.9, 1.0, 0.0);
+  addShape(new shapes::Cylinder(0.1, 0.3), Eigen::Vector3d(-0.4, 0.3, -0.1), 2.0, 0.8, 0.04);
+  makeCloud(20000, 2.0);
+  std::vector<int> mask;
+  mask_.maskContainment(cloud_, Eigen::Vector3d::Zero(), 0.0, 10.0, mask);
+  EXPECT_GT(checkMask(mask, 0.0, 10.0), 0u);
+}
+
+TEST_F(ShapeMaskTest, MixedThreadedAndClipped)
+{
+  shapes::Box box(0.3, 0.3, 0.3);
+  addShape(new shapes::Sphere(0.2), Eigen::Vector3d(0.3, 0.0, 0.0), 0.0, 1.0, 0.01);
+  addShape(new shapes::Box(0.4, 0.2, 0.6), Eigen::Vector3d(-0.3, 0.2, 0.1), 0.4, 1.0, 0.02);
+  addShape(new shapes::Cylinder(0.15, 0.5), Eigen::Vector3d(0.0, -0.4, 0.2), 1.3, 1.1, 0.0);
+  addShape(shapes::createMeshFromShape(&box), Eigen::Vector3d(0.1, 0.4, -0.3), 0.6, 1.0, 0.0);
+  makeCloud(50000, 2.0);
+
+  std::vector<int> mask;
+  mask_.maskContainment(cloud_, Eigen::Vector3d::Zero(), 0.1, 0.8, mask);
+  EXPECT_GT(checkMask(mask, 0.1, 0.8), 0u);
+
+  std::vector<int> threaded_mask;
+  mask_.setThreadCount(4);
+  EXPECT_EQ(4u, mask_.getThreadCount());
+  mask_.maskContainment(cloud_, Eigen::Vector3d::Zero(), 0.1, 0.8, threaded_mask);
+  EXPECT_TRUE(mask == threaded_mask);
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
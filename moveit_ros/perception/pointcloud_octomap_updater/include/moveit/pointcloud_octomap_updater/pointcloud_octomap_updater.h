@@ -83,6 +83,7 @@ private:
   double padding_;
   double max_range_;
   unsigned int point_subsample_;
+  unsigned int shape_mask_threads_;
   std::string filtered_cloud_topic_;
   ros::Publisher filtered_cloud_publisher_;
 
@@ -128,6 +128,7 @@ private:
   JntArray qdot_out_reduced;
 
   // This is the set of variable used when solving for position only inverse kinematics
+  Eigen::MatrixXd jac_translate; // the translational part of the jacobian, kept here so the SVD does not need a temporary
   Eigen::MatrixXd U_translate;
   Eigen::VectorXd S_translate;
   Eigen::MatrixXd V_translate;
@@ -156,6 +157,7 @@ private:
 
   // This is the set of variable used when solving for position only inverse kinematics
   // for the case where the redundant joint is "locked" and plays no part
+  Eigen::MatrixXd jac_translate_locked;
   Eigen::MatrixXd U_translate_locked;
   Eigen::VectorXd S_translate_locked;
   Eigen::MatrixXd V_translate_locked;
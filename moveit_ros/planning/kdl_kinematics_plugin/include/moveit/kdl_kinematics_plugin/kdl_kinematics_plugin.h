@@ -43,6 +43,7 @@
 
 // System
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 // ROS msgs
 #include <geometry_msgs/PoseStamped.h>
@@ -137,6 +138,14 @@ namespace kdl_kinematics_plugin
      */
     const std::vector<std::string>& getLinkNames() const;
 
+    /**
+     * @brief  Every call works on its own pooled solver workspace, so queries can run concurrently
+     */
+    virtual bool supportsConcurrentQueries() const
+    {
+      return true;
+    }
+
   protected:
 
   /**
@@ -167,6 +176,14 @@ namespace kdl_kinematics_plugin
 
   private:
 
+    /** @brief The solvers and scratch memory used by a call to searchPositionIK() or getPositionFK() */
+    struct IKSolverWorkspace;
+    typedef boost::shared_ptr<IKSolverWorkspace> IKSolverWorkspacePtr;
+
+    /** @brief Gives a call exclusive use of an idle workspace, and returns it to the pool when destroyed */
+    class WorkspaceGuard;
+    friend class WorkspaceGuard;
+
     bool timedOut(const ros::WallTime &start_time, double duration) const;
 
 
@@ -185,7 +202,7 @@ namespace kdl_kinematics_plugin
 
     int getKDLSegmentIndex(const std::string &name) const;
 
-    void getRandomConfiguration(KDL::JntArray &jnt_array, bool lock_redundancy) const;
+    void getRandomConfiguration(IKSolverWorkspace &ws, KDL::JntArray &jnt_array, bool lock_redundancy) const;
 
     /** @brief Get a random configuration within joint limits close to the seed state
      *  @param seed_state Seed state
@@ -193,7 +210,8 @@ namespace kdl_kinematics_plugin
      *  @param consistency_limit The returned state will contain a value for the redundant joint in the range [seed_state(redundancy_limit)-consistency_limit,seed_state(redundancy_limit)+consistency_limit]
      *  @param jnt_array Returned random configuration
      */
-    void getRandomConfiguration(const KDL::JntArray& seed_state,
+    void getRandomConfiguration(IKSolverWorkspace &ws,
+                                const KDL::JntArray& seed_state,
                                 const std::vector<double> &consistency_limits,
                                 KDL::JntArray &jnt_array,
                                 bool lock_redundancy) const;
@@ -216,7 +234,6 @@ namespace kdl_kinematics_plugin
 
     robot_model::RobotModelPtr robot_model_;
 
-    robot_state::RobotStatePtr state_, state_2_;
 
     int num_possible_redundant_joints_;
     std::vector<unsigned int> redundant_joints_map_index_;
@@ -228,6 +245,12 @@ namespace kdl_kinematics_plugin
     double epsilon_;
     std::vector<JointMimic> mimic_joints_;
 
+    // Workspaces are created on demand, one for each call running concurrently, and reused afterwards
+    mutable boost::mutex workspaces_lock_;
+    mutable std::vector<IKSolverWorkspacePtr> workspaces_;
+    mutable std::vector<IKSolverWorkspace*> idle_workspaces_;
+    unsigned int workspace_generation_; /** Incremented when the workspaces need to be set up again (e.g., redundant joints changed) */
+
   };
 }
 
@@ -47,19 +47,119 @@
 
 #include <moveit/rdf_loader/rdf_loader.h>
 
+#include <boost/scoped_ptr.hpp>
+
 //register KDLKinematics as a KinematicsBase implementation
 CLASS_LOADER_REGISTER_CLASS(kdl_kinematics_plugin::KDLKinematicsPlugin, kinematics::KinematicsBase)
 
 namespace kdl_kinematics_plugin
 {
 
-  KDLKinematicsPlugin::KDLKinematicsPlugin():active_(false) {}
+struct KDLKinematicsPlugin::IKSolverWorkspace
+{
+  IKSolverWorkspace(const robot_model::RobotModelConstPtr &robot_model) :
+    generation_(0),
+    valid_(false),
+    state_(robot_model)
+  {
+  }
+
+  /** @brief Construct the solvers and size the buffers for the current configuration of \e plugin */
+  void setup(const KDLKinematicsPlugin &plugin)
+  {
+    unsigned int dimension = plugin.dimension_;
+    jnt_seed_state_.resize(dimension);
+    jnt_pos_in_.resize(dimension);
+    jnt_pos_out_.resize(dimension);
+    values_.resize(dimension);
+    near_.resize(dimension);
+    consistency_limits_mimic_.clear();
+    consistency_limits_mimic_.reserve(dimension);
+
+    ik_solver_pos_.reset();
+    ik_solver_vel_.reset();
+    fk_solver_.reset(new KDL::ChainFkSolverPos_recursive(plugin.kdl_chain_));
+    ik_solver_vel_.reset(new KDL::ChainIkSolverVel_pinv_mimic(plugin.kdl_chain_, plugin.joint_model_group_->getMimicJointModels().size(),
+                                                              plugin.redundant_joint_indices_.size(), plugin.position_ik_));
+    ik_solver_pos_.reset(new KDL::ChainIkSolverPos_NR_JL_Mimic(plugin.kdl_chain_, plugin.joint_min_, plugin.joint_max_, *fk_solver_, *ik_solver_vel_,
+                                                               plugin.max_solver_iterations_, plugin.epsilon_, plugin.position_ik_));
+    ik_solver_vel_->setMimicJoints(plugin.mimic_joints_);
+    ik_solver_pos_->setMimicJoints(plugin.mimic_joints_);
+
+    valid_ = plugin.redundant_joint_indices_.empty() || ik_solver_vel_->setRedundantJointsMapIndex(plugin.redundant_joints_map_index_);
+    generation_ = plugin.workspace_generation_;
+  }
+
+  unsigned int generation_;
+  bool valid_;
+
+  KDL::JntArray jnt_seed_state_;
+  KDL::JntArray jnt_pos_in_;
+  KDL::JntArray jnt_pos_out_;
+
+  // the position solver refers to the other two, so it is destroyed first
+  boost::scoped_ptr<KDL::ChainFkSolverPos_recursive> fk_solver_;
+  boost::scoped_ptr<KDL::ChainIkSolverVel_pinv_mimic> ik_solver_vel_;
+  boost::scoped_ptr<KDL::ChainIkSolverPos_NR_JL_Mimic> ik_solver_pos_;
+
+  // used to sample random configurations
+  robot_state::RobotState state_;
+  std::vector<double> values_;
+  std::vector<double> near_;
+  std::vector<double> consistency_limits_mimic_;
+};
+
+class KDLKinematicsPlugin::WorkspaceGuard
+{
+public:
+
+  WorkspaceGuard(const KDLKinematicsPlugin &plugin) : plugin_(plugin), ws_(NULL)
+  {
+    {
+      boost::mutex::scoped_lock slock(plugin_.workspaces_lock_);
+      if (!plugin_.idle_workspaces_.empty())
+      {
+        ws_ = plugin_.idle_workspaces_.back();
+        plugin_.idle_workspaces_.pop_back();
+      }
+      else
+      {
+        plugin_.workspaces_.push_back(IKSolverWorkspacePtr(new IKSolverWorkspace(plugin_.robot_model_)));
+        // make sure returning workspaces to the pool never needs to allocate
+        plugin_.idle_workspaces_.reserve(plugin_.workspaces_.size());
+        ws_ = plugin_.workspaces_.back().get();
+      }
+    }
+    if (!ws_->fk_solver_ || ws_->generation_ != plugin_.workspace_generation_)
+      ws_->setup(plugin_);
+  }
+
+  ~WorkspaceGuard()
+  {
+    boost::mutex::scoped_lock slock(plugin_.workspaces_lock_);
+    plugin_.idle_workspaces_.push_back(ws_);
+  }
+
+  IKSolverWorkspace& get()
+  {
+    return *ws_;
+  }
+
+private:
 
-void KDLKinematicsPlugin::getRandomConfiguration(KDL::JntArray &jnt_array, bool lock_redundancy) const
+  const KDLKinematicsPlugin &plugin_;
+  IKSolverWorkspace *ws_;
+};
+
+KDLKinematicsPlugin::KDLKinematicsPlugin() : active_(false), workspace_generation_(0)
 {
-  std::vector<double> jnt_array_vector(dimension_, 0.0);
-  state_->setToRandomPositions(joint_model_group_);
-  state_->copyJointGroupPositions(joint_model_group_, &jnt_array_vector[0]);
+}
+
+void KDLKinematicsPlugin::getRandomConfiguration(IKSolverWorkspace &ws, KDL::JntArray &jnt_array, bool lock_redundancy) const
+{
+  std::vector<double> &jnt_array_vector = ws.values_;
+  ws.state_.setToRandomPositions(joint_model_group_);
+  ws.state_.copyJointGroupPositions(joint_model_group_, &jnt_array_vector[0]);
   for (std::size_t i = 0; i < dimension_; ++i)
   {
     if (lock_redundancy)
@@ -77,18 +177,20 @@ bool KDLKinematicsPlugin::isRedundantJoint(unsigned int index) const
   return false;
 }
 
-void KDLKinematicsPlugin::getRandomConfiguration(const KDL::JntArray &seed_state,
+void KDLKinematicsPlugin::getRandomConfiguration(IKSolverWorkspace &ws,
+                                                 const KDL::JntArray &seed_state,
                                                  const std::vector<double> &consistency_limits,
                                                  KDL::JntArray &jnt_array,
                                                  bool lock_redundancy) const
 {
-  std::vector<double> values(dimension_, 0.0);
-  std::vector<double> near(dimension_, 0.0);
+  std::vector<double> &values = ws.values_;
+  std::vector<double> &near = ws.near_;
   for (std::size_t i = 0 ; i < dimension_; ++i)
     near[i] = seed_state(i);
 
   // Need to resize the consistency limits to remove mimic joints
-  std::vector<double> consistency_limits_mimic;
+  std::vector<double> &consistency_limits_mimic = ws.consistency_limits_mimic_;
+  consistency_limits_mimic.clear();
   for(std::size_t i = 0; i < dimension_; ++i)
   {
     if(!mimic_joints_[i].active)
@@ -96,7 +198,7 @@ void KDLKinematicsPlugin::getRandomConfiguration(const KDL::JntArray &seed_state
     consistency_limits_mimic.push_back(consistency_limits[i]);
   }
 
-  joint_model_group_->getVariableRandomPositionsNearBy(state_->getRandomNumberGenerator(), values, near, consistency_limits_mimic);
+  joint_model_group_->getVariableRandomPositionsNearBy(ws.state_.getRandomNumberGenerator(), values, near, consistency_limits_mimic);
 
   for (std::size_t i = 0; i < dimension_; ++i)
   {
@@ -271,16 +373,19 @@ bool KDLKinematicsPlugin::initialize(const std::string &robot_description,
   }
   mimic_joints_ = mimic_joints;
 
-  // Setup the joint state groups that we need
-  state_.reset(new robot_state::RobotState(robot_model_));
-  state_2_.reset(new robot_state::RobotState(robot_model_));
-
   // Store things for when the set of redundant joints may change
   position_ik_ = position_ik;
   joint_model_group_ = joint_model_group;
   max_solver_iterations_ = max_solver_iterations;
   epsilon_ = epsilon;
 
+  // solvers set up for a previous configuration cannot be used anymore
+  {
+    boost::mutex::scoped_lock slock(workspaces_lock_);
+    workspaces_.clear();
+    idle_workspaces_.clear();
+  }
+
   active_ = true;
   ROS_DEBUG_NAMED("kdl","KDL solver initialized");
   return true;
@@ -341,6 +446,7 @@ bool KDLKinematicsPlugin::setRedundantJoints(const std::vector<unsigned int> &re
 
   redundant_joints_map_index_ = redundant_joints_map_index;
   redundant_joint_indices_ = redundant_joints;
+  workspace_generation_++;
   return true;
 }
 
@@ -497,17 +603,16 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose &ik_pose,
     return false;
   }
 
-  KDL::JntArray jnt_seed_state(dimension_);
-  KDL::JntArray jnt_pos_in(dimension_);
-  KDL::JntArray jnt_pos_out(dimension_);
-
-  KDL::ChainFkSolverPos_recursive fk_solver(kdl_chain_);
-  KDL::ChainIkSolverVel_pinv_mimic ik_solver_vel(kdl_chain_, joint_model_group_->getMimicJointModels().size(), redundant_joint_indices_.size(), position_ik_);
-  KDL::ChainIkSolverPos_NR_JL_Mimic ik_solver_pos(kdl_chain_, joint_min_, joint_max_, fk_solver, ik_solver_vel, max_solver_iterations_, epsilon_, position_ik_);
-  ik_solver_vel.setMimicJoints(mimic_joints_);
-  ik_solver_pos.setMimicJoints(mimic_joints_);
+  // the solvers and buffers are reused across calls instead of being constructed for each one
+  WorkspaceGuard guard(*this);
+  IKSolverWorkspace &ws = guard.get();
+  KDL::JntArray &jnt_seed_state = ws.jnt_seed_state_;
+  KDL::JntArray &jnt_pos_in = ws.jnt_pos_in_;
+  KDL::JntArray &jnt_pos_out = ws.jnt_pos_out_;
+  KDL::ChainIkSolverVel_pinv_mimic &ik_solver_vel = *ws.ik_solver_vel_;
+  KDL::ChainIkSolverPos_NR_JL_Mimic &ik_solver_pos = *ws.ik_solver_pos_;
 
-  if ((redundant_joint_indices_.size() > 0) && !ik_solver_vel.setRedundantJointsMapIndex(redundant_joints_map_index_))
+  if (!ws.valid_)
   {
     ROS_ERROR_NAMED("kdl","Could not set redundant joints");
     return false;
@@ -552,7 +657,7 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose &ik_pose,
     ROS_DEBUG_NAMED("kdl","IK valid: %d", ik_valid);
     if(!consistency_limits.empty())
     {
-      getRandomConfiguration(jnt_seed_state, consistency_limits, jnt_pos_in, options.lock_redundant_joints);
+      getRandomConfiguration(ws, jnt_seed_state, consistency_limits, jnt_pos_in, options.lock_redundant_joints);
       if( (ik_valid < 0 && !options.return_approximate_solution) || !checkConsistency(jnt_seed_state, consistency_limits, jnt_pos_out))
       {
         ROS_DEBUG_NAMED("kdl","Could not find IK solution: does not match consistency limits");
@@ -561,7 +666,7 @@ bool KDLKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose &ik_pose,
     }
     else
     {
-      getRandomConfiguration(jnt_pos_in, options.lock_redundant_joints);
+      getRandomConfiguration(ws, jnt_pos_in, options.lock_redundant_joints);
       ROS_DEBUG_NAMED("kdl","New random configuration");
       for(unsigned int j=0; j < dimension_; j++)
         ROS_DEBUG_NAMED("kdl","%d %f", j, jnt_pos_in(j));
@@ -614,13 +719,14 @@ bool KDLKinematicsPlugin::getPositionFK(const std::vector<std::string> &link_nam
   geometry_msgs::PoseStamped pose;
   tf::Stamped<tf::Pose> tf_pose;
 
-  KDL::JntArray jnt_pos_in(dimension_);
+  WorkspaceGuard guard(*this);
+  KDL::JntArray &jnt_pos_in = guard.get().jnt_pos_in_;
   for(unsigned int i=0; i < dimension_; i++)
   {
     jnt_pos_in(i) = joint_angles[i];
   }
 
-  KDL::ChainFkSolverPos_recursive fk_solver(kdl_chain_);
+  KDL::ChainFkSolverPos_recursive &fk_solver = *guard.get().fk_solver_;
 
   bool valid = true;
   for(unsigned int i=0; i < poses.size(); i++)
@@ -45,6 +45,8 @@
 #include <moveit/sensor_manager/sensor_manager.h>
 #include <pluginlib/class_loader.h>
 #include <boost/scoped_ptr.hpp>
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
 
 /** \brief This namespace includes functionality specific to the execution and monitoring of motion plans */
 namespace plan_execution
@@ -127,6 +129,17 @@ public:
     return default_max_replan_attempts_;
   }
 
+  /// Set the number of threads used to check the validity of the remaining path when the planning scene changes
+  void setPathValidationThreads(unsigned int threads)
+  {
+    path_validation_threads_ = std::max(1u, threads);
+  }
+
+  unsigned int getPathValidationThreads() const
+  {
+    return path_validation_threads_;
+  }
+
   void planAndExecute(ExecutableMotionPlan &plan, const Options &opt);
   void planAndExecute(ExecutableMotionPlan &plan, const moveit_msgs::PlanningScene &scene_diff, const Options &opt);
 
@@ -141,6 +154,9 @@ private:
   bool isRemainingPathValid(const ExecutableMotionPlan &plan);
   bool isRemainingPathValid(const ExecutableMotionPlan &plan, const std::pair<int, int> &path_segment);
 
+  /// Get a copy of the planning scene of \e plan to validate paths on; the copy is only taken again after the scene changed
+  planning_scene::PlanningSceneConstPtr getValidationScene(const ExecutableMotionPlan &plan);
+
   void planningSceneUpdatedCallback(const planning_scene_monitor::PlanningSceneMonitor::SceneUpdateType update_type);
   void doneWithTrajectoryExecution(const moveit_controller_manager::ExecutionStatus &status);
   void successfulTrajectorySegmentExecution(const ExecutableMotionPlan *plan, std::size_t index);
@@ -151,10 +167,17 @@ private:
   planning_scene_monitor::TrajectoryMonitorPtr trajectory_monitor_;
 
   unsigned int default_max_replan_attempts_;
+  unsigned int path_validation_threads_;
 
   bool preempt_requested_;
   bool new_scene_update_;
 
+  planning_scene::PlanningScenePtr validation_scene_;
+  planning_scene::PlanningSceneConstPtr validation_scene_source_;
+  /// Set by the scene update callback, cleared by the thread validating the path
+  boost::atomic<bool> validation_scene_stale_;
+  boost::mutex validation_scene_lock_;
+
   bool execution_complete_;
   bool path_became_invalid_;
 
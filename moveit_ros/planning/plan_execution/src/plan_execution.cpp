@@ -63,6 +63,7 @@ private:
   {
     owner_->setMaxReplanAttempts(config.max_replan_attempts);
     owner_->setTrajectoryStateRecordingFrequency(config.record_trajectory_state_frequency);
+    owner_->setPathValidationThreads(config.path_validation_threads);
   }
 
   PlanExecution *owner_;
@@ -81,9 +82,11 @@ plan_execution::PlanExecution::PlanExecution(const planning_scene_monitor::Plann
                                                                                                      planning_scene_monitor_->getStateMonitor()));
 
   default_max_replan_attempts_ = 5;
+  path_validation_threads_ = 4;
 
   preempt_requested_ = false;
   new_scene_update_ = false;
+  validation_scene_stale_ = true;
 
   // we want to be notified when new information is available
   planning_scene_monitor_->addUpdateCallback(boost::bind(&PlanExecution::planningSceneUpdatedCallback, this, _1));
@@ -269,39 +272,55 @@ bool plan_execution::PlanExecution::isRemainingPathValid(const ExecutableMotionP
   return isRemainingPathValid(plan, trajectory_execution_manager_->getCurrentExpectedTrajectoryIndex());
 }
 
+planning_scene::PlanningSceneConstPtr plan_execution::PlanExecution::getValidationScene(const ExecutableMotionPlan &plan)
+{
+  boost::mutex::scoped_lock slock(validation_scene_lock_);
+  // clear the flag before the copy is taken, so updates that arrive in the meantime are not lost
+  bool stale = validation_scene_stale_.exchange(false);
+  if (!validation_scene_ || stale || validation_scene_source_ != plan.planning_scene_)
+  {
+    // only hold the lock while taking a copy of the scene, so scene updates are not blocked while the path is checked
+    planning_scene_monitor::LockedPlanningSceneRO lscene(plan.planning_scene_monitor_);
+    validation_scene_ = planning_scene::PlanningScene::clone(plan.planning_scene_);
+    validation_scene_source_ = plan.planning_scene_;
+  }
+  return validation_scene_;
+}
+
 bool plan_execution::PlanExecution::isRemainingPathValid(const ExecutableMotionPlan &plan, const std::pair<int, int> &path_segment)
 {
   if (path_segment.first >= 0 && path_segment.second >= 0 && plan.plan_components_[path_segment.first].trajectory_monitoring_)
   {
-    planning_scene_monitor::LockedPlanningSceneRO lscene(plan.planning_scene_monitor_); // lock the scene so that it does not modify the world representation while isStateValid() is called
     const robot_trajectory::RobotTrajectory &t = *plan.plan_components_[path_segment.first].trajectory_;
     const collision_detection::AllowedCollisionMatrix *acm = plan.plan_components_[path_segment.first].allowed_collision_matrix_.get();
     std::size_t wpc = t.getWayPointCount();
+    std::size_t first = std::max(path_segment.second - 1, 0);
+    if (first >= wpc)
+      return true;
+
+    planning_scene::PlanningSceneConstPtr scene = getValidationScene(plan);
     collision_detection::CollisionRequest req;
     req.group_name = t.getGroupName();
-    for (std::size_t i = std::max(path_segment.second - 1, 0) ; i < wpc ; ++i)
+
+    // waypoints closest to the current position of the robot are checked first
+    std::size_t i;
+    if (!scene->isStateValidBatch(t, first, req, acm, true, i, NULL, path_validation_threads_))
+      return false;
+    if (i < wpc)
     {
+      // Dave's debacle
+      ROS_INFO("Trajectory component '%s' is invalid at waypoint %u of %u",
+               plan.plan_components_[path_segment.first].description_.c_str(), (unsigned int)i, (unsigned int)wpc);
+
+      // call the same functions again, in verbose mode, to show what issues have been detected
+      scene->isStateFeasible(t.getWayPoint(i), true);
+      req.verbose = true;
       collision_detection::CollisionResult res;
       if (acm)
-        plan.planning_scene_->checkCollisionUnpadded(req, res, t.getWayPoint(i), *acm);
+        scene->checkCollisionUnpadded(req, res, t.getWayPoint(i), *acm);
       else
-        plan.planning_scene_->checkCollisionUnpadded(req, res, t.getWayPoint(i));
-
-      if (res.collision || !plan.planning_scene_->isStateFeasible(t.getWayPoint(i), false))
-      {
-        // Dave's debacle
-        ROS_INFO("Trajectory component '%s' is invalid", plan.plan_components_[path_segment.first].description_.c_str());
-
-        // call the same functions again, in verbose mode, to show what issues have been detected
-        plan.planning_scene_->isStateFeasible(t.getWayPoint(i), true);
-        req.verbose = true;
-        res.clear();
-        if (acm)
-          plan.planning_scene_->checkCollisionUnpadded(req, res, t.getWayPoint(i), *acm);
-        else
-          plan.planning_scene_->checkCollisionUnpadded(req, res, t.getWayPoint(i));
-        return false;
-      }
+        scene->checkCollisionUnpadded(req, res, t.getWayPoint(i));
+      return false;
     }
   }
   return true;
@@ -452,8 +471,12 @@ moveit_msgs::MoveItErrorCodes plan_execution::PlanExecution::executeAndMonitor(c
 
 void plan_execution::PlanExecution::planningSceneUpdatedCallback(const planning_scene_monitor::PlanningSceneMonitor::SceneUpdateType update_type)
 {
+  // updates of the robot state alone do not affect path validation, which uses the states of the path
   if (update_type & (planning_scene_monitor::PlanningSceneMonitor::UPDATE_GEOMETRY | planning_scene_monitor::PlanningSceneMonitor::UPDATE_TRANSFORMS))
+  {
+    validation_scene_stale_ = true;
     new_scene_update_ = true;
+  }
 }
 
 void plan_execution::PlanExecution::doneWithTrajectoryExecution(const moveit_controller_manager::ExecutionStatus &status)
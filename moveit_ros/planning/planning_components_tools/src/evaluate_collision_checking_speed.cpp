@@ -35,6 +35,7 @@
 /* Author: Ioan Sucan, Sachin Chitta */
 
 #include <moveit/planning_scene_monitor/planning_scene_monitor.h>
+#include <moveit/collision_detection_fcl/collision_robot_fcl.h>
 #include <boost/program_options/parsers.hpp>
 #include <boost/program_options/variables_map.hpp>
 
@@ -54,6 +55,36 @@ void runCollisionDetection(unsigned int id, unsigned int trials, const planning_
   ROS_INFO("Thread %u performed %lf collision checks per second", id, (double)trials / duration);
 }
 
+void runSelfCollisionDetection(unsigned int trials, const collision_detection::CollisionRobot &crobot, const planning_scene::PlanningScene *scene,
+                               const std::vector<robot_state::RobotStatePtr> &states, const std::string &label)
+{
+  collision_detection::CollisionRequest req;
+  ros::WallTime start = ros::WallTime::now();
+  for (unsigned int i = 0 ; i < trials ; ++i)
+  {
+    collision_detection::CollisionResult res;
+    crobot.checkSelfCollision(req, res, *states[i % states.size()], scene->getAllowedCollisionMatrix());
+  }
+  double duration = (ros::WallTime::now() - start).toSec();
+  ROS_INFO("%s: performed %lf self-collision checks per second", label.c_str(), (double)trials / duration);
+}
+
+void compareSelfCollisionBroadPhase(unsigned int trials, const planning_scene::PlanningScene *scene,
+                                    const std::vector<robot_state::RobotStatePtr> &states)
+{
+  collision_detection::CollisionRobotFCL rebuild(scene->getRobotModel());
+  rebuild.setPersistentBroadPhase(false);
+  collision_detection::CollisionRobotFCL persistent(scene->getRobotModel());
+  persistent.setPersistentBroadPhase(true);
+
+  // the same state checked repeatedly does not need any refit; cycling through states refits every moving link
+  std::vector<robot_state::RobotStatePtr> one_state(1, states[0]);
+  runSelfCollisionDetection(trials, rebuild, scene, one_state, "Rebuilt broadphase, same state");
+  runSelfCollisionDetection(trials, persistent, scene, one_state, "Persistent broadphase, same state");
+  runSelfCollisionDetection(trials, rebuild, scene, states, "Rebuilt broadphase, changing states");
+  runSelfCollisionDetection(trials, persistent, scene, states, "Persistent broadphase, changing states");
+}
+
 int main(int argc, char **argv)
 {
   ros::init(argc, argv, "evaluate_collision_checking_speed");
@@ -64,6 +95,7 @@ int main(int argc, char **argv)
   desc.add_options()
     ("nthreads", boost::program_options::value<unsigned int>(&nthreads)->default_value(nthreads), "Number of threads to use")
     ("trials", boost::program_options::value<unsigned int>(&trials)->default_value(trials), "Number of collision checks to perform with each thread")
+    ("compare-broadphase", "Compare self-collision checking with persistent broadphase structures to rebuilding them for every check")
     ("wait", "Wait for a user command (so the planning scene can be updated in thre background)")
     ("help", "this screen");
   boost::program_options::variables_map vm;
@@ -112,6 +144,20 @@ int main(int argc, char **argv)
       states.push_back(robot_state::RobotStatePtr(state));
     }
 
+    if (vm.count("compare-broadphase"))
+    {
+      std::vector<robot_state::RobotStatePtr> random_states;
+      for (unsigned int i = 0 ; i < 100 ; ++i)
+      {
+        robot_state::RobotStatePtr state(new robot_state::RobotState(psm.getPlanningScene()->getRobotModel()));
+        state->setToRandomPositions();
+        state->update();
+        random_states.push_back(state);
+      }
+      compareSelfCollisionBroadPhase(trials, psm.getPlanningScene().get(), random_states);
+      return 0;
+    }
+
     std::vector<boost::thread*> threads;
 
     for (unsigned int i = 0 ; i < states.size() ; ++i)
@@ -36,11 +36,101 @@
 
 #include <moveit/robot_model_loader/robot_model_loader.h>
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_state/batch_forward_kinematics.h>
 #include <moveit/profiler/profiler.h>
 #include <ros/ros.h>
 
 static const std::string ROBOT_DESCRIPTION = "robot_description";
 
+// compare N calls to RobotState::update() with batch FK for the same N states, computed in chunks of at most CHUNK states
+static void evaluateBatchFK(const robot_model::RobotModelConstPtr &robot_model, const robot_model::JointModelGroup *jmg, int N)
+{
+  static const int CHUNK = 1000;
+  const std::string name = jmg ? jmg->getName() + ":" : std::string();
+  robot_state::RobotState state(robot_model);
+  state.setToDefaultValues();
+  state.update();
+  robot_state::RobotState reference(state);
+
+  robot_state::BatchForwardKinematics batch = jmg ? robot_state::BatchForwardKinematics(robot_model, jmg) : robot_state::BatchForwardKinematics(robot_model);
+  const std::size_t nv = batch.getVariableCount();
+  std::vector<double> positions(N * nv);
+  for (int i = 0 ; i < N ; ++i)
+  {
+    if (jmg)
+    {
+      state.setToRandomPositions(jmg);
+      state.copyJointGroupPositions(jmg, &positions[i * nv]);
+    }
+    else
+    {
+      state.setToRandomPositions();
+      std::copy(state.getVariablePositions(), state.getVariablePositions() + nv, positions.begin() + i * nv);
+    }
+  }
+
+  printf("%sEvaluating FK Sequential ...\n", name.c_str());
+  moveit::tools::Profiler::Begin(name + "FK Sequential");
+  for (int i = 0 ; i < N ; ++i)
+  {
+    if (jmg)
+      state.setJointGroupPositions(jmg, &positions[i * nv]);
+    else
+      state.setVariablePositions(&positions[i * nv]);
+    state.update();
+  }
+  moveit::tools::Profiler::End(name + "FK Sequential");
+
+  printf("%sEvaluating FK Batch ...\n", name.c_str());
+  moveit::tools::Profiler::Begin(name + "FK Batch");
+  for (int i = 0 ; i < N ; i += CHUNK)
+    batch.compute(reference, &positions[i * nv], std::min(CHUNK, N - i));
+  moveit::tools::Profiler::End(name + "FK Batch");
+}
+
+// compare reading the transform of the tip link of a group after a full update with computing just its chain
+static void evaluatePartialFK(const robot_model::RobotModelConstPtr &robot_model, const robot_model::JointModelGroup *jmg, int N)
+{
+  if (jmg->getLinkModels().empty())
+    return;
+  const robot_model::LinkModel *link = jmg->getLinkModels().back();
+  const std::string name = jmg->getName() + ":";
+  robot_state::RobotState state(robot_model);
+  state.setToDefaultValues();
+
+  const std::size_t nv = jmg->getVariableCount();
+  std::vector<double> positions(N * nv);
+  for (int i = 0 ; i < N ; ++i)
+  {
+    state.setToRandomPositions(jmg);
+    state.copyJointGroupPositions(jmg, &positions[i * nv]);
+  }
+
+  Eigen::Vector3d full = Eigen::Vector3d::Zero();
+  printf("%sEvaluating FK Link %s (full update) ...\n", name.c_str(), link->getName().c_str());
+  moveit::tools::Profiler::Begin(name + "FK Link Full");
+  for (int i = 0 ; i < N ; ++i)
+  {
+    state.setJointGroupPositions(jmg, &positions[i * nv]);
+    state.update();
+    full += state.getGlobalLinkTransform(link).translation();
+  }
+  moveit::tools::Profiler::End(name + "FK Link Full");
+
+  Eigen::Vector3d partial = Eigen::Vector3d::Zero();
+  printf("%sEvaluating FK Link %s (chain only) ...\n", name.c_str(), link->getName().c_str());
+  moveit::tools::Profiler::Begin(name + "FK Link Chain");
+  for (int i = 0 ; i < N ; ++i)
+  {
+    state.setJointGroupPositions(jmg, &positions[i * nv]);
+    partial += state.computeGlobalLinkTransform(link).translation();
+  }
+  moveit::tools::Profiler::End(name + "FK Link Chain");
+
+  if (!full.isApprox(partial, 1e-6))
+    ROS_ERROR("%s transforms computed for link '%s' differ", name.c_str(), link->getName().c_str());
+}
+
 int main(int argc, char **argv)
 {
     ros::init(argc, argv, "evaluate_state_operations_speed");
@@ -114,6 +204,15 @@ int main(int argc, char **argv)
         }
       }
 
+      printf("\n");
+      evaluateBatchFK(robot_model, NULL, N);
+      for (std::size_t j = 0 ; j < groups.size() ; ++j)
+        evaluateBatchFK(robot_model, robot_model->getJointModelGroup(groups[j]), N);
+
+      printf("\n");
+      for (std::size_t j = 0 ; j < groups.size() ; ++j)
+        evaluatePartialFK(robot_model, robot_model->getJointModelGroup(groups[j]), N);
+
       moveit::tools::Profiler::Stop();
       moveit::tools::Profiler::Status();
     }
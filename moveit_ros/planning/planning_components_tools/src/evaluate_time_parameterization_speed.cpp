@@ -0,0 +1,139 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt! contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Compare time parameterization of trajectories stored as RobotState waypoints and as compact matrices, and
+   iterative parabolic with time optimal parameterization */
+
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/robot_trajectory/compact_robot_trajectory.h>
+#include <moveit/trajectory_processing/iterative_time_parameterization.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
+#include <moveit/profiler/profiler.h>
+#include <ros/ros.h>
+
+static const std::string ROBOT_DESCRIPTION = "robot_description";
+
+// a path through LEGS random states of the group, each leg sampled with N waypoints
+static void makeTrajectory(robot_trajectory::RobotTrajectory &trajectory, int N)
+{
+  static const int LEGS = 5;
+  const robot_model::JointModelGroup *jmg = trajectory.getGroup();
+  robot_state::RobotState from(trajectory.getRobotModel()), to(trajectory.getRobotModel()), st(trajectory.getRobotModel());
+  from.setToDefaultValues();
+  to.setToDefaultValues();
+  for (int k = 0 ; k < LEGS ; ++k)
+  {
+    to.setToRandomPositions(jmg);
+    for (int i = k == 0 ? 0 : 1 ; i < N ; ++i)
+    {
+      from.interpolate(to, (double)i / (double)(N - 1), st);
+      trajectory.addSuffixWayPoint(st, 0.0);
+    }
+    from = to;
+  }
+}
+
+static void evaluateTimeParameterization(const robot_model::RobotModelConstPtr &robot_model, const robot_model::JointModelGroup *jmg, int N)
+{
+  const std::string name = jmg->getName() + ":";
+  robot_trajectory::RobotTrajectory trajectory(robot_model, jmg->getName());
+  makeTrajectory(trajectory, N);
+  robot_trajectory::CompactRobotTrajectory compact(trajectory);
+  robot_trajectory::RobotTrajectory optimal_trajectory(robot_model, jmg->getName());
+  for (std::size_t i = 0 ; i < trajectory.getWayPointCount() ; ++i)
+    optimal_trajectory.addSuffixWayPoint(trajectory.getWayPoint(i), 0.0);
+
+  trajectory_processing::IterativeParabolicTimeParameterization iptp;
+  printf("%sEvaluating Iterative Parabolic (RobotState waypoints) for %u waypoints ...\n", name.c_str(), (unsigned int)trajectory.getWayPointCount());
+  moveit::tools::Profiler::Begin(name + "Iterative Parabolic RobotState");
+  iptp.computeTimeStamps(trajectory);
+  moveit::tools::Profiler::End(name + "Iterative Parabolic RobotState");
+
+  printf("%sEvaluating Iterative Parabolic (compact) for %u waypoints ...\n", name.c_str(), (unsigned int)compact.getWayPointCount());
+  moveit::tools::Profiler::Begin(name + "Iterative Parabolic Compact");
+  iptp.computeTimeStamps(compact);
+  moveit::tools::Profiler::End(name + "Iterative Parabolic Compact");
+
+  trajectory_processing::TimeOptimalTrajectoryGeneration totg;
+  printf("%sEvaluating Time Optimal for %u waypoints ...\n", name.c_str(), (unsigned int)optimal_trajectory.getWayPointCount());
+  moveit::tools::Profiler::Begin(name + "Time Optimal");
+  bool optimal = totg.computeTimeStamps(optimal_trajectory);
+  moveit::tools::Profiler::End(name + "Time Optimal");
+
+  printf("%sTrajectory duration: %lf s iterative parabolic, ", name.c_str(), trajectory.getWaypointDurationFromStart(trajectory.getWayPointCount() - 1));
+  if (optimal)
+    printf("%lf s time optimal\n", optimal_trajectory.getWaypointDurationFromStart(optimal_trajectory.getWayPointCount() - 1));
+  else
+    printf("time optimal failed\n");
+}
+
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "evaluate_time_parameterization_speed");
+
+  ros::AsyncSpinner spinner(1);
+  spinner.start();
+
+  robot_model_loader::RobotModelLoader rml(ROBOT_DESCRIPTION);
+  ros::Duration(0.5).sleep();
+
+  robot_model::RobotModelConstPtr robot_model = rml.getModel();
+  if (robot_model)
+  {
+    static const int N = 400;
+    printf("Evaluating model '%s' using %d waypoints per leg\n", robot_model->getName().c_str(), N);
+
+    moveit::tools::Profiler::Clear();
+    moveit::tools::Profiler::Start();
+
+    const std::vector<std::string> &groups = robot_model->getJointModelGroupNames();
+    for (std::size_t j = 0 ; j < groups.size() ; ++j)
+    {
+      const robot_model::JointModelGroup *jmg = robot_model->getJointModelGroup(groups[j]);
+      if (jmg->getVariableCount() == 0)
+        continue;
+      printf("\n");
+      evaluateTimeParameterization(robot_model, jmg, N);
+    }
+
+    moveit::tools::Profiler::Stop();
+    moveit::tools::Profiler::Status();
+  }
+  else
+    ROS_ERROR("Unable to initialize robot model.");
+
+  ros::shutdown();
+  return 0;
+}
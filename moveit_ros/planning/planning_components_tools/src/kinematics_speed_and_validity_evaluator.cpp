@@ -37,10 +37,21 @@
 #include <moveit/robot_model_loader/robot_model_loader.h>
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/profiler/profiler.h>
+#include <eigen_conversions/eigen_msg.h>
 #include <ros/ros.h>
 
 static const std::string ROBOT_DESCRIPTION = "robot_description";
 
+namespace
+{
+
+void reportRate(const std::string &name, unsigned int calls, const ros::WallDuration &elapsed)
+{
+  ROS_INFO("%s: %u calls, %.1f calls per second", name.c_str(), calls, elapsed.toSec() > 0.0 ? calls / elapsed.toSec() : 0.0);
+}
+
+}
+
 int main(int argc, char **argv)
 {
   ros::init(argc, argv, "inverse_kinematics_test");
@@ -83,6 +94,7 @@ int main(int argc, char **argv)
 
         ROS_INFO("Running %u tests", test_count);
 
+        ros::WallDuration set_from_ik_time;
         moveit::tools::Profiler::Start();
         for (unsigned int i = 0 ; i < test_count ; ++i)
         {
@@ -90,7 +102,9 @@ int main(int argc, char **argv)
           Eigen::Affine3d pose = state.getGlobalLinkTransform(tip);
           state.setToRandomPositions(jmg);
           moveit::tools::Profiler::Begin("IK");
+          ros::WallTime start = ros::WallTime::now();
           state.setFromIK(jmg, pose);
+          set_from_ik_time += ros::WallTime::now() - start;
           moveit::tools::Profiler::End("IK");
           const Eigen::Affine3d &pose_upd = state.getGlobalLinkTransform(tip);
           Eigen::Affine3d diff = pose_upd * pose.inverse();
@@ -111,6 +125,39 @@ int main(int argc, char **argv)
         }
         moveit::tools::Profiler::Stop();
         moveit::tools::Profiler::Status();
+        reportRate("RobotState::setFromIK()", test_count, set_from_ik_time);
+
+        // time calls to the solver itself, separately from the work done by RobotState::setFromIK()
+        const std::vector<std::string> &joint_names = solver->getJointNames();
+        std::vector<geometry_msgs::Pose> poses(test_count);
+        std::vector<std::vector<double> > seeds(test_count, std::vector<double>(joint_names.size()));
+        for (unsigned int i = 0 ; i < test_count ; ++i)
+        {
+          state.setToRandomPositions(jmg);
+          state.update();
+          Eigen::Affine3d pose = state.getFrameTransform(solver->getBaseFrame()).inverse() * state.getGlobalLinkTransform(tip);
+          tf::poseEigenToMsg(pose, poses[i]);
+          state.setToRandomPositions(jmg);
+          for (std::size_t j = 0 ; j < joint_names.size() ; ++j)
+            seeds[i][j] = state.getVariablePosition(joint_names[j]);
+        }
+
+        std::vector<double> solution(joint_names.size());
+        moveit_msgs::MoveItErrorCodes error_code;
+        unsigned int solved = 0;
+
+        // the first call sets up whatever the solver keeps between calls
+        ros::WallTime start = ros::WallTime::now();
+        if (test_count > 0 && solver->searchPositionIK(poses[0], seeds[0], solver->getDefaultTimeout(), solution, error_code))
+          solved++;
+        reportRate("First call to searchPositionIK()", 1, ros::WallTime::now() - start);
+
+        start = ros::WallTime::now();
+        for (unsigned int i = 1 ; i < test_count ; ++i)
+          if (solver->searchPositionIK(poses[i], seeds[i], solver->getDefaultTimeout(), solution, error_code))
+            solved++;
+        reportRate("Subsequent calls to searchPositionIK()", test_count > 0 ? test_count - 1 : 0, ros::WallTime::now() - start);
+        ROS_INFO("searchPositionIK() found solutions for %u out of %u poses", solved, test_count);
       }
       else
         ROS_ERROR_STREAM("No kinematics solver specified for group " << group);
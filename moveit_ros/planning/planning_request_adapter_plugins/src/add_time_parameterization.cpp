@@ -35,9 +35,11 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/planning_request_adapter/planning_request_adapter.h>
+#include <moveit/robot_trajectory/compact_robot_trajectory.h>
 #include <moveit/trajectory_processing/iterative_time_parameterization.h>
+#include <moveit/trajectory_processing/time_optimal_trajectory_generation.h>
 #include <class_loader/class_loader.h>
-#include <ros/console.h>
+#include <ros/ros.h>
 
 namespace default_planner_request_adapters
 {
@@ -46,8 +48,23 @@ class AddTimeParameterization : public planning_request_adapter::PlanningRequest
 {
 public:
 
-  AddTimeParameterization() : planning_request_adapter::PlanningRequestAdapter()
+  static const std::string ALGORITHM_PARAM_NAME;
+
+  AddTimeParameterization() : planning_request_adapter::PlanningRequestAdapter(), nh_("~"), time_optimal_(false)
   {
+    std::string algorithm;
+    if (!nh_.getParam(ALGORITHM_PARAM_NAME, algorithm))
+      ROS_INFO_STREAM("Param '" << ALGORITHM_PARAM_NAME << "' was not set. Using default value: iterative_parabolic");
+    else
+    {
+      if (algorithm == "time_optimal")
+        time_optimal_ = true;
+      else
+        if (algorithm != "iterative_parabolic")
+          ROS_ERROR_STREAM("Unknown value '" << algorithm << "' for param '" << ALGORITHM_PARAM_NAME
+                           << "'. Expected 'iterative_parabolic' or 'time_optimal'. Using iterative_parabolic");
+      ROS_INFO_STREAM("Param '" << ALGORITHM_PARAM_NAME << "' was set to " << (time_optimal_ ? "time_optimal" : "iterative_parabolic"));
+    }
   }
 
   virtual std::string getDescription() const { return "Add Time Parameterization"; }
@@ -62,7 +79,16 @@ public:
     if (result && res.trajectory_)
     {
       ROS_DEBUG("Running '%s'", getDescription().c_str());
-      if (!time_param_.computeTimeStamps(*res.trajectory_, req.max_velocity_scaling_factor, req.max_acceleration_scaling_factor))
+      bool success = false;
+      if (time_optimal_)
+      {
+        success = time_optimal_param_.computeTimeStamps(*res.trajectory_, req.max_velocity_scaling_factor, req.max_acceleration_scaling_factor);
+        if (!success)
+          ROS_WARN("Time optimal parametrization for the solution path failed. Using iterative parabolic parametrization instead.");
+      }
+      if (!success)
+        success = computeIterativeParabolic(*res.trajectory_, req.max_velocity_scaling_factor, req.max_acceleration_scaling_factor);
+      if (!success)
         ROS_WARN("Time parametrization for the solution path failed.");
     }
 
@@ -71,9 +97,34 @@ public:
 
 private:
 
+  bool computeIterativeParabolic(robot_trajectory::RobotTrajectory &trajectory, double max_velocity_scaling_factor,
+                                 double max_acceleration_scaling_factor) const
+  {
+    // without a group the regular version reports the error
+    if (!trajectory.getGroup())
+      return time_param_.computeTimeStamps(trajectory, max_velocity_scaling_factor, max_acceleration_scaling_factor);
+
+    // parameterize the contiguous group variables, then write the result back into the existing waypoints, so
+    // variables outside the group keep their per-waypoint values and no states are allocated
+    robot_trajectory::CompactRobotTrajectory compact(trajectory);
+    if (!time_param_.computeTimeStamps(compact, max_velocity_scaling_factor, max_acceleration_scaling_factor))
+      return false;
+    for (std::size_t i = 0 ; i < compact.getWayPointCount() ; ++i)
+    {
+      compact.getWayPoint(i, *trajectory.getWayPointPtr(i));
+      trajectory.setWayPointDurationFromPrevious(i, compact.getWayPointDurationFromPrevious(i));
+    }
+    return true;
+  }
+
+  ros::NodeHandle nh_;
+  bool time_optimal_;
   trajectory_processing::IterativeParabolicTimeParameterization time_param_;
+  trajectory_processing::TimeOptimalTrajectoryGeneration time_optimal_param_;
 };
 
+const std::string AddTimeParameterization::ALGORITHM_PARAM_NAME = "time_parameterization";
+
 }
 
 CLASS_LOADER_REGISTER_CLASS(default_planner_request_adapters::AddTimeParameterization,
@@ -50,6 +50,7 @@
 #include <boost/noncopyable.hpp>
 #include <boost/thread/shared_mutex.hpp>
 #include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/mutex.hpp>
 
 namespace planning_scene_monitor
 {
@@ -258,6 +259,17 @@ public:
     return publish_planning_scene_frequency_;
   }
 
+  /** \brief Set the number of published planning scene diffs that carry only the changes to the monitored octomap before the full
+      octomap is published again. This lets subscribers that missed a diff resynchronize. 0 means the full octomap is always published. */
+  void setOctomapKeyframeInterval(unsigned int deltas);
+
+  /** \brief Get the number of octomap deltas published between full octomaps */
+  unsigned int getOctomapKeyframeInterval() const
+  {
+    boost::mutex::scoped_lock slock(octomap_publish_lock_);
+    return octomap_keyframe_interval_;
+  }
+
   /** @brief Get the stored instance of the stored current state monitor
    *  @return An instance of the stored current state monitor*/
   const CurrentStateMonitorPtr& getStateMonitor() const
@@ -385,6 +397,15 @@ protected:
   /** @brief Callback for octomap updates */
   void octomapUpdateCallback();
 
+  /** @brief Serialize the octomap for published planning scenes; diffs carry only the changes made to the monitored octree since the last published revision */
+  void serializeOctomap(const octomap::OcTree &octree, bool diff, octomap_msgs::Octomap &msg) const;
+
+  /** @brief Remember the revision of the octomap included in a published planning scene message */
+  void recordPublishedOctomap(const moveit_msgs::PlanningScene &msg);
+
+  /** @brief Let the monitored octree record its changes only while planning scenes (and therefore octomap deltas) are published */
+  void updateOctomapChangeTracking();
+
   /** @brief Callback for a new attached object msg*/
   void attachObjectCallback(const moveit_msgs::AttachedCollisionObjectConstPtr &obj);
 
@@ -443,6 +464,13 @@ protected:
   SceneUpdateType                       new_scene_update_;
   boost::condition_variable_any         new_scene_update_condition_;
 
+  // the state of octomap publishing; the serializer reads it from whichever thread asks the scene for a message
+  mutable boost::mutex                  octomap_publish_lock_;
+  unsigned int                          octomap_keyframe_interval_;
+  unsigned int                          octomap_published_revision_;
+  unsigned int                          octomap_deltas_since_keyframe_;
+  bool                                  octomap_change_tracking_;
+
   // subscribe to various sources of data
   ros::Subscriber                       planning_scene_subscriber_;
   ros::Subscriber                       planning_scene_world_subscriber_;
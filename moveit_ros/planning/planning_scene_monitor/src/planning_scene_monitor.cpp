@@ -37,6 +37,8 @@
 #include <moveit/planning_scene_monitor/planning_scene_monitor.h>
 #include <moveit/robot_model_loader/robot_model_loader.h>
 #include <moveit/exceptions/exceptions.h>
+#include <moveit/planning_scene/octomap_delta.h>
+#include <octomap_msgs/conversions.h>
 #include <moveit_msgs/GetPlanningScene.h>
 
 #include <dynamic_reconfigure/server.h>
@@ -89,6 +91,7 @@ private:
     if (config.publish_planning_scene)
     {
       owner_->setPlanningScenePublishingFrequency(config.publish_planning_scene_hz);
+      owner_->setOctomapKeyframeInterval(config.publish_octomap_keyframe_interval);
       owner_->startPublishingPlanningScene(event);
     }
     else
@@ -212,6 +215,10 @@ void planning_scene_monitor::PlanningSceneMonitor::initialize(const planning_sce
 
   publish_planning_scene_frequency_ = 2.0;
   new_scene_update_ = UPDATE_NONE;
+  octomap_keyframe_interval_ = 20;
+  octomap_published_revision_ = 0;
+  octomap_deltas_since_keyframe_ = 0;
+  octomap_change_tracking_ = false;
 
   last_update_time_ = ros::Time::now();
   last_state_update_ = ros::WallTime::now();
@@ -290,7 +297,12 @@ void planning_scene_monitor::PlanningSceneMonitor::stopPublishingPlanningScene()
     new_scene_update_condition_.notify_all();
     copy->join();
     monitorDiffs(false);
+    {
+      boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
+      scene_->setOctomapSerializer(planning_scene::OctomapSerializerFn());
+    }
     planning_scene_publisher_.shutdown();
+    updateOctomapChangeTracking();
     ROS_INFO("Stopped publishing maintained planning scene.");
   }
 }
@@ -303,7 +315,16 @@ void planning_scene_monitor::PlanningSceneMonitor::startPublishingPlanningScene(
     planning_scene_publisher_ = nh_.advertise<moveit_msgs::PlanningScene>(planning_scene_topic, 100, false);
     ROS_INFO("Publishing maintained planning scene on '%s'", planning_scene_topic.c_str());
     monitorDiffs(true);
+    {
+      boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
+      {
+        boost::mutex::scoped_lock slock(octomap_publish_lock_);
+        octomap_published_revision_ = 0;
+      }
+      scene_->setOctomapSerializer(boost::bind(&PlanningSceneMonitor::serializeOctomap, this, _1, _2, _3));
+    }
     publish_planning_scene_.reset(new boost::thread(boost::bind(&PlanningSceneMonitor::scenePublishingThread, this)));
+    updateOctomapChangeTracking();
   }
 }
 
@@ -318,6 +339,7 @@ void planning_scene_monitor::PlanningSceneMonitor::scenePublishingThread()
     if (octomap_monitor_) lock = octomap_monitor_->getOcTreePtr()->reading();
     scene_->getPlanningSceneMsg(msg);
   }
+  recordPublishedOctomap(msg);
   planning_scene_publisher_.publish(msg);
   ROS_DEBUG("Published the full planning scene: '%s'", msg.name.c_str());
 
@@ -361,6 +383,7 @@ void planning_scene_monitor::PlanningSceneMonitor::scenePublishingThread()
             if (octomap_monitor_) lock = octomap_monitor_->getOcTreePtr()->reading();
             scene_->getPlanningSceneMsg(msg);
           }
+          recordPublishedOctomap(msg);
           publish_msg = true;
         }
         new_scene_update_ = UPDATE_NONE;
@@ -378,6 +401,68 @@ void planning_scene_monitor::PlanningSceneMonitor::scenePublishingThread()
   while (publish_planning_scene_);
 }
 
+void planning_scene_monitor::PlanningSceneMonitor::serializeOctomap(const octomap::OcTree &octree, bool diff, octomap_msgs::Octomap &msg) const
+{
+  // only the monitored octree keeps track of its changes; the read lock on it is held by the caller
+  if (!octomap_monitor_ || &octree != octomap_monitor_->getOcTreePtr().get())
+  {
+    octomap_msgs::fullMapToMsg(octree, msg);
+    return;
+  }
+
+  unsigned int published_revision;
+  bool keyframe_due;
+  {
+    boost::mutex::scoped_lock slock(octomap_publish_lock_);
+    published_revision = octomap_published_revision_;
+    keyframe_due = octomap_deltas_since_keyframe_ >= octomap_keyframe_interval_;
+  }
+
+  const occupancy_map_monitor::OccMapTree &tree = *octomap_monitor_->getOcTreePtr();
+  octomap::KeySet keys;
+  if (diff && published_revision > 0 && !keyframe_due && tree.getChangedKeys(published_revision, keys))
+    planning_scene::octomapDeltaToMsg(tree, keys, published_revision, tree.getRevision(), msg);
+  else
+  {
+    octomap_msgs::fullMapToMsg(tree, msg);
+    msg.header.seq = tree.getRevision();
+  }
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::recordPublishedOctomap(const moveit_msgs::PlanningScene &msg)
+{
+  const octomap_msgs::Octomap &map = msg.world.octomap.octomap;
+  if (map.data.empty())
+    return;
+  boost::mutex::scoped_lock slock(octomap_publish_lock_);
+  if (map.id == planning_scene::OCTOMAP_DELTA_ID)
+    octomap_deltas_since_keyframe_++;
+  else
+    octomap_deltas_since_keyframe_ = 0;
+  octomap_published_revision_ = map.header.seq;
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::updateOctomapChangeTracking()
+{
+  bool track = publish_planning_scene_ && octomap_monitor_;
+  if (track == octomap_change_tracking_)
+    return;
+  if (track)
+    octomap_monitor_->getOcTreePtr()->enableChangeTracking();
+  else
+    octomap_monitor_->getOcTreePtr()->disableChangeTracking();
+  octomap_change_tracking_ = track;
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::setOctomapKeyframeInterval(unsigned int deltas)
+{
+  {
+    boost::mutex::scoped_lock slock(octomap_publish_lock_);
+    octomap_keyframe_interval_ = deltas;
+  }
+  ROS_DEBUG("Full octomaps are now published after %u octomap deltas", deltas);
+}
+
 void planning_scene_monitor::PlanningSceneMonitor::getMonitoredTopics(std::vector<std::string> &topics) const
 {
   topics.clear();
@@ -476,6 +561,7 @@ void planning_scene_monitor::PlanningSceneMonitor::clearOctomap()
 {
   octomap_monitor_->getOcTreePtr()->lockWrite();
   octomap_monitor_->getOcTreePtr()->clear();
+  octomap_monitor_->getOcTreePtr()->resetChangeHistory();
   octomap_monitor_->getOcTreePtr()->unlockWrite();
 }
 
@@ -502,6 +588,7 @@ bool planning_scene_monitor::PlanningSceneMonitor::newPlanningSceneMessage(const
       {
         octomap_monitor_->getOcTreePtr()->lockWrite();
         octomap_monitor_->getOcTreePtr()->clear();
+        octomap_monitor_->getOcTreePtr()->resetChangeHistory();
         octomap_monitor_->getOcTreePtr()->unlockWrite();
       }
     }
@@ -518,6 +605,8 @@ bool planning_scene_monitor::PlanningSceneMonitor::newPlanningSceneMessage(const
       scene_const_ = scene_;
       scene_->setAttachedBodyUpdateCallback(boost::bind(&PlanningSceneMonitor::currentStateAttachedBodyUpdateCallback, this, _1, _2));
       scene_->setCollisionObjectUpdateCallback(boost::bind(&PlanningSceneMonitor::currentWorldObjectUpdateCallback, this, _1, _2));
+      scene_->setOctomapSerializer(parent_scene_->getOctomapSerializer());
+      parent_scene_->setOctomapSerializer(planning_scene::OctomapSerializerFn());
     }
     if (octomap_monitor_)
     {
@@ -568,6 +657,7 @@ void planning_scene_monitor::PlanningSceneMonitor::newPlanningSceneWorldCallback
         {
           octomap_monitor_->getOcTreePtr()->lockWrite();
           octomap_monitor_->getOcTreePtr()->clear();
+          octomap_monitor_->getOcTreePtr()->resetChangeHistory();
           octomap_monitor_->getOcTreePtr()->unlockWrite();
         }
       }
@@ -959,6 +1049,7 @@ void planning_scene_monitor::PlanningSceneMonitor::startWorldGeometryMonitor(con
 
       octomap_monitor_->setTransformCacheCallback(boost::bind(&PlanningSceneMonitor::getShapeTransformCache, this, _1, _2, _3));
       octomap_monitor_->setUpdateCallback(boost::bind(&PlanningSceneMonitor::octomapUpdateCallback, this));
+      updateOctomapChangeTracking();
     }
     octomap_monitor_->startMonitor();
   }